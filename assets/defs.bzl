@@ -9,6 +9,7 @@ def _asset_header_impl(ctx):
     headers = [
         "data.h",
         "font.h",
+        "group.h",
         "image.h",
         "model.h",
         "pak.h",
@@ -101,9 +102,11 @@ def _asset_data_impl(ctx):
             "-dir=" + _join(ctx.bin_dir.path, ctx.label.workspace_root, ctx.label.package, dirname),
             "-dir=" + _join(ctx.label.workspace_root, ctx.label.package, dirname),
         ]
+    for trace in ctx.files.traces:
+        arguments.append("-trace=" + trace.path)
     ctx.actions.run(
         outputs = [out, stats],
-        inputs = [manifest] + ctx.files.srcs,
+        inputs = [manifest] + ctx.files.srcs + ctx.files.traces,
         progress_message = "Creating asset package %s" % out.short_path,
         executable = ctx.executable._makepak,
         arguments = arguments,
@@ -123,6 +126,9 @@ asset_data = rule(
         "dirs": attr.string_list(
             default = ["."],
         ),
+        "traces": attr.label_list(
+            allow_files = True,
+        ),
         "_makepak": attr.label(
             default = Label("//tools/makepak"),
             allow_single_file = True,
@@ -1,18 +1,22 @@
-def _textures_impl(ctx):
-    outputs = []
+def _texture_args(ctx):
     base_args = ["-format=" + ctx.attr.format]
-    if ctx.attr.mipmap:
+    if getattr(ctx.attr, "mipmap", False):
         base_args.append("-mipmap")
     if ctx.attr.native:
         base_args.append("-native")
     if ctx.attr.dither != "":
         base_args.append("-dither=" + ctx.attr.dither)
+    if ctx.attr.gamma:
+        base_args.append("-gamma=" + ctx.attr.gamma)
+    return base_args
+
+def _textures_impl(ctx):
+    outputs = []
+    base_args = _texture_args(ctx)
     if ctx.attr.strips:
         base_args.append("-strips")
     if ctx.attr.anchor:
         base_args.append("-anchor=" + ctx.attr.anchor)
-    if ctx.attr.gamma:
-        base_args.append("-gamma=" + ctx.attr.gamma)
     suffix = ctx.attr.suffix + ".texture"
     for src in ctx.files.srcs:
         name = src.basename
@@ -62,3 +66,47 @@ textures = rule(
         ),
     },
 )
+
+def _texture_atlas_impl(ctx):
+    out = ctx.actions.declare_file(ctx.attr.name + ".texture")
+    ctx.actions.run(
+        outputs = [out],
+        inputs = ctx.files.srcs,
+        progress_message = "Creating texture atlas %s" % out.short_path,
+        executable = ctx.executable._converter,
+        arguments = _texture_args(ctx) + [
+            "-atlas",
+            "-output=" + out.path,
+            "-input=" + ",".join([src.path for src in ctx.files.srcs]),
+        ],
+    )
+    return [DefaultInfo(files = depset([out]))]
+
+# Pack multiple textures into one atlas texture. The order of srcs must match
+# the order of materials passed to the atlas attribute of the models rule. The
+# srcs must all have the same power-of-two size, which is passed to the models
+# rule as atlas_cell_size, and the atlas must fit in TMEM without scaling.
+# Atlases cannot have mipmaps.
+texture_atlas = rule(
+    implementation = _texture_atlas_impl,
+    attrs = {
+        "srcs": attr.label_list(
+            allow_files = True,
+            mandatory = True,
+        ),
+        "format": attr.string(
+            mandatory = True,
+        ),
+        "native": attr.bool(
+            default = False,
+        ),
+        "dither": attr.string(),
+        "gamma": attr.string(),
+        "_converter": attr.label(
+            default = Label("//tools/textureconvert"),
+            allow_single_file = True,
+            executable = True,
+            cfg = "exec",
+        ),
+    },
+)
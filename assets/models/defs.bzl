@@ -14,6 +14,15 @@ def _models_impl(ctx):
         base_args.append("-axes=" + ctx.attr.axes)
     if ctx.attr.animate:
         base_args.append("-animate")
+    if ctx.attr.atlas:
+        base_args.append("-atlas=" + ctx.attr.atlas)
+        base_args.append("-atlas-cell-size=%d" % ctx.attr.atlas_cell_size)
+    # Must match the microcode linked into the game. F3DEX3 is only supported
+    # by modelconvert, since the SDK has no F3DEX3 microcode or gbi.h.
+    ucode = ctx.var.get("ucode", "f3dex2")
+    if ucode not in ("f3dex", "f3dex2"):
+        fail("unsupported microcode for the game: %r" % ucode)
+    base_args.append("-ucode=" + ucode)
     for src in ctx.files.srcs:
         name = src.basename
         idx = name.find(".")
@@ -60,6 +69,11 @@ models = rule(
         ),
         "axes": attr.string(),
         "animate": attr.bool(),
+        # Comma-separated list of materials to merge using a texture atlas,
+        # created with the texture_atlas rule.
+        "atlas": attr.string(),
+        # Size of each cell in the atlas texture, in texels.
+        "atlas_cell_size": attr.int(),
         "_converter": attr.label(
             default = Label("//tools/modelconvert"),
             allow_single_file = True,
@@ -98,7 +98,37 @@ enum {
     FLEN_BIGL,
 };
 
-static intmax_t read_argi(int lengthmod, va_list *ap) {
+// Source of arguments for formatting, either a va_list or an array.
+struct console_args {
+    va_list *ap;
+    const union console_arg *arg, *end;
+};
+
+static union console_arg read_arg(struct console_args *restrict args) {
+    return args->arg < args->end ? *args->arg++ : (union console_arg){0};
+}
+
+static intmax_t read_argi(int lengthmod, struct console_args *restrict args) {
+    if (args->ap == NULL) {
+        long long val = read_arg(args).i;
+        switch (lengthmod) {
+        case FLEN_NORMAL:
+            return (int)val;
+        case FLEN_HH:
+            return (signed char)val;
+        case FLEN_H:
+            return (short)val;
+        case FLEN_L:
+            return (long)val;
+        case FLEN_Z:
+            return (size_t)val;
+        case FLEN_T:
+            return (ptrdiff_t)val;
+        default:
+            return val;
+        }
+    }
+    va_list *ap = args->ap;
     switch (lengthmod) {
     case FLEN_NORMAL:
         return va_arg(*ap, int);
@@ -121,7 +151,27 @@ static intmax_t read_argi(int lengthmod, va_list *ap) {
     }
 }
 
-static uintmax_t read_argu(int lengthmod, va_list *ap) {
+static uintmax_t read_argu(int lengthmod, struct console_args *restrict args) {
+    if (args->ap == NULL) {
+        unsigned long long val = read_arg(args).i;
+        switch (lengthmod) {
+        case FLEN_NORMAL:
+            return (unsigned)val;
+        case FLEN_HH:
+            return (unsigned char)val;
+        case FLEN_H:
+            return (unsigned short)val;
+        case FLEN_L:
+            return (unsigned long)val;
+        case FLEN_Z:
+            return (size_t)val;
+        case FLEN_T:
+            return (ptrdiff_t)val;
+        default:
+            return val;
+        }
+    }
+    va_list *ap = args->ap;
     switch (lengthmod) {
     case FLEN_NORMAL:
         return va_arg(*ap, unsigned);
@@ -144,6 +194,20 @@ static uintmax_t read_argu(int lengthmod, va_list *ap) {
     }
 }
 
+static double read_argf(struct console_args *restrict args) {
+    if (args->ap == NULL) {
+        return read_arg(args).f;
+    }
+    return va_arg(*args->ap, double);
+}
+
+static const void *read_argp(struct console_args *restrict args) {
+    if (args->ap == NULL) {
+        return read_arg(args).p;
+    }
+    return va_arg(*args->ap, const void *);
+}
+
 enum {
     PUTD_LEN = 27,
     PUTO_LEN = 22,
@@ -234,7 +298,7 @@ static void console_putpad(struct console *cs, int ch, int n) {
 }
 
 static const char *console_putitem(struct console *cs, const char *restrict fmt,
-                                   va_list *ap) {
+                                   struct console_args *restrict args) {
     if (*fmt == '%') {
         console_putc(cs, '%');
         return fmt + 1;
@@ -268,11 +332,12 @@ static const char *console_putitem(struct console *cs, const char *restrict fmt,
     // Parse field width.
 parse_width:
     if (*ptr == '*') {
-        width = va_arg(*ap, int);
+        width = read_argi(FLEN_NORMAL, args);
         if (width < 0) {
             width = -width;
             flags |= FMT_LEFTJUSTIFY;
         }
+        ptr++;
     } else if ('0' <= *ptr && *ptr <= '9') {
         int c = (unsigned char)*ptr;
         do {
@@ -287,7 +352,7 @@ parse_width:
         ptr++;
         int c = (unsigned char)*ptr;
         if (c == '*') {
-            precision = va_arg(*ap, int);
+            precision = read_argi(FLEN_NORMAL, args);
             if (precision < 0) {
                 flags &= ~FMT_HASPRECISION;
             }
@@ -348,7 +413,7 @@ parse_width:
     case 'd':
     case 'i': {
         flags |= FMT_INT;
-        intmax_t val = read_argi(lengthmod, ap);
+        intmax_t val = read_argi(lengthmod, args);
         uintmax_t uval = val;
         if (val < 0) {
             uval = ~uval + 1;
@@ -367,7 +432,7 @@ parse_width:
     //     break;
     case 'o': {
         flags |= FMT_INT;
-        uintmax_t val = read_argu(lengthmod, ap);
+        uintmax_t val = read_argu(lengthmod, args);
         puto(cbuf, val);
         cptr = cbuf;
         cend = cbuf + PUTO_LEN;
@@ -380,7 +445,7 @@ parse_width:
     } break;
     case 'u': {
         flags |= FMT_INT;
-        uintmax_t val = read_argu(lengthmod, ap);
+        uintmax_t val = read_argu(lengthmod, args);
         putd(cbuf, val);
         cptr = cbuf;
         cend = cbuf + PUTD_LEN;
@@ -388,7 +453,7 @@ parse_width:
     case 'x':
     case 'X': {
         flags |= FMT_INT;
-        uintmax_t val = read_argu(lengthmod, ap);
+        uintmax_t val = read_argu(lengthmod, args);
         const char *restrict hexdigit = HEX_DIGIT[c == 'X'];
         putx(cbuf, val >> 32, hexdigit);
         putx(cbuf + 8, val, hexdigit);
@@ -400,20 +465,20 @@ parse_width:
         }
     } break;
     case 'c': {
-        int cval = va_arg(*ap, int);
+        int cval = read_argi(FLEN_NORMAL, args);
         cbuf[0] = cval;
         cptr = cbuf;
         cend = cbuf + 1;
     } break;
     case 'p': {
-        void *pval = va_arg(*ap, void *);
+        const void *pval = read_argp(args);
         cbuf[0] = '$';
         putx(cbuf + 1, (uintptr_t)pval, HEX_DIGIT[0]);
         cptr = cbuf;
         cend = cbuf + 9;
     } break;
     case 's':
-        cptr = va_arg(*ap, const char *);
+        cptr = read_argp(args);
         if (cptr == NULL) {
             cptr = "(null)";
             cend = cptr + 6;
@@ -438,7 +503,7 @@ parse_width:
             double f;
             uint64_t i;
         } val;
-        val.f = va_arg(*ap, double);
+        val.f = read_argf(args);
         unsigned exponent = (unsigned)(val.i >> 52) & ((1u << 11) - 1);
         if ((val.i >> 63) != 0) {
             val.f = -val.f;
@@ -520,22 +585,36 @@ void console_printf(struct console *cs, const char *fmt, ...) {
     va_end(ap);
 }
 
-void console_vprintf(struct console *cs, const char *fmt, va_list ap) {
-    va_list aq;
-    va_copy(aq, ap);
+static void console_format(struct console *cs, const char *fmt,
+                           struct console_args *restrict args) {
     for (;;) {
         unsigned c = (unsigned char)*fmt++;
         if (c == '\0') {
             break;
         } else if (c == '%') {
-            fmt = console_putitem(cs, fmt, &aq);
+            fmt = console_putitem(cs, fmt, args);
         } else {
             console_putc(cs, c);
         }
     }
+}
+
+void console_vprintf(struct console *cs, const char *fmt, va_list ap) {
+    va_list aq;
+    va_copy(aq, ap);
+    console_format(cs, fmt, &(struct console_args){.ap = &aq});
     va_end(aq);
 }
 
+void console_aprintf(struct console *cs, const char *fmt,
+                     const union console_arg *args, int count) {
+    console_format(cs, fmt,
+                   &(struct console_args){
+                       .arg = args,
+                       .end = args + count,
+                   });
+}
+
 int console_rows(struct console *cs, struct console_rowptr *restrict rows) {
     int pos = cs->row;
     if (cs->ptr != cs->rowstart) {
@@ -35,6 +35,19 @@ void console_printf(struct console *cs, const char *fmt, ...)
 // Write a formatted string to the console.
 void console_vprintf(struct console *cs, const char *fmt, va_list ap);
 
+// An argument for console_aprintf. Integers, including characters, are stored
+// in i, floating-point numbers in f, and strings and pointers in p.
+union console_arg {
+    long long i;
+    double f;
+    const void *p;
+};
+
+// Write a formatted string to the console, taking the arguments from an array.
+// Missing arguments are zero.
+void console_aprintf(struct console *cs, const char *fmt,
+                     const union console_arg *args, int count);
+
 // Callback for fatal errors. This should be initialized once at program
 // startup. This is a function pointer in order to prevent backwards linking
 // dependencies.
@@ -0,0 +1,31 @@
+#include "base/console.h"
+
+#include "base/console_internal.h"
+#include "base/testlib/bench.h"
+#include "base/testlib/testlib.h"
+
+static struct console cs;
+
+// Print a line like the per-frame debug output, starting from an empty
+// console so the console never fills up.
+static void bench_printf(long count) {
+    for (long i = 0; i < count; i++) {
+        console_init(&cs, CONSOLE_TRUNCATE);
+        console_printf(&cs, "obj %ld: pos=%.3f,%.3f hp=%d %s\n", i,
+                       (double)i * 0.25, -1.5, (int)(i & 255), "ok");
+    }
+    bench_sink(cs);
+}
+
+static void bench_init(long count) {
+    for (long i = 0; i < count; i++) {
+        console_init(&cs, CONSOLE_TRUNCATE);
+    }
+    bench_sink(cs);
+}
+
+void test_main(void) {
+    // The cost of console_init is included in console_printf.
+    bench_run("console_init", bench_init);
+    bench_run("console_printf", bench_printf);
+}
@@ -63,6 +63,9 @@ void test_main(void) {
     test_printf("s = abcd1", "s = %.*s", (int)5, "abcd1234");
     test_printf("right [   abc]", "right [%6s]", "abc");
     test_printf("left [abc   ]", "left [%-6s]", "abc");
+    test_printf("star [  abc]", "star [%*s]", (int)5, "abc");
+    test_printf("star [abc  ]", "star [%-*s]", (int)5, "abc");
+    test_printf("star [abc  ]", "star [%*s]", (int)-5, "abc");
     test_printf("i = 000123", "i = %06d", 123);
     test_printf("i = 123456789", "i = %06d", 123456789);
     test_printf("i = -00123", "i = %06d", -123);
@@ -0,0 +1,7 @@
+#include "base/fastmath.h"
+
+float fast_sin_quadrant(float x, int n);
+float fast_sinf(float x);
+float fast_cosf(float x);
+float fast_atan2f(float y, float x);
+float fast_rsqrtf(float x);
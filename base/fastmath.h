@@ -0,0 +1,127 @@
+#pragma once
+
+// Fast approximations of math functions, for gameplay code where speed matters
+// more than the last few bits of precision. The error bounds below are checked
+// by fastmath_test.
+
+#include <math.h>
+#include <stdint.h>
+
+// Whether gameplay code uses the approximations. If 0, the fm_ functions call
+// the C library instead.
+#ifndef FASTMATH
+#define FASTMATH 1
+#endif
+
+// Compute sin(x + n * pi/2). The argument is reduced to the range [-pi/4, pi/4]
+// in two steps, so the error grows only slowly with |x|, and then the sine or
+// cosine is computed with a polynomial.
+inline float fast_sin_quadrant(float x, int n) {
+    // pi/2 is split into two parts. The first part has few enough bits that
+    // q * part1 is exact.
+    const float part1 = 1.5703125f, part2 = 4.83826794897e-4f;
+    float t = x * 0.636619772f; // 2/pi
+    int q = (int)(t < 0.0f ? t - 0.5f : t + 0.5f);
+    float r = (x - (float)q * part1) - (float)q * part2;
+    // Taylor series. The truncation error is below 2e-9 in this range.
+    const float s3 = -1.0f / 6.0f, s5 = 1.0f / 120.0f, s7 = -1.0f / 5040.0f,
+                s9 = 1.0f / 362880.0f;
+    const float c2 = -1.0f / 2.0f, c4 = 1.0f / 24.0f, c6 = -1.0f / 720.0f,
+                c8 = 1.0f / 40320.0f;
+    float r2 = r * r;
+    float s = r * (1.0f + r2 * (s3 + r2 * (s5 + r2 * (s7 + r2 * s9))));
+    float c = 1.0f + r2 * (c2 + r2 * (c4 + r2 * (c6 + r2 * c8)));
+    switch ((q + n) & 3) {
+    default:
+        return s;
+    case 1:
+        return c;
+    case 2:
+        return -s;
+    case 3:
+        return -c;
+    }
+}
+
+// Compute sin(x). The absolute error is at most 2e-7 for |x| <= 16.
+inline float fast_sinf(float x) {
+    return fast_sin_quadrant(x, 0);
+}
+
+// Compute cos(x). The absolute error is at most 2e-7 for |x| <= 16.
+inline float fast_cosf(float x) {
+    return fast_sin_quadrant(x, 1);
+}
+
+// Compute atan2(y, x), using the polynomial from Abramowitz and Stegun 4.4.49
+// after reducing the argument to [0, 1]. The absolute error is at most 1.2e-5.
+// Returns 0 if both arguments are 0.
+inline float fast_atan2f(float y, float x) {
+    const float ax = fabsf(x), ay = fabsf(y);
+    const float lo = ax < ay ? ax : ay, hi = ax < ay ? ay : ax;
+    if (hi == 0.0f) {
+        return 0.0f;
+    }
+    const float a1 = 0.9998660f, a3 = -0.3302995f, a5 = 0.1801410f,
+                a7 = -0.0851330f, a9 = 0.0208351f;
+    const float z = lo / hi, z2 = z * z;
+    float a = z * (a1 + z2 * (a3 + z2 * (a5 + z2 * (a7 + z2 * a9))));
+    if (ay > ax) {
+        a = 1.57079633f - a;
+    }
+    if (x < 0.0f) {
+        a = 3.14159265f - a;
+    }
+    return y < 0.0f ? -a : a;
+}
+
+// Compute 1/sqrt(x), for positive, finite x, using an initial estimate from
+// the bit representation and two Newton-Raphson steps. The relative error is at
+// most 5e-6.
+inline float fast_rsqrtf(float x) {
+    union {
+        float f;
+        uint32_t u;
+    } v = {.f = x};
+    v.u = 0x5f375a86 - (v.u >> 1);
+    float y = v.f;
+    const float hx = 0.5f * x;
+    y = y * (1.5f - hx * y * y);
+    y = y * (1.5f - hx * y * y);
+    return y;
+}
+
+// Functions for gameplay code, which can be switched to the C library by
+// defining FASTMATH to 0.
+
+static inline float fm_sinf(float x) {
+#if FASTMATH
+    return fast_sinf(x);
+#else
+    return sinf(x);
+#endif
+}
+
+static inline float fm_cosf(float x) {
+#if FASTMATH
+    return fast_cosf(x);
+#else
+    return cosf(x);
+#endif
+}
+
+static inline float fm_atan2f(float y, float x) {
+#if FASTMATH
+    return fast_atan2f(y, x);
+#else
+    return atan2f(y, x);
+#endif
+}
+
+static inline float fm_rsqrtf(float x) {
+#if FASTMATH
+    return fast_rsqrtf(x);
+#else
+    return 1.0f / sqrtf(x);
+#endif
+}
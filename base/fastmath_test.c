@@ -0,0 +1,80 @@
+#include "base/fastmath.h"
+
+#include "base/testlib/testlib.h"
+
+#include <math.h>
+
+// Check that the maximum error is within the documented bound.
+static void check_error(const char *name, double error, double bound) {
+    test_logf("%s: max error %.3g", name, error);
+    if (error > bound) {
+        test_logf("%s: error exceeds %.3g", name, bound);
+        test_fail();
+    }
+}
+
+static void test_sincos(void) {
+    test_start("sincos");
+    double sin_error = 0.0, cos_error = 0.0;
+    const int n = 1 << 20;
+    for (int i = -n; i <= n; i++) {
+        float x = (float)i * (16.0f / (float)n);
+        double s = fabs((double)fast_sinf(x) - sin((double)x));
+        double c = fabs((double)fast_cosf(x) - cos((double)x));
+        if (s > sin_error) {
+            sin_error = s;
+        }
+        if (c > cos_error) {
+            cos_error = c;
+        }
+    }
+    check_error("sin", sin_error, 2e-7);
+    check_error("cos", cos_error, 2e-7);
+}
+
+static void test_atan2(void) {
+    test_start("atan2");
+    double error = 0.0;
+    const int n = 1 << 20;
+    for (int i = 0; i < n; i++) {
+        double a = (double)i * (2.0 * M_PI / (double)n) - M_PI;
+        for (int j = 0; j < 3; j++) {
+            double r = j == 0 ? 1e-3 : j == 1 ? 1.0 : 1e3;
+            float y = (float)(r * sin(a)), x = (float)(r * cos(a));
+            double e = fabs((double)fast_atan2f(y, x) - atan2((double)y, x));
+            if (e > error) {
+                error = e;
+            }
+        }
+    }
+    check_error("atan2", error, 1.2e-5);
+    if (fast_atan2f(0.0f, 0.0f) != 0.0f) {
+        test_logf("atan2(0, 0) is not 0");
+        test_fail();
+    }
+}
+
+static void test_rsqrt(void) {
+    test_start("rsqrt");
+    double error = 0.0;
+    // Test two full octaves, which cover every exponent parity and mantissa.
+    const int n = 1 << 22;
+    for (int i = 0; i < n; i++) {
+        float x = 1.0f + (float)i * (3.0f / (float)n);
+        for (int j = 0; j < 3; j++) {
+            float xs = j == 0 ? x * 1e-6f : j == 1 ? x : x * 1e6f;
+            double expect = 1.0 / sqrt((double)xs);
+            double e = fabs((double)fast_rsqrtf(xs) - expect) / expect;
+            if (e > error) {
+                error = e;
+            }
+        }
+    }
+    check_error("rsqrt", error, 5e-6);
+}
+
+void test_main(void) {
+    test_sincos();
+    test_atan2();
+    test_rsqrt();
+}
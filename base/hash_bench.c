@@ -0,0 +1,19 @@
+#include "base/hash.h"
+
+#include "base/testlib/bench.h"
+#include "base/testlib/testlib.h"
+
+#include <stdint.h>
+
+// Each hash depends on the previous one, so this measures latency.
+static void bench_hash32(long count) {
+    uint32_t x = 0;
+    for (long i = 0; i < count; i++) {
+        x = hash32(x + (uint32_t)i);
+    }
+    bench_sink(x);
+}
+
+void test_main(void) {
+    bench_run("hash32", bench_hash32);
+}
@@ -0,0 +1,236 @@
+#include "base/heap.h"
+
+#include "base/base.h"
+
+#include <string.h>
+
+void heap_init(struct heap *restrict h, const char *name, void *data,
+               size_t size, int handle_count, unsigned latency) {
+    if (((uintptr_t)data & (HEAP_ALIGN - 1)) != 0) {
+        fatal_error("%s: unaligned heap\nPtr: %p", name, data);
+    }
+    // Each handle has a block, and each block can leave behind a region
+    // waiting to be released.
+    int block_max = handle_count * 2 + 4;
+    *h = (struct heap){
+        .name = name,
+        .data = data,
+        .size = size & ~(size_t)(HEAP_ALIGN - 1),
+        .block_max = block_max,
+        .block = mem_calloc(sizeof(*h->block) * block_max),
+        .handle_count = handle_count,
+        .handle = mem_calloc(sizeof(*h->handle) * (handle_count + 1)),
+        .latency = latency,
+    };
+}
+
+// Insert a region at the given index.
+static void heap_insert(struct heap *restrict h, int index,
+                        struct heap_block block) {
+    if (h->block_count >= h->block_max) {
+        fatal_error("%s: too many blocks", h->name);
+    }
+    memmove(h->block + index + 1, h->block + index,
+            sizeof(*h->block) * (h->block_count - index));
+    h->block[index] = block;
+    h->block_count++;
+}
+
+// Remove the region at the given index.
+static void heap_remove(struct heap *restrict h, int index) {
+    h->block_count--;
+    memmove(h->block + index, h->block + index + 1,
+            sizeof(*h->block) * (h->block_count - index));
+}
+
+// Return true if a block may still be in use by the RCP.
+static bool heap_recent(const struct heap *restrict h,
+                        const struct heap_handle *restrict hp) {
+    return h->frame - hp->last_use < h->latency;
+}
+
+void heap_set_frame(struct heap *restrict h, unsigned frame) {
+    h->frame = frame;
+    for (int i = 0; i < h->block_count;) {
+        const struct heap_block *restrict b = &h->block[i];
+        if (b->handle == 0 && (int)(frame - b->release) >= 0) {
+            heap_remove(h, i);
+        } else {
+            i++;
+        }
+    }
+}
+
+// Get a handle which is in use, or abort.
+static struct heap_handle *heap_handle(const struct heap *restrict h,
+                                       int handle) {
+    if (handle < 1 || h->handle_count < handle ||
+        h->handle[handle].size == 0) {
+        fatal_error("%s: invalid handle\nHandle: %d", h->name, handle);
+    }
+    return &h->handle[handle];
+}
+
+// Find the index of the region for a handle.
+static int heap_find(const struct heap *restrict h, int handle) {
+    uint32_t offset = h->handle[handle].offset;
+    int lo = 0, hi = h->block_count;
+    while (lo < hi) {
+        int mid = (lo + hi) >> 1;
+        if (h->block[mid].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo >= h->block_count || h->block[lo].handle != handle) {
+        fatal_error("%s: corrupt heap\nHandle: %d", h->name, handle);
+    }
+    return lo;
+}
+
+// Try to allocate a block without compacting.
+static int heap_alloc_fit(struct heap *restrict h, int handle,
+                          uint32_t size) {
+    uint32_t pos = 0;
+    for (int i = 0; i <= h->block_count; i++) {
+        uint32_t end = i < h->block_count ? h->block[i].offset : h->size;
+        if (end - pos >= size) {
+            heap_insert(h, i,
+                        (struct heap_block){
+                            .offset = pos,
+                            .size = size,
+                            .handle = handle,
+                        });
+            h->handle[handle] = (struct heap_handle){
+                .offset = pos,
+                .size = size,
+                .last_use = h->frame - h->latency,
+            };
+            if (pos + size > h->stats.high_water) {
+                h->stats.high_water = pos + size;
+            }
+            h->stats.alloc++;
+            return handle;
+        }
+        if (i < h->block_count) {
+            pos = h->block[i].offset + h->block[i].size;
+        }
+    }
+    return 0;
+}
+
+int heap_alloc(struct heap *restrict h, size_t size) {
+    if (size == 0 || size > h->size) {
+        return 0;
+    }
+    uint32_t asize = (size + HEAP_ALIGN - 1) & ~(uint32_t)(HEAP_ALIGN - 1);
+    int handle = 0;
+    for (int i = 1; i <= h->handle_count; i++) {
+        if (h->handle[i].size == 0) {
+            handle = i;
+            break;
+        }
+    }
+    if (handle == 0) {
+        fatal_error("%s: no free handles\nHandles: %d", h->name,
+                    h->handle_count);
+    }
+    if (heap_alloc_fit(h, handle, asize) != 0) {
+        return handle;
+    }
+    if (heap_free_size(h) < asize) {
+        return 0;
+    }
+    heap_compact(h, (size_t)-1);
+    return heap_alloc_fit(h, handle, asize);
+}
+
+void heap_free(struct heap *restrict h, int handle) {
+    if (handle == 0) {
+        return;
+    }
+    struct heap_handle *restrict hp = heap_handle(h, handle);
+    int index = heap_find(h, handle);
+    if (heap_recent(h, hp)) {
+        h->block[index].handle = 0;
+        h->block[index].release = hp->last_use + h->latency;
+    } else {
+        heap_remove(h, index);
+    }
+    hp->size = 0;
+}
+
+void *heap_use(struct heap *restrict h, int handle) {
+    struct heap_handle *restrict hp = heap_handle(h, handle);
+    hp->last_use = h->frame;
+    return h->data + hp->offset;
+}
+
+void *heap_get(const struct heap *restrict h, int handle) {
+    return h->data + heap_handle(h, handle)->offset;
+}
+
+size_t heap_compact(struct heap *restrict h, size_t budget) {
+    size_t moved = 0;
+    uint32_t pos = 0;
+    for (int i = 0; i < h->block_count; i++) {
+        struct heap_block *restrict b = &h->block[i];
+        uint32_t gap = b->offset - pos;
+        if (gap > 0 && b->handle != 0) {
+            struct heap_handle *restrict hp = &h->handle[b->handle];
+            bool recent = heap_recent(h, hp);
+            // A recently used block may be read by the RCP at its old
+            // location, so it can only be copied if it does not overlap,
+            // and the old location must be kept until the latency passes.
+            bool can_move = recent ? gap >= b->size &&
+                                         h->block_count < h->block_max
+                                   : true;
+            if (can_move) {
+                if (b->size > budget - moved) {
+                    break;
+                }
+                uint32_t old = b->offset;
+                memmove(h->data + pos, h->data + old, b->size);
+                b->offset = pos;
+                hp->offset = pos;
+                moved += b->size;
+                h->stats.moved++;
+                h->stats.moved_size += b->size;
+                if (recent) {
+                    heap_insert(h, i + 1,
+                                (struct heap_block){
+                                    .offset = old,
+                                    .size = b->size,
+                                    .release = hp->last_use + h->latency,
+                                });
+                    b = &h->block[i];
+                }
+            }
+        }
+        pos = b->offset + b->size;
+    }
+    return moved;
+}
+
+size_t heap_free_size(const struct heap *restrict h) {
+    size_t used = 0;
+    for (int i = 0; i < h->block_count; i++) {
+        used += h->block[i].size;
+    }
+    return h->size - used;
+}
+
+size_t heap_largest_free(const struct heap *restrict h) {
+    uint32_t pos = 0, largest = 0;
+    for (int i = 0; i <= h->block_count; i++) {
+        uint32_t end = i < h->block_count ? h->block[i].offset : h->size;
+        if (end - pos > largest) {
+            largest = end - pos;
+        }
+        if (i < h->block_count) {
+            pos = h->block[i].offset + h->block[i].size;
+        }
+    }
+    return largest;
+}
@@ -0,0 +1,103 @@
+// Compacting heap for variable-size assets.
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Blocks are referenced by handle, because compaction moves them. Pointers to
+// block data are only valid until the next call to heap_compact or heap_alloc.
+// Block data must be position-independent.
+//
+// The RCP may still be reading a block for a few frames after it was last
+// used. A block which was used recently is only moved if its new location
+// does not overlap the old one, and space freed by moving or freeing it is
+// not reused until the latency has passed.
+
+// A region of the heap, sorted by offset.
+struct heap_block {
+    uint32_t offset;
+    uint32_t size;
+    // Handle using this region, or zero if the region is waiting to be
+    // released.
+    int handle;
+    // For regions waiting to be released, the frame when they are released.
+    unsigned release;
+};
+
+// A handle to a block.
+struct heap_handle {
+    uint32_t offset;
+    uint32_t size;     // Zero if the handle is not in use.
+    unsigned last_use; // Frame when the block was last used.
+};
+
+// Heap statistics, since initialization.
+struct heap_stats {
+    unsigned alloc;      // Number of blocks allocated.
+    unsigned moved;      // Number of blocks moved by compaction.
+    uint32_t moved_size; // Number of bytes moved by compaction.
+    uint32_t high_water; // Highest end of a block.
+};
+
+// A compacting heap.
+struct heap {
+    const char *name;
+    uint8_t *data;
+    uint32_t size;
+
+    // Regions in use, sorted by offset. Free space is the space between
+    // regions.
+    int block_count;
+    int block_max;
+    struct heap_block *block;
+
+    // Handles. Handle zero is never used.
+    int handle_count;
+    struct heap_handle *handle;
+
+    // Current frame, and the number of frames after its last use that a block
+    // may still be in use by the RCP.
+    unsigned frame;
+    unsigned latency;
+
+    struct heap_stats stats;
+};
+
+enum {
+    // Alignment of blocks in the heap.
+    HEAP_ALIGN = 16,
+};
+
+// Initialize a heap using the given memory, which must be aligned to
+// HEAP_ALIGN. At most handle_count blocks can be allocated at once.
+void heap_init(struct heap *restrict h, const char *name, void *data,
+               size_t size, int handle_count, unsigned latency);
+
+// Set the current frame, and release regions whose latency has passed.
+// Frames should increase by one each time.
+void heap_set_frame(struct heap *restrict h, unsigned frame);
+
+// Allocate a block. If there is no free space large enough, this compacts the
+// heap as much as possible and tries again. Returns the handle, or zero if
+// there is not enough space.
+int heap_alloc(struct heap *restrict h, size_t size);
+
+// Free a block. Does nothing if the handle is zero.
+void heap_free(struct heap *restrict h, int handle);
+
+// Get a pointer to a block, and mark it as used in the current frame.
+void *heap_use(struct heap *restrict h, int handle);
+
+// Get a pointer to a block, without marking it as used.
+void *heap_get(const struct heap *restrict h, int handle);
+
+// Move blocks towards the start of the heap to merge free space, copying at
+// most the given number of bytes. Returns the number of bytes copied.
+size_t heap_compact(struct heap *restrict h, size_t budget);
+
+// Get the amount of free space, not including space waiting to be released.
+size_t heap_free_size(const struct heap *restrict h);
+
+// Get the size of the largest free region.
+size_t heap_largest_free(const struct heap *restrict h);
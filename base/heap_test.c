@@ -0,0 +1,162 @@
+#include "base/heap.h"
+
+#include "base/base.h"
+#include "base/testlib/testlib.h"
+
+#include <string.h>
+
+enum {
+    HEAP_SIZE = 1024,
+    HANDLES = 8,
+    LATENCY = 2,
+};
+
+static struct heap heap;
+static uint8_t heap_data[HEAP_SIZE] __attribute__((aligned(HEAP_ALIGN)));
+static unsigned frame;
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+static void init(void) {
+    frame = 100;
+    heap_init(&heap, "test", heap_data, sizeof(heap_data), HANDLES, LATENCY);
+    heap_set_frame(&heap, frame);
+}
+
+static void next_frame(void) {
+    heap_set_frame(&heap, ++frame);
+}
+
+// Allocate a block and fill it with a pattern.
+static int alloc(size_t size, int fill) {
+    int handle = heap_alloc(&heap, size);
+    if (handle == 0) {
+        test_logf("could not allocate %zu bytes", size);
+        test_fail();
+    }
+    uint8_t *ptr = heap_get(&heap, handle);
+    if (((uintptr_t)ptr & (HEAP_ALIGN - 1)) != 0) {
+        test_logf("unaligned block");
+        test_fail();
+    }
+    memset(ptr, fill, size);
+    return handle;
+}
+
+// Check that a block still contains its pattern.
+static void check_block(int handle, size_t size, int fill) {
+    const uint8_t *ptr = heap_get(&heap, handle);
+    for (size_t i = 0; i < size; i++) {
+        if (ptr[i] != fill) {
+            test_logf("handle %d: data corrupted at offset %zu", handle, i);
+            test_fail();
+        }
+    }
+}
+
+static int offset(int handle) {
+    return (uint8_t *)heap_get(&heap, handle) - heap_data;
+}
+
+static void test_alloc(void) {
+    test_start("alloc");
+    init();
+    int a = alloc(100, 1), b = alloc(200, 2), c = alloc(16, 3);
+    check_int("offset a", offset(a), 0);
+    check_int("offset b", offset(b), 112);
+    check_int("offset c", offset(c), 320);
+    check_int("free", heap_free_size(&heap), HEAP_SIZE - 336);
+    check_int("too large", heap_alloc(&heap, HEAP_SIZE), 0);
+    // Space from a free block is reused.
+    heap_free(&heap, b);
+    int d = alloc(64, 4);
+    check_int("offset d", offset(d), 112);
+    check_block(a, 100, 1);
+    check_block(c, 16, 3);
+}
+
+static void test_compact(void) {
+    test_start("compact");
+    init();
+    int a = alloc(256, 1), b = alloc(256, 2), c = alloc(256, 3);
+    heap_free(&heap, a);
+    heap_free(&heap, c);
+    check_int("largest", heap_largest_free(&heap), 512);
+    // The budget is too small to move anything.
+    check_int("moved", heap_compact(&heap, 255), 0);
+    check_int("moved", heap_compact(&heap, 256), 256);
+    check_int("offset b", offset(b), 0);
+    check_block(b, 256, 2);
+    check_int("largest", heap_largest_free(&heap), HEAP_SIZE - 256);
+    check_int("moved", heap_compact(&heap, 1024), 0);
+}
+
+static void test_alloc_compact(void) {
+    test_start("alloc_compact");
+    init();
+    int h[4];
+    for (int i = 0; i < 4; i++) {
+        h[i] = alloc(256, i + 1);
+    }
+    heap_free(&heap, h[0]);
+    heap_free(&heap, h[2]);
+    // There is enough space, but it is split in two.
+    int big = alloc(512, 9);
+    check_int("offset", offset(big), 512);
+    check_block(h[1], 256, 2);
+    check_block(h[3], 256, 4);
+    check_int("full", heap_alloc(&heap, 16), 0);
+}
+
+static void test_latency(void) {
+    test_start("latency");
+    init();
+    int a = alloc(256, 1), b = alloc(384, 2), c = alloc(384, 3);
+    heap_use(&heap, b);
+    heap_use(&heap, c);
+    heap_free(&heap, a);
+    // Block b is in use and would overlap its old location.
+    check_int("moved", heap_compact(&heap, 1024), 0);
+    next_frame();
+    check_int("moved", heap_compact(&heap, 1024), 0);
+    next_frame();
+    check_int("moved", heap_compact(&heap, 1024), 768);
+    check_int("offset b", offset(b), 0);
+    check_int("offset c", offset(c), 384);
+    check_block(b, 384, 2);
+
+    // A recently used block which does not overlap its new location is
+    // copied, and its old location is released later.
+    heap_free(&heap, b);
+    next_frame();
+    next_frame();
+    heap_use(&heap, c);
+    check_int("moved", heap_compact(&heap, 1024), 384);
+    check_int("offset c", offset(c), 0);
+    check_block(c, 384, 3);
+    check_int("free", heap_free_size(&heap), 256);
+    next_frame();
+    check_int("free", heap_free_size(&heap), 256);
+    next_frame();
+    check_int("free", heap_free_size(&heap), 640);
+
+    // Freeing a recently used block does not release its space immediately.
+    heap_use(&heap, c);
+    heap_free(&heap, c);
+    check_int("free", heap_free_size(&heap), 640);
+    next_frame();
+    next_frame();
+    check_int("free", heap_free_size(&heap), HEAP_SIZE);
+}
+
+void test_main(void) {
+    test_alloc();
+    test_compact();
+    test_alloc_compact();
+    test_latency();
+}
@@ -0,0 +1,84 @@
+#include "base/log.h"
+
+#include "base/base.h"
+#include "base/ticks.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0);
+
+// A logged message.
+struct log_record {
+    const char *fmt;
+    uint32_t time;
+    uint8_t level;
+    uint8_t count; // Number of arguments.
+    union console_arg arg[LOG_MAX_ARGS];
+};
+
+static struct log_record log_ring[LOG_RING_SIZE];
+
+// Sequence number of the next record.
+static unsigned log_pos;
+
+void log_write(log_level level, int count, const union console_arg *args) {
+    if (count > LOG_MAX_ARGS) {
+        count = LOG_MAX_ARGS;
+    }
+    struct log_record *restrict r = &log_ring[log_pos & (LOG_RING_SIZE - 1)];
+    log_pos++;
+    r->fmt = args[0].p;
+    r->time = ticks_now();
+    r->level = level;
+    r->count = count;
+    memcpy(r->arg, args + 1, sizeof(*args) * count);
+}
+
+unsigned log_position(void) {
+    return log_pos;
+}
+
+// Get the sequence number of the oldest record still in the ring.
+static unsigned log_oldest(void) {
+    return log_pos > LOG_RING_SIZE ? log_pos - LOG_RING_SIZE : 0;
+}
+
+void log_print(struct console *cs, unsigned start) {
+    unsigned oldest = log_oldest();
+    if ((int)(start - oldest) < 0) {
+        start = oldest;
+    }
+    for (unsigned i = start; i != log_pos; i++) {
+        const struct log_record *restrict r =
+            &log_ring[i & (LOG_RING_SIZE - 1)];
+        console_aprintf(cs, r->fmt, r->arg, r->count);
+    }
+}
+
+static const char LOG_LEVEL_CHAR[] = {
+    [LOG_LEVEL_DEBUG] = 'D',
+    [LOG_LEVEL_INFO] = 'I',
+    [LOG_LEVEL_WARN] = 'W',
+    [LOG_LEVEL_ERROR] = 'E',
+};
+
+void log_dump(struct console *cs, unsigned count) {
+    unsigned start = log_oldest();
+    if (log_pos - start > count) {
+        start = log_pos - count;
+    }
+    if (start == log_pos) {
+        return;
+    }
+    // Times are relative to the newest record, so they do not depend on when
+    // the clock wrapped around.
+    uint32_t now = log_ring[(log_pos - 1) & (LOG_RING_SIZE - 1)].time;
+    for (unsigned i = start; i != log_pos; i++) {
+        const struct log_record *restrict r =
+            &log_ring[i & (LOG_RING_SIZE - 1)];
+        double ms = (double)(now - r->time) * (1e3 / TICKS_RATE);
+        console_printf(cs, "%c -%.3f ", LOG_LEVEL_CHAR[r->level], ms);
+        console_aprintf(cs, r->fmt, r->arg, r->count);
+    }
+}
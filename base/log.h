@@ -0,0 +1,122 @@
+// Deferred logging to a ring buffer.
+#pragma once
+
+#include "base/console.h"
+
+// Logging a message records the format string, the raw arguments, and a
+// timestamp. Messages are only formatted when they are printed to a console.
+// The format string and any string arguments are stored as pointers, so they
+// must still be valid when the message is printed. Use string literals.
+//
+// Logging should only be done from the main thread.
+
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+} log_level;
+
+// Lowest level which is compiled in. Messages below this level are removed
+// at compile time, and their arguments are not evaluated.
+#ifndef LOG_LEVEL
+#ifdef NDEBUG
+#define LOG_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+enum {
+    // Maximum number of arguments after the format string.
+    LOG_MAX_ARGS = 7,
+
+    // Number of records in the ring buffer. Must be a power of two.
+    LOG_RING_SIZE = 64,
+};
+
+// Log a message. The arguments after the level are a printf format string and
+// its arguments. Arguments may be integers, floating-point numbers, strings,
+// or void pointers.
+#define LOG_DEBUG(...) LOG_WRITE(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_WRITE(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_WRITE(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_WRITE(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#define LOG_WRITE(level, ...)                                                \
+    do {                                                                     \
+        if ((level) >= LOG_LEVEL) {                                          \
+            log_write((level), LOG_NARG(__VA_ARGS__) - 1,                    \
+                      (const union console_arg[]){LOG_ARGS(__VA_ARGS__)});   \
+        }                                                                    \
+        if (0) {                                                             \
+            log_check_format(__VA_ARGS__);                                   \
+        }                                                                    \
+    } while (0)
+
+// Record a message. The first argument is the format string, followed by count
+// arguments. Use the LOG macros instead.
+void log_write(log_level level, int count, const union console_arg *args);
+
+// Get the sequence number of the next message to be logged.
+unsigned log_position(void);
+
+// Print the messages starting with the given sequence number to a console.
+// Messages which have already been overwritten are skipped.
+void log_print(struct console *cs, unsigned start);
+
+// Print the newest messages in the ring buffer to a console, with timestamps
+// and levels. At most count messages are printed. This is called by the crash
+// screen.
+void log_dump(struct console *cs, unsigned count);
+
+// Never called. Lets the compiler check the format string.
+__attribute__((format(printf, 1, 2))) static inline void log_check_format(
+    const char *fmt, ...) {
+    (void)fmt;
+}
+
+// Convert an argument to a console_arg.
+#define LOG_ARG(x)                      \
+    _Generic((x),                       \
+        float: log_arg_float,           \
+        double: log_arg_double,         \
+        long double: log_arg_double,    \
+        char *: log_arg_ptr,            \
+        const char *: log_arg_ptr,      \
+        void *: log_arg_ptr,            \
+        const void *: log_arg_ptr,      \
+        default: log_arg_int)(x)
+
+static inline union console_arg log_arg_int(long long x) {
+    return (union console_arg){.i = x};
+}
+
+static inline union console_arg log_arg_float(float x) {
+    return (union console_arg){.f = (double)x};
+}
+
+static inline union console_arg log_arg_double(double x) {
+    return (union console_arg){.f = x};
+}
+
+static inline union console_arg log_arg_ptr(const void *x) {
+    return (union console_arg){.p = x};
+}
+
+// Count the arguments, up to LOG_MAX_ARGS + 1.
+#define LOG_NARG(...) LOG_NARG_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARG_(a1, a2, a3, a4, a5, a6, a7, a8, n, ...) n
+
+// Convert each argument with LOG_ARG.
+#define LOG_ARGS(...) LOG_CAT(LOG_ARGS_, LOG_NARG(__VA_ARGS__))(__VA_ARGS__)
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+#define LOG_ARGS_1(a) LOG_ARG(a)
+#define LOG_ARGS_2(a, ...) LOG_ARG(a), LOG_ARGS_1(__VA_ARGS__)
+#define LOG_ARGS_3(a, ...) LOG_ARG(a), LOG_ARGS_2(__VA_ARGS__)
+#define LOG_ARGS_4(a, ...) LOG_ARG(a), LOG_ARGS_3(__VA_ARGS__)
+#define LOG_ARGS_5(a, ...) LOG_ARG(a), LOG_ARGS_4(__VA_ARGS__)
+#define LOG_ARGS_6(a, ...) LOG_ARG(a), LOG_ARGS_5(__VA_ARGS__)
+#define LOG_ARGS_7(a, ...) LOG_ARG(a), LOG_ARGS_6(__VA_ARGS__)
+#define LOG_ARGS_8(a, ...) LOG_ARG(a), LOG_ARGS_7(__VA_ARGS__)
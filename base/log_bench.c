@@ -0,0 +1,81 @@
+// Benchmark for deferred logging, compared with formatting to the console
+// immediately. Each frame logs the same messages as game_update and
+// time_update2.
+#include "base/log.h"
+
+#include "base/base.h"
+#include "base/console.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+enum {
+    // Minimum time to run each method, in nanoseconds.
+    MIN_TIME = 200 * 1000 * 1000,
+};
+
+static int64_t now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Values which change each frame.
+static float frame_dt;
+static int frame_beat;
+static float frame_subbeat;
+
+static void next_frame(long frame) {
+    frame_dt = 0.016f + (float)(frame & 7) * 0.001f;
+    frame_beat = (frame >> 4) & 3;
+    frame_subbeat = (float)(frame & 15) * (1.0f / 16.0f);
+}
+
+static void frame_cprintf(void) {
+    cprintf("dt = %.3f\n", (double)frame_dt);
+    cprintf("%d:%02d:%d:%04.2f\n", 1, 12, frame_beat + 1,
+            (double)frame_subbeat);
+}
+
+static void frame_log(void) {
+    LOG_DEBUG("dt = %.3f\n", (double)frame_dt);
+    LOG_DEBUG("%d:%02d:%d:%04.2f\n", 1, 12, frame_beat + 1,
+              (double)frame_subbeat);
+}
+
+static void frame_log_print(void) {
+    unsigned start = log_position();
+    frame_log();
+    log_print(&console, start);
+}
+
+static const struct {
+    const char *name;
+    void (*func)(void);
+} methods[] = {
+    {"cprintf", frame_cprintf},
+    {"log", frame_log},
+    {"log+print", frame_log_print},
+};
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    printf("%-10s %10s\n", "method", "ns/frame");
+    for (size_t i = 0; i < ARRAY_COUNT(methods); i++) {
+        int64_t start = now(), elapsed;
+        long frame = 0;
+        do {
+            for (int j = 0; j < 100; j++) {
+                next_frame(frame++);
+                console_init(&console, CONSOLE_TRUNCATE);
+                methods[i].func();
+            }
+            elapsed = now() - start;
+        } while (elapsed < MIN_TIME);
+        printf("%-10s %10.1f\n", methods[i].name,
+               (double)elapsed / (double)frame);
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Debug messages are compiled out of this test.
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+#include "base/log.h"
+
+#include "base/base.h"
+#include "base/console_internal.h"
+#include "base/testlib/testlib.h"
+
+#include <string.h>
+
+static struct console cs;
+
+// Check that the console contains the given lines.
+static void check_lines(const char *const *lines, int count) {
+    struct console_rowptr rows[CON_ROWS];
+    int nrows = console_rows(&cs, rows);
+    if (nrows != count) {
+        test_logf("got %d rows, expect %d", nrows, count);
+        test_fail();
+    }
+    for (int i = 0; i < nrows && i < count; i++) {
+        size_t len = rows[i].end - rows[i].start;
+        if (len != strlen(lines[i]) ||
+            memcmp(rows[i].start, lines[i], len) != 0) {
+            test_logf("row %d: got %s", i, quote_mem(rows[i].start, len));
+            test_logf("expect %s", quote_str(lines[i]));
+            test_fail();
+        }
+    }
+}
+
+static int side_effect;
+
+static int touch(void) {
+    side_effect++;
+    return side_effect;
+}
+
+static void test_print(void) {
+    test_start("print");
+    console_init(&cs, CONSOLE_TRUNCATE);
+    unsigned start = log_position();
+    float f = 0.25f;
+    LOG_INFO("int %d %u %x\n", -5, 7u, 255);
+    LOG_WARN("float %.3f %5.1f\n", (double)f, 12.5);
+    LOG_ERROR("str %s %c %lld %zu\n", "abc", 'x', -1ll, (size_t)9);
+    LOG_INFO("none\n");
+    LOG_DEBUG("debug %d\n", touch());
+    if (log_position() != start + 4) {
+        test_logf("got %u messages, expect 4", log_position() - start);
+        test_fail();
+    }
+    if (side_effect != 0) {
+        test_logf("debug message was evaluated");
+        test_fail();
+    }
+    log_print(&cs, start);
+    static const char *const lines[] = {
+        "int -5 7 ff",
+        "float 0.250  12.5",
+        "str abc x -1 9",
+        "none",
+    };
+    check_lines(lines, ARRAY_COUNT(lines));
+}
+
+static void test_wrap(void) {
+    test_start("wrap");
+    unsigned start = log_position();
+    for (int i = 0; i < LOG_RING_SIZE + 3; i++) {
+        LOG_INFO("%d\n", i);
+    }
+    // Only the newest messages are kept.
+    console_init(&cs, CONSOLE_TRUNCATE);
+    log_print(&cs, log_position() - 2);
+    static const char *const lines[] = {"65", "66"};
+    check_lines(lines, ARRAY_COUNT(lines));
+    console_init(&cs, CONSOLE_SCROLL);
+    log_print(&cs, start);
+    struct console_rowptr rows[CON_ROWS];
+    int nrows = console_rows(&cs, rows);
+    if (nrows < 1 || rows[nrows - 1].end - rows[nrows - 1].start != 2 ||
+        memcmp(rows[nrows - 1].start, "66", 2) != 0) {
+        test_logf("last row is not the newest message");
+        test_fail();
+    }
+}
+
+static void test_dump(void) {
+    test_start("dump");
+    LOG_ERROR("last %s\n", "message");
+    console_init(&cs, CONSOLE_SCROLL);
+    log_dump(&cs, LOG_RING_SIZE);
+    struct console_rowptr rows[CON_ROWS];
+    int nrows = console_rows(&cs, rows);
+    // Times are relative to the newest message.
+    const char *expect = "E -0.000 last message";
+    if (nrows < 1) {
+        test_logf("no rows");
+        test_fail();
+    }
+    size_t len = rows[nrows - 1].end - rows[nrows - 1].start;
+    if (len != strlen(expect) ||
+        memcmp(rows[nrows - 1].start, expect, len) != 0) {
+        test_logf("last row: got %s", quote_mem(rows[nrows - 1].start, len));
+        test_fail();
+    }
+}
+
+static void test_dump_count(void) {
+    test_start("dump_count");
+    LOG_INFO("a\n");
+    LOG_INFO("b\n");
+    LOG_INFO("c\n");
+    console_init(&cs, CONSOLE_TRUNCATE);
+    log_dump(&cs, 2);
+    struct console_rowptr rows[CON_ROWS];
+    int nrows = console_rows(&cs, rows);
+    if (nrows != 2) {
+        test_logf("got %d rows, expect 2", nrows);
+        test_fail();
+    }
+    static const char suffix[2] = {'b', 'c'};
+    for (int i = 0; i < nrows && i < 2; i++) {
+        if (rows[i].end == rows[i].start || rows[i].end[-1] != suffix[i]) {
+            test_logf("row %d: got %s", i,
+                      quote_mem(rows[i].start, rows[i].end - rows[i].start));
+            test_fail();
+        }
+    }
+    console_init(&cs, CONSOLE_TRUNCATE);
+    log_dump(&cs, 0);
+    if (console_rows(&cs, rows) != 0) {
+        test_logf("count 0 printed messages");
+        test_fail();
+    }
+}
+
+void test_main(void) {
+    test_print();
+    test_wrap();
+    test_dump();
+    test_dump_count();
+}
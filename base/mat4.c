@@ -1,5 +1,7 @@
 #include "base/mat4.h"
 
+#include <stddef.h>
+
 // Set the top 3x3 submatrix to contain the given rotation and scale.
 static void mat4_set_rotate_scale(mat4 *restrict out, quat rotation,
                                   float scale) {
@@ -52,6 +54,43 @@ void mat4_translate_rotate_scale(mat4 *restrict out, vec3 translation,
     out->v[15] = 1.0f;
 }
 
+// Convert two adjacent elements to fixed-point and store them in the given
+// word of the matrix.
+static inline void mat4_fixed_pair(mat4fixed *restrict out, int word, float a,
+                                   float b) {
+    const unsigned ea = (int)(a * 65536.0f), eb = (int)(b * 65536.0f);
+    out->v[word] = (ea & 0xffff0000) | (eb >> 16);
+    out->v[word + 8] = (ea << 16) | (eb & 0xffff);
+}
+
+void mat4_fixed_translate_rotate_scale(mat4fixed *restrict out, int count,
+                                       const vec3 *restrict translation,
+                                       const quat *restrict rotation,
+                                       const float *restrict scale) {
+    for (int i = 0; i < count; i++) {
+        // Only the rotation and scale elements are used, so the compiler can
+        // keep them in registers.
+        mat4 m;
+        mat4_set_rotate_scale(&m, rotation[i], scale != NULL ? scale[i] : 1.0f);
+        const vec3 t = translation[i];
+        mat4fixed *restrict o = &out[i];
+        mat4_fixed_pair(o, 0, m.v[0], m.v[1]);
+        mat4_fixed_pair(o, 1, m.v[2], 0.0f);
+        mat4_fixed_pair(o, 2, m.v[4], m.v[5]);
+        mat4_fixed_pair(o, 3, m.v[6], 0.0f);
+        mat4_fixed_pair(o, 4, m.v[8], m.v[9]);
+        mat4_fixed_pair(o, 5, m.v[10], 0.0f);
+        mat4_fixed_pair(o, 6, t.v[0], t.v[1]);
+        mat4_fixed_pair(o, 7, t.v[2], 1.0f);
+    }
+}
+
+void mat4_fixed(mat4fixed *restrict out, const mat4 *restrict in) {
+    for (int i = 0; i < 8; i++) {
+        mat4_fixed_pair(out, i, in->v[i * 2], in->v[i * 2 + 1]);
+    }
+}
+
 void mat4_perspective(mat4 *restrict out, float focalx, float focaly,
                       float near, float far, float scale) {
     *out = (mat4){{
@@ -6,6 +6,19 @@
 void mat4_translate_rotate_scale(mat4 *restrict out, vec3 translation,
                                  quat rotation, float scale);
 
+// Create fixed-point matrices which scale, rotate, and then translate, like
+// mat4_translate_rotate_scale followed by mat4_fixed. Each output matrix uses
+// the corresponding element of each input array. If scale is NULL, the scale
+// is 1. The result is identical to calling the non-batched functions.
+void mat4_fixed_translate_rotate_scale(mat4fixed *restrict out, int count,
+                                       const vec3 *restrict translation,
+                                       const quat *restrict rotation,
+                                       const float *restrict scale);
+
+// Convert a matrix to fixed-point, rounding toward zero. Elements must be at
+// least -32768 and less than 32768. This gives the same result as guMtxF2L.
+void mat4_fixed(mat4fixed *restrict out, const mat4 *restrict in);
+
 // Create a perspective projection matrix. The focal length for the X and Y
 // directions is given, where a focal length of 1.0 is defined to have a 90
 // degree field of view. The scale is multiplied into the entire matrix.
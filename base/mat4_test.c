@@ -0,0 +1,108 @@
+#include "base/mat4.h"
+
+#include "base/base.h"
+#include "base/quat.h"
+#include "base/random.h"
+#include "base/testlib/testlib.h"
+
+#include <stddef.h>
+#include <string.h>
+
+enum {
+    BATCH = 32,
+};
+
+// Get an element of a fixed-point matrix as a 16.16 value.
+static int fixed_element(const mat4fixed *restrict m, int i) {
+    unsigned hi = m->v[i >> 1], lo = m->v[8 + (i >> 1)];
+    if ((i & 1) == 0) {
+        hi >>= 16;
+        lo >>= 16;
+    }
+    return (int)(((hi & 0xffff) << 16) | (lo & 0xffff));
+}
+
+static void test_fixed(void) {
+    test_start("fixed");
+    mat4 m = {{
+        0.0f, 1.0f, -1.0f, 1.5f,            //
+        -0.25f, 32767.5f, -32768.0f, 0.75f, //
+        1e-6f, -1e-6f, 100.125f, -100.125f, //
+        2.0f, -3.0f, 0.5f, -0.5f,           //
+    }};
+    mat4fixed f;
+    mat4_fixed(&f, &m);
+    for (int i = 0; i < 16; i++) {
+        int expect = (int)(m.v[i] * 65536.0f);
+        int got = fixed_element(&f, i);
+        if (got != expect) {
+            test_logf("element %d: got 0x%08x, expect 0x%08x", i, got,
+                      expect);
+            test_fail();
+        }
+    }
+    // Check the word layout directly, for the first row.
+    static const unsigned expect[16] = {
+        [0] = 0x00000001, [1] = 0xffff0001, [8] = 0x00000000, [9] = 0x00008000,
+    };
+    for (int i = 0; i < 2; i++) {
+        if (f.v[i] != expect[i] || f.v[i + 8] != expect[i + 8]) {
+            test_logf("word %d: got 0x%08x 0x%08x, expect 0x%08x 0x%08x", i,
+                      f.v[i], f.v[i + 8], expect[i], expect[i + 8]);
+            test_fail();
+        }
+    }
+}
+
+static void check_batch(const vec3 *translation, const quat *rotation,
+                        const float *scale) {
+    mat4fixed batch[BATCH];
+    mat4_fixed_translate_rotate_scale(batch, BATCH, translation, rotation,
+                                      scale);
+    for (int i = 0; i < BATCH; i++) {
+        mat4 m;
+        mat4fixed expect;
+        mat4_translate_rotate_scale(&m, translation[i], rotation[i],
+                                    scale != NULL ? scale[i] : 1.0f);
+        mat4_fixed(&expect, &m);
+        if (memcmp(&batch[i], &expect, sizeof(expect)) != 0) {
+            for (int j = 0; j < 16; j++) {
+                int got = fixed_element(&batch[i], j),
+                    exp = fixed_element(&expect, j);
+                if (got != exp) {
+                    test_logf("matrix %d element %d: got 0x%08x, expect 0x%08x",
+                              i, j, got, exp);
+                }
+            }
+            test_fail();
+        }
+    }
+}
+
+static void test_batch(void) {
+    test_start("batch");
+    struct rand r;
+    rand_init(&r, 1234, 5678);
+    vec3 translation[BATCH];
+    quat rotation[BATCH];
+    float scale[BATCH];
+    for (int i = 0; i < BATCH; i++) {
+        for (int j = 0; j < 3; j++) {
+            translation[i].v[j] = rand_frange(&r, -2000.0f, 2000.0f);
+        }
+        rotation[i] = quat_angles((vec3){{
+            rand_frange(&r, -4.0f, 4.0f),
+            rand_frange(&r, -4.0f, 4.0f),
+            rand_frange(&r, -4.0f, 4.0f),
+        }});
+        // Include the fast path for a scale of 1.
+        scale[i] = i % 4 == 0 ? 1.0f : rand_frange(&r, 0.1f, 8.0f);
+    }
+    check_batch(translation, rotation, scale);
+    check_batch(translation, rotation, NULL);
+}
+
+void test_main(void) {
+    test_fixed();
+    test_batch();
+}
@@ -1,27 +1,110 @@
 #include "base/memory.h"
 #include "base/base.h"
+#include "base/console.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+static const char mem_tag_names[MEM_TAG_COUNT][8] = {
+    [MEM_TAG_OTHER] = "other",  [MEM_TAG_GRAPHICS] = "gfx",
+    [MEM_TAG_AUDIO] = "audio",  [MEM_TAG_ASSET] = "asset",
+    [MEM_TAG_TEXT] = "text",    [MEM_TAG_GAME] = "game",
+};
+
+// Tag for heap allocations.
+static mem_tag mem_current_tag;
+
+// Statistics for heap allocations by tag.
+static struct mem_stats mem_tag_stats_arr[MEM_TAG_COUNT];
+
+// Zones created by mem_zone_init, most recent first.
+static struct mem_zone *mem_zone_list;
+
+mem_tag mem_set_tag(mem_tag tag) {
+    if ((unsigned)tag >= MEM_TAG_COUNT) {
+        fatal_error("mem_set_tag: bad tag\nTag: %d", tag);
+    }
+    mem_tag prev = mem_current_tag;
+    mem_current_tag = tag;
+    return prev;
+}
+
+const struct mem_stats *mem_tag_stats(mem_tag tag) {
+    return &mem_tag_stats_arr[tag];
+}
+
+// Record a successful allocation.
+static void mem_stats_alloc(struct mem_stats *restrict st, size_t size) {
+    st->current += size;
+    if (st->current > st->high_water) {
+        st->high_water = st->current;
+    }
+    st->alloc_count++;
+}
+
+// Record a free.
+static void mem_stats_free(struct mem_stats *restrict st, size_t size) {
+    st->current -= size;
+}
+
+// Record a failed allocation.
+static void mem_stats_fail(struct mem_stats *restrict st, size_t size) {
+    if (size > st->largest_failed) {
+        st->largest_failed = size;
+    }
+}
 
 static noreturn void malloc_fail(size_t size) {
-    fatal_error("Out of memory\nSize: %zu", size);
+    mem_stats_fail(&mem_tag_stats_arr[mem_current_tag], size);
+    fatal_error("Out of memory\nSize: %zu\nTag: %s", size,
+                mem_tag_names[mem_current_tag]);
 }
 
 void mem_zone_init(struct mem_zone *restrict z, size_t size, const char *name) {
     uintptr_t base = (uintptr_t)mem_alloc(size);
+    bool listed = false;
+    for (struct mem_zone *p = mem_zone_list; p != NULL; p = p->next) {
+        if (p == z) {
+            listed = true;
+            break;
+        }
+    }
     *z = (struct mem_zone){
         .pos = base,
         .start = base,
         .end = base + size,
         .name = name,
+        .next = z->next,
     };
+    if (!listed) {
+        z->next = mem_zone_list;
+        mem_zone_list = z;
+    }
 }
 
-void *mem_zone_alloc(struct mem_zone *restrict z, size_t size) {
+void *mem_zone_try_alloc(struct mem_zone *restrict z, size_t size) {
     if (size == 0) {
         return NULL;
     }
-    size = (size + 15) & ~(size_t)15;
+    size_t asize = (size + 15) & ~(size_t)15;
     size_t rem = z->end - z->pos;
-    if (rem < size) {
+    if (rem < asize) {
+        mem_stats_fail(&z->stats, size);
+        return NULL;
+    }
+    uintptr_t ptr = z->pos;
+    z->pos = ptr + asize;
+    mem_stats_alloc(&z->stats, asize);
+    return (void *)ptr;
+}
+
+void *mem_zone_alloc(struct mem_zone *restrict z, size_t size) {
+    if (size == 0) {
+        return NULL;
+    }
+    void *ptr = mem_zone_try_alloc(z, size);
+    if (ptr == NULL) {
+        size = (size + 15) & ~(size_t)15;
         fatal_error(
             "mem_zone_alloc failed\n"
             "Alloc size: %zu\n"
@@ -31,14 +114,48 @@ void *mem_zone_alloc(struct mem_zone *restrict z, size_t size) {
             size, z->name, (size_t)(z->end - z->start),
             (size_t)(z->pos + size - z->start));
     }
-    uintptr_t ptr = z->pos;
-    z->pos = ptr + size;
-    return (void *)ptr;
+    return ptr;
 }
 
-#if _ULTRA64
+struct mem_mark mem_zone_mark(const struct mem_zone *restrict z) {
+    return (struct mem_mark){z->pos};
+}
 
-#include <string.h>
+void mem_zone_release(struct mem_zone *restrict z, struct mem_mark mark) {
+    if (mark.pos < z->start || z->pos < mark.pos) {
+        fatal_error(
+            "mem_zone_release: bad mark\n"
+            "Zone: %s\n"
+            "Mark: %zu\n"
+            "Used: %zu",
+            z->name, (size_t)(mark.pos - z->start),
+            (size_t)(z->pos - z->start));
+    }
+#ifndef NDEBUG
+    memset((void *)mark.pos, MEM_POISON, z->pos - mark.pos);
+#endif
+    z->pos = mark.pos;
+    z->stats.current = z->pos - z->start;
+}
+
+void mem_zone_reset(struct mem_zone *restrict z) {
+    mem_zone_release(z, (struct mem_mark){z->start});
+}
+
+void mem_frame_init(struct mem_frame *restrict f, size_t size,
+                    const char *name) {
+    for (int i = 0; i < 2; i++) {
+        mem_zone_init(&f->zone[i], size, name);
+    }
+}
+
+struct mem_zone *mem_frame_begin(struct mem_frame *restrict f, int task) {
+    struct mem_zone *restrict z = &f->zone[task];
+    mem_zone_reset(z);
+    return z;
+}
+
+#if _ULTRA64
 
 enum {
     // Memory allocation alignment.
@@ -98,6 +215,8 @@ void *mem_alloc(size_t size) {
 
     void *ptr = (void *)best_zone->pos;
     best_zone->pos += asize;
+    mem_stats_alloc(&best_zone->stats, asize);
+    mem_stats_alloc(&mem_tag_stats_arr[mem_current_tag], asize);
     return ptr;
 }
 
@@ -107,6 +226,54 @@ void *mem_calloc(size_t size) {
     return ptr;
 }
 
+void *mem_alloc_temp(size_t size) {
+    if (size == 0) {
+        return NULL;
+    }
+    size_t asize = align_up(size);
+
+    if (mem_heap == NULL) {
+        fatal_error("No heap");
+    }
+
+    // Use the zone with the most space, so later heap allocations are less
+    // likely to fail.
+    struct mem_zone *best_zone = NULL;
+    size_t best_avail = 0;
+    for (struct mem_zone *z = mem_heap; z->pos != 0; z++) {
+        uintptr_t avail = z->end - z->pos;
+        if (asize <= avail && avail >= best_avail) {
+            best_zone = z;
+            best_avail = avail;
+        }
+    }
+
+    if (best_zone == NULL) {
+        malloc_fail(size);
+    }
+
+    best_zone->end -= asize;
+    mem_stats_alloc(&best_zone->stats, asize);
+    mem_stats_alloc(&mem_tag_stats_arr[mem_current_tag], asize);
+    return (void *)best_zone->end;
+}
+
+void mem_free_temp(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+    size_t asize = align_up(size);
+    for (struct mem_zone *z = mem_heap; z->pos != 0; z++) {
+        if (z->end == (uintptr_t)ptr) {
+            z->end += asize;
+            mem_stats_free(&z->stats, asize);
+            mem_stats_free(&mem_tag_stats_arr[mem_current_tag], asize);
+            return;
+        }
+    }
+    fatal_error("mem_free_temp: not the most recent allocation");
+}
+
 #else
 
 #include <stdlib.h>
@@ -119,6 +286,7 @@ void *mem_alloc(size_t size) {
     if (ptr == NULL) {
         malloc_fail(size);
     }
+    mem_stats_alloc(&mem_tag_stats_arr[mem_current_tag], size);
     return ptr;
 }
 
@@ -130,7 +298,43 @@ void *mem_calloc(size_t size) {
     if (ptr == NULL) {
         malloc_fail(size);
     }
+    mem_stats_alloc(&mem_tag_stats_arr[mem_current_tag], size);
     return ptr;
 }
 
+void *mem_alloc_temp(size_t size) {
+    return mem_alloc(size);
+}
+
+void mem_free_temp(void *ptr, size_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+    free(ptr);
+    mem_stats_free(&mem_tag_stats_arr[mem_current_tag], size);
+}
+
+#endif
+
+// Print the statistics for one zone or tag.
+static void mem_report_line(const char *name, const struct mem_stats *st,
+                            size_t size) {
+    cprintf("%-6.6s %6zu %6zu %6zu %4u %zu\n", name, st->current,
+            st->high_water, size, st->alloc_count, st->largest_failed);
+}
+
+void mem_report(void) {
+    cprintf("%-6s %6s %6s %6s %4s %s\n", "Memory", "Used", "High", "Size",
+            "Cnt", "Fail");
+#if _ULTRA64
+    for (struct mem_zone *z = mem_heap; z != NULL && z->pos != 0; z++) {
+        mem_report_line(z->name, &z->stats, z->end - z->start);
+    }
 #endif
+    for (struct mem_zone *z = mem_zone_list; z != NULL; z = z->next) {
+        mem_report_line(z->name, &z->stats, z->end - z->start);
+    }
+    for (int i = 0; i < MEM_TAG_COUNT; i++) {
+        mem_report_line(mem_tag_names[i], &mem_tag_stats_arr[i], 0);
+    }
+}
@@ -3,20 +3,109 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// Memory usage statistics.
+struct mem_stats {
+    size_t current;        // Number of bytes allocated.
+    size_t high_water;     // Highest number of bytes allocated.
+    unsigned alloc_count;  // Number of allocations.
+    size_t largest_failed; // Largest allocation which failed, or zero.
+};
+
 // A contiguous zone where memory can be allocated.
 struct mem_zone {
     uintptr_t pos;
     uintptr_t start;
     uintptr_t end;
     const char *name;
+    struct mem_stats stats;
+    // Next zone in the list of zones created by mem_zone_init.
+    struct mem_zone *next;
 };
 
+// Subsystems which allocate memory. Allocations from the heap are tagged with
+// the current tag, set by mem_set_tag.
+typedef enum {
+    MEM_TAG_OTHER,
+    MEM_TAG_GRAPHICS,
+    MEM_TAG_AUDIO,
+    MEM_TAG_ASSET,
+    MEM_TAG_TEXT,
+    MEM_TAG_GAME,
+    MEM_TAG_COUNT,
+} mem_tag;
+
+// Set the tag for subsequent allocations from the heap, by mem_alloc,
+// mem_calloc, and mem_zone_init. Returns the previous tag.
+mem_tag mem_set_tag(mem_tag tag);
+
+// Get the statistics for heap allocations with the given tag.
+const struct mem_stats *mem_tag_stats(mem_tag tag);
+
 // Allocate a memory zone with the given size and name.
 void mem_zone_init(struct mem_zone *restrict z, size_t size, const char *name);
 
-// Allocate an object from the given zone.
+// Allocate an object from the given zone. These are not marked as malloc,
+// because the same memory is returned again after the zone is released or
+// reset.
 void *mem_zone_alloc(struct mem_zone *restrict z, size_t size)
-    __attribute__((malloc, alloc_size(2), warn_unused_result));
+    __attribute__((alloc_size(2), warn_unused_result));
+
+// Allocate an object from the given zone, or return NULL if there is not
+// enough space. Failures are recorded in the zone statistics.
+void *mem_zone_try_alloc(struct mem_zone *restrict z, size_t size)
+    __attribute__((alloc_size(2), warn_unused_result));
+
+// A position in a memory zone. Objects allocated after the mark can be
+// released together.
+struct mem_mark {
+    uintptr_t pos;
+};
+
+// Get the current position in a zone.
+struct mem_mark mem_zone_mark(const struct mem_zone *restrict z);
+
+// Release all objects allocated from a zone since the mark was taken. In debug
+// builds, the released memory is filled with MEM_POISON.
+void mem_zone_release(struct mem_zone *restrict z, struct mem_mark mark);
+
+// Release all objects allocated from a zone.
+void mem_zone_reset(struct mem_zone *restrict z);
+
+enum {
+    // Byte value written to released memory in debug builds.
+    MEM_POISON = 0xa5,
+};
+
+// A pair of zones for transient data built each frame, which the RCP may read
+// until the graphics task for that frame finishes. Each graphics task uses one
+// zone, and the zone is reset when the task's resources are released.
+struct mem_frame {
+    struct mem_zone zone[2];
+};
+
+// Allocate a pair of frame zones, each with the given size.
+void mem_frame_init(struct mem_frame *restrict f, size_t size,
+                    const char *name);
+
+// Reset and return the zone for a graphics task. The previous task using the
+// zone must have finished.
+struct mem_zone *mem_frame_begin(struct mem_frame *restrict f, int task);
+
+// Allocate temporary memory from the top of the heap, so it can be freed
+// without freeing anything allocated by mem_alloc in the meantime. Temporary
+// allocations are tagged like heap allocations, and must be freed in the
+// reverse order they were made. If not enough memory is available, this calls
+// fatal_error.
+void *mem_alloc_temp(size_t size)
+    __attribute__((malloc, alloc_size(1), warn_unused_result));
+
+// Free the most recent temporary allocation, which has the given size. The
+// current tag must be the same as when it was allocated.
+void mem_free_temp(void *ptr, size_t size);
+
+// Print memory usage for each heap zone, each zone created by mem_zone_init,
+// and each tag to the console.
+void mem_report(void);
 
 // Initialize the memory subsystem. The zones are terminated by a zone filled
 // with zeroes. The zones are owned by the memory subsystem, and will be
@@ -0,0 +1,204 @@
+#include "base/memory.h"
+
+#include "base/base.h"
+#include "base/console.h"
+#include "base/console_internal.h"
+#include "base/testlib/testlib.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+// Get the number of bytes used in a zone.
+static int zone_used(const struct mem_zone *restrict z) {
+    return z->pos - z->start;
+}
+
+// Check that memory is filled with the poison value, in debug builds.
+static void check_poison(const void *ptr, size_t size) {
+#ifndef NDEBUG
+    const unsigned char *p = ptr;
+    for (size_t i = 0; i < size; i++) {
+        if (p[i] != MEM_POISON) {
+            test_logf("released memory not poisoned at offset %zu", i);
+            test_fail();
+        }
+    }
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
+
+// Zones are listed for mem_report, so they must not be on the stack.
+static struct mem_zone z;
+
+static void test_mark(void) {
+    test_start("mark");
+    mem_zone_init(&z, 1024, "test");
+    void *a = mem_zone_alloc(&z, 100);
+    check_int("used", zone_used(&z), 112);
+    struct mem_mark mark = mem_zone_mark(&z);
+    void *b = mem_zone_alloc(&z, 200);
+    memset(b, 0, 200);
+    struct mem_mark inner = mem_zone_mark(&z);
+    void *c = mem_zone_alloc(&z, 16);
+    memset(c, 0, 16);
+    mem_zone_release(&z, inner);
+    check_int("used", zone_used(&z), 320);
+    check_poison(c, 16);
+    mem_zone_release(&z, mark);
+    check_int("used", zone_used(&z), 112);
+    check_poison(b, 208);
+    // Released memory is reused.
+    void *d = mem_zone_alloc(&z, 50);
+    if (d != b) {
+        test_logf("released memory not reused");
+        test_fail();
+    }
+    mem_zone_reset(&z);
+    check_int("used", zone_used(&z), 0);
+    if (mem_zone_alloc(&z, 16) != a) {
+        test_logf("reset zone not reused");
+        test_fail();
+    }
+}
+
+static void test_frame(void) {
+    test_start("frame");
+    static struct mem_frame f;
+    mem_frame_init(&f, 256, "frame");
+    struct mem_zone *z0 = mem_frame_begin(&f, 0);
+    unsigned char *p0 = mem_zone_alloc(z0, 64);
+    memset(p0, 1, 64);
+    struct mem_zone *z1 = mem_frame_begin(&f, 1);
+    unsigned char *p1 = mem_zone_alloc(z1, 128);
+    memset(p1, 2, 128);
+    // Starting the next frame for task 0 leaves task 1's data alone.
+    z0 = mem_frame_begin(&f, 0);
+    check_int("used 0", zone_used(z0), 0);
+    check_int("used 1", zone_used(z1), 128);
+    check_poison(p0, 64);
+    for (int i = 0; i < 128; i++) {
+        if (p1[i] != 2) {
+            test_logf("data for other task modified");
+            test_fail();
+        }
+    }
+    check_int("alloc", (unsigned char *)mem_zone_alloc(z0, 256) - p0, 0);
+}
+
+static void check_stats(const char *what, const struct mem_stats *restrict st,
+                        size_t current, size_t high_water, unsigned alloc_count,
+                        size_t largest_failed) {
+    if (st->current != current || st->high_water != high_water ||
+        st->alloc_count != alloc_count ||
+        st->largest_failed != largest_failed) {
+        test_logf(
+            "%s: got current=%zu high_water=%zu alloc_count=%u "
+            "largest_failed=%zu, expect %zu %zu %u %zu",
+            what, st->current, st->high_water, st->alloc_count,
+            st->largest_failed, current, high_water, alloc_count,
+            largest_failed);
+        test_fail();
+    }
+}
+
+static void test_stats(void) {
+    test_start("stats");
+    mem_zone_init(&z, 256, "stats");
+    check_stats("init", &z.stats, 0, 0, 0, 0);
+    struct mem_mark mark = mem_zone_mark(&z);
+    void *a = mem_zone_alloc(&z, 100);
+    void *b = mem_zone_alloc(&z, 20);
+    (void)a;
+    (void)b;
+    check_stats("alloc", &z.stats, 144, 144, 2, 0);
+    if (mem_zone_try_alloc(&z, 200) != NULL) {
+        test_logf("allocation should fail");
+        test_fail();
+    }
+    if (mem_zone_try_alloc(&z, 150) != NULL) {
+        test_logf("allocation should fail");
+        test_fail();
+    }
+    check_stats("fail", &z.stats, 144, 144, 2, 200);
+    mem_zone_release(&z, mark);
+    void *c = mem_zone_alloc(&z, 16);
+    (void)c;
+    check_stats("release", &z.stats, 16, 144, 3, 200);
+}
+
+static void test_tags(void) {
+    test_start("tags");
+    struct mem_stats audio = *mem_tag_stats(MEM_TAG_AUDIO);
+    struct mem_stats game = *mem_tag_stats(MEM_TAG_GAME);
+    mem_tag prev = mem_set_tag(MEM_TAG_AUDIO);
+    void *a = mem_alloc(1000);
+    void *b = mem_calloc(24);
+    check_int("previous", mem_set_tag(MEM_TAG_GAME), MEM_TAG_AUDIO);
+    void *c = mem_alloc(8);
+    mem_set_tag(prev);
+    check_int("audio", mem_tag_stats(MEM_TAG_AUDIO)->current - audio.current,
+              1024);
+    check_int("audio count",
+              mem_tag_stats(MEM_TAG_AUDIO)->alloc_count - audio.alloc_count, 2);
+    check_int("game", mem_tag_stats(MEM_TAG_GAME)->current - game.current, 8);
+    free(a);
+    free(b);
+    free(c);
+}
+
+static void test_temp(void) {
+    test_start("temp");
+    struct mem_stats game = *mem_tag_stats(MEM_TAG_GAME);
+    mem_tag prev = mem_set_tag(MEM_TAG_GAME);
+    void *a = mem_alloc_temp(500);
+    void *b = mem_alloc_temp(100);
+    memset(a, 0, 500);
+    memset(b, 0, 100);
+    check_int("current", mem_tag_stats(MEM_TAG_GAME)->current - game.current,
+              600);
+    mem_free_temp(b, 100);
+    mem_free_temp(a, 500);
+    check_int("freed", mem_tag_stats(MEM_TAG_GAME)->current - game.current, 0);
+    check_int("high water",
+              mem_tag_stats(MEM_TAG_GAME)->high_water - game.current >= 600,
+              1);
+    mem_set_tag(prev);
+}
+
+static void test_report(void) {
+    test_start("report");
+    console_init(&console, CONSOLE_TRUNCATE);
+    mem_report();
+    struct console_rowptr rows[CON_ROWS];
+    int n = console_rows(&console, rows);
+    bool found = false;
+    for (int i = 0; i < n; i++) {
+        if (rows[i].end - rows[i].start >= 5 &&
+            memcmp(rows[i].start, "stats", 5) == 0) {
+            found = true;
+        }
+    }
+    if (!found) {
+        test_logf("zone missing from report");
+        test_fail();
+    }
+}
+
+void test_main(void) {
+    test_mark();
+    test_frame();
+    test_stats();
+    test_tags();
+    test_temp();
+    test_report();
+}
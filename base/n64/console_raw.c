@@ -0,0 +1,165 @@
+#include "base/n64/console_raw.h"
+
+#define INCLUDE_FONT_DATA 1
+
+#include "base/base.h"
+#include "base/console_internal.h"
+
+#include <stdint.h>
+
+// Glyphs are drawn in pairs. Two glyph rows are 12 pixels, which are written
+// as three 64-bit words, each containing four pixels.
+static_assert(FONT_WIDTH == 6);
+static_assert((CON_WIDTH * 2) % 8 == 0);
+static_assert((CON_XMARGIN * 2) % 8 == 0);
+
+// Framebuffer words. These alias the 16-bit pixels.
+typedef uint64_t __attribute__((may_alias)) console_word;
+typedef uint32_t __attribute__((may_alias)) console_word32;
+
+enum {
+    // Framebuffer row size, in 64-bit words.
+    CON_STRIDE = CON_WIDTH / 4,
+};
+
+// Mask for one pixel in a 64-bit word. Pixel 0 is at the lowest address.
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define PIXEL(x) ((uint64_t)0xffff << (48 - 16 * (x)))
+#else
+#define PIXEL(x) ((uint64_t)0xffff << (16 * (x)))
+#endif
+
+#define MASK(n)                                               \
+    (((n) & 1 ? PIXEL(0) : 0) | ((n) & 2 ? PIXEL(1) : 0) |    \
+     ((n) & 4 ? PIXEL(2) : 0) | ((n) & 8 ? PIXEL(3) : 0))
+
+// Pixel masks for four bits of font data. The lowest bit is the leftmost pixel,
+// the same as in the font.
+static const uint64_t CONSOLE_MASK[16] = {
+    MASK(0),  MASK(1),  MASK(2),  MASK(3),  MASK(4),  MASK(5),
+    MASK(6),  MASK(7),  MASK(8),  MASK(9),  MASK(10), MASK(11),
+    MASK(12), MASK(13), MASK(14), MASK(15),
+};
+
+// Mask for the last two pixels of a glyph, which are written as a 32-bit word.
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define PIXEL32(x) ((uint32_t)0xffff << (16 - 16 * (x)))
+#else
+#define PIXEL32(x) ((uint32_t)0xffff << (16 * (x)))
+#endif
+
+static const uint32_t CONSOLE_MASK32[4] = {
+    0,
+    PIXEL32(0),
+    PIXEL32(1),
+    PIXEL32(0) | PIXEL32(1),
+};
+
+#undef PIXEL
+#undef PIXEL32
+#undef MASK
+
+// A character, ready to draw. Each pixel is bg ^ (mask & fgbg), where mask is
+// set for pixels in the glyph.
+struct console_glyph {
+    unsigned offset; // Offset of glyph in FONT_DATA.
+    uint64_t bg;     // Background color, in all four pixels.
+    uint64_t fgbg;   // Foreground color XOR background color.
+};
+
+static struct console_glyph console_glyph(unsigned c) {
+    const uint64_t rep = 0x0001000100010001;
+    if (FONT_START <= c && c < FONT_END) {
+        return (struct console_glyph){
+            .offset = (c - FONT_START) * FONT_HEIGHT,
+            .bg = 0,
+            .fgbg = rep * 0xffff,
+        };
+    }
+    // Characters outside the font are drawn as a gray box.
+    return (struct console_glyph){
+        .offset = 0,
+        .bg = rep * 0x7bdf,
+        .fgbg = 0,
+    };
+}
+
+// Draw the characters in one console row.
+static void console_draw_row(uint16_t *restrict framebuffer, int row,
+                             const uint8_t *restrict ptr, int len) {
+    int offset = (CON_YMARGIN + row * FONT_HEIGHT) * CON_WIDTH + CON_XMARGIN;
+    console_word *restrict optr = (console_word *)(framebuffer + offset);
+    int col = 0;
+    for (; col + 2 <= len; col += 2, optr += 3) {
+        struct console_glyph g0 = console_glyph(ptr[col]),
+                             g1 = console_glyph(ptr[col + 1]);
+        // The middle word has two pixels from each glyph.
+        const uint64_t bgm =
+            (g0.bg & CONSOLE_MASK[3]) | (g1.bg & CONSOLE_MASK[12]);
+        const uint64_t fgbgm =
+            (g0.fgbg & CONSOLE_MASK[3]) | (g1.fgbg & CONSOLE_MASK[12]);
+        console_word *restrict rptr = optr;
+        for (int y = 0; y < FONT_HEIGHT; y++, rptr += CON_STRIDE) {
+            unsigned bits = FONT_DATA[g0.offset + y] |
+                            (FONT_DATA[g1.offset + y] << FONT_WIDTH);
+            rptr[0] = g0.bg ^ (CONSOLE_MASK[bits & 15] & g0.fgbg);
+            rptr[1] = bgm ^ (CONSOLE_MASK[(bits >> 4) & 15] & fgbgm);
+            rptr[2] = g1.bg ^ (CONSOLE_MASK[bits >> 8] & g1.fgbg);
+        }
+    }
+    if (col < len) {
+        struct console_glyph g = console_glyph(ptr[col]);
+        const uint32_t bg32 = g.bg, fgbg32 = g.fgbg;
+        console_word *restrict rptr = optr;
+        for (int y = 0; y < FONT_HEIGHT; y++, rptr += CON_STRIDE) {
+            unsigned bits = FONT_DATA[g.offset + y];
+            rptr[0] = g.bg ^ (CONSOLE_MASK[bits & 15] & g.fgbg);
+            *(console_word32 *)(rptr + 1) =
+                bg32 ^ (CONSOLE_MASK32[(bits >> 4) & 3] & fgbg32);
+        }
+    }
+}
+
+void console_draw_raw(struct console *cs, uint16_t *restrict framebuffer) {
+    struct console_rowptr rows[CON_ROWS];
+    int nrows = console_rows(cs, rows);
+    // This border is here because otherwise we might see a previous crash
+    // message underneath, which is confusing. The code is complicated so no
+    // pixel will change color, which would cause flickering.
+    {
+        const unsigned border_color = 0xf801;
+        int rlens[CON_ROWS + 2];
+        rlens[0] = 0;
+        for (int row = 0; row < nrows; row++) {
+            rlens[row + 1] = rows[row].end - rows[row].start;
+        }
+        rlens[nrows + 1] = 0;
+        for (int row = 0; row < nrows; row++) {
+            const int len0 = rlens[row];
+            const int len1 = rlens[row + 1];
+            int len2 = rlens[row + 2];
+            const int x0 = CON_XMARGIN - 1;
+            const int x1 = x0 + len1 * FONT_WIDTH + 1;
+            const int y0 = CON_YMARGIN + row * FONT_HEIGHT - 1;
+            const int y1 = y0 + FONT_HEIGHT + 1;
+            if (len1 > len0) {
+                for (int x = CON_XMARGIN + len0 * FONT_WIDTH; x < x1; x++) {
+                    framebuffer[y0 * CON_WIDTH + x] = border_color;
+                }
+            }
+            for (int y = y0 + 1; y < y1; y++) {
+                framebuffer[y * CON_WIDTH + x0] = border_color;
+                framebuffer[y * CON_WIDTH + x1] = border_color;
+            }
+            if (len1 > len2) {
+                for (int x = CON_XMARGIN + len2 * FONT_WIDTH; x < x1; x++) {
+                    framebuffer[y1 * CON_WIDTH + x] = border_color;
+                }
+            }
+        }
+    }
+    for (int row = 0; row < nrows; row++) {
+        console_draw_row(framebuffer, row, rows[row].start,
+                         rows[row].end - rows[row].start);
+    }
+}
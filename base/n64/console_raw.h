@@ -0,0 +1,11 @@
+// Drawing the debugging console to a framebuffer with the CPU. This does not
+// depend on libultra, so it can be tested on the host.
+#pragma once
+
+#include <stdint.h>
+
+struct console;
+
+// Draw the console to the framebuffer using the CPU. Does not flush cache. The
+// framebuffer is 320x240 with 16-bit pixels, and must be 8-byte aligned.
+void console_draw_raw(struct console *cs, uint16_t *restrict framebuffer);
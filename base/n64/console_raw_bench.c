@@ -0,0 +1,70 @@
+// Benchmark for drawing the console to a framebuffer with the CPU, with a full
+// console and with a console that has a few short lines, like the fault screen.
+#include "base/n64/console_raw.h"
+
+#include "base/base.h"
+#include "base/console_internal.h"
+
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+enum {
+    // Minimum time to run each case, in nanoseconds.
+    MIN_TIME = 200 * 1000 * 1000,
+};
+
+static int64_t now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct console cs;
+static alignas(8) uint16_t framebuffer[CON_WIDTH * CON_HEIGHT];
+
+static void fill_full(void) {
+    for (int i = 0; i < CON_ROWS * CON_COLS; i++) {
+        console_putc(&cs, FONT_START + i % FONT_NCHARS);
+    }
+}
+
+static void fill_fault(void) {
+    console_puts(&cs, "Thread 6 faulted: TLB exception on load\n"
+                      "pc=80012345 ra=80012300 sp=803fff00\n"
+                      "badvaddr=00000004\n");
+}
+
+static const struct {
+    const char *name;
+    void (*fill)(void);
+} cases[] = {
+    {"full", fill_full},
+    {"fault", fill_fault},
+};
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    printf("%-8s %8s %10s\n", "case", "chars", "us/frame");
+    for (size_t i = 0; i < ARRAY_COUNT(cases); i++) {
+        console_init(&cs, CONSOLE_TRUNCATE);
+        cases[i].fill();
+        struct console_rowptr rows[CON_ROWS];
+        int nrows = console_rows(&cs, rows), nchars = 0;
+        for (int row = 0; row < nrows; row++) {
+            nchars += rows[row].end - rows[row].start;
+        }
+        int64_t start = now(), elapsed;
+        long iter = 0;
+        do {
+            console_draw_raw(&cs, framebuffer);
+            iter++;
+            elapsed = now() - start;
+        } while (elapsed < MIN_TIME);
+        printf("%-8s %8d %10.2f\n", cases[i].name, nchars,
+               (double)elapsed * 1e-3 / (double)iter);
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "base/n64/console_raw.h"
+
+#define INCLUDE_FONT_DATA 1
+
+#include "base/base.h"
+#include "base/console_internal.h"
+#include "base/testlib/testlib.h"
+
+#include <stdalign.h>
+#include <stdint.h>
+
+enum {
+    FB_SIZE = CON_WIDTH * CON_HEIGHT,
+};
+
+// Reference renderer, which draws one pixel at a time. This is the original
+// version of console_draw_raw.
+static void draw_reference(struct console *cs, uint16_t *restrict framebuffer) {
+    struct console_rowptr rows[CON_ROWS];
+    int nrows = console_rows(cs, rows);
+    {
+        const unsigned border_color = 0xf801;
+        int rlens[CON_ROWS + 2];
+        rlens[0] = 0;
+        for (int row = 0; row < nrows; row++) {
+            rlens[row + 1] = rows[row].end - rows[row].start;
+        }
+        rlens[nrows + 1] = 0;
+        for (int row = 0; row < nrows; row++) {
+            const int len0 = rlens[row];
+            const int len1 = rlens[row + 1];
+            int len2 = rlens[row + 2];
+            const int x0 = CON_XMARGIN - 1;
+            const int x1 = x0 + len1 * FONT_WIDTH + 1;
+            const int y0 = CON_YMARGIN + row * FONT_HEIGHT - 1;
+            const int y1 = y0 + FONT_HEIGHT + 1;
+            if (len1 > len0) {
+                for (int x = CON_XMARGIN + len0 * FONT_WIDTH; x < x1; x++) {
+                    framebuffer[y0 * CON_WIDTH + x] = border_color;
+                }
+            }
+            for (int y = y0 + 1; y < y1; y++) {
+                framebuffer[y * CON_WIDTH + x0] = border_color;
+                framebuffer[y * CON_WIDTH + x1] = border_color;
+            }
+            if (len1 > len2) {
+                for (int x = CON_XMARGIN + len2 * FONT_WIDTH; x < x1; x++) {
+                    framebuffer[y1 * CON_WIDTH + x] = border_color;
+                }
+            }
+        }
+    }
+    for (int row = 0; row < nrows; row++) {
+        const uint8_t *ptr = rows[row].start, *end = rows[row].end;
+        int cy = CON_YMARGIN + row * FONT_HEIGHT;
+        for (int col = 0; col < end - ptr; col++) {
+            unsigned c = ptr[col];
+            int cx = CON_XMARGIN + col * FONT_WIDTH;
+            if (FONT_START <= c && c < FONT_END) {
+                for (int y = 0; y < FONT_HEIGHT; y++) {
+                    uint16_t *optr = framebuffer + (cy + y) * CON_WIDTH + cx;
+                    uint32_t idata =
+                        FONT_DATA[(c - FONT_START) * FONT_HEIGHT + y];
+                    for (int x = 0; x < FONT_WIDTH; x++) {
+                        optr[x] = (idata & (1u << x)) != 0 ? 0xffff : 0x0000;
+                    }
+                }
+            } else {
+                for (int y = 0; y < FONT_HEIGHT; y++) {
+                    uint16_t *optr = framebuffer + (cy + y) * CON_WIDTH + cx;
+                    for (int x = 0; x < FONT_WIDTH; x++) {
+                        optr[x] = 0x7bdf;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static struct console cs;
+static alignas(8) uint16_t framebuffers[2][FB_SIZE];
+static unsigned rand_state;
+
+static unsigned rand_bits(void) {
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 16;
+}
+
+// Draw the console with both renderers and compare every pixel, including the
+// pixels outside the console, which should not change.
+static void check_draw(void) {
+    for (int i = 0; i < FB_SIZE; i++) {
+        uint16_t value = rand_bits();
+        framebuffers[0][i] = value;
+        framebuffers[1][i] = value;
+    }
+    draw_reference(&cs, framebuffers[0]);
+    console_draw_raw(&cs, framebuffers[1]);
+    for (int i = 0; i < FB_SIZE; i++) {
+        if (framebuffers[0][i] != framebuffers[1][i]) {
+            test_logf("pixel (%d, %d): got 0x%04x, expect 0x%04x",
+                      i % CON_WIDTH, i / CON_WIDTH, framebuffers[1][i],
+                      framebuffers[0][i]);
+            test_fail();
+        }
+    }
+}
+
+static void test_text(void) {
+    test_start("text");
+    console_init(&cs, CONSOLE_TRUNCATE);
+    check_draw();
+    console_puts(&cs, "a");
+    check_draw();
+    console_puts(&cs, "b\nHello, world!\n\nodd\neven\n");
+    check_draw();
+}
+
+static void test_all_chars(void) {
+    test_start("all chars");
+    console_init(&cs, CONSOLE_TRUNCATE);
+    // Includes characters outside the font, at both even and odd columns.
+    for (int c = 1; c < 256; c++) {
+        if (c != '\n') {
+            console_putc(&cs, c);
+        }
+    }
+    console_putc(&cs, '\n');
+    for (int c = FONT_END - 2; c < FONT_END + 3; c++) {
+        console_putc(&cs, c);
+    }
+    check_draw();
+}
+
+static void test_random(void) {
+    test_start("random");
+    for (int i = 0; i < 20; i++) {
+        console_init(&cs, i % 2 == 0 ? CONSOLE_TRUNCATE : CONSOLE_SCROLL);
+        for (int j = 0; j < 30; j++) {
+            int len = rand_bits() % (CON_COLS + 1);
+            for (int k = 0; k < len; k++) {
+                console_putc(&cs, FONT_START - 2 + rand_bits() % 100);
+            }
+            console_putc(&cs, '\n');
+        }
+        check_draw();
+    }
+}
+
+void test_main(void) {
+    test_text();
+    test_all_chars();
+    test_random();
+}
@@ -2,6 +2,7 @@
 
 #include "base/base.h"
 #include "base/console.h"
+#include "base/log.h"
 #include "base/n64/console.h"
 #include "base/n64/os.h"
 
@@ -13,6 +14,11 @@ extern OSThread *__osGetCurrFaultedThread(void);
 
 static const char CRASH_MESSAGE[] = "The game has crashed :-(\n";
 
+enum {
+    // Number of log messages shown on the crash screen.
+    CRASH_LOG_COUNT = 6,
+};
+
 enum {
     CRASH_INVALID,
     CRASH_USER,  // User triggered with fatal_error.
@@ -140,6 +146,8 @@ void faultproc(void *arg) {
         console_puts(cs, "Bad type");
         break;
     }
+    console_puts(cs, "\n\nLog:\n");
+    log_dump(cs, CRASH_LOG_COUNT);
 
     enum {
         SCREEN_WIDTH = 320,
@@ -1,3 +1,11 @@
 #include "base/n64/mat4.h"
 
+#include "base/base.h"
+
+static_assert(sizeof(Mtx) == sizeof(mat4fixed));
+
 void mat4_tofixed(Mtx *out, mat4 *in);
+void mat4_tofixed_translate_rotate_scale(Mtx *restrict out, int count,
+                                         const vec3 *restrict translation,
+                                         const quat *restrict rotation,
+                                         const float *restrict scale);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "base/mat4.h"
 #include "base/vectypes.h"
 
 #include <ultra64.h>
@@ -7,3 +8,12 @@
 inline void mat4_tofixed(Mtx *out, mat4 *in) {
     guMtxF2L((float(*)[4])in->v, out);
 }
+
+// Create fixed-point matrices which scale, rotate, and then translate. See
+// mat4_fixed_translate_rotate_scale.
+inline void mat4_tofixed_translate_rotate_scale(
+    Mtx *restrict out, int count, const vec3 *restrict translation,
+    const quat *restrict rotation, const float *restrict scale) {
+    mat4_fixed_translate_rotate_scale((mat4fixed *)out, count, translation,
+                                      rotation, scale);
+}
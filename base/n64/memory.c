@@ -16,14 +16,17 @@ extern uint8_t _heap3_start[];
 
 static struct mem_zone mem_zones[] = {
     {
+        .name = "heap1",
         .start = (uintptr_t)_heap1_start,
         .end = (uintptr_t)_heap1_end,
     },
     {
+        .name = "heap2",
         .start = (uintptr_t)_heap2_start,
         .end = (uintptr_t)_heap2_end,
     },
     {
+        .name = "heap3",
         .start = (uintptr_t)_heap3_start,
     },
     {0},
@@ -0,0 +1,190 @@
+#include "base/n64/scheduler.h"
+
+#include "base/base.h"
+#include "base/testlib/testlib.h"
+#include "sdk/host/host.h"
+
+#include <stdint.h>
+
+// Referenced by scheduler_start. Threads on the host have their own stacks.
+u8 _scheduler_thread_stack[1];
+
+static struct scheduler scheduler;
+
+static OSMesgQueue done_queue;
+static OSMesg done_buffer[8];
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+// Wait for the next message on the done queue, and check it.
+static void check_done(const char *what, int expect) {
+    OSMesg mesg;
+    osRecvMesg(&done_queue, &mesg, OS_MESG_BLOCK);
+    check_int(what, (uintptr_t)mesg, expect);
+}
+
+static void check_empty(const char *what) {
+    OSMesg mesg;
+    if (osRecvMesg(&done_queue, &mesg, OS_MESG_NOBLOCK) == 0) {
+        test_logf("%s: unexpected message %d", what, (int)(uintptr_t)mesg);
+        test_fail();
+    }
+}
+
+// Submit an RSP task and wait for it. The task finishes when the scheduler
+// handles its SP event, which is queued after all earlier events, so all
+// earlier events have been handled once this returns. An empty task would not
+// work, because the scheduler may run it before handling earlier events.
+static void sync(void) {
+    struct scheduler_task task = {
+        .flags = SCHEDULER_TASK_AUDIO,
+        .task = {.t = {.type = M_AUDTASK}},
+        .done_queue = &done_queue,
+        .done_mesg = (OSMesg)99,
+    };
+    scheduler_submit(&scheduler, &task);
+    check_done("sync", 99);
+}
+
+static void test_rsp(void) {
+    struct scheduler_task tasks[2] = {
+        {
+            .flags = SCHEDULER_TASK_AUDIO,
+            .task = {.t = {.type = M_AUDTASK}},
+            .done_queue = &done_queue,
+            .done_mesg = (OSMesg)1,
+        },
+        {
+            .flags = SCHEDULER_TASK_VIDEO,
+            .task = {.t = {.type = M_GFXTASK}},
+            .done_queue = &done_queue,
+            .done_mesg = (OSMesg)2,
+        },
+    };
+    for (int i = 0; i < 2; i++) {
+        tasks[i].runtime = -1;
+        scheduler_submit(&scheduler, &tasks[i]);
+    }
+    check_done("audio task", 1);
+    check_done("video task", 2);
+    for (int i = 0; i < 2; i++) {
+        if (tasks[i].runtime < 0) {
+            test_logf("task %d: runtime not set", i);
+            test_fail();
+        }
+    }
+}
+
+// Framebuffers, aligned as the scheduler requires.
+static uint64_t framebuffers[3][2] __attribute__((aligned(16)));
+
+static void submit_frame(struct scheduler_task *task, int index,
+                         unsigned frame) {
+    *task = (struct scheduler_task){
+        .flags = SCHEDULER_TASK_VIDEO | SCHEDULER_TASK_FRAMEBUFFER,
+        .task = {.t = {.type = M_GFXTASK}},
+        .done_queue = &done_queue,
+        .done_mesg = (OSMesg)(uintptr_t)(10 + index),
+        .data = {.framebuffer =
+                     {
+                         .ptr = framebuffers[index],
+                         .frame = frame,
+                         .done_queue = &done_queue,
+                         .done_mesg = (OSMesg)(uintptr_t)(20 + index),
+                     }},
+    };
+    scheduler_submit(&scheduler, task);
+}
+
+static void test_video(void) {
+    struct scheduler_task tasks[3];
+    submit_frame(&tasks[0], 0, 100);
+    check_done("task 0", 10);
+    submit_frame(&tasks[1], 1, 101);
+    check_done("task 1", 11);
+
+    // Framebuffer 0 is shown, framebuffer 1 is waiting.
+    host_vi_retrace();
+    sync();
+    check_int("frame", scheduler_getframe(&scheduler).frame, 100);
+    check_empty("first retrace");
+
+    // Framebuffer 1 replaces framebuffer 0, which is released.
+    host_vi_retrace();
+    check_done("framebuffer 0", 20);
+    sync();
+    check_int("frame", scheduler_getframe(&scheduler).frame, 101);
+
+    // Nothing new to show.
+    host_vi_retrace();
+    sync();
+    check_int("frame", scheduler_getframe(&scheduler).frame, 101);
+    check_empty("idle retrace");
+
+    submit_frame(&tasks[2], 2, 102);
+    check_done("task 2", 12);
+    host_vi_retrace();
+    check_done("framebuffer 1", 21);
+    sync();
+    check_int("frame", scheduler_getframe(&scheduler).frame, 102);
+}
+
+enum {
+    AUDIO_SIZE = 256,
+};
+
+static uint64_t audiobuffers[3][AUDIO_SIZE / 8] __attribute__((aligned(16)));
+
+static void submit_audio(struct scheduler_task *task, int index) {
+    *task = (struct scheduler_task){
+        .flags = SCHEDULER_TASK_AUDIOBUFFER,
+        .data = {.audiobuffer =
+                     {
+                         .ptr = audiobuffers[index],
+                         .size = AUDIO_SIZE,
+                         .sample = index * (AUDIO_SIZE / 4),
+                         .done_queue = &done_queue,
+                         .done_mesg = (OSMesg)(uintptr_t)(30 + index),
+                     }},
+    };
+    scheduler_submit(&scheduler, task);
+}
+
+static void test_audio(void) {
+    // Three buffers: two go to the AI, and the third waits.
+    struct scheduler_task tasks[3];
+    for (int i = 0; i < 3; i++) {
+        submit_audio(&tasks[i], i);
+    }
+    sync();
+    check_empty("queued");
+
+    // Play into the second buffer. The first buffer is released, and the
+    // third buffer is sent to the AI.
+    host_ai_play(AUDIO_SIZE + 16);
+    check_done("audiobuffer 0", 30);
+    host_ai_play(AUDIO_SIZE);
+    check_done("audiobuffer 1", 31);
+    // The last buffer is not released until another buffer replaces it.
+    host_ai_play(AUDIO_SIZE);
+    sync();
+    check_empty("audiobuffer 2");
+}
+
+void test_main(void) {
+    host_init(&(struct host_config){0});
+    osCreateMesgQueue(&done_queue, done_buffer, ARRAY_COUNT(done_buffer));
+    scheduler_start(&scheduler, 1);
+
+    test_start("rsp");
+    test_rsp();
+    test_start("video");
+    test_video();
+    test_start("audio");
+    test_audio();
+}
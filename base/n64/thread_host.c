@@ -0,0 +1,13 @@
+#include "base/n64/os.h"
+
+// Host version of thread_create, for running against the libultra stand-in in
+// //sdk/host. There is no $gp to initialize.
+
+// ID of previous thread created.
+static int thread_index;
+
+void thread_create(OSThread *thread, void (*func)(void *arg), void *arg,
+                   void *stack, int priority) {
+    int thread_id = ++thread_index;
+    osCreateThread(thread, thread_id, func, arg, stack, priority);
+}
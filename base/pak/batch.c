@@ -0,0 +1,146 @@
+#include "base/pak/batch.h"
+
+#include "base/base.h"
+#include "base/pak/lz.h"
+#include "base/pak/request.h"
+
+#include <string.h>
+
+struct pak_batch_stats pak_batch_stats;
+
+// Buffer for merged transfers.
+static uint8_t pak_batch_bounce[PAK_BATCH_BOUNCE_SIZE]
+    __attribute__((aligned(16)));
+
+// A range of items, sorted by offset, which is loaded with one transfer.
+struct pak_batch_run {
+    int start, end;  // Range of indexes into the sorted items.
+    uint32_t offset; // Offset of the transfer.
+    uint32_t size;   // Size of the transfer.
+};
+
+// Sort the items by cartridge offset. Returns the sorted item indexes in
+// order. Batches are small, so this uses insertion sort.
+static void pak_batch_sort(const struct pak_object *objects,
+                           const struct pak_batch_item *items, int count,
+                           int *order) {
+    for (int i = 0; i < count; i++) {
+        uint32_t offset = objects[items[i].object].offset;
+        int j = i;
+        for (; j > 0 && objects[items[order[j - 1]].object].offset > offset;
+             j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+}
+
+// Split the sorted items into runs. Returns the number of runs.
+static int pak_batch_plan(const struct pak_object *objects,
+                          const struct pak_batch_item *items, const int *order,
+                          int count, uint32_t gap,
+                          struct pak_batch_run *runs) {
+    int nrun = 0;
+    for (int i = 0; i < count;) {
+        const struct pak_object *obj = &objects[items[order[i]].object];
+        uint32_t start = obj->offset, end = start + obj->stored_size;
+        int j = i + 1;
+        if ((obj->flags & PAK_COMPRESSED) == 0) {
+            for (; j < count; j++) {
+                const struct pak_object *next =
+                    &objects[items[order[j]].object];
+                if ((next->flags & PAK_COMPRESSED) != 0 ||
+                    next->offset > end + gap) {
+                    break;
+                }
+                uint32_t next_end = next->offset + next->stored_size;
+                if (next_end < end) {
+                    next_end = end;
+                }
+                if (next_end - start > PAK_BATCH_BOUNCE_SIZE) {
+                    break;
+                }
+                end = next_end;
+            }
+        }
+        runs[nrun++] = (struct pak_batch_run){
+            .start = i,
+            .end = j,
+            .offset = start,
+            .size = end - start,
+        };
+        i = j;
+    }
+    return nrun;
+}
+
+void pak_batch_load(const struct pak_object *objects,
+                    const struct pak_batch_item *items, int count,
+                    uint32_t gap) {
+    if (count < 0 || count > PAK_BATCH_MAX) {
+        fatal_error("pak_batch_load: bad count\nCount: %d", count);
+    }
+    for (int i = 0; i < count; i++) {
+        const struct pak_object *obj = &objects[items[i].object];
+        if (obj->size > items[i].destsize) {
+            fatal_error(
+                "pak_batch_load: buffer too small\n"
+                "Object: %d\nSize: %lu\nDest size: %zu",
+                items[i].object, (unsigned long)obj->size, items[i].destsize);
+        }
+    }
+    int order[PAK_BATCH_MAX];
+    struct pak_batch_run runs[PAK_BATCH_MAX];
+    pak_batch_sort(objects, items, count, order);
+    int nrun = pak_batch_plan(objects, items, order, count, gap, runs);
+
+    // Start the direct transfers first, so they proceed while merged
+    // transfers are copied out of the bounce buffer.
+    uint32_t direct[PAK_BATCH_MAX];
+    int ndirect = 0;
+    uint32_t requests = 0;
+    for (int r = 0; r < nrun; r++) {
+        const struct pak_batch_run *run = &runs[r];
+        const struct pak_batch_item *item = &items[order[run->start]];
+        const struct pak_object *obj = &objects[item->object];
+        if (run->end - run->start == 1 &&
+            (obj->flags & PAK_COMPRESSED) == 0) {
+            direct[ndirect++] = pak_request_start(
+                item->dest, obj->offset, obj->size, PAK_PRI_NORMAL, NULL, NULL);
+        }
+    }
+    for (int r = 0; r < nrun; r++) {
+        const struct pak_batch_run *run = &runs[r];
+        const struct pak_batch_item *item = &items[order[run->start]];
+        const struct pak_object *obj = &objects[item->object];
+        if ((obj->flags & PAK_COMPRESSED) != 0) {
+            pak_lz_load(item->dest, item->destsize, obj);
+            requests += (obj->stored_size + PAK_LZ_CHUNK_SIZE - 1) /
+                        PAK_LZ_CHUNK_SIZE;
+            continue;
+        }
+        requests++;
+        if (run->end - run->start > 1) {
+            pak_wait(pak_request_start(pak_batch_bounce, run->offset,
+                                       run->size, PAK_PRI_NORMAL, NULL, NULL));
+            uint32_t used = 0;
+            for (int i = run->start; i < run->end; i++) {
+                const struct pak_batch_item *it = &items[order[i]];
+                const struct pak_object *o = &objects[it->object];
+                memcpy(it->dest, pak_batch_bounce + (o->offset - run->offset),
+                       o->size);
+                used += o->size;
+            }
+            pak_batch_stats.saved += run->end - run->start - 1;
+            if (run->size > used) {
+                pak_batch_stats.extra_bytes += run->size - used;
+            }
+        }
+    }
+    for (int i = 0; i < ndirect; i++) {
+        pak_wait(direct[i]);
+    }
+    pak_batch_stats.batches++;
+    pak_batch_stats.objects += count;
+    pak_batch_stats.requests += requests;
+}
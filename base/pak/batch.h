@@ -0,0 +1,52 @@
+// Batched pak loads.
+#pragma once
+
+#include "base/pak/object.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+    // Maximum number of objects in a batch.
+    PAK_BATCH_MAX = 32,
+
+    // Size of the bounce buffer. Objects which are merged into one transfer
+    // must fit in the bounce buffer together.
+    PAK_BATCH_BOUNCE_SIZE = 16 * 1024,
+
+    // Default for the largest gap between objects which are merged into one
+    // transfer. Reading a few hundred extra bytes costs less than starting
+    // another DMA.
+    PAK_BATCH_GAP = 256,
+};
+
+// An object to load in a batch.
+struct pak_batch_item {
+    int object;      // Object ID.
+    void *dest;      // Destination buffer.
+    size_t destsize; // Size of destination buffer.
+};
+
+// Counters for batched loads, since startup.
+struct pak_batch_stats {
+    uint32_t batches;     // Number of batches loaded.
+    uint32_t objects;     // Number of objects loaded.
+    uint32_t requests;    // Number of DMA requests made. A compressed
+                          // object takes one for each PAK_LZ_CHUNK_SIZE
+                          // bytes of stored data.
+    uint32_t saved;       // Number of DMA requests saved by merging.
+    uint32_t extra_bytes; // Bytes read from gaps between merged objects.
+};
+
+extern struct pak_batch_stats pak_batch_stats;
+
+// Load a batch of objects, using the given object table. Objects whose stored
+// data is within the given gap of each other in the cartridge are merged into
+// one DMA through the bounce buffer, and then copied to their destinations.
+// Other objects are loaded directly, and compressed objects are loaded with
+// pak_lz_load. Returns once every object is loaded. On the Nintendo 64, the
+// caller must write back the data cache for data copied from the bounce
+// buffer, if it is used by the RSP.
+void pak_batch_load(const struct pak_object *objects,
+                    const struct pak_batch_item *items, int count,
+                    uint32_t gap);
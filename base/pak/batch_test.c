@@ -0,0 +1,116 @@
+#include "base/pak/batch.h"
+
+#include "base/base.h"
+#include "base/pak/request.h"
+#include "base/pak/sim.h"
+#include "base/testlib/testlib.h"
+
+#include <string.h>
+
+enum {
+    ROM_SIZE = 64 * 1024,
+    FILL = 0xa5,
+};
+
+static uint8_t rom[ROM_SIZE];
+
+// Object table. Objects 1-3 are adjacent, object 4 follows after a small gap,
+// object 5 is far away, and object 6 is too large to merge.
+static const struct pak_object objects[] = {
+    {0},
+    {.offset = 1000, .size = 100, .stored_size = 100},
+    {.offset = 1100, .size = 50, .stored_size = 50},
+    {.offset = 1150, .size = 202, .stored_size = 202},
+    {.offset = 1400, .size = 64, .stored_size = 64},
+    {.offset = 9000, .size = 30, .stored_size = 30},
+    {.offset = 20000, .size = 20000, .stored_size = 20000},
+};
+
+static void sim_init(void) {
+    for (int i = 0; i < ROM_SIZE; i++) {
+        rom[i] = i * 7 + (i >> 8);
+    }
+    pak_sim_init(&(struct pak_sim_config){
+        .rom = rom,
+        .rom_size = sizeof(rom),
+        .latency = 100,
+        .bytes_per_tick = 4,
+    });
+    pak_batch_stats = (struct pak_batch_stats){0};
+}
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+// Destination buffers, with extra space to check for overruns.
+static uint8_t dest[ARRAY_COUNT(objects)][20032];
+
+// Load the given objects in a batch, and check the results.
+static void load(const int *ids, int count, uint32_t gap) {
+    struct pak_batch_item items[PAK_BATCH_MAX];
+    memset(dest, FILL, sizeof(dest));
+    for (int i = 0; i < count; i++) {
+        items[i] = (struct pak_batch_item){
+            .object = ids[i],
+            .dest = dest[ids[i]],
+            .destsize = objects[ids[i]].size,
+        };
+    }
+    pak_batch_load(objects, items, count, gap);
+    for (int i = 0; i < count; i++) {
+        const struct pak_object *obj = &objects[ids[i]];
+        const uint8_t *d = dest[ids[i]];
+        if (memcmp(d, rom + obj->offset, obj->size) != 0) {
+            test_logf("object %d: data does not match", ids[i]);
+            test_fail();
+        }
+        if (d[obj->size] != FILL) {
+            test_logf("object %d: wrote past end", ids[i]);
+            test_fail();
+        }
+    }
+    check_int("in flight", pak_poll(), 0);
+}
+
+static void test_adjacent(void) {
+    test_start("adjacent");
+    sim_init();
+    // Out of order, to check sorting.
+    load((const int[]){3, 1, 2}, 3, 0);
+    check_int("requests", pak_batch_stats.requests, 1);
+    check_int("saved", pak_batch_stats.saved, 2);
+    check_int("extra bytes", pak_batch_stats.extra_bytes, 0);
+}
+
+static void test_gap(void) {
+    test_start("gap");
+    sim_init();
+    // The gap between objects 3 and 4 is 48 bytes.
+    load((const int[]){1, 2, 3, 4}, 4, 0);
+    check_int("requests", pak_batch_stats.requests, 2);
+    load((const int[]){1, 2, 3, 4}, 4, 48);
+    check_int("requests", pak_batch_stats.requests, 3);
+    check_int("extra bytes", pak_batch_stats.extra_bytes, 48);
+    check_int("saved", pak_batch_stats.saved, 2 + 3);
+}
+
+static void test_direct(void) {
+    test_start("direct");
+    sim_init();
+    // Objects which are far apart, or too large for the bounce buffer, are
+    // loaded directly.
+    load((const int[]){5, 6, 4, 3}, 4, PAK_BATCH_GAP);
+    check_int("requests", pak_batch_stats.requests, 3);
+    check_int("saved", pak_batch_stats.saved, 1);
+    check_int("objects", pak_batch_stats.objects, 4);
+}
+
+void test_main(void) {
+    test_adjacent();
+    test_gap();
+    test_direct();
+}
@@ -0,0 +1,254 @@
+#include "base/pak/lz.h"
+
+#include "base/base.h"
+#include "base/pak/request.h"
+
+#include <string.h>
+
+enum {
+    // Flag in block header for raw blocks.
+    PAK_LZ_RAW = 0x8000,
+
+    // Length of the shortest match.
+    PAK_LZ_MIN_MATCH = 4,
+
+    // Space before each bounce buffer chunk for the incomplete block left over
+    // from the previous chunk.
+    PAK_LZ_CARRY = (PAK_LZ_BLOCK_MAX + 15) & ~15,
+};
+
+// Buffers for loading compressed objects which cannot be loaded in place.
+// Chunks alternate between the two buffers.
+static uint8_t pak_lz_bounce[2][PAK_LZ_CARRY + PAK_LZ_CHUNK_SIZE]
+    __attribute__((aligned(16)));
+
+noreturn static void pak_lz_corrupt(const struct pak_lz *restrict st) {
+    fatal_error("Corrupt compressed data\nOutput position: %lu",
+                (unsigned long)st->out_pos);
+}
+
+void pak_lz_init(struct pak_lz *restrict st, void *out, uint32_t size) {
+    *st = (struct pak_lz){
+        .out = out,
+        .out_size = size,
+    };
+}
+
+// Read a length extension.
+static uint32_t pak_lz_length(const struct pak_lz *restrict st,
+                              const uint8_t **ptr, const uint8_t *end) {
+    const uint8_t *in = *ptr;
+    uint32_t n = 0;
+    for (;;) {
+        if (in == end) {
+            pak_lz_corrupt(st);
+        }
+        unsigned b = *in++;
+        n += b;
+        if (b != 255) {
+            break;
+        }
+    }
+    *ptr = in;
+    return n;
+}
+
+// Decompress one block, ending at the given output position.
+static void pak_lz_block(struct pak_lz *restrict st, const uint8_t *in,
+                         const uint8_t *in_end, uint32_t end) {
+    uint8_t *out = st->out;
+    uint32_t pos = st->out_pos;
+    while (pos < end) {
+        if (in == in_end) {
+            pak_lz_corrupt(st);
+        }
+        unsigned token = *in++;
+        uint32_t nlit = token >> 4;
+        if (nlit == 15) {
+            nlit += pak_lz_length(st, &in, in_end);
+        }
+        if (nlit > (size_t)(in_end - in) || nlit > end - pos) {
+            pak_lz_corrupt(st);
+        }
+        // When decompressing in place, the literals may overlap the output.
+        memmove(out + pos, in, nlit);
+        in += nlit;
+        pos += nlit;
+        if (pos == end) {
+            break;
+        }
+        if (in_end - in < 2) {
+            pak_lz_corrupt(st);
+        }
+        uint32_t offset = ((uint32_t)in[0] << 8) | in[1];
+        in += 2;
+        uint32_t length = (token & 15) + PAK_LZ_MIN_MATCH;
+        if (length == 15 + PAK_LZ_MIN_MATCH) {
+            length += pak_lz_length(st, &in, in_end);
+        }
+        if (offset == 0 || offset > pos || length > end - pos) {
+            pak_lz_corrupt(st);
+        }
+        uint8_t *dst = out + pos;
+        const uint8_t *src = dst - offset;
+        if (offset >= length) {
+            memcpy(dst, src, length);
+        } else {
+            // The match overlaps itself, so it repeats with a period of the
+            // offset. Copy it in pieces which double in size.
+            uint32_t done = 0, span = offset;
+            while (done < length) {
+                uint32_t n = length - done < span ? length - done : span;
+                memcpy(dst + done, dst + done - span, n);
+                done += n;
+                span = offset + done;
+            }
+        }
+        pos += length;
+    }
+    if (in != in_end) {
+        pak_lz_corrupt(st);
+    }
+    st->out_pos = pos;
+}
+
+size_t pak_lz_decode(struct pak_lz *st, const uint8_t *in, size_t size) {
+    const uint8_t *const start = in, *const in_end = in + size;
+    while (st->out_pos < st->out_size && in_end - in >= 2) {
+        unsigned header = ((unsigned)in[0] << 8) | in[1];
+        uint32_t n = header & ~PAK_LZ_RAW;
+        if (n > (size_t)(in_end - in) - 2) {
+            break;
+        }
+        const uint8_t *payload = in + 2;
+        uint32_t end = st->out_size - st->out_pos > PAK_LZ_BLOCK_SIZE
+                           ? st->out_pos + PAK_LZ_BLOCK_SIZE
+                           : st->out_size;
+        if ((header & PAK_LZ_RAW) != 0) {
+            if (n != end - st->out_pos) {
+                pak_lz_corrupt(st);
+            }
+            memmove(st->out + st->out_pos, payload, n);
+            st->out_pos = end;
+        } else {
+            pak_lz_block(st, payload, payload + n, end);
+        }
+        in = payload + n;
+    }
+    return in - start;
+}
+
+// Check that a compressed object was completely decompressed.
+static void pak_lz_finish(const struct pak_lz *restrict st, uint32_t in_pos,
+                          const struct pak_object *restrict obj) {
+    if (st->out_pos != st->out_size || in_pos != obj->stored_size) {
+        pak_lz_corrupt(st);
+    }
+}
+
+// Get the size of the given chunk of a compressed object.
+static uint32_t pak_lz_chunk_size(const struct pak_object *restrict obj,
+                                  uint32_t chunk) {
+    uint32_t pos = chunk * PAK_LZ_CHUNK_SIZE;
+    uint32_t rem = obj->stored_size - pos;
+    return rem < PAK_LZ_CHUNK_SIZE ? rem : PAK_LZ_CHUNK_SIZE;
+}
+
+// Start loading a chunk of a compressed object.
+static uint32_t pak_lz_start(void *dest, const struct pak_object *restrict obj,
+                             uint32_t chunk) {
+    return pak_request_start(dest, obj->offset + chunk * PAK_LZ_CHUNK_SIZE,
+                             pak_lz_chunk_size(obj, chunk), PAK_PRI_NORMAL,
+                             NULL, NULL);
+}
+
+// Get the location to load compressed data for decompressing in place, or NULL
+// if the destination is too small. The location is aligned to a cache line,
+// so the decompressor never writes to a cache line which a DMA is loading.
+static uint8_t *pak_lz_inplace(uint8_t *dest, size_t destsize,
+                               const struct pak_object *restrict obj) {
+    if (destsize < obj->stored_size) {
+        return NULL;
+    }
+    uintptr_t start = (uintptr_t)dest;
+    uintptr_t in = (start + destsize - obj->stored_size) & ~(uintptr_t)15;
+    if (in < start ||
+        in - start + obj->stored_size < (size_t)obj->size + obj->margin) {
+        return NULL;
+    }
+    return (uint8_t *)in;
+}
+
+// Load a compressed object into the end of the destination buffer, and
+// decompress it in place.
+static void pak_lz_load_inplace(struct pak_lz *restrict st, uint8_t *in,
+                                const struct pak_object *restrict obj) {
+    uint32_t count =
+        (obj->stored_size + PAK_LZ_CHUNK_SIZE - 1) / PAK_LZ_CHUNK_SIZE;
+    uint32_t id[PAK_LZ_AHEAD];
+    uint32_t started = 0;
+    for (; started < count && started < PAK_LZ_AHEAD; started++) {
+        id[started] = pak_lz_start(in + started * PAK_LZ_CHUNK_SIZE, obj,
+                                   started);
+    }
+    uint32_t in_pos = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        pak_wait(id[i % PAK_LZ_AHEAD]);
+        uint32_t avail = i * PAK_LZ_CHUNK_SIZE + pak_lz_chunk_size(obj, i);
+        in_pos += pak_lz_decode(st, in + in_pos, avail - in_pos);
+        if (started < count) {
+            id[started % PAK_LZ_AHEAD] = pak_lz_start(
+                in + started * PAK_LZ_CHUNK_SIZE, obj, started);
+            started++;
+        }
+    }
+    pak_lz_finish(st, in_pos, obj);
+}
+
+// Load a compressed object through the bounce buffers. Data for an incomplete
+// block at the end of one chunk is copied in front of the next chunk.
+static void pak_lz_load_bounce(struct pak_lz *restrict st,
+                               const struct pak_object *restrict obj) {
+    uint32_t count =
+        (obj->stored_size + PAK_LZ_CHUNK_SIZE - 1) / PAK_LZ_CHUNK_SIZE;
+    uint32_t id[2];
+    for (uint32_t i = 0; i < count && i < 2; i++) {
+        id[i] = pak_lz_start(pak_lz_bounce[i] + PAK_LZ_CARRY, obj, i);
+    }
+    uint32_t in_pos = 0;
+    size_t carry = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t *chunk = pak_lz_bounce[i & 1] + PAK_LZ_CARRY;
+        pak_wait(id[i & 1]);
+        const uint8_t *in = chunk - carry;
+        size_t size = carry + pak_lz_chunk_size(obj, i);
+        size_t used = pak_lz_decode(st, in, size);
+        in_pos += used;
+        carry = size - used;
+        if (carry > PAK_LZ_CARRY) {
+            pak_lz_corrupt(st);
+        }
+        memcpy(pak_lz_bounce[(i & 1) ^ 1] + PAK_LZ_CARRY - carry, in + used,
+               carry);
+        if (i + 2 < count) {
+            id[i & 1] = pak_lz_start(chunk, obj, i + 2);
+        }
+    }
+    pak_lz_finish(st, in_pos, obj);
+}
+
+void pak_lz_load(void *dest, size_t destsize,
+                 const struct pak_object *restrict obj) {
+    if (obj->size > destsize) {
+        fatal_error("pak_lz_load: buffer too small\nSize: %lu\nDest size: %zu",
+                    (unsigned long)obj->size, destsize);
+    }
+    struct pak_lz st;
+    pak_lz_init(&st, dest, obj->size);
+    uint8_t *in = pak_lz_inplace(dest, destsize, obj);
+    if (in != NULL) {
+        pak_lz_load_inplace(&st, in, obj);
+    } else {
+        pak_lz_load_bounce(&st, obj);
+    }
+}
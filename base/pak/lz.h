@@ -0,0 +1,51 @@
+// Decompression for compressed pak objects.
+#pragma once
+
+#include "base/pak/object.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The compressed format is described in tools/lz.
+
+enum {
+    // Decompressed size of each block in a compressed stream.
+    PAK_LZ_BLOCK_SIZE = 4096,
+
+    // Maximum stored size of a block, including its header.
+    PAK_LZ_BLOCK_MAX = PAK_LZ_BLOCK_SIZE + 2,
+
+    // Size of each DMA when loading a compressed object.
+    PAK_LZ_CHUNK_SIZE = 4096,
+
+    // Number of DMAs to keep in flight when loading a compressed object in
+    // place.
+    PAK_LZ_AHEAD = 4,
+};
+
+// State for decompressing a stream.
+struct pak_lz {
+    uint8_t *out;      // Output buffer.
+    uint32_t out_pos;  // Number of bytes decompressed so far.
+    uint32_t out_size; // Total decompressed size.
+};
+
+// Start decompressing a stream with the given decompressed size.
+void pak_lz_init(struct pak_lz *restrict st, void *out, uint32_t size);
+
+// Decompress all complete blocks at the start of the input. Returns the number
+// of bytes of input consumed. Incomplete blocks at the end of the input are
+// not consumed, and must be passed in again with the rest of their data. The
+// input may overlap the output, as long as it is far enough ahead of the
+// output, as given by the object's margin. Aborts if the data is corrupt.
+size_t pak_lz_decode(struct pak_lz *st, const uint8_t *in, size_t size);
+
+// Load a compressed object, and decompress each chunk of it as its DMA
+// completes. If the destination has room for the object's margin, the object
+// is loaded into the end of the destination and decompressed in place, which
+// may overwrite the destination past the end of the object. Otherwise, it is
+// loaded through a bounce buffer. The destination must be at least as large as
+// the object. On the Nintendo 64, the caller must write back the data cache
+// for the destination if the data is used by the RSP.
+void pak_lz_load(void *dest, size_t destsize,
+                 const struct pak_object *restrict obj);
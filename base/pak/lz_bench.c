@@ -0,0 +1,95 @@
+// Benchmark for decompressing pak objects, using the shared test corpus. The
+// same corpus is used by BenchmarkDecompress in tools/lz.
+#include "base/pak/lz.h"
+
+#include "base/tool.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const char *const corpus[] = {
+    "empty", "logo", "marble", "random", "text", "zeros",
+};
+
+enum {
+    // Minimum time to run each file, in nanoseconds.
+    MIN_TIME = 200 * 1000 * 1000,
+};
+
+static uint8_t *read_file(const char *dir, const char *name, size_t *size) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.lz", dir, name);
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        die_errno(errno, "open %s", path);
+    }
+    size_t cap = 1024, len = 0;
+    uint8_t *data = xmalloc(cap);
+    for (;;) {
+        len += fread(data + len, 1, cap - len, fp);
+        if (len < cap) {
+            break;
+        }
+        cap *= 2;
+        data = realloc(data, cap);
+        if (data == NULL) {
+            die("out of memory");
+        }
+    }
+    if (ferror(fp)) {
+        die_read(fp, "read %s", path);
+    }
+    fclose(fp);
+    *size = len;
+    return data;
+}
+
+static int64_t now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    const char *dir = argc > 1 ? argv[1] : "base/pak/testdata";
+    printf("%-8s %8s %8s %10s\n", "file", "size", "stored", "MB/s");
+    // Totals for one pass over the corpus.
+    int64_t total_bytes = 0;
+    double total_time = 0.0;
+    for (size_t i = 0; i < ARRAY_COUNT(corpus); i++) {
+        size_t fsize;
+        uint8_t *data = read_file(dir, corpus[i], &fsize);
+        if (fsize < 8) {
+            die("%s: file too short", corpus[i]);
+        }
+        uint32_t size = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                        ((uint32_t)data[2] << 8) | data[3];
+        const uint8_t *in = data + 8;
+        size_t stored = fsize - 8;
+        uint8_t *out = xmalloc(size > 0 ? size : 1);
+        int64_t start = now(), elapsed;
+        long iter = 0;
+        do {
+            struct pak_lz st;
+            pak_lz_init(&st, out, size);
+            if (pak_lz_decode(&st, in, stored) != stored ||
+                st.out_pos != size) {
+                die("%s: decode failed", corpus[i]);
+            }
+            iter++;
+            elapsed = now() - start;
+        } while (elapsed < MIN_TIME);
+        double rate = (double)size * iter * 1e3 / (double)elapsed;
+        printf("%-8s %8lu %8zu %10.1f\n", corpus[i], (unsigned long)size,
+               stored, rate);
+        total_bytes += size;
+        total_time += (double)elapsed / (double)iter;
+        free(out);
+        free(data);
+    }
+    printf("%-8s %8s %8s %10.1f\n", "total", "", "",
+           (double)total_bytes * 1e3 / total_time);
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include "base/pak/lz.h"
+
+#include "base/base.h"
+#include "base/pak/request.h"
+#include "base/pak/sim.h"
+#include "base/testlib/testlib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test corpus, shared with tools/lz. See tools/lz/lz_test.go for the format.
+static const char *const corpus[] = {
+    "empty", "logo", "marble", "random", "text", "zeros",
+};
+
+struct corpus_file {
+    uint8_t *data;
+    uint32_t size;
+    uint8_t *compressed;
+    uint32_t compressed_size;
+    uint32_t margin;
+};
+
+static uint8_t *read_file(const char *name, const char *ext, uint32_t *size) {
+    char path[128];
+    snprintf(path, sizeof(path), "base/pak/testdata/%s%s", name, ext);
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        test_logf("could not open %s", quote_str(path));
+        test_fail();
+    }
+    size_t cap = 1024, len = 0;
+    uint8_t *data = malloc(cap);
+    for (;;) {
+        len += fread(data + len, 1, cap - len, fp);
+        if (len < cap) {
+            break;
+        }
+        cap *= 2;
+        data = realloc(data, cap);
+    }
+    if (ferror(fp)) {
+        test_logf("could not read %s", quote_str(path));
+        test_fail();
+    }
+    fclose(fp);
+    *size = len;
+    return data;
+}
+
+static uint32_t read32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void read_corpus(struct corpus_file *restrict f, const char *name) {
+    f->data = read_file(name, ".bin", &f->size);
+    uint32_t size;
+    uint8_t *data = read_file(name, ".lz", &size);
+    if (size < 8 || read32(data) != f->size) {
+        test_logf("%s: bad header", name);
+        test_fail();
+    }
+    f->margin = read32(data + 4);
+    f->compressed = data + 8;
+    f->compressed_size = size - 8;
+}
+
+static void check_output(const char *name, const char *what,
+                         const struct corpus_file *restrict f,
+                         const uint8_t *out) {
+    if (memcmp(out, f->data, f->size) != 0) {
+        size_t i = 0;
+        while (out[i] == f->data[i]) {
+            i++;
+        }
+        test_logf("%s: %s: output does not match at offset %zu", name, what,
+                  i);
+        test_fail();
+    }
+}
+
+// Decompress the entire stream at once.
+static void test_decode(const char *name, const struct corpus_file *restrict f,
+                        uint8_t *buf) {
+    struct pak_lz st;
+    pak_lz_init(&st, buf, f->size);
+    size_t used = pak_lz_decode(&st, f->compressed, f->compressed_size);
+    if (used != f->compressed_size || st.out_pos != f->size) {
+        test_logf("%s: decoded %zu bytes to %lu, expect %lu to %lu", name,
+                  used, (unsigned long)st.out_pos,
+                  (unsigned long)f->compressed_size, (unsigned long)f->size);
+        test_fail();
+    }
+    check_output(name, "decode", f, buf);
+}
+
+// Decompress the stream, making more input available a piece at a time.
+static void test_decode_partial(const char *name,
+                                const struct corpus_file *restrict f,
+                                uint8_t *buf) {
+    struct pak_lz st;
+    pak_lz_init(&st, buf, f->size);
+    size_t pos = 0;
+    for (size_t avail = 0; avail <= f->compressed_size; avail += 333) {
+        pos += pak_lz_decode(&st, f->compressed + pos, avail - pos);
+    }
+    pos += pak_lz_decode(&st, f->compressed + pos, f->compressed_size - pos);
+    if (pos != f->compressed_size || st.out_pos != f->size) {
+        test_logf("%s: partial decode incomplete", name);
+        test_fail();
+    }
+    check_output(name, "partial", f, buf);
+}
+
+enum {
+    // Offset of the object in the simulated ROM.
+    ROM_OFFSET = 258,
+    FILL = 0xa5,
+};
+
+// Load the stream through the simulated PI.
+static void test_load(const char *name, const struct corpus_file *restrict f,
+                      uint8_t *rom, uint8_t *buf, size_t destsize,
+                      bool inplace) {
+    pak_sim_init(&(struct pak_sim_config){
+        .rom = rom,
+        .rom_size = ROM_OFFSET + f->compressed_size,
+        .latency = 100,
+        .bytes_per_tick = 4,
+    });
+    memset(buf, FILL, destsize);
+    struct pak_object obj = {
+        .offset = ROM_OFFSET,
+        .size = f->size,
+        .stored_size = f->compressed_size,
+        .flags = PAK_COMPRESSED,
+        .margin = f->margin,
+    };
+    pak_lz_load(buf, destsize, &obj);
+    check_output(name, inplace ? "in place" : "bounce", f, buf);
+    if (!inplace) {
+        // The bounce buffer path must not touch memory past the object.
+        for (size_t i = f->size; i < destsize; i++) {
+            if (buf[i] != FILL) {
+                test_logf("%s: bounce: wrote past end at offset %zu", name, i);
+                test_fail();
+            }
+        }
+    }
+    if (pak_poll() != 0) {
+        test_logf("%s: requests still in flight", name);
+        test_fail();
+    }
+}
+
+void test_main(void) {
+    for (size_t i = 0; i < ARRAY_COUNT(corpus); i++) {
+        const char *name = corpus[i];
+        test_start(name);
+        struct corpus_file f;
+        read_corpus(&f, name);
+        size_t bufsize = f.size + f.margin + 32;
+        if (bufsize < f.compressed_size + 32) {
+            bufsize = f.compressed_size + 32;
+        }
+        // Aligned, so the in-place size is predictable.
+        uint8_t *buf = aligned_alloc(16, (bufsize + 15) & ~(size_t)15);
+        uint8_t *rom = malloc(ROM_OFFSET + f.compressed_size);
+        memset(rom, 0, ROM_OFFSET);
+        memcpy(rom + ROM_OFFSET, f.compressed, f.compressed_size);
+
+        test_decode(name, &f, buf);
+        test_decode_partial(name, &f, buf);
+        if (f.size > 0) {
+            // Exactly the object size. This is only in place if the margin
+            // fits after aligning the compressed data.
+            bool fits = f.compressed_size <= f.size &&
+                        ((f.size - f.compressed_size) & ~15u) >=
+                            f.size - f.compressed_size + f.margin;
+            test_load(name, &f, rom, buf, f.size, fits);
+            // Just enough room for the margin.
+            size_t need = f.size + f.margin - f.compressed_size;
+            test_load(name, &f, rom, buf,
+                      ((need + 15) & ~(size_t)15) + f.compressed_size, true);
+            test_load(name, &f, rom, buf, bufsize, true);
+        }
+
+        free(rom);
+        free(buf);
+        free(f.data);
+        free(f.compressed - 8);
+    }
+}
@@ -0,0 +1,32 @@
+// Pak object descriptors.
+#pragma once
+
+#include <stdint.h>
+
+// Flags for pak objects.
+enum {
+    // The object is compressed. See tools/lz for the format.
+    PAK_COMPRESSED = 1 << 0,
+};
+
+// Descriptor for an object in the pak.
+struct pak_object {
+    uint32_t offset;      // Offset of the stored data in the cartridge.
+    uint32_t size;        // Size of the object, after decompression.
+    uint32_t stored_size; // Size of the data stored in the cartridge.
+    uint16_t flags;       // PAK_COMPRESSED, or zero.
+    // For compressed objects, extra space needed to decompress in place,
+    // beyond the object size.
+    uint16_t margin;
+};
+
+_Static_assert(sizeof(struct pak_object) == 16, "struct pak_object size");
+
+// Header at the start of a preload group object. A group object contains this
+// header, followed by the stored data for each member, so the entire group can
+// be loaded with one DMA. Each member's location is given by its own object
+// descriptor.
+struct pak_group_header {
+    uint16_t count;    // Number of members.
+    uint16_t object[]; // Object ID of each member, in the order stored.
+};
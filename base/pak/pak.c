@@ -1,39 +1,84 @@
 #include "base/pak/pak.h"
 
 #include "base/base.h"
+#include "base/pak/lz.h"
+#include "base/pak/trace.h"
 
 #include <ultra64.h>
 
+#include <string.h>
+
 OSPiHandle *rom_handle;
 
-static OSMesgQueue dma_message_queue;
-static OSMesg dma_message_buffer;
-static OSIoMesg dma_io_message_buffer;
+// Number of objects in the pak, including the empty first object.
+static unsigned pak_asset_count;
+
+// Group which has been loaded into memory by pak_load_group. Members of the
+// group are loaded from here instead of from the cartridge.
+static struct {
+    const uint8_t *data;
+    uint32_t offset;
+    uint32_t size;
+} pak_staged;
+
+// Queue which receives PI DMA completion messages.
+static OSMesgQueue pak_dma_queue;
+static OSMesg pak_dma_queue_buffer[PAK_REQUEST_COUNT];
+
+// IO message for each request slot.
+static OSIoMesg pak_dma_mesg[PAK_REQUEST_COUNT];
 
 // Offset in cartridge where data is stored.
 extern uint8_t _pakdata_offset[];
 
-void pak_load_data_sync(void *dest, uint32_t offset, uint32_t size) {
-    osWritebackDCache(dest, size);
-    osInvalDCache(dest, size);
-    dma_io_message_buffer = (OSIoMesg){
+void pak_pi_start(int slot, const struct pak_request *req) {
+    osWritebackDCache(req->dest, req->size);
+    osInvalDCache(req->dest, req->size);
+    pak_dma_mesg[slot] = (OSIoMesg){
         .hdr =
             {
-                .pri = OS_MESG_PRI_NORMAL,
-                .retQueue = &dma_message_queue,
+                .pri = req->priority == PAK_PRI_HIGH ? OS_MESG_PRI_HIGH
+                                                     : OS_MESG_PRI_NORMAL,
+                .retQueue = &pak_dma_queue,
             },
-        .dramAddr = dest,
-        .devAddr = offset,
-        .size = size,
+        .dramAddr = req->dest,
+        .devAddr = req->offset,
+        .size = req->size,
     };
-    osEPiStartDma(rom_handle, &dma_io_message_buffer, OS_READ);
-    osRecvMesg(&dma_message_queue, NULL, OS_MESG_BLOCK);
-    osInvalDCache(dest, size);
+    osEPiStartDma(rom_handle, &pak_dma_mesg[slot], OS_READ);
+}
+
+int pak_pi_next(bool block) {
+    OSMesg mesg;
+    if (osRecvMesg(&pak_dma_queue, &mesg,
+                   block ? OS_MESG_BLOCK : OS_MESG_NOBLOCK) != 0) {
+        return -1;
+    }
+    return (OSIoMesg *)mesg - pak_dma_mesg;
+}
+
+void pak_pi_finish(const struct pak_request *req) {
+    osInvalDCache(req->dest, req->size);
+    if (req->queue != NULL) {
+        osSendMesg(req->queue, req->mesg, OS_MESG_NOBLOCK);
+    }
+}
+
+uint32_t pak_load_async(void *dest, uint32_t offset, uint32_t size,
+                        pak_priority priority, OSMesgQueue *queue,
+                        OSMesg mesg) {
+    return pak_request_start(dest, offset, size, priority, queue, mesg);
+}
+
+void pak_load_data_sync(void *dest, uint32_t offset, uint32_t size) {
+    pak_wait(pak_load_async(dest, offset, size, PAK_PRI_NORMAL, NULL, NULL));
 }
 
 void pak_init(unsigned asset_count) {
     rom_handle = osCartRomInit();
-    osCreateMesgQueue(&dma_message_queue, &dma_message_buffer, 1);
+    osCreateMesgQueue(&pak_dma_queue, pak_dma_queue_buffer,
+                      ARRAY_COUNT(pak_dma_queue_buffer));
+    pak_asset_count = asset_count;
     if (asset_count > 0) {
         uint32_t offset = (uintptr_t)_pakdata_offset;
         pak_load_data_sync(pak_objects + 1, offset,
@@ -44,15 +89,124 @@ void pak_init(unsigned asset_count) {
     }
 }
 
-void pak_load_asset_sync(void *dest, size_t destsize, int asset_id) {
+// Get an asset and check that it fits in the destination buffer.
+static struct pak_object pak_get_asset(void *dest, size_t destsize,
+                                       int asset_id) {
     struct pak_object obj = pak_objects[asset_id];
     if (obj.size > destsize) {
         fatal_error(
             "Buffer too small to load asset\n\n"
             "Asset ID: %d\nAsset size: %lu\nDest size = %zu\nDest = %p\n",
-            asset_id, obj.size, destsize, dest);
+            asset_id, (unsigned long)obj.size, destsize, dest);
+    }
+    return obj;
+}
+
+// Load and decompress a compressed asset.
+static void pak_load_compressed(void *dest, size_t destsize,
+                                const struct pak_object *restrict obj) {
+    pak_lz_load(dest, destsize, obj);
+    // The decompressed data is in the data cache, but it may be read by the
+    // RSP.
+    osWritebackDCache(dest, obj->size);
+}
+
+// Get the data for an object in the staged group, or NULL if the object is not
+// in the staged group.
+static const uint8_t *pak_staged_data(const struct pak_object *restrict obj) {
+    if (pak_staged.data == NULL || obj->offset < pak_staged.offset ||
+        obj->stored_size > pak_staged.size ||
+        obj->offset - pak_staged.offset > pak_staged.size - obj->stored_size) {
+        return NULL;
+    }
+    return pak_staged.data + (obj->offset - pak_staged.offset);
+}
+
+// Copy or decompress an object from the staged group.
+static void pak_load_staged(void *dest, const struct pak_object *restrict obj,
+                            const uint8_t *src) {
+    if ((obj->flags & PAK_COMPRESSED) != 0) {
+        struct pak_lz st;
+        pak_lz_init(&st, dest, obj->size);
+        if (pak_lz_decode(&st, src, obj->stored_size) != obj->stored_size ||
+            st.out_pos != obj->size) {
+            fatal_error("Corrupt compressed data\nOutput position: %lu",
+                        (unsigned long)st.out_pos);
+        }
+    } else {
+        memcpy(dest, src, obj->size);
+    }
+    osWritebackDCache(dest, obj->size);
+}
+
+uint32_t pak_load_asset_async(void *dest, size_t destsize, int asset_id,
+                              pak_priority priority) {
+    struct pak_object obj = pak_get_asset(dest, destsize, asset_id);
+    const uint8_t *src = pak_staged_data(&obj);
+    if (src != NULL) {
+        pak_load_staged(dest, &obj, src);
+        return 0;
+    }
+    pak_trace_record(asset_id);
+    if ((obj.flags & PAK_COMPRESSED) != 0) {
+        pak_load_compressed(dest, destsize, &obj);
+        return 0;
+    }
+    return pak_load_async(dest, obj.offset, obj.size, priority, NULL, NULL);
+}
+
+void pak_load_asset_sync(void *dest, size_t destsize, int asset_id) {
+    struct pak_object obj = pak_get_asset(dest, destsize, asset_id);
+    const uint8_t *src = pak_staged_data(&obj);
+    if (src != NULL) {
+        pak_load_staged(dest, &obj, src);
+        return;
+    }
+    pak_trace_record(asset_id);
+    if ((obj.flags & PAK_COMPRESSED) != 0) {
+        pak_load_compressed(dest, destsize, &obj);
+    } else {
+        pak_load_data_sync(dest, obj.offset, obj.size);
+    }
+}
+
+void pak_load_group(int group_id, void *buf, size_t bufsize,
+                    void (*member)(int object_id)) {
+    if (pak_staged.data != NULL) {
+        fatal_error("pak_load_group: already loading a group");
+    }
+    struct pak_object obj = pak_get_asset(buf, bufsize, group_id);
+    pak_trace_record(group_id);
+    pak_load_data_sync(buf, obj.offset, obj.size);
+    const struct pak_group_header *restrict hdr = buf;
+    if (obj.size < sizeof(*hdr) ||
+        hdr->count > (obj.size - sizeof(*hdr)) / sizeof(*hdr->object)) {
+        fatal_error("Bad group header\nGroup: %d", group_id);
+    }
+    pak_staged.data = buf;
+    pak_staged.offset = obj.offset;
+    pak_staged.size = obj.size;
+    for (int i = 0; i < hdr->count; i++) {
+        int object_id = hdr->object[i];
+        if (object_id < 1 || pak_asset_count <= (unsigned)object_id) {
+            fatal_error("Bad group member\nGroup: %d\nObject: %d", group_id,
+                        object_id);
+        }
+        member(object_id);
+    }
+    pak_staged.data = NULL;
+}
+
+void pak_load_batch(const struct pak_batch_item *items, int count) {
+    for (int i = 0; i < count; i++) {
+        pak_trace_record(items[i].object);
+    }
+    pak_batch_load(pak_objects, items, count, PAK_BATCH_GAP);
+    // Data copied from the bounce buffer is in the data cache, but it may be
+    // read by the RSP.
+    for (int i = 0; i < count; i++) {
+        osWritebackDCache(items[i].dest, pak_objects[items[i].object].size);
     }
-    pak_load_data_sync(dest, obj.offset, obj.size);
 }
 
 int pak_get_region(void) {
@@ -1,6 +1,11 @@
 // Asset loading.
 #pragma once
 
+#include "base/pak/batch.h"
+#include "base/pak/object.h"
+#include "base/pak/request.h"
+
+#include <stddef.h>
 #include <stdint.h>
 
 #include <ultra64.h>
@@ -8,16 +13,19 @@
 // Handle to access ROM data, from osCartRomInit.
 extern OSPiHandle *rom_handle;
 
-// Descriptor for an object in the pak.
-struct pak_object {
-    uint32_t offset;
-    uint32_t size;
-};
-
 // Asset table. This must be defined in the client somewhere in order to have
 // the correct size.
 extern struct pak_object pak_objects[];
 
+// Start loading PAK data by offset and size. Returns a request ID for pak_wait.
+// Cache writeback and invalidation for the destination are handled here. When
+// the load completes, mesg is sent to queue, if queue is not NULL. Completed
+// loads are only processed by pak_poll and pak_wait, so the main loop must
+// call pak_poll.
+uint32_t pak_load_async(void *dest, uint32_t offset, uint32_t size,
+                        pak_priority priority, OSMesgQueue *queue,
+                        OSMesg mesg);
+
 // Load PAK data by offset and size.
 void pak_load_data_sync(void *dest, uint32_t offset, uint32_t size);
 
@@ -27,7 +35,28 @@ void pak_init(unsigned asset_count);
 // Synchronously load the asset with the given ID. The destsize argument is just
 // the size of the buffer pointed by dest, and it is used for checking that the
 // transfer is valid. If the asset is larger than destsize, this will abort.
+// Compressed assets are decompressed, and may use the entire buffer while
+// loading.
 void pak_load_asset_sync(void *dest, size_t destsize, int asset_id);
 
+// Start loading the asset with the given ID. Returns a request ID for
+// pak_wait. Checks the destination size like pak_load_asset_sync. Compressed
+// assets are loaded synchronously, and the returned ID is zero.
+uint32_t pak_load_asset_async(void *dest, size_t destsize, int asset_id,
+                              pak_priority priority);
+
+// Load a preload group with a single DMA into the given buffer, which must be
+// at least as large as the group object. Then call the member function with
+// the object ID of each member. While the member function runs, loading a
+// member with pak_load_asset_sync or pak_load_asset_async copies or
+// decompresses it from the buffer instead of reading the cartridge.
+void pak_load_group(int group_id, void *buf, size_t bufsize,
+                    void (*member)(int object_id));
+
+// Load a batch of assets. Assets which are close together in the cartridge are
+// merged into one DMA; see pak_batch_load. Does not load from a group staged
+// by pak_load_group.
+void pak_load_batch(const struct pak_batch_item *items, int count);
+
 // Get the region code from the ROM header. Synchronous.
 int pak_get_region(void);
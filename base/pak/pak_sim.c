@@ -0,0 +1,142 @@
+#include "base/pak/sim.h"
+
+#include "base/base.h"
+#include "base/pak/request.h"
+
+#include <string.h>
+
+// A request which the simulated PI has received.
+struct pak_sim_request {
+    const struct pak_request *req; // NULL if slot is unused.
+    unsigned time;                 // Time when the request was started.
+    unsigned seq;                  // Order in which the request was started.
+};
+
+// State of the simulated PI.
+struct pak_sim_state {
+    struct pak_sim_config cfg;
+    unsigned now;
+    unsigned seq;
+
+    // Slot of the request being transferred, or -1 if idle.
+    int active;
+
+    // Time when the active transfer completes, or when the last transfer
+    // completed, if idle.
+    unsigned busy_until;
+
+    struct pak_sim_request request[PAK_REQUEST_COUNT];
+};
+
+static struct pak_sim_state pak_sim;
+
+void (*pak_sim_notify)(void *queue, void *mesg);
+
+void pak_sim_init(const struct pak_sim_config *restrict cfg) {
+    if (cfg->bytes_per_tick == 0) {
+        fatal_error("pak_sim_init: zero transfer rate");
+    }
+    pak_sim = (struct pak_sim_state){
+        .cfg = *cfg,
+        .active = -1,
+    };
+}
+
+void pak_sim_advance(unsigned ticks) {
+    pak_sim.now += ticks;
+}
+
+unsigned pak_sim_time(void) {
+    return pak_sim.now;
+}
+
+// Return true if request a should be transferred before request b, when the PI
+// becomes idle at the given time.
+static bool pak_sim_before(const struct pak_sim_request *restrict a,
+                           const struct pak_sim_request *restrict b,
+                           unsigned idle) {
+    bool a_ready = a->time <= idle, b_ready = b->time <= idle;
+    if (a_ready != b_ready) {
+        return a_ready;
+    }
+    if (!a_ready && a->time != b->time) {
+        return a->time < b->time;
+    }
+    if (a->req->priority != b->req->priority) {
+        return a->req->priority > b->req->priority;
+    }
+    return a->seq < b->seq;
+}
+
+// If the PI is idle, start transferring the next request.
+static void pak_sim_schedule(void) {
+    struct pak_sim_state *restrict st = &pak_sim;
+    if (st->active >= 0) {
+        return;
+    }
+    int next = -1;
+    for (int i = 0; i < PAK_REQUEST_COUNT; i++) {
+        if (st->request[i].req != NULL &&
+            (next < 0 || pak_sim_before(&st->request[i], &st->request[next],
+                                        st->busy_until))) {
+            next = i;
+        }
+    }
+    if (next < 0) {
+        return;
+    }
+    const struct pak_sim_request *restrict sr = &st->request[next];
+    unsigned start = sr->time > st->busy_until ? sr->time : st->busy_until;
+    unsigned duration = st->cfg.latency +
+                        (sr->req->size + st->cfg.bytes_per_tick - 1) /
+                            st->cfg.bytes_per_tick;
+    st->active = next;
+    st->busy_until = start + duration;
+}
+
+void pak_pi_start(int slot, const struct pak_request *req) {
+    struct pak_sim_state *restrict st = &pak_sim;
+    if (st->request[slot].req != NULL) {
+        fatal_error("pak_pi_start: slot in use\nSlot: %d", slot);
+    }
+    if (req->offset > st->cfg.rom_size ||
+        req->size > st->cfg.rom_size - req->offset) {
+        fatal_error("pak_pi_start: read past end of ROM\nOffset: %u\nSize: %u",
+                    (unsigned)req->offset, (unsigned)req->size);
+    }
+    st->request[slot] = (struct pak_sim_request){
+        .req = req,
+        .time = st->now,
+        .seq = st->seq++,
+    };
+    pak_sim_schedule();
+}
+
+int pak_pi_next(bool block) {
+    struct pak_sim_state *restrict st = &pak_sim;
+    if (st->active < 0) {
+        if (block) {
+            fatal_error("pak_pi_next: no requests in flight");
+        }
+        return -1;
+    }
+    if (st->busy_until > st->now) {
+        if (!block) {
+            return -1;
+        }
+        st->now = st->busy_until;
+    }
+    int slot = st->active;
+    const struct pak_request *restrict req = st->request[slot].req;
+    memcpy(req->dest, (const char *)st->cfg.rom + req->offset, req->size);
+    st->request[slot].req = NULL;
+    st->active = -1;
+    pak_sim_schedule();
+    return slot;
+}
+
+void pak_pi_finish(const struct pak_request *req) {
+    if (req->queue != NULL && pak_sim_notify != NULL) {
+        pak_sim_notify(req->queue, req->mesg);
+    }
+}
@@ -0,0 +1,260 @@
+// Test for pak.c, running against the host libultra stand-in. The test writes
+// a ROM image, with the object table at the offset given by the
+// _pakdata_offset symbol, which is defined on the linker command line.
+#include "base/pak/pak.h"
+
+#include "base/base.h"
+#include "base/testlib/testlib.h"
+#include "sdk/host/host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    // Must match the --defsym for _pakdata_offset in BUILD.bazel.
+    PAKDATA = 0x1000,
+
+    // Object IDs.
+    OBJ_A = 1, // Three objects close together.
+    OBJ_B,
+    OBJ_C,
+    OBJ_LZ,    // Compressed object.
+    OBJ_GROUP, // Group containing OBJ_G1 and OBJ_G2.
+    OBJ_G1,
+    OBJ_G2,
+    OBJ_COUNT,
+
+    ROM_SIZE = 64 * 1024,
+    GROUP_HEADER = 8,
+};
+
+struct pak_object pak_objects[OBJ_COUNT];
+
+// Object table, as stored in the ROM image, with offsets relative to the
+// table. Compressed object sizes are filled in when the ROM is created.
+static struct pak_object rom_objects[OBJ_COUNT] = {
+    [OBJ_A] = {.offset = 0x100, .size = 1000, .stored_size = 1000},
+    [OBJ_B] = {.offset = 0x500, .size = 3000, .stored_size = 3000},
+    [OBJ_C] = {.offset = 0x1100, .size = 500, .stored_size = 500},
+    [OBJ_LZ] = {.offset = 0x2000, .flags = PAK_COMPRESSED},
+    [OBJ_GROUP] = {.offset = 0x8000, .size = 1000, .stored_size = 1000},
+    [OBJ_G1] = {.offset = 0x8000 + GROUP_HEADER, .size = 400,
+                .stored_size = 400},
+    [OBJ_G2] = {.offset = 0x8000 + GROUP_HEADER + 400, .size = 592,
+                .stored_size = 592},
+};
+
+static uint8_t rom[ROM_SIZE];
+
+// Decompressed data for OBJ_LZ.
+static uint8_t *lz_data;
+
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        test_logf("could not open %s", quote_str(path));
+        test_fail();
+    }
+    size_t cap = 1024, len = 0;
+    uint8_t *data = malloc(cap);
+    for (;;) {
+        len += fread(data + len, 1, cap - len, fp);
+        if (len < cap) {
+            break;
+        }
+        cap *= 2;
+        data = realloc(data, cap);
+    }
+    fclose(fp);
+    *size = len;
+    return data;
+}
+
+static uint32_t read32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Create the ROM image and write it to a file. Returns the path.
+static const char *make_rom(void) {
+    for (int i = 0; i < ROM_SIZE; i++) {
+        rom[i] = i * 13 + (i >> 8) + 1;
+    }
+    rom[0x3e] = 'E'; // Region.
+
+    size_t size;
+    lz_data = read_file("base/pak/testdata/text.bin", &size);
+    size_t lzsize;
+    uint8_t *lz = read_file("base/pak/testdata/text.lz", &lzsize);
+    struct pak_object *restrict obj = &rom_objects[OBJ_LZ];
+    obj->size = read32(lz);
+    obj->margin = read32(lz + 4);
+    obj->stored_size = lzsize - 8;
+    if (obj->size != size ||
+        obj->offset + obj->stored_size > rom_objects[OBJ_GROUP].offset) {
+        test_logf("bad compressed object");
+        test_fail();
+    }
+    memcpy(rom + PAKDATA + obj->offset, lz + 8, obj->stored_size);
+    free(lz);
+
+    uint16_t header[GROUP_HEADER / 2] = {2, OBJ_G1, OBJ_G2};
+    memcpy(rom + PAKDATA + rom_objects[OBJ_GROUP].offset, header,
+           sizeof(header));
+
+    memcpy(rom + PAKDATA, rom_objects + 1,
+           (OBJ_COUNT - 1) * sizeof(*rom_objects));
+
+    static char path[256];
+    const char *dir = getenv("TEST_TMPDIR");
+    if (dir == NULL) {
+        dir = "/tmp";
+    }
+    snprintf(path, sizeof(path), "%s/pak_test.rom", dir);
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL || fwrite(rom, 1, sizeof(rom), fp) != sizeof(rom) ||
+        fclose(fp) != 0) {
+        test_logf("could not write %s", quote_str(path));
+        test_fail();
+    }
+    return path;
+}
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+// Check that an object was loaded correctly.
+static void check_object(int obj, const uint8_t *data) {
+    const struct pak_object *restrict p = &rom_objects[obj];
+    const uint8_t *expect =
+        obj == OBJ_LZ ? lz_data : rom + PAKDATA + p->offset;
+    if (memcmp(data, expect, p->size) != 0) {
+        test_logf("object %d: data does not match", obj);
+        test_fail();
+    }
+}
+
+static uint8_t buffer[OBJ_COUNT][16 * 1024] __attribute__((aligned(16)));
+
+static void clear_buffers(void) {
+    memset(buffer, 0, sizeof(buffer));
+}
+
+static void test_init(void) {
+    pak_init(OBJ_COUNT);
+    for (int i = 1; i < OBJ_COUNT; i++) {
+        check_int("offset", pak_objects[i].offset,
+                  PAKDATA + rom_objects[i].offset);
+        check_int("size", pak_objects[i].size, rom_objects[i].size);
+    }
+    check_int("region", pak_get_region(), 'E');
+}
+
+static void test_sync(void) {
+    clear_buffers();
+    for (int i = 1; i < OBJ_COUNT; i++) {
+        pak_load_asset_sync(buffer[i], sizeof(buffer[i]), i);
+        check_object(i, buffer[i]);
+    }
+}
+
+static void test_async(void) {
+    clear_buffers();
+    static OSMesgQueue queue;
+    static OSMesg queue_buffer[4];
+    osCreateMesgQueue(&queue, queue_buffer, ARRAY_COUNT(queue_buffer));
+    uint32_t id[3];
+    id[0] = pak_load_asset_async(buffer[OBJ_A], sizeof(buffer[OBJ_A]), OBJ_A,
+                                 PAK_PRI_NORMAL);
+    id[1] = pak_load_asset_async(buffer[OBJ_B], sizeof(buffer[OBJ_B]), OBJ_B,
+                                 PAK_PRI_HIGH);
+    id[2] = pak_load_async(buffer[OBJ_C], pak_objects[OBJ_C].offset,
+                           pak_objects[OBJ_C].size, PAK_PRI_NORMAL, &queue,
+                           (OSMesg)123);
+    for (int i = 0; i < 3; i++) {
+        pak_wait(id[i]);
+    }
+    for (int i = OBJ_A; i <= OBJ_C; i++) {
+        check_object(i, buffer[i]);
+    }
+    OSMesg mesg;
+    if (osRecvMesg(&queue, &mesg, OS_MESG_NOBLOCK) != 0) {
+        test_logf("no completion message");
+        test_fail();
+    }
+    check_int("message", (uintptr_t)mesg, 123);
+    check_int("in flight", pak_poll(), 0);
+}
+
+static void load_member(int object_id) {
+    pak_load_asset_sync(buffer[object_id], sizeof(buffer[object_id]),
+                        object_id);
+}
+
+static void test_group(void) {
+    clear_buffers();
+    unsigned count = host_pi_stats().dma_count;
+    static uint8_t groupbuf[1024] __attribute__((aligned(16)));
+    pak_load_group(OBJ_GROUP, groupbuf, sizeof(groupbuf), load_member);
+    check_int("DMA count", host_pi_stats().dma_count - count, 1);
+    check_object(OBJ_G1, buffer[OBJ_G1]);
+    check_object(OBJ_G2, buffer[OBJ_G2]);
+}
+
+static void test_batch(void) {
+    clear_buffers();
+    struct pak_batch_item items[3];
+    for (int i = 0; i < 3; i++) {
+        int obj = OBJ_A + i;
+        items[i] = (struct pak_batch_item){
+            .object = obj,
+            .dest = buffer[obj],
+            .destsize = sizeof(buffer[obj]),
+        };
+    }
+    unsigned count = host_pi_stats().dma_count;
+    pak_load_batch(items, 3);
+    check_int("DMA count", host_pi_stats().dma_count - count, 1);
+    for (int i = OBJ_A; i <= OBJ_C; i++) {
+        check_object(i, buffer[i]);
+    }
+
+    // A compressed object is read in chunks, and each chunk is counted as a
+    // request.
+    clear_buffers();
+    items[1] = (struct pak_batch_item){
+        .object = OBJ_LZ,
+        .dest = buffer[OBJ_LZ],
+        .destsize = sizeof(buffer[OBJ_LZ]),
+    };
+    count = host_pi_stats().dma_count;
+    uint32_t requests = pak_batch_stats.requests;
+    pak_load_batch(items, 2);
+    check_int("requests", pak_batch_stats.requests - requests,
+              host_pi_stats().dma_count - count);
+    check_object(OBJ_A, buffer[OBJ_A]);
+    check_object(OBJ_LZ, buffer[OBJ_LZ]);
+}
+
+void test_main(void) {
+    host_init(&(struct host_config){
+        .rom = make_rom(),
+        .pi_latency = 20000,
+        .pi_rate = 5,
+    });
+    test_start("init");
+    test_init();
+    test_start("sync");
+    test_sync();
+    test_start("async");
+    test_async();
+    test_start("group");
+    test_group();
+    test_start("batch");
+    test_batch();
+}
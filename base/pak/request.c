@@ -0,0 +1,87 @@
+#include "base/pak/request.h"
+
+#include "base/base.h"
+
+// Requests which are in flight.
+static struct pak_request pak_requests[PAK_REQUEST_COUNT];
+
+// Number of requests in flight.
+static int pak_request_active;
+
+// ID of the most recent request.
+static uint32_t pak_request_last_id;
+
+// Process the next completed request. Returns false if blocking is disabled
+// and no request has completed.
+static bool pak_request_next(bool block) {
+    int slot = pak_pi_next(block);
+    if (slot < 0) {
+        return false;
+    }
+    if (slot >= PAK_REQUEST_COUNT || pak_requests[slot].id == 0) {
+        fatal_error("pak_request_next: bad slot\nSlot: %d", slot);
+    }
+    struct pak_request *restrict req = &pak_requests[slot];
+    pak_pi_finish(req);
+    req->id = 0;
+    pak_request_active--;
+    return true;
+}
+
+uint32_t pak_request_start(void *dest, uint32_t offset, uint32_t size,
+                           pak_priority priority, void *queue, void *mesg) {
+    if (pak_request_active >= PAK_REQUEST_COUNT) {
+        pak_request_next(true);
+    }
+    int slot = 0;
+    while (pak_requests[slot].id != 0) {
+        slot++;
+    }
+    uint32_t id = pak_request_last_id + 1;
+    if (id == 0) {
+        id = 1;
+    }
+    pak_request_last_id = id;
+    struct pak_request *restrict req = &pak_requests[slot];
+    *req = (struct pak_request){
+        .id = id,
+        .dest = dest,
+        .offset = offset,
+        .size = size,
+        .priority = priority,
+        .queue = queue,
+        .mesg = mesg,
+    };
+    pak_request_active++;
+    pak_pi_start(slot, req);
+    return id;
+}
+
+int pak_poll(void) {
+    while (pak_request_active > 0 && pak_request_next(false)) {}
+    return pak_request_active;
+}
+
+bool pak_done(uint32_t id) {
+    if (id == 0) {
+        return true;
+    }
+    for (int i = 0; i < PAK_REQUEST_COUNT; i++) {
+        if (pak_requests[i].id == id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void pak_wait(uint32_t id) {
+    while (!pak_done(id)) {
+        pak_request_next(true);
+    }
+}
+
+void pak_wait_all(void) {
+    while (pak_request_active > 0) {
+        pak_request_next(true);
+    }
+}
@@ -0,0 +1,64 @@
+// Asynchronous pak load requests.
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The request bookkeeping does not depend on libultra. It accesses the PI
+// through the pak_pi functions below, which are implemented by pak.c on the
+// Nintendo 64, and by pak_sim.c on the host.
+
+enum {
+    // Maximum number of load requests in flight at once.
+    PAK_REQUEST_COUNT = 8,
+};
+
+// Priority of a load request. High priority requests are moved to the front
+// of the PI queue.
+typedef enum {
+    PAK_PRI_NORMAL,
+    PAK_PRI_HIGH,
+} pak_priority;
+
+// A load request which is in flight.
+struct pak_request {
+    uint32_t id; // Zero if this request is not in use.
+    void *dest;
+    uint32_t offset;
+    uint32_t size;
+    pak_priority priority;
+    void *queue; // Queue notified when the request completes, or NULL.
+    void *mesg;  // Message sent to the queue.
+};
+
+// Start loading data from the pak. Returns a nonzero request ID. If all
+// requests are in use, this first waits for one to complete. The queue and
+// message are passed to pak_pi_finish when the request completes.
+uint32_t pak_request_start(void *dest, uint32_t offset, uint32_t size,
+                           pak_priority priority, void *queue, void *mesg);
+
+// Process any completed requests, without blocking. Returns the number of
+// requests still in flight.
+int pak_poll(void);
+
+// Return true if the request with the given ID has completed and been
+// processed.
+bool pak_done(uint32_t id);
+
+// Wait until the request with the given ID has completed. Returns immediately
+// if it has already completed.
+void pak_wait(uint32_t id);
+
+// Wait until all requests have completed.
+void pak_wait_all(void);
+
+// Start the PI DMA for a request. The slot identifies the request until it
+// completes.
+void pak_pi_start(int slot, const struct pak_request *req);
+
+// Get the slot of the next request whose DMA has completed. If no DMA has
+// completed, then either block until one completes or return -1.
+int pak_pi_next(bool block);
+
+// Finish a request after its DMA has completed.
+void pak_pi_finish(const struct pak_request *req);
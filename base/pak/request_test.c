@@ -0,0 +1,158 @@
+#include "base/pak/request.h"
+
+#include "base/base.h"
+#include "base/pak/sim.h"
+#include "base/testlib/testlib.h"
+
+#include <string.h>
+
+enum {
+    ROM_SIZE = 4096,
+    LATENCY = 100,
+    BYTES_PER_TICK = 4,
+};
+
+static uint8_t rom[ROM_SIZE];
+
+// Messages received from completed requests, in order.
+static void *notify_mesg[PAK_REQUEST_COUNT * 2];
+static int notify_count;
+
+static void notify(void *queue, void *mesg) {
+    (void)queue;
+    if (notify_count >= (int)ARRAY_COUNT(notify_mesg)) {
+        test_logf("too many notifications");
+        test_fail();
+    }
+    notify_mesg[notify_count++] = mesg;
+}
+
+static void sim_init(void) {
+    for (int i = 0; i < ROM_SIZE; i++) {
+        rom[i] = i * 7 + 3;
+    }
+    pak_sim_init(&(struct pak_sim_config){
+        .rom = rom,
+        .rom_size = sizeof(rom),
+        .latency = LATENCY,
+        .bytes_per_tick = BYTES_PER_TICK,
+    });
+    pak_sim_notify = notify;
+    notify_count = 0;
+}
+
+static unsigned duration(unsigned size) {
+    return LATENCY + size / BYTES_PER_TICK;
+}
+
+static void check_data(const uint8_t *data, uint32_t offset, uint32_t size) {
+    if (memcmp(data, rom + offset, size) != 0) {
+        test_logf("data does not match ROM at offset %u", (unsigned)offset);
+        test_fail();
+    }
+}
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+static void test_latency(void) {
+    test_start("latency");
+    sim_init();
+    static uint8_t buf[64];
+    uint32_t id = pak_request_start(buf, 128, sizeof(buf), PAK_PRI_NORMAL,
+                                    NULL, NULL);
+    check_int("id", id != 0, 1);
+    check_int("in flight", pak_poll(), 1);
+    pak_sim_advance(duration(sizeof(buf)) - 1);
+    check_int("in flight", pak_poll(), 1);
+    check_int("done", pak_done(id), 0);
+    pak_sim_advance(1);
+    check_int("in flight", pak_poll(), 0);
+    check_int("done", pak_done(id), 1);
+    check_data(buf, 128, sizeof(buf));
+    // Waiting for a completed request returns immediately.
+    unsigned t = pak_sim_time();
+    pak_wait(id);
+    pak_wait(0);
+    check_int("time", pak_sim_time(), t);
+}
+
+static void test_serial(void) {
+    test_start("serial");
+    sim_init();
+    static uint8_t buf[3][256];
+    uint32_t id[3];
+    for (int i = 0; i < 3; i++) {
+        id[i] = pak_request_start(buf[i], 512 * i, sizeof(buf[i]),
+                                  PAK_PRI_NORMAL, NULL, NULL);
+    }
+    pak_wait(id[1]);
+    check_int("time", pak_sim_time(), 2 * duration(sizeof(buf[0])));
+    check_int("done 0", pak_done(id[0]), 1);
+    check_int("done 2", pak_done(id[2]), 0);
+    pak_wait_all();
+    check_int("time", pak_sim_time(), 3 * duration(sizeof(buf[0])));
+    for (int i = 0; i < 3; i++) {
+        check_data(buf[i], 512 * i, sizeof(buf[i]));
+    }
+}
+
+static void test_priority(void) {
+    test_start("priority");
+    sim_init();
+    static uint8_t buf[3][32];
+    static int queue;
+    static const pak_priority pri[3] = {PAK_PRI_NORMAL, PAK_PRI_NORMAL,
+                                        PAK_PRI_HIGH};
+    for (int i = 0; i < 3; i++) {
+        pak_request_start(buf[i], 64 * i, sizeof(buf[i]), pri[i], &queue,
+                          &buf[i]);
+    }
+    pak_wait_all();
+    // The first request was already being transferred when the high priority
+    // request arrived.
+    static const int order[3] = {0, 2, 1};
+    check_int("notify count", notify_count, 3);
+    for (int i = 0; i < 3; i++) {
+        if (notify_mesg[i] != &buf[order[i]]) {
+            test_logf("completion %d is not request %d", i, order[i]);
+            test_fail();
+        }
+    }
+}
+
+static void test_full(void) {
+    test_start("full");
+    sim_init();
+    enum { COUNT = PAK_REQUEST_COUNT * 2 };
+    static uint8_t buf[COUNT][16];
+    static int queue;
+    uint32_t id[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        id[i] = pak_request_start(buf[i], 16 * i, sizeof(buf[i]),
+                                  PAK_PRI_NORMAL, &queue, &buf[i]);
+        check_int("in flight", pak_poll(), i < PAK_REQUEST_COUNT ? i + 1 : 8);
+    }
+    check_int("notify count", notify_count, PAK_REQUEST_COUNT);
+    pak_wait_all();
+    check_int("notify count", notify_count, COUNT);
+    for (int i = 0; i < COUNT; i++) {
+        check_int("done", pak_done(id[i]), 1);
+        check_data(buf[i], 16 * i, sizeof(buf[i]));
+        if (notify_mesg[i] != &buf[i]) {
+            test_logf("completion %d out of order", i);
+            test_fail();
+        }
+    }
+}
+
+void test_main(void) {
+    test_latency();
+    test_serial();
+    test_priority();
+    test_full();
+}
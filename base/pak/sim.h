@@ -0,0 +1,31 @@
+// Simulated PI for testing pak loading on the host.
+#pragma once
+
+#include <stddef.h>
+
+// Parameters for the simulated PI. Times are in ticks of the simulated clock.
+struct pak_sim_config {
+    // ROM image to load data from.
+    const void *rom;
+    size_t rom_size;
+
+    // Time from the start of a DMA to the first byte.
+    unsigned latency;
+
+    // Transfer rate, in bytes per tick. Must be nonzero.
+    unsigned bytes_per_tick;
+};
+
+// Reset the simulated PI. There must not be any requests in flight.
+void pak_sim_init(const struct pak_sim_config *restrict cfg);
+
+// Advance the simulated clock. DMAs only complete when the clock advances, or
+// when waiting for a request to complete.
+void pak_sim_advance(unsigned ticks);
+
+// Get the current time of the simulated clock.
+unsigned pak_sim_time(void);
+
+// Function called when a request completes, with the request's queue and
+// message. Only called for requests with a non-NULL queue.
+extern void (*pak_sim_notify)(void *queue, void *mesg);
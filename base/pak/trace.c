@@ -0,0 +1,37 @@
+#include "base/pak/trace.h"
+
+#include "base/base.h"
+#include "base/console.h"
+
+#include <string.h>
+
+struct pak_trace pak_trace;
+
+// True if loads are being recorded.
+static bool pak_trace_enabled;
+
+void pak_trace_start(void) {
+    pak_trace = (struct pak_trace){.count = 0};
+    memcpy(pak_trace.magic, "PAKTRACE", sizeof(pak_trace.magic));
+    pak_trace_enabled = true;
+}
+
+void pak_trace_stop(void) {
+    pak_trace_enabled = false;
+}
+
+void pak_trace_record(int object_id) {
+    if (!pak_trace_enabled) {
+        return;
+    }
+    if (pak_trace.count >= PAK_TRACE_SIZE) {
+        pak_trace.dropped++;
+        return;
+    }
+    pak_trace.object[pak_trace.count++] = object_id;
+}
+
+void pak_trace_print(void) {
+    cprintf("Pak trace: %lu loads, %lu dropped\n",
+            (unsigned long)pak_trace.count, (unsigned long)pak_trace.dropped);
+}
@@ -0,0 +1,41 @@
+// Pak load tracing.
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A trace records the sequence of objects loaded from the cartridge. Traces
+// are read from a memory dump by tools/paktrace, and makepak uses them to
+// store objects which are loaded one after another next to each other, so a
+// loader can coalesce the loads. Only loads which start a DMA are recorded:
+// members of a group are recorded as a load of the group.
+
+enum {
+    // Maximum number of loads in a trace.
+    PAK_TRACE_SIZE = 2048,
+};
+
+// A trace buffer. This can be found in a memory dump by its magic, so the
+// layout must match tools/paktrace.
+struct pak_trace {
+    char magic[8];     // "PAKTRACE".
+    uint32_t count;    // Number of loads recorded.
+    uint32_t dropped;  // Number of loads not recorded, because it was full.
+    uint16_t object[PAK_TRACE_SIZE]; // Object ID for each load.
+};
+
+// The current trace.
+extern struct pak_trace pak_trace;
+
+// Clear the trace and start recording loads.
+void pak_trace_start(void);
+
+// Stop recording loads.
+void pak_trace_stop(void);
+
+// Record a load of the given object, if recording.
+void pak_trace_record(int object_id);
+
+// Print a summary of the trace to the console. The console is too small for
+// the full trace, which is read from the trace buffer in a memory dump.
+void pak_trace_print(void);
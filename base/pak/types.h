@@ -41,3 +41,8 @@ typedef struct pak_track {
 } pak_track;
 
 #define TRACK_NONE ((pak_track){0})
+
+// Identifier for a group of assets which are loaded together.
+typedef struct pak_group {
+    int id;
+} pak_group;
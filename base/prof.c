@@ -0,0 +1,229 @@
+#include "base/prof.h"
+
+#include "base/base.h"
+#include "base/console.h"
+#include "base/ticks.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+static_assert((PROF_FRAMES & (PROF_FRAMES - 1)) == 0);
+static_assert(PROF_NAMES <= 256);
+
+struct prof_ring prof_ring;
+
+// Stack of open zones, as indexes into the current frame's zones, or -1 for
+// zones which were dropped.
+static int prof_stack[PROF_DEPTH];
+static int prof_depth;
+
+// Whether prof_next_frame has been called. Zones before then are discarded.
+static bool prof_started;
+
+// Set up the ring buffer header, if this has not been done yet.
+static void prof_init(void) {
+    struct prof_ring *restrict r = &prof_ring;
+    if (r->name_count != 0) {
+        return;
+    }
+    memcpy(r->magic, "PROFRING", sizeof(r->magic));
+    r->rate = TICKS_RATE;
+    // Name 0 is not used, so the first PROF_BEGIN can tell that the name has
+    // not been added yet.
+    r->name_count = 1;
+}
+
+static struct prof_frame *prof_current(void) {
+    return &prof_ring.frames[prof_ring.frame & (PROF_FRAMES - 1)];
+}
+
+int prof_intern(const char *name) {
+    struct prof_ring *restrict r = &prof_ring;
+    prof_init();
+    for (unsigned i = 1; i < r->name_count; i++) {
+        if (strncmp(r->name[i], name, PROF_NAME_SIZE - 1) == 0) {
+            return i;
+        }
+    }
+    if (r->name_count >= PROF_NAMES) {
+        fatal_error("Too many profiler zones\nName: %s", name);
+    }
+    int index = r->name_count++;
+    strncpy(r->name[index], name, PROF_NAME_SIZE - 1);
+    return index;
+}
+
+void prof_begin(int name) {
+    uint32_t now = ticks_now();
+    if (prof_depth >= PROF_DEPTH) {
+        fatal_error("Profiler zones nested too deeply\nName: %s",
+                    prof_ring.name[name]);
+    }
+    struct prof_frame *restrict f = prof_current();
+    int index = -1;
+    if (f->count < PROF_ZONES) {
+        index = f->count++;
+        f->zone[index] = (struct prof_zone){
+            .start = now - f->start,
+            .name = name,
+            .depth = prof_depth,
+        };
+    } else {
+        f->dropped++;
+    }
+    prof_stack[prof_depth++] = index;
+}
+
+void prof_end(void) {
+    uint32_t now = ticks_now();
+    if (prof_depth == 0) {
+        fatal_error("PROF_END without PROF_BEGIN");
+    }
+    int index = prof_stack[--prof_depth];
+    if (index >= 0) {
+        struct prof_frame *restrict f = prof_current();
+        f->zone[index].duration = now - f->start - f->zone[index].start;
+    }
+}
+
+void prof_next_frame(void) {
+    uint32_t now = ticks_now();
+    if (prof_depth != 0) {
+        int index = prof_stack[prof_depth - 1];
+        const char *name = "(dropped)";
+        if (index >= 0) {
+            name = prof_ring.name[prof_current()->zone[index].name];
+        }
+        fatal_error("Profiler zone not ended\nName: %s", name);
+    }
+    prof_init();
+    struct prof_frame *restrict f = prof_current();
+    if (prof_started) {
+        f->duration = now - f->start;
+        prof_ring.frame++;
+        f = prof_current();
+    }
+    prof_started = true;
+    *f = (struct prof_frame){.start = now};
+}
+
+// Get the number of complete frames in the ring buffer.
+static int prof_frame_count(void) {
+    return prof_ring.frame < PROF_FRAMES - 1 ? (int)prof_ring.frame
+                                             : PROF_FRAMES - 1;
+}
+
+static const struct prof_frame *prof_get_frame(int age) {
+    return &prof_ring.frames[(prof_ring.frame - age) & (PROF_FRAMES - 1)];
+}
+
+// A node in the averaged tree. Zones in different frames are the same node if
+// they have the same name and their parents are the same node.
+struct prof_node {
+    uint8_t name;
+    uint8_t depth;
+    int8_t parent; // Index of parent node, or -1.
+    uint32_t total; // Total duration, in ticks.
+    uint16_t calls; // Number of zones.
+};
+
+// Averaged tree of zones.
+struct prof_tree {
+    struct prof_node node[PROF_ZONES * 2];
+    int count;
+    int frames; // Number of frames averaged.
+};
+
+static void prof_print_node(struct console *cs,
+                            const struct prof_tree *restrict t, int index) {
+    const struct prof_node *restrict n = &t->node[index];
+    console_printf(cs, "%*s%-*s %7.3f %5.1f\n", n->depth, "",
+                   PROF_NAME_SIZE + 8 - n->depth, prof_ring.name[n->name],
+                   (double)n->total * (1e3 / TICKS_RATE) / t->frames,
+                   (double)n->calls / t->frames);
+    for (int i = index + 1; i < t->count; i++) {
+        if (t->node[i].parent == index) {
+            prof_print_node(cs, t, i);
+        }
+    }
+}
+
+void prof_print(struct console *cs) {
+    static struct prof_tree tree;
+    struct prof_tree *restrict t = &tree;
+    t->count = 0;
+    t->frames = prof_frame_count();
+    if (t->frames == 0) {
+        return;
+    }
+    uint32_t frame_total = 0;
+    bool overflow = false;
+    for (int age = 1; age <= t->frames; age++) {
+        const struct prof_frame *restrict f = prof_get_frame(age);
+        frame_total += f->duration;
+        // Node for the innermost zone at each depth.
+        int parent[PROF_DEPTH];
+        for (int i = 0; i < f->count; i++) {
+            const struct prof_zone *restrict z = &f->zone[i];
+            int p = z->depth > 0 ? parent[z->depth - 1] : -1;
+            int node = -1;
+            for (int j = p + 1; j < t->count; j++) {
+                if (t->node[j].parent == p && t->node[j].name == z->name) {
+                    node = j;
+                    break;
+                }
+            }
+            if (node < 0) {
+                if (t->count >= (int)ARRAY_COUNT(t->node)) {
+                    overflow = true;
+                    break;
+                }
+                node = t->count++;
+                t->node[node] = (struct prof_node){
+                    .name = z->name,
+                    .depth = z->depth,
+                    .parent = p,
+                };
+            }
+            t->node[node].total += z->duration;
+            t->node[node].calls++;
+            parent[z->depth] = node;
+        }
+    }
+    // Times are averaged per frame, in milliseconds.
+    console_printf(cs, "%-*s %7s %5s\n", PROF_NAME_SIZE + 8, "zone", "ms",
+                   "calls");
+    console_printf(cs, "%-*s %7.3f\n", PROF_NAME_SIZE + 8, "frame",
+                   (double)frame_total * (1e3 / TICKS_RATE) / t->frames);
+    for (int i = 0; i < t->count; i++) {
+        if (t->node[i].parent < 0) {
+            prof_print_node(cs, t, i);
+        }
+    }
+    if (overflow) {
+        console_puts(cs, "(too many zones)\n");
+    }
+}
+
+// Convert a duration from ticks to microseconds.
+static unsigned prof_micros(uint32_t ticks) {
+    return (uint64_t)ticks * 1000000 / TICKS_RATE;
+}
+
+void prof_dump(struct console *cs) {
+    if (prof_frame_count() == 0) {
+        return;
+    }
+    const struct prof_frame *restrict f = prof_get_frame(1);
+    const unsigned frame = prof_ring.frame - 1;
+    console_printf(cs, "prof: %u frame %u\n", frame, prof_micros(f->duration));
+    for (int i = 0; i < f->count; i++) {
+        const struct prof_zone *restrict z = &f->zone[i];
+        console_printf(cs, "prof: %u %d %u %u %s\n", frame, z->depth,
+                       prof_micros(z->start), prof_micros(z->duration),
+                       prof_ring.name[z->name]);
+    }
+    if (f->dropped != 0) {
+        console_printf(cs, "prof: %u dropped %d\n", frame, f->dropped);
+    }
+}
@@ -0,0 +1,120 @@
+// Per-frame CPU profiler.
+#pragma once
+
+#include <stdint.h>
+
+struct console;
+
+// The profiler records the time spent in nested zones, marked with PROF_BEGIN
+// and PROF_END, for each of the last PROF_FRAMES frames. Call prof_next_frame
+// at the start of each frame. Zone names are copied into the profiler the
+// first time each zone is entered, so they can be read from a memory dump.
+// Names must not contain spaces.
+//
+// Profiling should only be done from the main thread.
+
+// Whether profiling is compiled in. If 0, PROF_BEGIN and PROF_END do nothing.
+#ifndef PROF_ENABLE
+#ifdef NDEBUG
+#define PROF_ENABLE 0
+#else
+#define PROF_ENABLE 1
+#endif
+#endif
+
+enum {
+    // Number of frames in the ring buffer. Must be a power of two.
+    PROF_FRAMES = 16,
+
+    // Maximum number of zones recorded in each frame.
+    PROF_ZONES = 32,
+
+    // Maximum number of distinct zone names.
+    PROF_NAMES = 32,
+
+    // Size of a zone name, including the nul terminator. Longer names are
+    // truncated.
+    PROF_NAME_SIZE = 16,
+
+    // Maximum nesting depth of zones.
+    PROF_DEPTH = 8,
+};
+
+// A zone in a frame.
+struct prof_zone {
+    uint32_t start;    // Start time, in ticks, relative to frame start.
+    uint32_t duration; // Duration, in ticks.
+    uint8_t name;      // Index into names.
+    uint8_t depth;     // Nesting depth, 0 for top-level zones.
+    uint16_t pad;
+};
+
+// A recorded frame. Zones are stored in the order they started, so each zone's
+// parent is the closest previous zone with a smaller depth.
+struct prof_frame {
+    uint32_t start;    // Start time, in ticks.
+    uint32_t duration; // Duration, in ticks.
+    uint16_t count;    // Number of zones recorded.
+    uint16_t dropped;  // Number of zones not recorded, because it was full.
+    struct prof_zone zone[PROF_ZONES];
+};
+
+// The profiler ring buffer. This can be found in a memory dump by its magic,
+// so the layout must match tools/proftrace.
+struct prof_ring {
+    char magic[8];      // "PROFRING".
+    uint32_t rate;      // Clock rate, in ticks per second.
+    uint32_t frame;     // Sequence number of the current frame.
+    uint32_t name_count;
+    char name[PROF_NAMES][PROF_NAME_SIZE];
+    struct prof_frame frames[PROF_FRAMES];
+};
+
+extern struct prof_ring prof_ring;
+
+#if PROF_ENABLE
+
+// Start a zone with the given name, which must be a string literal.
+#define PROF_BEGIN(name)                     \
+    do {                                     \
+        static uint8_t prof_name_;           \
+        if (prof_name_ == 0) {               \
+            prof_name_ = prof_intern(name);  \
+        }                                    \
+        prof_begin(prof_name_);              \
+    } while (0)
+
+// End the innermost zone.
+#define PROF_END() prof_end()
+
+#else
+
+#define PROF_BEGIN(name) \
+    do {                 \
+    } while (0)
+#define PROF_END() \
+    do {           \
+    } while (0)
+
+#endif
+
+// Get the index of a zone name, adding it if necessary. Returns a nonzero
+// index. Use PROF_BEGIN instead.
+int prof_intern(const char *name);
+
+// Start a zone, given the index of its name. Use PROF_BEGIN instead.
+void prof_begin(int name);
+
+// End the innermost zone.
+void prof_end(void);
+
+// Finish the current frame and start the next one. All zones must be ended.
+void prof_next_frame(void);
+
+// Print the average time spent in each zone over the recorded frames to a
+// console, as a tree.
+void prof_print(struct console *cs);
+
+// Print the most recent complete frame to a console, in the text format read
+// by tools/proftrace.
+void prof_dump(struct console *cs);
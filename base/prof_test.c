@@ -0,0 +1,165 @@
+#include "base/prof.h"
+
+#include "base/base.h"
+#include "base/console_internal.h"
+#include "base/testlib/testlib.h"
+
+#include <string.h>
+
+static struct console cs;
+
+// Check that the console contains the given lines.
+static void check_lines(const char *const *lines, int count) {
+    struct console_rowptr rows[CON_ROWS];
+    int nrows = console_rows(&cs, rows);
+    if (nrows != count) {
+        test_logf("got %d rows, expect %d", nrows, count);
+        test_fail();
+    }
+    for (int i = 0; i < nrows && i < count; i++) {
+        size_t len = rows[i].end - rows[i].start;
+        if (len != strlen(lines[i]) ||
+            memcmp(rows[i].start, lines[i], len) != 0) {
+            test_logf("row %d: got %s", i, quote_mem(rows[i].start, len));
+            test_logf("expect %s", quote_str(lines[i]));
+            test_fail();
+        }
+    }
+}
+
+// Get the most recent complete frame.
+static const struct prof_frame *last_frame(void) {
+    return &prof_ring.frames[(prof_ring.frame - 1) & (PROF_FRAMES - 1)];
+}
+
+static void test_zones(void) {
+    test_start("zones");
+    prof_next_frame();
+    PROF_BEGIN("update");
+    for (int i = 0; i < 2; i++) {
+        PROF_BEGIN("physics");
+        PROF_END();
+    }
+    PROF_END();
+    PROF_BEGIN("render");
+    PROF_END();
+    prof_next_frame();
+    if (memcmp(prof_ring.magic, "PROFRING", 8) != 0) {
+        test_logf("bad magic");
+        test_fail();
+    }
+    const struct prof_frame *restrict f = last_frame();
+    static const struct {
+        const char *name;
+        int depth;
+    } expect[] = {{"update", 0}, {"physics", 1}, {"physics", 1}, {"render", 0}};
+    if (f->count != ARRAY_COUNT(expect) || f->dropped != 0) {
+        test_logf("got %d zones, %d dropped, expect %zu zones", f->count,
+                  f->dropped, ARRAY_COUNT(expect));
+        test_fail();
+    }
+    for (size_t i = 0; i < ARRAY_COUNT(expect); i++) {
+        const struct prof_zone *restrict z = &f->zone[i];
+        const char *name = prof_ring.name[z->name];
+        if (strcmp(name, expect[i].name) != 0 || z->depth != expect[i].depth) {
+            test_logf("zone %zu: got %s depth %d, expect %s depth %d", i,
+                      quote_str(name), z->depth, quote_str(expect[i].name),
+                      expect[i].depth);
+            test_fail();
+        }
+        if (z->start + z->duration > f->duration) {
+            test_logf("zone %zu is outside the frame", i);
+            test_fail();
+        }
+    }
+    // Children are inside their parent.
+    const struct prof_zone *restrict z = f->zone;
+    if (z[1].start < z[0].start ||
+        z[2].start + z[2].duration > z[0].start + z[0].duration) {
+        test_logf("child zones are outside parent");
+        test_fail();
+    }
+}
+
+static void test_dropped(void) {
+    test_start("dropped");
+    prof_next_frame();
+    for (int i = 0; i < PROF_ZONES + 2; i++) {
+        PROF_BEGIN("many");
+        PROF_END();
+    }
+    prof_next_frame();
+    const struct prof_frame *restrict f = last_frame();
+    if (f->count != PROF_ZONES || f->dropped != 2) {
+        test_logf("got %d zones, %d dropped; expect %d zones, 2 dropped",
+                  f->count, f->dropped, PROF_ZONES);
+        test_fail();
+    }
+}
+
+// Replace the recorded frames with two frames with known times. The host clock
+// has microsecond ticks.
+static void set_frames(void) {
+    int update = prof_intern("update");
+    int physics = prof_intern("physics");
+    int render = prof_intern("render");
+    memset(prof_ring.frames, 0, sizeof(prof_ring.frames));
+    prof_ring.frame = 2;
+    prof_ring.frames[0] = (struct prof_frame){
+        .duration = 16000,
+        .count = 4,
+        .zone =
+            {
+                {.start = 0, .duration = 5000, .name = update},
+                {.start = 1000, .duration = 1000, .name = physics, .depth = 1},
+                {.start = 3000, .duration = 1000, .name = physics, .depth = 1},
+                {.start = 5000, .duration = 8000, .name = render},
+            },
+    };
+    prof_ring.frames[1] = (struct prof_frame){
+        .duration = 18000,
+        .count = 2,
+        .dropped = 1,
+        .zone =
+            {
+                {.start = 0, .duration = 3000, .name = update},
+                {.start = 1000, .duration = 1500, .name = physics, .depth = 1},
+            },
+    };
+}
+
+static void test_print(void) {
+    test_start("print");
+    set_frames();
+    console_init(&cs, CONSOLE_TRUNCATE);
+    prof_print(&cs);
+    static const char *const lines[] = {
+        "zone                          ms calls",
+        "frame                     17.000",
+        "update                     4.000   1.0",
+        " physics                   1.750   1.5",
+        "render                     4.000   0.5",
+    };
+    check_lines(lines, ARRAY_COUNT(lines));
+}
+
+static void test_dump(void) {
+    test_start("dump");
+    set_frames();
+    console_init(&cs, CONSOLE_TRUNCATE);
+    prof_dump(&cs);
+    static const char *const lines[] = {
+        "prof: 1 frame 18000",
+        "prof: 1 0 0 3000 update",
+        "prof: 1 1 1000 1500 physics",
+        "prof: 1 dropped 1",
+    };
+    check_lines(lines, ARRAY_COUNT(lines));
+}
+
+void test_main(void) {
+    test_zones();
+    test_dropped();
+    test_print();
+    test_dump();
+}
@@ -0,0 +1,30 @@
+#include "base/random.h"
+
+#include "base/testlib/bench.h"
+#include "base/testlib/testlib.h"
+
+#include <stdint.h>
+
+static struct rand rng;
+
+static void bench_rand_next(long count) {
+    uint32_t x = 0;
+    for (long i = 0; i < count; i++) {
+        x ^= rand_next(&rng);
+    }
+    bench_sink(x);
+}
+
+static void bench_rand_frange(long count) {
+    float x = 0.0f;
+    for (long i = 0; i < count; i++) {
+        x += rand_frange(&rng, -1.0f, 1.0f);
+    }
+    bench_sink(x);
+}
+
+void test_main(void) {
+    rand_init(&rng, 1, 2);
+    bench_run("rand_next", bench_rand_next);
+    bench_run("rand_frange", bench_rand_frange);
+}
@@ -0,0 +1,112 @@
+#include "base/residency.h"
+
+#include "base/base.h"
+
+void residency_init(struct residency *restrict r, const char *name,
+                    int slot_count, int asset_count, unsigned latency,
+                    void (*load)(int asset, int slot)) {
+    *r = (struct residency){
+        .name = name,
+        .slot_count = slot_count,
+        .asset_count = asset_count,
+        .slot = mem_calloc(sizeof(*r->slot) * slot_count),
+        .to_slot = mem_calloc(sizeof(*r->to_slot) * (asset_count + 1)),
+        .load = load,
+        .latency = latency,
+    };
+}
+
+void residency_set_frame(struct residency *restrict r, unsigned frame) {
+    r->frame = frame;
+}
+
+int residency_find(const struct residency *restrict r, int asset) {
+    if (asset < 1 || r->asset_count < asset) {
+        return -1;
+    }
+    int slot = r->to_slot[asset];
+    return r->slot[slot].asset == asset ? slot : -1;
+}
+
+// Find a slot to load a new asset into. Returns -1 if there is none. Empty
+// slots are only returned if allow_empty is true.
+static int residency_victim(const struct residency *restrict r,
+                            bool allow_empty) {
+    int best = -1;
+    unsigned best_age = 0;
+    for (int i = 0; i < r->slot_count; i++) {
+        const struct residency_slot *restrict sp = &r->slot[i];
+        if (sp->asset == 0) {
+            if (allow_empty) {
+                return i;
+            }
+            continue;
+        }
+        unsigned age = r->frame - sp->last_use;
+        if (sp->pin == 0 && age >= r->latency && (best < 0 || age > best_age)) {
+            best = i;
+            best_age = age;
+        }
+    }
+    return best;
+}
+
+int residency_try_use(struct residency *restrict r, int asset) {
+    if (asset < 1 || r->asset_count < asset) {
+        fatal_error("%s: invalid asset\nAsset: %d", r->name, asset);
+    }
+    int slot = r->to_slot[asset];
+    struct residency_slot *restrict sp = &r->slot[slot];
+    if (sp->asset == asset) {
+        r->stats.hit++;
+        sp->last_use = r->frame;
+        return slot;
+    }
+    slot = residency_victim(r, true);
+    if (slot < 0) {
+        r->stats.full++;
+        return -1;
+    }
+    r->stats.miss++;
+    sp = &r->slot[slot];
+    if (sp->asset != 0) {
+        r->stats.evict++;
+    }
+    *sp = (struct residency_slot){
+        .asset = asset,
+        .last_use = r->frame,
+    };
+    r->to_slot[asset] = slot;
+    r->load(asset, slot);
+    return slot;
+}
+
+int residency_use(struct residency *restrict r, int asset) {
+    int slot = residency_try_use(r, asset);
+    if (slot < 0) {
+        fatal_error("%s: no slots available\nAsset: %d\nSlots: %d", r->name,
+                    asset, r->slot_count);
+    }
+    return slot;
+}
+
+int residency_evict(struct residency *restrict r) {
+    int slot = residency_victim(r, false);
+    if (slot >= 0) {
+        r->stats.evict++;
+        r->slot[slot] = (struct residency_slot){0};
+    }
+    return slot;
+}
+
+void residency_pin(struct residency *restrict r, int slot) {
+    r->slot[slot].pin++;
+}
+
+void residency_unpin(struct residency *restrict r, int slot) {
+    struct residency_slot *restrict sp = &r->slot[slot];
+    if (sp->pin <= 0) {
+        fatal_error("%s: slot not pinned\nSlot: %d", r->name, slot);
+    }
+    sp->pin--;
+}
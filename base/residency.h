@@ -0,0 +1,73 @@
+// Residency manager for assets loaded into a fixed set of slots.
+#pragma once
+
+#include <stdbool.h>
+
+// A slot which can hold one asset.
+struct residency_slot {
+    int asset;         // Asset ID, or zero if the slot is empty.
+    unsigned last_use; // Frame when the asset was last used.
+    int pin;           // Pin count. Pinned assets are never evicted.
+};
+
+// Residency statistics, since initialization.
+struct residency_stats {
+    unsigned hit;   // Uses of an asset which was already loaded.
+    unsigned miss;  // Uses of an asset which had to be loaded.
+    unsigned evict; // Assets evicted to make room for other assets.
+    unsigned full;  // Uses which failed because no slot could be evicted.
+};
+
+// Tracks which assets are loaded into which slots. When an asset is used and
+// no slot is free, the least recently used asset is evicted.
+struct residency {
+    const char *name;
+    int slot_count;
+    int asset_count;
+    struct residency_slot *slot;
+
+    // Map from asset ID to slot. Only valid if the slot maps back to the same
+    // asset.
+    int *to_slot;
+
+    // Function which loads an asset into a slot.
+    void (*load)(int asset, int slot);
+
+    // Current frame, and the number of frames after its last use that an
+    // asset may still be in use by the RCP, and cannot be evicted.
+    unsigned frame;
+    unsigned latency;
+
+    struct residency_stats stats;
+};
+
+// Initialize a residency manager. Asset IDs range from 1 to asset_count.
+void residency_init(struct residency *restrict r, const char *name,
+                    int slot_count, int asset_count, unsigned latency,
+                    void (*load)(int asset, int slot));
+
+// Set the current frame. Frames should increase by one each time.
+void residency_set_frame(struct residency *restrict r, unsigned frame);
+
+// Get the slot for an asset, and mark it as used in the current frame. If the
+// asset is not loaded, this evicts the least recently used asset if necessary,
+// and loads the asset. Aborts if every slot is pinned or in use.
+int residency_use(struct residency *restrict r, int asset);
+
+// Like residency_use, but returns -1 instead of aborting if the asset is not
+// loaded and every slot is pinned or in use.
+int residency_try_use(struct residency *restrict r, int asset);
+
+// Get the slot for an asset, or -1 if it is not loaded. Does not mark the
+// asset as used.
+int residency_find(const struct residency *restrict r, int asset);
+
+// Evict the least recently used asset which is not pinned or in use, leaving
+// its slot empty. Returns the slot, or -1 if no asset can be evicted. This can
+// be called from the load function, to make room for a variable-size asset.
+int residency_evict(struct residency *restrict r);
+
+// Pin or unpin the asset in a slot. Pins are counted, and the asset cannot be
+// evicted until it is unpinned as many times as it is pinned.
+void residency_pin(struct residency *restrict r, int slot);
+void residency_unpin(struct residency *restrict r, int slot);
@@ -0,0 +1,172 @@
+#include "base/residency.h"
+
+#include "base/base.h"
+#include "base/testlib/testlib.h"
+
+enum {
+    SLOTS = 3,
+    ASSETS = 10,
+    LATENCY = 2,
+};
+
+static struct residency res;
+
+// Asset loaded into each slot by the load callback.
+static int loaded[SLOTS];
+static int load_count;
+
+static void load(int asset, int slot) {
+    loaded[slot] = asset;
+    load_count++;
+}
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+static void init(void) {
+    residency_init(&res, "test", SLOTS, ASSETS, LATENCY, load);
+    for (int i = 0; i < SLOTS; i++) {
+        loaded[i] = 0;
+    }
+    load_count = 0;
+}
+
+// Use an asset and check that it is loaded.
+static int use(int asset) {
+    int slot = residency_use(&res, asset);
+    check_int("loaded asset", loaded[slot], asset);
+    check_int("find", residency_find(&res, asset), slot);
+    return slot;
+}
+
+static void test_hit(void) {
+    test_start("hit");
+    init();
+    int a = use(1), b = use(2);
+    check_int("slot", use(1), a);
+    check_int("slot", use(2), b);
+    check_int("loads", load_count, 2);
+    check_int("hit", res.stats.hit, 2);
+    check_int("miss", res.stats.miss, 2);
+    check_int("evict", res.stats.evict, 0);
+    check_int("find", residency_find(&res, 3), -1);
+}
+
+static void test_lru(void) {
+    test_start("lru");
+    init();
+    for (int i = 1; i <= SLOTS; i++) {
+        residency_set_frame(&res, i);
+        use(i);
+    }
+    // Asset 1 was used most recently, so asset 2 is evicted.
+    residency_set_frame(&res, 10);
+    use(1);
+    int slot2 = residency_find(&res, 2);
+    check_int("slot", use(4), slot2);
+    check_int("evicted", residency_find(&res, 2), -1);
+    check_int("evict", res.stats.evict, 1);
+    // Asset 3 is next.
+    int slot3 = residency_find(&res, 3);
+    check_int("slot", use(5), slot3);
+    check_int("evict", res.stats.evict, 2);
+}
+
+static void test_latency(void) {
+    test_start("latency");
+    init();
+    for (int i = 1; i <= SLOTS; i++) {
+        use(i);
+    }
+    // Assets used in the last LATENCY frames may still be in use by the RCP.
+    residency_set_frame(&res, LATENCY - 1);
+    use(1);
+    residency_set_frame(&res, LATENCY);
+    use(2);
+    int slot3 = residency_find(&res, 3);
+    check_int("slot", use(4), slot3);
+    int slot1 = residency_find(&res, 1);
+    residency_set_frame(&res, 2 * LATENCY - 1);
+    check_int("slot", use(5), slot1);
+}
+
+static void test_pin(void) {
+    test_start("pin");
+    init();
+    for (int i = 1; i <= SLOTS; i++) {
+        use(i);
+    }
+    int slot1 = residency_find(&res, 1);
+    residency_pin(&res, slot1);
+    residency_pin(&res, slot1);
+    // Frames advance between uses, so only the pin prevents eviction.
+    unsigned frame = 100;
+    for (int i = 4; i <= 7; i++) {
+        residency_set_frame(&res, frame += 10);
+        use(i);
+    }
+    check_int("pinned", residency_find(&res, 1), slot1);
+    residency_unpin(&res, slot1);
+    for (int i = 8; i <= 9; i++) {
+        residency_set_frame(&res, frame += 10);
+        use(i);
+    }
+    check_int("pinned", residency_find(&res, 1), slot1);
+    residency_unpin(&res, slot1);
+    residency_set_frame(&res, frame += 10);
+    check_int("slot", use(10), slot1);
+}
+
+static void test_evict(void) {
+    test_start("evict");
+    init();
+    check_int("empty", residency_evict(&res), -1);
+    residency_set_frame(&res, 10);
+    use(1);
+    residency_set_frame(&res, 20);
+    use(2);
+    // Asset 2 is still in use, and empty slots are not evicted.
+    residency_set_frame(&res, 20 + LATENCY - 1);
+    int slot1 = residency_find(&res, 1);
+    check_int("slot", residency_evict(&res), slot1);
+    check_int("evicted", residency_find(&res, 1), -1);
+    check_int("in use", residency_evict(&res), -1);
+    check_int("evict", res.stats.evict, 1);
+    // The empty slot is reused.
+    check_int("slot", use(3), slot1);
+}
+
+static void test_full(void) {
+    test_start("full");
+    init();
+    residency_set_frame(&res, 10);
+    for (int i = 1; i <= SLOTS; i++) {
+        use(i);
+    }
+    // Every slot was used in this frame, so nothing can be evicted.
+    check_int("slot", residency_try_use(&res, 4), -1);
+    check_int("find", residency_find(&res, 4), -1);
+    check_int("full", res.stats.full, 1);
+    check_int("miss", res.stats.miss, SLOTS);
+    check_int("loads", load_count, SLOTS);
+    // Loaded assets can still be used.
+    check_int("slot", residency_try_use(&res, 2), residency_find(&res, 2));
+    // The asset can be loaded once the others are no longer in use.
+    residency_set_frame(&res, 10 + LATENCY);
+    int slot = residency_try_use(&res, 4);
+    check_int("loaded asset", slot >= 0 ? loaded[slot] : -1, 4);
+    check_int("full", res.stats.full, 1);
+}
+
+void test_main(void) {
+    test_hit();
+    test_lru();
+    test_latency();
+    test_pin();
+    test_evict();
+    test_full();
+}
@@ -0,0 +1,121 @@
+#include "base/testlib/bench.h"
+
+#include "base/base.h"
+#include "base/testlib/internal.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum {
+    // Number of samples for each benchmark.
+    BENCH_SAMPLES = 101,
+};
+
+// Minimum time for each sample, in nanoseconds.
+static const double bench_sample_time = 1e6;
+
+// Whether the header for the results has been printed.
+static bool bench_did_start;
+
+#if _ULTRA64
+
+#include "base/console.h"
+
+#include <ultra64.h>
+
+typedef uint32_t bench_time;
+
+static bench_time bench_now(void) {
+    return osGetCount();
+}
+
+// Get the time since the start, in nanoseconds. The count register wraps
+// around every 90 seconds, which is much longer than a sample.
+static double bench_elapsed(bench_time start) {
+    return (double)(uint32_t)(osGetCount() - start) *
+           (1e9 / (double)OS_CPU_COUNTER);
+}
+
+static void bench_report(const char *name, struct bench_result r) {
+    if (!bench_did_start) {
+        bench_did_start = true;
+        test_keep_console = true;
+        console_init(&console, CONSOLE_TRUNCATE);
+        console_puts(&console, "name min median p99 (ns)\n");
+    }
+    console_printf(&console, "%s %.1f %.1f %.1f\n", name, r.min, r.median,
+                   r.p99);
+}
+
+#else
+
+#include <stdio.h>
+#include <time.h>
+
+typedef int64_t bench_time;
+
+static bench_time bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double bench_elapsed(bench_time start) {
+    return (double)(bench_now() - start);
+}
+
+static void bench_report(const char *name, struct bench_result r) {
+    if (!bench_did_start) {
+        bench_did_start = true;
+        fprintf(stderr, "%-24s %10s %10s %10s %10s\n", "name", "count",
+                "min ns", "median ns", "p99 ns");
+    }
+    fprintf(stderr, "%-24s %10ld %10.2f %10.2f %10.2f\n", name, r.count,
+            r.min, r.median, r.p99);
+    printf(
+        "{\"name\":\"%s\",\"count\":%ld,\"samples\":%d,\"min_ns\":%.3f,"
+        "\"median_ns\":%.3f,\"p99_ns\":%.3f}\n",
+        name, r.count, BENCH_SAMPLES, r.min, r.median, r.p99);
+    fflush(stdout);
+}
+
+#endif
+
+// Time one sample, in nanoseconds.
+static double bench_sample(bench_func func, long count) {
+    bench_time start = bench_now();
+    func(count);
+    return bench_elapsed(start);
+}
+
+struct bench_result bench_run(const char *name, bench_func func) {
+    // Calibrate. This also warms up the caches.
+    long count = 1;
+    for (;;) {
+        double time = bench_sample(func, count);
+        if (time >= bench_sample_time) {
+            break;
+        }
+        count *= 2;
+    }
+
+    // Collect samples and sort them, with insertion sort.
+    double sample[BENCH_SAMPLES];
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        double time = bench_sample(func, count) / (double)count;
+        int j = i;
+        for (; j > 0 && sample[j - 1] > time; j--) {
+            sample[j] = sample[j - 1];
+        }
+        sample[j] = time;
+    }
+
+    struct bench_result r = {
+        .count = count,
+        .min = sample[0],
+        .median = sample[BENCH_SAMPLES / 2],
+        .p99 = sample[(BENCH_SAMPLES * 99 + 99) / 100 - 1],
+    };
+    bench_report(name, r);
+    return r;
+}
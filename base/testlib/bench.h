@@ -0,0 +1,27 @@
+// Microbenchmark harness. A benchmark is a program which links with testlib
+// and calls bench_run from test_main, so it runs on both the host and the
+// Nintendo 64.
+#pragma once
+
+// A benchmarked operation. It should perform the operation count times.
+typedef void (*bench_func)(long count);
+
+// Result of running a benchmark. Times are in nanoseconds per operation.
+struct bench_result {
+    long count; // Number of operations in each sample.
+    double min;
+    double median;
+    double p99;
+};
+
+// Run a benchmark. The number of operations per sample is calibrated so each
+// sample takes at least a millisecond, and then the benchmark is timed over a
+// number of samples. The results are printed in a human-readable table and a
+// machine-readable summary. On the host, the summary is printed to stdout as
+// one JSON object per line, and the table is printed to stderr. On the
+// Nintendo 64, the summary is printed to the console.
+struct bench_result bench_run(const char *name, bench_func func);
+
+// Anti-optimization sink. Forces the value of an lvalue to be computed and
+// stored, so the compiler cannot remove the operations that produced it.
+#define bench_sink(x) __asm__ volatile("" : : "r"(&(x)) : "memory")
@@ -0,0 +1,8 @@
+// Internal definitions for the test harness.
+#pragma once
+
+#include <stdbool.h>
+
+// If true, the console is not cleared before the final OK message, so
+// benchmark results stay on screen. Only used on the Nintendo 64.
+extern bool test_keep_console;
@@ -11,6 +11,7 @@
 #include "base/console.h"
 #include "base/n64/console.h"
 #include "base/n64/os.h"
+#include "base/testlib/internal.h"
 
 #include <ultra64.h>
 
@@ -22,6 +23,8 @@ enum {
 static uint16_t framebuffers[2][SCREEN_WIDTH * SCREEN_HEIGHT]
     __attribute__((section("uninit.cfb"), aligned(16)));
 
+bool test_keep_console;
+
 static void test_show(uint16_t *framebuffer) {
     console_draw_raw(&console, framebuffer);
     osWritebackDCache(framebuffer, sizeof(framebuffers[0]));
@@ -69,7 +72,9 @@ static void main(void *arg) {
     test_main();
 
     // Print OK message.
-    console_init(&console, CONSOLE_TRUNCATE);
+    if (!test_keep_console) {
+        console_init(&console, CONSOLE_TRUNCATE);
+    }
     console_puts(&console, "OK");
     test_show(framebuffers[1]);
 
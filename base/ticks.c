@@ -0,0 +1,17 @@
+#include "base/ticks.h"
+
+#if _ULTRA64
+
+uint32_t ticks_now(void);
+
+#else
+
+#include <time.h>
+
+uint32_t ticks_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000u + (uint32_t)(ts.tv_nsec / 1000);
+}
+
+#endif
@@ -0,0 +1,29 @@
+// Timestamps for logging and profiling.
+#pragma once
+
+#include <stdint.h>
+
+#if _ULTRA64
+
+// Rate of the clock, in ticks per second. This is the CPU count register,
+// which runs at half the CPU clock. It is the same counter as osGetCount,
+// which base cannot call because it does not depend on libultra.
+#define TICKS_RATE 46875000
+
+// Get the current time, in ticks. The value wraps around.
+inline uint32_t ticks_now(void) {
+    uint32_t count;
+    __asm__ volatile("mfc0 %0, $9" : "=r"(count));
+    return count;
+}
+
+#else
+
+// Rate of the clock, in ticks per second. The host uses a monotonic clock with
+// microsecond ticks.
+#define TICKS_RATE 1000000
+
+// Get the current time, in ticks. The value wraps around.
+uint32_t ticks_now(void);
+
+#endif
@@ -0,0 +1,78 @@
+#include "base/vec3.h"
+
+#include "base/random.h"
+#include "base/testlib/bench.h"
+#include "base/testlib/testlib.h"
+
+enum {
+    // Number of input vectors. Must be a power of two.
+    INPUT_COUNT = 64,
+};
+
+static vec3 input[INPUT_COUNT];
+
+static void bench_add_scale(long count) {
+    vec3 acc = vec3_vec2((vec2){{0.0f, 0.0f}}, 0.0f);
+    for (long i = 0; i < count; i++) {
+        acc = vec3_add(vec3_scale(acc, 0.5f), input[i & (INPUT_COUNT - 1)]);
+    }
+    bench_sink(acc);
+}
+
+static void bench_madd(long count) {
+    vec3 acc = vec3_vec2((vec2){{0.0f, 0.0f}}, 0.0f);
+    for (long i = 0; i < count; i++) {
+        acc = vec3_madd(acc, input[i & (INPUT_COUNT - 1)], 0.25f);
+    }
+    bench_sink(acc);
+}
+
+static void bench_dot(long count) {
+    float acc = 0.0f;
+    for (long i = 0; i < count; i++) {
+        acc += vec3_dot(input[i & (INPUT_COUNT - 1)],
+                        input[(i + 1) & (INPUT_COUNT - 1)]);
+    }
+    bench_sink(acc);
+}
+
+static void bench_cross(long count) {
+    vec3 acc = vec3_vec2((vec2){{0.0f, 0.0f}}, 0.0f);
+    for (long i = 0; i < count; i++) {
+        acc = vec3_add(acc, vec3_cross(input[i & (INPUT_COUNT - 1)],
+                                       input[(i + 1) & (INPUT_COUNT - 1)]));
+    }
+    bench_sink(acc);
+}
+
+static void bench_normalize(long count) {
+    vec3 acc = vec3_vec2((vec2){{0.0f, 0.0f}}, 0.0f);
+    for (long i = 0; i < count; i++) {
+        acc = vec3_add(acc, vec3_normalize(input[i & (INPUT_COUNT - 1)]));
+    }
+    bench_sink(acc);
+}
+
+static void bench_length(long count) {
+    float acc = 0.0f;
+    for (long i = 0; i < count; i++) {
+        acc += vec3_length(input[i & (INPUT_COUNT - 1)]);
+    }
+    bench_sink(acc);
+}
+
+void test_main(void) {
+    struct rand r;
+    rand_init(&r, 1, 2);
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        for (int j = 0; j < 3; j++) {
+            input[i].v[j] = rand_frange(&r, -10.0f, 10.0f);
+        }
+    }
+    bench_run("vec3_add_scale", bench_add_scale);
+    bench_run("vec3_madd", bench_madd);
+    bench_run("vec3_dot", bench_dot);
+    bench_run("vec3_cross", bench_cross);
+    bench_run("vec3_normalize", bench_normalize);
+    bench_run("vec3_length", bench_length);
+}
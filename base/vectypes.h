@@ -21,6 +21,13 @@ typedef struct mat4 {
     float v[16];
 } mat4;
 
+// 4x4 fixed-point matrix, in the layout used by the RSP. Elements are signed
+// 16.16 fixed-point. The first eight words contain the integer parts, two
+// elements per word, and the last eight words contain the fractional parts.
+typedef struct mat4fixed {
+    unsigned v[16];
+} mat4fixed;
+
 // 2D integer vector.
 typedef struct ivec2 {
     int v[2];
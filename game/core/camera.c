@@ -1,6 +1,7 @@
 #include "game/core/camera.h"
 
 #include "base/base.h"
+#include "base/fastmath.h"
 #include "base/vec3.h"
 
 #include <math.h>
@@ -13,6 +14,11 @@ void camera_init(struct sys_camera *restrict csys) {
     };
 }
 
+// Normalize a vector, using the fast reciprocal square root.
+static vec3 camera_normalize(vec3 v) {
+    return vec3_scale(v, fm_rsqrtf(vec3_length2(v)));
+}
+
 void camera_update(struct sys_camera *restrict csys) {
     // Viewpoint: for every 1 meter of camera elevation, move this many meters
     // away from the subject. So, 0 = view down from above, 1 = 45 degree angle,
@@ -37,7 +43,7 @@ void camera_update(struct sys_camera *restrict csys) {
     }};
 
     vec3 up = (vec3){{0.0f, 0.0f, 1.0f}};
-    csys->forward = vec3_normalize(vec3_sub(csys->look_at, csys->pos));
-    csys->right = vec3_normalize(vec3_cross(csys->forward, up));
-    csys->up = vec3_normalize(vec3_cross(csys->right, csys->forward));
+    csys->forward = camera_normalize(vec3_sub(csys->look_at, csys->pos));
+    csys->right = camera_normalize(vec3_cross(csys->forward, up));
+    csys->up = camera_normalize(vec3_cross(csys->right, csys->forward));
 }
@@ -4,34 +4,44 @@
 
 #include <stdnoreturn.h>
 
-// I mean... it's only sensible.
-static_assert(ENTITY_COUNT >= 2);
+enum {
+    // Mask for generation numbers, which keeps entity IDs positive.
+    ENTITY_GENERATION_MASK = 0x7fff,
+};
 
-void entity_init(struct sys_ent *restrict esys) {
+int entity_index(ent_id ent);
+
+void entity_init(struct sys_ent *restrict esys, int count) {
+    // I mean... it's only sensible.
+    if (count < 2 || ENTITY_MAX_COUNT < count) {
+        fatal_error("entity_init: bad count\nCount: %d", count);
+    }
     *esys = (struct sys_ent){
-        .free_start = 1,
-        .free_end = ENTITY_COUNT - 1,
-        .entities = mem_alloc(ENTITY_COUNT * sizeof(*esys->entities)),
+        .count = count,
+        .entities = mem_alloc(count * sizeof(*esys->entities)),
+        .generation = mem_calloc(count * sizeof(*esys->generation)),
+        .destroy = mem_alloc(count * sizeof(*esys->destroy)),
     };
     entity_freeall(esys);
 }
 
 ent_id entity_newid(struct sys_ent *restrict esys) {
-    int id = esys->free_start;
-    if (id != 0) {
-        // Remove from freelist.
-        int next = esys->entities[id];
-        esys->entities[id] = 0;
-        if (next == id) {
-            // Last entity in freelist.
-            esys->free_start = 0;
-            esys->free_end = 0;
-        } else {
-            // Update freelist.
-            esys->free_start = next;
-        }
+    int index = esys->free_start;
+    if (index == 0) {
+        return ENTITY_DESTROY;
+    }
+    // Remove from freelist.
+    int next = esys->entities[index];
+    esys->entities[index] = 0;
+    if (next == index) {
+        // Last entity in freelist.
+        esys->free_start = 0;
+        esys->free_end = 0;
+    } else {
+        // Update freelist.
+        esys->free_start = next;
     }
-    return (ent_id){id};
+    return (ent_id){(esys->generation[index] << ENTITY_INDEX_BITS) | index};
 }
 
 static noreturn void entity_err(const char *msg, ent_id ent) {
@@ -40,31 +50,77 @@ static noreturn void entity_err(const char *msg, ent_id ent) {
 
 void entity_freeid(struct sys_ent *restrict esys, ent_id ent) {
     // Sanity check.
-    if (ent.id <= 0 || ENTITY_COUNT <= ent.id) {
+    int index = entity_index(ent);
+    if (index <= 0 || esys->count <= index) {
         entity_err("invalid ent", ent);
     }
-    // Check that entity is not already in freelist.
-    int next = esys->entities[ent.id];
-    if (next != 0) {
+    // Check that entity is not already in freelist, and that the ID is not
+    // from an earlier generation.
+    int next = esys->entities[index];
+    if (next != 0 ||
+        esys->generation[index] != ent.id >> ENTITY_INDEX_BITS) {
         entity_err("double free", ent);
     }
+    esys->generation[index] =
+        (esys->generation[index] + 1) & ENTITY_GENERATION_MASK;
     // Add entity to end of freelist.
-    esys->entities[ent.id] = ent.id;
+    esys->entities[index] = index;
     if (esys->free_end == 0) {
-        esys->free_start = ent.id;
+        esys->free_start = index;
     } else {
-        esys->entities[esys->free_end] = ent.id;
+        esys->entities[esys->free_end] = index;
     }
-    esys->free_end = ent.id;
+    esys->free_end = index;
+}
+
+bool entity_alive(const struct sys_ent *restrict esys, ent_id ent) {
+    int index = entity_index(ent);
+    return 0 < index && index < esys->count &&
+           esys->generation[index] == ent.id >> ENTITY_INDEX_BITS &&
+           esys->entities[index] == 0;
+}
+
+bool entity_queue(struct sys_ent *restrict esys, ent_id ent) {
+    int index = entity_index(ent);
+    if (index <= 0 || esys->count <= index) {
+        fatal_error("entity_queue: invalid ent\nent: %d", ent.id);
+    }
+    if (esys->generation[index] != ent.id >> ENTITY_INDEX_BITS) {
+        fatal_error("entity_queue: entity was freed\nent: %d", ent.id);
+    }
+    if (esys->entities[index] != 0) {
+        return false;
+    }
+    esys->entities[index] = index;
+    esys->destroy[esys->destroy_count++] = ent;
+    return true;
+}
+
+void entity_freequeue(struct sys_ent *restrict esys) {
+    for (int i = 0; i < esys->destroy_count; i++) {
+        ent_id ent = esys->destroy[i];
+        esys->entities[entity_index(ent)] = 0;
+        entity_freeid(esys, ent);
+    }
+    esys->destroy_count = 0;
 }
 
 void entity_freeall(struct sys_ent *restrict esys) {
+    const int count = esys->count;
     // Entity 0 is invalid, and not in the freelist.
     esys->entities[0] = 0;
     // Entities 1..(N-2) are in the freelist, pointing to the next entity.
-    for (int i = 0; i < ENTITY_COUNT - 1; i++) {
+    for (int i = 1; i < count - 1; i++) {
         esys->entities[i] = i + 1;
     }
     // Entity N-1 is at the end of the freelist, points to itself.
-    esys->entities[ENTITY_COUNT - 1] = ENTITY_COUNT - 1;
+    esys->entities[count - 1] = count - 1;
+    esys->free_start = 1;
+    esys->free_end = count - 1;
+    esys->destroy_count = 0;
+    // Any IDs still held for the old entities are no longer valid.
+    for (int i = 1; i < count; i++) {
+        esys->generation[i] =
+            (esys->generation[i] + 1) & ENTITY_GENERATION_MASK;
+    }
 }
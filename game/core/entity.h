@@ -1,36 +1,67 @@
 #pragma once
 
+#include <stdbool.h>
+
 enum {
-    // Maximum number of entities. This includes entity 0, which is invalid.
+    // Default maximum number of entities. This includes entity 0, which is
+    // invalid.
     ENTITY_COUNT = 16,
 
+    // Number of bits in an entity ID used for the entity index. The remaining
+    // bits are the generation.
+    ENTITY_INDEX_BITS = 16,
+    ENTITY_INDEX_MASK = (1 << ENTITY_INDEX_BITS) - 1,
+
+    // Largest possible number of entities.
+    ENTITY_MAX_COUNT = 1 << ENTITY_INDEX_BITS,
+
     // Maximum number of supported players.
     PLAYER_COUNT = 2,
 };
 
-// An entity ID. The ID must be in the range 0..ENTITY_COUNT-1. The value 0
-// refers to a destroyed entity.
+// An entity ID. The low bits are the entity index, which is in the range
+// 1..count-1, and the high bits are the generation of that index. The
+// generation changes each time the index is freed, so an ID for a destroyed
+// entity never refers to a new entity using the same index. The value 0 refers
+// to a destroyed entity.
 typedef struct ent_id {
     int id;
 } ent_id;
 
 #define ENTITY_DESTROY ((ent_id){0})
 
+// Get the index of an entity.
+inline int entity_index(ent_id ent) {
+    return ent.id & ENTITY_INDEX_MASK;
+}
+
 // Entity tracking system. Tracks which entities exist, and hands out entity IDs
 // for new entities.
 struct sys_ent {
+    // Number of entity indexes, including index 0.
+    int count;
+
     // Index of the first and last entity in the freelist, or 0 if the freelist
     // is empty. The freelist itself is a singly linked list.
     unsigned short free_start, free_end;
 
-    // If an entity is in the freelist, its entry is the next ID in the
-    // freelist, or points to itself if that is the last ID in the freelist. If
-    // an entity is not in the freelist, the entry is 0.
+    // If an entity is in the freelist, its entry is the next index in the
+    // freelist, or points to itself if that is the last index in the freelist.
+    // If an entity is queued for destruction, the entry points to itself. If
+    // an entity exists, the entry is 0.
     unsigned short *entities;
+
+    // Current generation of each entity index.
+    unsigned short *generation;
+
+    // Entities queued for destruction.
+    ent_id *destroy;
+    int destroy_count;
 };
 
-// Initialize the entity system.
-void entity_init(struct sys_ent *restrict esys);
+// Initialize the entity system with the given number of entity indexes,
+// including index 0.
+void entity_init(struct sys_ent *restrict esys, int count);
 
 // Create a new entity ID. Returns 0 if no IDs are available.
 ent_id entity_newid(struct sys_ent *restrict esys);
@@ -39,5 +70,14 @@ ent_id entity_newid(struct sys_ent *restrict esys);
 // again.
 void entity_freeid(struct sys_ent *restrict esys, ent_id ent);
 
-// Mark all entities as free.
+// Return true if the entity exists and is not queued for destruction.
+bool entity_alive(const struct sys_ent *restrict esys, ent_id ent);
+
+// Queue an entity for destruction. Returns false if it was already queued.
+bool entity_queue(struct sys_ent *restrict esys, ent_id ent);
+
+// Return the queued entities to the freelist, and empty the queue.
+void entity_freequeue(struct sys_ent *restrict esys);
+
+// Mark all entities as free, and empty the queue.
 void entity_freeall(struct sys_ent *restrict esys);
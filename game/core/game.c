@@ -1,44 +1,81 @@
 #include "game/core/game.h"
 
 #include "base/base.h"
-#include "base/console.h"
+#include "base/log.h"
+#include "base/prof.h"
 #include "game/core/input.h"
 #include "game/core/random.h"
 
 #include <stdbool.h>
 
+static const struct game_limits game_default_limits = {
+    .entity_count = ENTITY_COUNT,
+    .physics_count = ENTITY_COUNT,
+    .walk_count = ENTITY_COUNT,
+    .model_count = ENTITY_COUNT,
+    .monster_count = 8,
+};
+
 void game_init(struct game_state *restrict gs) {
+    game_init_limits(gs, &game_default_limits);
+}
+
+void game_init_limits(struct game_state *restrict gs,
+                      const struct game_limits *restrict limits) {
+    const int ecount = limits->entity_count;
     sfx_init(&gs->sfx);
     rand_init(&grand, 0x01234567, 0x243F6A88); // Pi fractional digits.
-    entity_init(&gs->ent);
-    physics_init(&gs->physics);
-    walk_init(&gs->walk);
+    entity_init(&gs->ent, ecount);
+    physics_init(&gs->physics, limits->physics_count, ecount);
+    walk_init(&gs->walk, limits->walk_count, ecount);
     camera_init(&gs->camera);
-    model_init(&gs->model);
-    monster_init(&gs->monster);
+    model_init(&gs->model, limits->model_count, ecount);
+    monster_init(&gs->monster, limits->monster_count, ecount);
     player_init(&gs->player);
     particle_init(&gs->particle);
     menu_init(gs);
 }
 
 void game_update(struct game_state *restrict gs, float dt) {
-    cprintf("dt = %.3f\n", (double)dt);
+    LOG_DEBUG("dt = %.3f\n", (double)dt);
     if (dt > 0.1f || dt < 0.0f) {
         fatal_error("dt = %f", (double)dt);
     }
+    PROF_BEGIN("sfx");
     sfx_update(&gs->sfx, dt); // Must be first.
+    PROF_END();
+    PROF_BEGIN("menu");
     menu_update(gs, dt);
+    PROF_END();
     time_update2(&gs->time);
     if (gs->menu.stack_size == 0) {
+        PROF_BEGIN("particle");
         particle_update(&gs->particle, dt);
+        PROF_END();
+        PROF_BEGIN("player");
         player_update(gs, dt);
+        PROF_END();
+        PROF_BEGIN("stage");
         stage_update(gs, dt);
+        PROF_END();
+        PROF_BEGIN("monster");
         monster_update(&gs->monster, &gs->physics, &gs->walk, dt);
+        PROF_END();
+        PROF_BEGIN("walk");
         walk_update(&gs->walk, &gs->physics, dt);
+        PROF_END();
+        PROF_BEGIN("physics");
         physics_update(&gs->physics, dt);
+        PROF_END();
+        PROF_BEGIN("camera");
         camera_update(&gs->camera);
-        model_update(&gs->model);
+        PROF_END();
     }
+    // Destroy entities after all systems have run, so the systems can keep
+    // pointers to components during the update.
+    PROF_BEGIN("flush");
+    entity_flush(gs);
+    PROF_END();
 
     if (gs->input.count >= 1 &&
         (gs->input.input[0].button_press & BUTTON_L) != 0) {
@@ -47,37 +84,27 @@ void game_update(struct game_state *restrict gs, float dt) {
 }
 
 void entity_destroy(struct game_state *restrict gs, ent_id ent) {
-    entity_freeid(&gs->ent, ent);
-    {
-        struct cp_phys *pp = physics_get(&gs->physics, ent);
-        if (pp != NULL) {
-            pp->ent = ENTITY_DESTROY;
-        }
-    }
-    {
-        struct cp_walk *wp = walk_get(&gs->walk, ent);
-        if (wp != NULL) {
-            wp->ent = ENTITY_DESTROY;
-        }
-    }
-    {
-        struct cp_model *mp = model_get(&gs->model, ent);
-        if (mp != NULL) {
-            mp->ent = ENTITY_DESTROY;
-        }
-    }
-    {
-        struct cp_monster *mp = monster_get(&gs->monster, ent);
-        if (mp != NULL) {
-            mp->ent = ENTITY_DESTROY;
-        }
+    entity_queue(&gs->ent, ent);
+}
+
+void entity_flush(struct game_state *restrict gs) {
+    struct sys_ent *restrict esys = &gs->ent;
+    const int count = esys->destroy_count;
+    if (count == 0) {
+        return;
     }
-    {
-        struct cp_player *pl = player_get(&gs->player, ent);
+    const ent_id *restrict ents = esys->destroy;
+    pool_remove_list(&gs->physics.pool, ents, count);
+    pool_remove_list(&gs->walk.pool, ents, count);
+    pool_remove_list(&gs->model.pool, ents, count);
+    pool_remove_list(&gs->monster.pool, ents, count);
+    for (int i = 0; i < count; i++) {
+        struct cp_player *pl = player_get(&gs->player, ents[i]);
         if (pl != NULL) {
             pl->ent = ENTITY_DESTROY;
         }
     }
+    entity_freequeue(esys);
 }
 
 void entity_destroyall(struct game_state *restrict gs) {
@@ -42,14 +42,32 @@ struct game_state {
     bool show_console;
 };
 
-// Initialize the game state.
+// Sizes of the entity and component pools.
+struct game_limits {
+    int entity_count; // Including entity 0, which is invalid.
+    int physics_count;
+    int walk_count;
+    int model_count;
+    int monster_count;
+};
+
+// Initialize the game state, with the default limits.
 void game_init(struct game_state *restrict gs);
 
+// Initialize the game state, with the given limits.
+void game_init_limits(struct game_state *restrict gs,
+                      const struct game_limits *restrict limits);
+
 // Advance the game state.
 void game_update(struct game_state *restrict gs, float dt);
 
-// Destroy the named entity.
+// Destroy the named entity. The entity is queued, and its components are
+// removed by entity_flush at the end of game_update. Destroying an entity which
+// is already queued does nothing.
 void entity_destroy(struct game_state *restrict gs, ent_id ent);
 
+// Destroy all queued entities, removing their components from every system.
+void entity_flush(struct game_state *restrict gs);
+
 // Destroy all entities.
 void entity_destroyall(struct game_state *restrict gs);
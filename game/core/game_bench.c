@@ -0,0 +1,67 @@
+// Benchmark for game_update with large numbers of entities.
+#include "game/core/game.h"
+
+#include "base/base.h"
+#include "base/console.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const int entity_counts[] = {16, 256, 1024, 4096};
+
+enum {
+    // Minimum time to run each entity count, in nanoseconds.
+    MIN_TIME = 500 * 1000 * 1000,
+};
+
+static struct game_state game;
+
+static int64_t now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Create a game with a player and the given number of monsters, running the
+// stage with no menu open.
+static void setup(int monster_count) {
+    int count = monster_count + PLAYER_COUNT + 1;
+    game_init_limits(&game, &(struct game_limits){
+                                .entity_count = count,
+                                .physics_count = count,
+                                .walk_count = count,
+                                .model_count = count,
+                                .monster_count = count,
+                            });
+    game.menu.stack_size = 0;
+    game.input.count = 1;
+    stage_start(&game, 1);
+    for (int i = 0; i < monster_count; i++) {
+        monster_spawn(&game, i & 1 ? MONSTER_BLUE : MONSTER_GREEN);
+    }
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    const float dt = 1.0f / 60.0f;
+    printf("%8s %8s %12s %12s\n", "entities", "frames", "us/frame",
+           "ns/entity");
+    for (size_t i = 0; i < ARRAY_COUNT(entity_counts); i++) {
+        int n = entity_counts[i];
+        setup(n);
+        int64_t start = now(), elapsed;
+        long frames = 0;
+        do {
+            console_init(&console, CONSOLE_TRUNCATE);
+            game_update(&game, dt);
+            frames++;
+            elapsed = now() - start;
+        } while (elapsed < MIN_TIME);
+        double frame_ns = (double)elapsed / (double)frames;
+        printf("%8d %8ld %12.1f %12.1f\n", n, frames, frame_ns * 1e-3,
+               frame_ns / n);
+    }
+    return 0;
+}
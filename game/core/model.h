@@ -3,6 +3,7 @@
 #include "base/pak/types.h"
 #include "game/core/entity.h"
 #include "game/core/material.h"
+#include "game/core/pool.h"
 
 // Model component. Used for entities that have a 3D model.
 struct cp_model {
@@ -19,29 +20,23 @@ struct cp_model {
 
 // Model system.
 struct sys_model {
-    struct cp_model *models;
-    unsigned short *entities;
-    int count;
+    struct pool pool;
 };
 
 // Initialize model system.
-void model_init(struct sys_model *restrict msys);
+void model_init(struct sys_model *restrict msys, int capacity,
+                int entity_count);
 
 // Destroy all components.
 inline void model_destroyall(struct sys_model *restrict msys) {
-    msys->count = 0;
+    pool_clear(&msys->pool);
 }
 
 // Get the model component for the given entity.
 inline struct cp_model *model_get(struct sys_model *restrict msys, ent_id ent) {
-    int index = msys->entities[ent.id];
-    struct cp_model *mp = &msys->models[index];
-    return mp->ent.id == ent.id && index < msys->count ? mp : 0;
+    return pool_get(&msys->pool, ent);
 }
 
 // Create a new model component for the given entity. Overwrite any existing
 // model component.
 struct cp_model *model_new(struct sys_model *restrict msys, ent_id ent);
-
-// Update the model system.
-void model_update(struct sys_model *restrict msys);
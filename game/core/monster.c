@@ -9,16 +9,10 @@
 #include "game/core/physics.h"
 #include "game/core/random.h"
 
-enum {
-    // Maximum number of monster components.
-    MONSTER_COUNT = 8,
-};
-
-void monster_init(struct sys_monster *restrict msys) {
-    *msys = (struct sys_monster){
-        .monsters = mem_alloc(sizeof(*msys->monsters) * MONSTER_COUNT),
-        .entities = mem_calloc(sizeof(*msys->entities) * ENTITY_COUNT),
-    };
+void monster_init(struct sys_monster *restrict msys, int capacity,
+                  int entity_count) {
+    *msys = (struct sys_monster){0};
+    POOL_INIT(&msys->pool, struct cp_monster, capacity, entity_count);
 }
 
 void monster_destroyall(struct sys_monster *restrict msys);
@@ -26,17 +20,7 @@ void monster_destroyall(struct sys_monster *restrict msys);
 struct cp_monster *monster_get(struct sys_monster *restrict msys, ent_id ent);
 
 struct cp_monster *monster_new(struct sys_monster *restrict msys, ent_id ent) {
-    int index = msys->entities[ent.id];
-    struct cp_monster *p = &msys->monsters[index];
-    if (p->ent.id != ent.id || index >= msys->count) {
-        index = msys->count;
-        if (index >= MONSTER_COUNT) {
-            fatal_error("Too many monsters");
-        }
-        msys->count = index + 1;
-        p = &msys->monsters[index];
-        msys->entities[ent.id] = index;
-    }
+    struct cp_monster *p = pool_new(&msys->pool, ent);
     *p = (struct cp_monster){
         .ent = ent,
     };
@@ -96,18 +80,10 @@ void monster_update(struct sys_monster *restrict msys,
                     struct sys_phys *restrict psys,
                     struct sys_walk *restrict wsys, float dt) {
     (void)psys;
-    struct cp_monster *mstart = msys->monsters, *mend = mstart + msys->count;
-    for (struct cp_monster *mp = mstart; mp != mend; mp++) {
-        if (mp->ent.id == 0) {
-            do {
-                mend--;
-            } while (mp != mend && mend->ent.id == 0);
-            if (mp == mend) {
-                break;
-            }
-            *mp = *mend;
-            msys->entities[mp->ent.id] = mp - mstart;
-        }
+    struct cp_monster *restrict mstart = msys->pool.data;
+    const int count = msys->pool.count;
+    for (int i = 0; i < count; i++) {
+        struct cp_monster *restrict mp = &mstart[i];
         mp->timer -= dt;
         if (mp->timer <= 0.0f) {
             mp->timer = rand_frange(&grand, 1.0f, 2.0f);
@@ -118,7 +94,6 @@ void monster_update(struct sys_monster *restrict msys,
             }
         }
     }
-    msys->count = mend - mstart;
 }
 
 #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
@@ -126,7 +101,7 @@ void monster_update(struct sys_monster *restrict msys,
 bool monster_damage(struct game_state *restrict gs, ent_id ent,
                     unsigned buttons) {
     struct cp_monster *mp = monster_get(&gs->monster, ent);
-    if (mp == NULL) {
+    if (mp == NULL || !entity_alive(&gs->ent, ent)) {
         return false;
     }
     const struct monster_info *mi = &monster_info[mp->type];
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "game/core/entity.h"
+#include "game/core/pool.h"
 
 #include <stdbool.h>
 
@@ -24,26 +25,23 @@ struct cp_monster {
 
 // Monster behavior system.
 struct sys_monster {
-    struct cp_monster *monsters;
-    unsigned short *entities;
-    int count;
+    struct pool pool;
     monster_type type;
 };
 
 // Initialize monster system.
-void monster_init(struct sys_monster *restrict msys);
+void monster_init(struct sys_monster *restrict msys, int capacity,
+                  int entity_count);
 
 // Destroy all components.
 inline void monster_destroyall(struct sys_monster *restrict msys) {
-    msys->count = 0;
+    pool_clear(&msys->pool);
 }
 
 // Get the monster component for an entity.
 inline struct cp_monster *monster_get(struct sys_monster *restrict msys,
                                       ent_id ent) {
-    int index = msys->entities[ent.id];
-    struct cp_monster *p = &msys->monsters[index];
-    return p->ent.id == ent.id && 0 < ent.id && index < msys->count ? p : 0;
+    return pool_get(&msys->pool, ent);
 }
 
 // Create new monster component attached to the given entity. Overwrites any
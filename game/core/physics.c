@@ -1,22 +1,16 @@
 #include "game/core/physics.h"
 
 #include "base/base.h"
+#include "base/fastmath.h"
 #include "base/quat.h"
 #include "base/vec2.h"
 #include "game/core/random.h"
 
 #include <math.h>
 
-enum {
-    // Maximum number of physics objects.
-    MAX_PHYSICS_OBJS = 64,
-};
-
-void physics_init(struct sys_phys *restrict psys) {
-    *psys = (struct sys_phys){
-        .physics = mem_alloc(sizeof(*psys->physics) * MAX_PHYSICS_OBJS),
-        .entities = mem_calloc(sizeof(*psys->entities) * ENTITY_COUNT),
-    };
+void physics_init(struct sys_phys *restrict psys, int capacity,
+                  int entity_count) {
+    POOL_INIT(&psys->pool, struct cp_phys, capacity, entity_count);
 }
 
 void physics_destroyall(struct sys_phys *restrict psys);
@@ -33,8 +27,9 @@ struct cp_phys *physics_find(struct sys_phys *restrict psys, ent_id self,
                              vec2 pos, float radius) {
     float best_distance = radius;
     struct cp_phys *best = NULL;
-    struct cp_phys *restrict parr = psys->physics;
-    for (int i = 0; i < psys->count; i++) {
+    struct cp_phys *restrict parr = psys->pool.data;
+    const int count = psys->pool.count;
+    for (int i = 0; i < count; i++) {
         if (parr[i].ent.id == self.id) {
             continue;
         }
@@ -54,17 +49,7 @@ struct cp_phys *physics_find(struct sys_phys *restrict psys, ent_id self,
 }
 
 struct cp_phys *physics_new(struct sys_phys *restrict psys, ent_id ent) {
-    int index = psys->entities[ent.id];
-    struct cp_phys *pp = &psys->physics[index];
-    if (pp->ent.id != ent.id || index >= psys->count) {
-        index = psys->count;
-        if (index >= MAX_PHYSICS_OBJS) {
-            fatal_error("Too many physics objects");
-        }
-        psys->count = index + 1;
-        pp = &psys->physics[index];
-        psys->entities[ent.id] = index;
-    }
+    struct cp_phys *pp = pool_new(&psys->pool, ent);
     *pp = (struct cp_phys){
         .ent = ent,
         .orientation = quat_identity(),
@@ -86,7 +71,9 @@ static void physics_update_pair(struct cp_phys *restrict cx,
     if (dist2 > radius * radius) {
         return;
     }
-    float dist = sqrtf(dist2);
+    // Clamped so the reciprocal is finite when the objects coincide.
+    float inv_dist = fm_rsqrtf(fmaxf(dist2, 1e-12f));
+    float dist = dist2 * inv_dist;
     float overlap = radius - dist;
     if (overlap <= 0.0f) {
         return;
@@ -97,10 +84,10 @@ static void physics_update_pair(struct cp_phys *restrict cx,
         // direction (and don't divide by zero).
         float hc = atanf(1.0f);
         float a = rand_frange(&grand, -hc, hc);
-        dpos = (vec2){{cosf(a), sinf(a)}};
+        dpos = (vec2){{fm_cosf(a), fm_sinf(a)}};
         adj_amount = 0.5f * overlap;
     } else {
-        adj_amount = 0.5f * overlap / dist;
+        adj_amount = 0.5f * overlap * inv_dist;
     }
     cx->adj = vec2_madd(cx->adj, dpos, adj_amount);
     cy->adj = vec2_madd(cy->adj, dpos, -adj_amount);
@@ -151,54 +138,36 @@ void physics_update(struct sys_phys *restrict psys, float dt) {
     if (dt < 1e-4f) {
         return;
     }
-    struct cp_phys *restrict cps = psys->physics;
-
-    // Clean up destroyed entities.
-    {
-        struct cp_phys *cpend = cps + psys->count;
-        for (struct cp_phys *cp = cps; cp != cpend; cp++) {
-            if (cp->ent.id == 0) {
-                do {
-                    cpend--;
-                } while (cp != cpend && cpend->ent.id == 0);
-                if (cp == cpend) {
-                    break;
-                }
-                *cp = *cpend;
-                psys->entities[cp->ent.id] = cp - cps;
-            }
-        }
-        psys->count = cpend - cps;
-    }
-
+    struct cp_phys *restrict cps = psys->pool.data;
+    const int count = psys->pool.count;
     const float invdt = 1.0f / dt;
 
     // Move forwards.
-    for (int i = 0; i < psys->count; i++) {
+    for (int i = 0; i < count; i++) {
         cps[i].pos = vec2_madd(cps[i].pos, cps[i].vel, dt);
         cps[i].adj = (vec2){{0.0f, 0.0f}};
         cps[i].collided = false;
     }
 
     // Find collisions between entities and push entities out of collisions.
-    for (int i = 0; i < psys->count; i++) {
+    for (int i = 0; i < count; i++) {
         struct cp_phys *cx = &cps[i];
-        for (int j = i + 1; j < psys->count; j++) {
+        for (int j = i + 1; j < count; j++) {
             struct cp_phys *cy = &cps[j];
             physics_update_pair(cx, cy);
         }
     }
 
     // Update velocity after collision update.
-    physics_post_collision(cps, psys->count, invdt);
+    physics_post_collision(cps, count, invdt);
 
     // Find collisions with walls and push entities out of collisions.
-    for (int i = 0; i < psys->count; i++) {
+    for (int i = 0; i < count; i++) {
         physics_update_static(&cps[i]);
     }
 
     // All entities are considered stable after a physics tick.
-    for (int i = 0; i < psys->count; i++) {
+    for (int i = 0; i < count; i++) {
         cps[i].stable = true;
     }
 }
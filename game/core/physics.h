@@ -2,6 +2,7 @@
 
 #include "base/vectypes.h"
 #include "game/core/entity.h"
+#include "game/core/pool.h"
 
 #include <stdbool.h>
 #include <stdnoreturn.h>
@@ -34,17 +35,16 @@ struct cp_phys {
 
 // Physics system.
 struct sys_phys {
-    struct cp_phys *physics;
-    unsigned short *entities;
-    int count;
+    struct pool pool;
 };
 
 // Initialize physics system.
-void physics_init(struct sys_phys *restrict psys);
+void physics_init(struct sys_phys *restrict psys, int capacity,
+                  int entity_count);
 
 // Destroy all components.
 inline void physics_destroyall(struct sys_phys *restrict psys) {
-    psys->count = 0;
+    pool_clear(&psys->pool);
 }
 
 // Signal a fatal error for a missing physics component.
@@ -52,18 +52,15 @@ noreturn void physics_missing(ent_id ent);
 
 // Get the physics component for the given entity.
 inline struct cp_phys *physics_get(struct sys_phys *restrict psys, ent_id ent) {
-    int index = psys->entities[ent.id];
-    struct cp_phys *pp = &psys->physics[index];
-    return pp->ent.id == ent.id && index < psys->count ? pp : 0;
+    return pool_get(&psys->pool, ent);
 }
 
 // Get the physics component for the given entity, and signal a fatal error if
 // not found.
 inline struct cp_phys *physics_require(struct sys_phys *restrict psys,
                                        ent_id ent) {
-    int index = psys->entities[ent.id];
-    struct cp_phys *pp = &psys->physics[index];
-    if (index >= psys->count || pp->ent.id != ent.id) {
+    struct cp_phys *pp = pool_get(&psys->pool, ent);
+    if (pp == NULL) {
         physics_missing(ent);
     }
     return pp;
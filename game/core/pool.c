@@ -0,0 +1,84 @@
+#include "game/core/pool.h"
+
+#include "base/base.h"
+
+#include <string.h>
+
+void pool_init(struct pool *restrict p, const char *name, size_t elem_size,
+               int capacity, int entity_count) {
+    if (capacity < 1 || entity_count < 1 ||
+        ENTITY_MAX_COUNT < entity_count) {
+        fatal_error("pool_init: bad size\nPool: %s\nCapacity: %d\nEntities: %d",
+                    name, capacity, entity_count);
+    }
+    *p = (struct pool){
+        .name = name,
+        .data = mem_alloc(elem_size * capacity),
+        .sparse = mem_calloc(sizeof(*p->sparse) * entity_count),
+        .elem_size = elem_size,
+        .capacity = capacity,
+        .entity_count = entity_count,
+    };
+}
+
+void *pool_at(const struct pool *restrict p, int index);
+
+ent_id pool_entity(const struct pool *restrict p, int index);
+
+void *pool_get(const struct pool *restrict p, ent_id ent);
+
+void *pool_new(struct pool *restrict p, ent_id ent) {
+    int eindex = entity_index(ent);
+    if (eindex == 0 || p->entity_count <= eindex) {
+        fatal_error("pool_new: invalid entity\nPool: %s\nEntity: %d", p->name,
+                    ent.id);
+    }
+    void *cp = pool_get(p, ent);
+    if (cp != NULL) {
+        return cp;
+    }
+    int index = p->count;
+    if (index >= p->capacity) {
+        fatal_error("Too many components\nPool: %s\nCapacity: %d", p->name,
+                    p->capacity);
+    }
+    p->count = index + 1;
+    p->sparse[eindex] = index;
+    cp = pool_at(p, index);
+    *(ent_id *)cp = ent;
+    return cp;
+}
+
+// Remove the component at the given position by moving the last component into
+// its place.
+static void pool_remove_at(struct pool *restrict p, int index) {
+    int last = --p->count;
+    if (index != last) {
+        memcpy(pool_at(p, index), pool_at(p, last), p->elem_size);
+        p->sparse[entity_index(pool_entity(p, index))] = index;
+    }
+}
+
+void pool_remove(struct pool *restrict p, ent_id ent) {
+    void *cp = pool_get(p, ent);
+    if (cp != NULL) {
+        pool_remove_at(p, p->sparse[entity_index(ent)]);
+    }
+}
+
+void pool_remove_list(struct pool *restrict p, const ent_id *restrict ents,
+                      int count) {
+    for (int i = 0; i < count && p->count > 0; i++) {
+        int index = p->sparse[entity_index(ents[i])];
+        if (index < p->count && pool_entity(p, index).id == ents[i].id) {
+            pool_remove_at(p, index);
+        }
+    }
+}
+
+void pool_clear(struct pool *restrict p);
+
+struct pool_join pool_join_start(const struct pool *restrict a,
+                                 const struct pool *restrict b);
+
+bool pool_join_next(struct pool_join *restrict j);
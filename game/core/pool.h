@@ -0,0 +1,118 @@
+// Sparse-set storage for entity components.
+#pragma once
+
+#include "game/core/entity.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Components are stored densely, so systems iterate over them as an array, and
+// each entity index maps to the position of its component. Getting, creating,
+// and removing a component are constant time. Removing a component moves the
+// last component into its place, so pointers to components are only valid
+// until the next removal. Entities are removed from every pool at once, after
+// the systems have updated, so systems never see a hole in the array.
+//
+// Every component type must start with the ent_id of its entity. Looking up a
+// component compares the whole ID, including the generation, so IDs for
+// destroyed entities never find a component.
+
+// A pool of components of one type.
+struct pool {
+    const char *name;
+    void *data;             // Components, count used out of capacity.
+    unsigned short *sparse; // Position of the component for each entity index.
+    size_t elem_size;
+    int count;
+    int capacity;
+    int entity_count;
+};
+
+// Initialize a pool for a component type, with room for the given number of
+// components, for entities with indexes less than entity_count.
+#define POOL_INIT(p, type, capacity, entity_count)                       \
+    do {                                                                 \
+        static_assert(offsetof(type, ent) == 0,                          \
+                      #type " must start with ent");                     \
+        pool_init(p, #type, sizeof(type), capacity, entity_count);       \
+    } while (0)
+
+void pool_init(struct pool *restrict p, const char *name, size_t elem_size,
+               int capacity, int entity_count);
+
+// Get the component at the given position.
+inline void *pool_at(const struct pool *restrict p, int index) {
+    return (char *)p->data + p->elem_size * index;
+}
+
+// Get the entity for the component at the given position.
+inline ent_id pool_entity(const struct pool *restrict p, int index) {
+    return *(const ent_id *)pool_at(p, index);
+}
+
+// Get the component for the given entity, or NULL if there is none.
+inline void *pool_get(const struct pool *restrict p, ent_id ent) {
+    int index = p->sparse[entity_index(ent)];
+    if (index >= p->count) {
+        return NULL;
+    }
+    void *cp = pool_at(p, index);
+    return ((const ent_id *)cp)->id == ent.id ? cp : NULL;
+}
+
+// Create a component for the given entity, or return the existing component.
+// The caller must initialize it, including its ent field.
+void *pool_new(struct pool *restrict p, ent_id ent);
+
+// Remove the component for the given entity, if it has one.
+void pool_remove(struct pool *restrict p, ent_id ent);
+
+// Remove the components for a list of entities, if they have them.
+void pool_remove_list(struct pool *restrict p, const ent_id *restrict ents,
+                      int count);
+
+// Remove all components.
+inline void pool_clear(struct pool *restrict p) {
+    p->count = 0;
+}
+
+// Iterator over the entities which have a component in both of two pools. The
+// smaller pool is iterated in order, and components in the other pool are
+// looked up directly through its sparse array.
+struct pool_join {
+    const struct pool *outer, *inner;
+    bool swap;
+    int index;
+    // The components for the current entity, from the first and second pool.
+    void *a, *b;
+};
+
+// Start iterating over entities with components in both pools.
+inline struct pool_join pool_join_start(const struct pool *restrict a,
+                                        const struct pool *restrict b) {
+    bool swap = b->count < a->count;
+    return (struct pool_join){
+        .outer = swap ? b : a,
+        .inner = swap ? a : b,
+        .swap = swap,
+    };
+}
+
+// Advance to the next entity. Returns false if there are no more entities.
+inline bool pool_join_next(struct pool_join *restrict j) {
+    const struct pool *restrict outer = j->outer, *restrict inner = j->inner;
+    while (j->index < outer->count) {
+        void *op = pool_at(outer, j->index++);
+        ent_id ent = *(const ent_id *)op;
+        int index = inner->sparse[entity_index(ent)];
+        if (index < inner->count) {
+            void *ip = pool_at(inner, index);
+            if (((const ent_id *)ip)->id == ent.id) {
+                j->a = j->swap ? ip : op;
+                j->b = j->swap ? op : ip;
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,177 @@
+#include "game/core/pool.h"
+
+#include "base/base.h"
+#include "base/testlib/testlib.h"
+
+#include <stddef.h>
+
+enum {
+    CAPACITY = 8,
+    ENTITIES = 16,
+};
+
+struct cp_test {
+    ent_id ent;
+    int value;
+};
+
+static struct sys_ent ent;
+static struct pool pool, other;
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+static void init(void) {
+    entity_init(&ent, ENTITIES);
+    POOL_INIT(&pool, struct cp_test, CAPACITY, ENTITIES);
+    POOL_INIT(&other, struct cp_test, CAPACITY, ENTITIES);
+}
+
+static ent_id new_entity(void) {
+    ent_id e = entity_newid(&ent);
+    if (e.id == 0) {
+        test_logf("no entity");
+        test_fail();
+    }
+    return e;
+}
+
+// Create a component with the given value.
+static void add(struct pool *restrict p, ent_id e, int value) {
+    struct cp_test *cp = pool_new(p, e);
+    *cp = (struct cp_test){
+        .ent = e,
+        .value = value,
+    };
+}
+
+// Get the value of a component, or -1 if it does not exist.
+static int value(const struct pool *restrict p, ent_id e) {
+    const struct cp_test *cp = pool_get(p, e);
+    return cp != NULL ? cp->value : -1;
+}
+
+static void test_basic(void) {
+    test_start("basic");
+    init();
+    ent_id e[4];
+    for (int i = 0; i < 4; i++) {
+        e[i] = new_entity();
+        add(&pool, e[i], i * 10);
+    }
+    check_int("count", pool.count, 4);
+    check_int("get", value(&pool, e[2]), 20);
+    check_int("get zero", value(&pool, ENTITY_DESTROY), -1);
+    // Creating a component again returns the same component.
+    add(&pool, e[1], 11);
+    check_int("count", pool.count, 4);
+    check_int("get", value(&pool, e[1]), 11);
+    // Removing a component moves the last one into its place.
+    pool_remove(&pool, e[0]);
+    check_int("count", pool.count, 3);
+    check_int("get removed", value(&pool, e[0]), -1);
+    check_int("get moved", value(&pool, e[3]), 30);
+    check_int("position", entity_index(pool_entity(&pool, 0)),
+              entity_index(e[3]));
+    pool_remove(&pool, e[0]);
+    check_int("count", pool.count, 3);
+}
+
+static void test_generation(void) {
+    test_start("generation");
+    init();
+    ent_id a = new_entity();
+    add(&pool, a, 1);
+    entity_freeid(&ent, a);
+    pool_remove(&pool, a);
+    // Use every index, so the index of a is used again.
+    ent_id b = ENTITY_DESTROY;
+    for (int i = 1; i < ENTITIES; i++) {
+        ent_id e = new_entity();
+        if (entity_index(e) == entity_index(a)) {
+            b = e;
+        }
+    }
+    check_int("same index", entity_index(b), entity_index(a));
+    if (b.id == a.id) {
+        test_logf("ID was reused: %d", a.id);
+        test_fail();
+    }
+    add(&pool, b, 2);
+    check_int("get stale", value(&pool, a), -1);
+    check_int("get new", value(&pool, b), 2);
+}
+
+static void test_queue(void) {
+    test_start("queue");
+    init();
+    ent_id e[6];
+    for (int i = 0; i < 6; i++) {
+        e[i] = new_entity();
+        add(&pool, e[i], i);
+    }
+    check_int("queue", entity_queue(&ent, e[1]), true);
+    check_int("queue", entity_queue(&ent, e[4]), true);
+    check_int("queue", entity_queue(&ent, e[5]), true);
+    check_int("queue again", entity_queue(&ent, e[1]), false);
+    check_int("alive", entity_alive(&ent, e[0]), true);
+    check_int("alive queued", entity_alive(&ent, e[1]), false);
+    // Queued entities keep their components until the queue is flushed.
+    check_int("get queued", value(&pool, e[1]), 1);
+    check_int("count", pool.count, 6);
+    pool_remove_list(&pool, ent.destroy, ent.destroy_count);
+    entity_freequeue(&ent);
+    check_int("queue count", ent.destroy_count, 0);
+    check_int("count", pool.count, 3);
+    for (int i = 0; i < 6; i++) {
+        int expect = i == 1 || i >= 4 ? -1 : i;
+        check_int("get", value(&pool, e[i]), expect);
+    }
+    check_int("alive freed", entity_alive(&ent, e[1]), false);
+}
+
+static void test_join(void) {
+    test_start("join");
+    init();
+    ent_id e[6];
+    for (int i = 0; i < 6; i++) {
+        e[i] = new_entity();
+        add(&pool, e[i], i);
+        if (i % 2 == 0) {
+            add(&other, e[i], i + 100);
+        }
+    }
+    pool_remove(&pool, e[2]);
+    // The smaller pool is iterated, but components come out in the order the
+    // pools were passed.
+    for (int order = 0; order < 2; order++) {
+        struct pool_join j = order == 0 ? pool_join_start(&pool, &other)
+                                        : pool_join_start(&other, &pool);
+        int n = 0, sum = 0;
+        while (pool_join_next(&j)) {
+            const struct cp_test *a = j.a, *b = j.b;
+            if (order != 0) {
+                const struct cp_test *t = a;
+                a = b;
+                b = t;
+            }
+            check_int("entity", a->ent.id, b->ent.id);
+            check_int("value", b->value, a->value + 100);
+            n++;
+            sum += a->value;
+        }
+        check_int("count", n, 2);
+        check_int("sum", sum, 4);
+    }
+}
+
+void test_main(void) {
+    test_basic();
+    test_generation();
+    test_queue();
+    test_join();
+}
@@ -44,7 +44,7 @@ void stage_update(struct game_state *restrict gs, float dt) {
         if (ssys->spawn_time < 0.0f) {
             ssys->spawn_active = false;
             ssys->spawn_time = 0.0f;
-            int n = MONSTER_SPAWN_COUNT - gs->monster.count;
+            int n = MONSTER_SPAWN_COUNT - gs->monster.pool.count;
             if (n > 0) {
                 monster_type type =
                     ssys->spawn_type ? MONSTER_BLUE : MONSTER_GREEN;
@@ -54,7 +54,7 @@ void stage_update(struct game_state *restrict gs, float dt) {
                 ssys->spawn_type ^= 1;
             }
         }
-    } else if (gs->monster.count < MONSTER_SPAWN_COUNT) {
+    } else if (gs->monster.pool.count < MONSTER_SPAWN_COUNT) {
         ssys->spawn_active = true;
         ssys->spawn_time = 1.5f;
     }
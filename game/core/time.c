@@ -1,6 +1,6 @@
 #include "game/core/time.h"
 
-#include "base/console.h"
+#include "base/log.h"
 
 enum {
     AUDIO_SAMPLERATE = 32000,
@@ -15,8 +15,8 @@ void time_update2(struct game_time *restrict tm) {
         const float subbeat = fbeat - beat;
         int measure = (beat >> 2) + 1;
         beat = (beat & 3) + 1;
-        cprintf("%d:%02d:%d:%04.2f\n", tm->track_loop, measure, beat,
-                (double)subbeat);
+        LOG_DEBUG("%d:%02d:%d:%04.2f\n", tm->track_loop, measure, beat,
+                  (double)subbeat);
         tm->measure = measure;
         tm->beat = beat;
         tm->subbeat = subbeat;
@@ -1,23 +1,16 @@
 #include "game/core/walk.h"
 
 #include "base/base.h"
+#include "base/fastmath.h"
 #include "base/quat.h"
 #include "base/vec2.h"
 #include "game/core/physics.h"
 
 #include <math.h>
 
-enum {
-    // Maximum number of walking objects.
-    MAX_WALK_OBJS = 16,
-};
-
 // Initailize walkers.
-void walk_init(struct sys_walk *restrict wsys) {
-    *wsys = (struct sys_walk){
-        .components = mem_alloc(sizeof(*wsys->components) * MAX_WALK_OBJS),
-        .entities = mem_calloc(sizeof(*wsys->entities) * ENTITY_COUNT),
-    };
+void walk_init(struct sys_walk *restrict wsys, int capacity, int entity_count) {
+    POOL_INIT(&wsys->pool, struct cp_walk, capacity, entity_count);
 }
 
 void walk_destroyall(struct sys_walk *restrict wsys);
@@ -25,17 +18,7 @@ void walk_destroyall(struct sys_walk *restrict wsys);
 struct cp_walk *walk_get(struct sys_walk *restrict wsys, ent_id ent);
 
 struct cp_walk *walk_new(struct sys_walk *restrict wsys, ent_id ent) {
-    int index = wsys->entities[ent.id];
-    struct cp_walk *wp = &wsys->components[index];
-    if (wp->ent.id != ent.id || index >= wsys->count) {
-        index = wsys->count;
-        if (index >= MAX_WALK_OBJS) {
-            fatal_error("Too many walk objects");
-        }
-        wsys->count = index + 1;
-        wp = &wsys->components[index];
-        wsys->entities[ent.id] = index;
-    }
+    struct cp_walk *wp = pool_new(&wsys->pool, ent);
     *wp = (struct cp_walk){
         .ent = ent,
         .face_angle = 0.0f,
@@ -46,25 +29,11 @@ struct cp_walk *walk_new(struct sys_walk *restrict wsys, ent_id ent) {
 // Update walkers.
 void walk_update(struct sys_walk *restrict wsys, struct sys_phys *restrict psys,
                  float dt) {
-    struct cp_walk *wstart = wsys->components, *wend = wstart + wsys->count;
-    for (struct cp_walk *wp = wstart; wp != wend; wp++) {
-        // Clean up destroyed entities.
-        if (wp->ent.id == 0) {
-            do {
-                wend--;
-            } while (wp != wend && wend->ent.id == 0);
-            if (wp == wend) {
-                break;
-            }
-            *wp = *wend;
-            wsys->entities[wp->ent.id] = wp - wstart;
-        }
-
-        // Process remaining entities.
-        struct cp_phys *pp = physics_get(psys, wp->ent);
-        if (pp == NULL) {
-            continue;
-        }
+    // Process walkers with a physics component.
+    struct pool_join j = pool_join_start(&wsys->pool, &psys->pool);
+    while (pool_join_next(&j)) {
+        struct cp_walk *restrict wp = j.a;
+        struct cp_phys *restrict pp = j.b;
 
         // Update velocity.
         float speed = 10.0f;
@@ -80,7 +49,8 @@ void walk_update(struct sys_walk *restrict wsys, struct sys_phys *restrict psys,
         float accel = speed / accel_time;
         float max_dv = dt * accel;
         if (dv2 > max_dv * max_dv) {
-            pp->vel = vec2_madd(pp->vel, delta_vel, max_dv / sqrtf(dv2));
+            pp->vel =
+                vec2_madd(pp->vel, delta_vel, max_dv * fm_rsqrtf(dv2));
         } else {
             pp->vel = target_vel;
         }
@@ -89,7 +59,8 @@ void walk_update(struct sys_walk *restrict wsys, struct sys_phys *restrict psys,
         if (drive_mag > 0.05f) {
             const float half_circle = 4.0f * atanf(1.0f);
             const float turn_speed = 3.0f * (2.0f * half_circle) * drive_mag;
-            const float target_face = atan2f(wp->drive.v[1], wp->drive.v[0]);
+            const float target_face =
+                fm_atan2f(wp->drive.v[1], wp->drive.v[0]);
             float delta_face = target_face - wp->face_angle;
             if (delta_face > half_circle) {
                 delta_face -= 2.0f * half_circle;
@@ -107,8 +78,12 @@ void walk_update(struct sys_walk *restrict wsys, struct sys_phys *restrict psys,
         }
 
         // Update orientation.
-        pp->orientation = quat_rotate_z(wp->face_angle);
+        pp->orientation = (quat){{
+            fm_cosf(0.5f * wp->face_angle),
+            0.0f,
+            0.0f,
+            fm_sinf(0.5f * wp->face_angle),
+        }};
         pp->forward = vec2_vec3(quat_x(pp->orientation));
     }
-    wsys->count = wend - wstart;
 }
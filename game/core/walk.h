@@ -2,6 +2,7 @@
 
 #include "base/vectypes.h"
 #include "game/core/entity.h"
+#include "game/core/pool.h"
 
 struct sys_phys;
 
@@ -13,24 +14,20 @@ struct cp_walk {
 };
 
 struct sys_walk {
-    struct cp_walk *components;
-    unsigned short *entities;
-    int count;
+    struct pool pool;
 };
 
 // Initailize walkers.
-void walk_init(struct sys_walk *restrict wsys);
+void walk_init(struct sys_walk *restrict wsys, int capacity, int entity_count);
 
 // Destroy all components.
 inline void walk_destroyall(struct sys_walk *restrict wsys) {
-    wsys->count = 0;
+    pool_clear(&wsys->pool);
 }
 
 // Get the walker component for the given entity.
 inline struct cp_walk *walk_get(struct sys_walk *restrict wsys, ent_id ent) {
-    int index = wsys->entities[ent.id];
-    struct cp_walk *wp = &wsys->components[index];
-    return wp->ent.id == ent.id && index < wsys->count ? wp : 0;
+    return pool_get(&wsys->pool, ent);
 }
 
 // Create new walker.
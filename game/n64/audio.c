@@ -3,24 +3,23 @@
 #include "assets/pak.h"
 #include "assets/track.h"
 #include "base/base.h"
-#include "base/fixup.h"
 #include "base/n64/os.h" // osTvType
 #include "base/n64/scheduler.h"
 #include "base/pak/pak.h"
+#include "base/residency.h"
 #include "game/core/game.h"
+#include "game/n64/audio_dma.h"
 #include "game/n64/defs.h"
 #include "game/n64/system.h"
 #include "game/n64/task.h"
 
 #include <stdalign.h>
+#include <stddef.h>
 
 enum {
-    ID_SFX_FIRST = ID_SFX_CLANG,
-    ID_SFX_LAST = ID_SFX_WHA_5,
-};
-
-enum {
-    AUDIO_SFX_SLOTS = ID_SFX_LAST - ID_SFX_FIRST + 1,
+    // Number of sound effects which can be loaded at once. Must be larger than
+    // the number of sound effect voices, since playing sounds are pinned.
+    AUDIO_SFX_SLOTS = 8,
 
     // Number of frames in an audio buffer.
     AUDIO_BUFSZ = 1024,
@@ -31,73 +30,15 @@ enum {
     AUDIO_MAX_VOICES = 4,
     AUDIO_MAX_UPDATES = 64,
     AUDIO_EVT_COUNT = 32,
-    AUDIO_DMA_COUNT = 8,
-    AUDIO_DMA_BUFSZ = 2 * 1024,
 };
 
 // =============================================================================
 // Audio DMA
 // =============================================================================
 
-struct audio_dmainfo {
-    uint32_t age;
-    uint32_t offset;
-};
-
-static struct audio_dmainfo audio_dma[AUDIO_DMA_COUNT];
-
-static u8 audio_dmabuf[AUDIO_DMA_COUNT][AUDIO_DMA_BUFSZ]
-    __attribute__((aligned(16), section("uninit")));
-
-static OSIoMesg audio_dmamsg[AUDIO_DMA_COUNT];
-
-static OSMesgQueue audio_dmaqueue;
-static OSMesg audio_dmaqueue_buffer[AUDIO_DMA_COUNT];
-static unsigned audio_dmanext, audio_dmanactive;
-
 static s32 audio_dma_callback(s32 addr, s32 len, void *state) {
     (void)state;
-    struct audio_dmainfo *restrict dma = audio_dma;
-    uint32_t astart = addr, aend = astart + len;
-
-    // If these samples are already buffered, return the buffer.
-    int oldest = 0;
-    uint32_t oldest_age = 0;
-    for (int i = 0; i < AUDIO_DMA_COUNT; i++) {
-        if (dma[i].age > oldest_age) {
-            oldest = i;
-            oldest_age = dma[i].age;
-        }
-        uint32_t dstart = dma[i].offset, dend = dstart + AUDIO_DMA_BUFSZ;
-        if (dstart <= astart && aend <= dend) {
-            dma[i].age = 0;
-            uint32_t offset = astart - dstart;
-            return K0_TO_PHYS(audio_dmabuf[i] + offset);
-        }
-    }
-
-    // Otherwise, use the oldest buffer to start a new DMA.
-    if (oldest_age == 0 || audio_dmanactive >= AUDIO_DMA_COUNT) {
-        // If the buffer is in use, don't bother.
-        fatal_error("DMA buffer in use"); // FIXME: not in release builds
-        return K0_TO_PHYS(audio_dmabuf[oldest]);
-    }
-    uint32_t dma_addr = astart & ~1u;
-    OSIoMesg *restrict mesg = &audio_dmamsg[audio_dmanext];
-    audio_dmanext = (audio_dmanext + 1) % AUDIO_DMA_COUNT;
-    audio_dmanactive++;
-    *mesg = (OSIoMesg){
-        .hdr = {.pri = OS_MESG_PRI_NORMAL, .retQueue = &audio_dmaqueue},
-        .dramAddr = audio_dmabuf[oldest],
-        .devAddr = dma_addr,
-        .size = AUDIO_DMA_BUFSZ,
-    };
-    osEPiStartDma(rom_handle, mesg, OS_READ);
-    dma[oldest] = (struct audio_dmainfo){
-        .age = 0,
-        .offset = dma_addr,
-    };
-    return K0_TO_PHYS(audio_dmabuf[oldest] + (astart & 1u));
+    return K0_TO_PHYS(audio_dma_load(addr, len));
 }
 
 static ALDMAproc audio_dma_new(void *arg) {
@@ -122,41 +63,45 @@ unsigned audio_trackstart;
 
 struct audio_trackinfo audio_trackinfo;
 
+// Header for an audio track. The asset has a fixed layout with no internal
+// pointers. The wave table pointers, which the audio library requires, are set
+// to point at the loop and codebook at fixed offsets in the header.
 struct audio_header {
     struct audio_trackinfo info;
     ALWaveTable wavetable;
+    ALADPCMloop loop; // Only valid if info.loop_length is nonzero.
+    ALADPCMBook book; // Variable size.
 };
 
+// Must match the layout in tools/audio.
+static_assert(offsetof(struct audio_header, loop) == 28);
+static_assert(offsetof(struct audio_header, book) == 72);
+
 union audio_tracktablebuf {
     struct audio_header header;
     uint8_t data[208];
 };
 
-static void audio_adpcm_fixup(ALADPCMWaveInfo *restrict w, uintptr_t base,
-                              size_t size) {
-    w->book = pointer_fixup(w->book, base, size);
-    w->loop = pointer_fixup(w->loop, base, size);
-}
-
-static void audio_raw16_fixup(ALRAWWaveInfo *restrict w, uintptr_t base,
-                              size_t size) {
-    w->loop = pointer_fixup(w->loop, base, size);
-}
-
-static void audio_track_fixup(union audio_tracktablebuf *p, pak_track asset) {
-    const uintptr_t base = (uintptr_t)p;
-    const size_t size = sizeof(union audio_tracktablebuf);
-    ALWaveTable *restrict tbl = &p->header.wavetable;
+// Bind the wave table in a track header to the track's sample data and to the
+// loop and codebook in the header.
+static void audio_track_bind(union audio_tracktablebuf *p, pak_track asset) {
+    struct audio_header *restrict hdr = &p->header;
+    ALWaveTable *restrict tbl = &hdr->wavetable;
     int obj = pak_track_object(asset) + 1;
     tbl->base = (u8 *)pak_objects[obj].offset;
     tbl->len = pak_objects[obj].size;
     switch (tbl->type) {
     case AL_ADPCM_WAVE:
-        audio_adpcm_fixup(&tbl->waveInfo.adpcmWave, base, size);
+        tbl->waveInfo.adpcmWave = (ALADPCMWaveInfo){
+            .loop = hdr->info.loop_length != 0 ? &hdr->loop : NULL,
+            .book = &hdr->book,
+        };
         break;
     case AL_RAW16_WAVE:
-        audio_raw16_fixup(&tbl->waveInfo.rawWave, base, size);
+        tbl->waveInfo.rawWave = (ALRAWWaveInfo){.loop = NULL};
         break;
+    default:
+        fatal_error("Bad audio track\nType: %d", tbl->type);
     }
 }
 
@@ -169,10 +114,14 @@ struct sfx_slot {
     ALSndId id;
 };
 
-static int audio_sfxcount;
 static struct sfx_slot audio_sfxbuf[AUDIO_SFX_SLOTS] ASSET;
-static int audio_track_to_slot[PAK_TRACK_COUNT + 1];
-static int audio_track_from_slot[AUDIO_SFX_SLOTS];
+
+// Tracks which sound effects are loaded into which slots. Sound effects are
+// loaded when played, and pinned until they stop.
+static struct residency audio_sfx_residency;
+
+// Audio frame counter, for the residency manager.
+static unsigned audio_frame_count;
 
 static ALEnvelope sndenv = {
     .attackVolume = 127,
@@ -180,16 +129,15 @@ static ALEnvelope sndenv = {
     .decayTime = -1,
 };
 
-static void sfx_load_slot(pak_track asset_id, int slot) {
+static void sfx_load_slot(int asset, int slot) {
+    pak_track asset_id = {asset};
     int obj = pak_track_object(asset_id);
     int frames = pak_objects[obj + 1].size / 9;
     int samples = frames * 16;
     int microsec = (int64_t)samples * 1000000 / AUDIO_SAMPLERATE;
     pak_load_asset_sync(&audio_sfxbuf[slot].buf, sizeof(audio_sfxbuf[slot].buf),
                         obj);
-    audio_track_fixup(&audio_sfxbuf[slot].buf, asset_id);
-    audio_track_to_slot[asset_id.id] = slot;
-    audio_track_from_slot[slot] = asset_id.id;
+    audio_track_bind(&audio_sfxbuf[slot].buf, asset_id);
     audio_sfxbuf[slot].sound = (ALSound){
         .envelope = &audio_sfxbuf[slot].envelope,
         .wavetable = &audio_sfxbuf[slot].buf.header.wavetable,
@@ -206,43 +154,22 @@ static void sfx_load_slot(pak_track asset_id, int slot) {
     // audio_sfxbuf[slot].samples = samples;
 }
 
-static void sfx_load(pak_track asset_id) {
-    if (asset_id.id < 1 || PAK_TRACK_COUNT < asset_id.id) {
-        fatal_error("sfx_load: invalid asset");
-    }
-    int slot = audio_track_to_slot[asset_id.id];
-    if (audio_track_from_slot[slot] == asset_id.id) {
-        return;
-    }
-    slot = audio_sfxcount;
-    if (slot >= AUDIO_SFX_SLOTS) {
-        fatal_error("sfx_load: out of slots");
-    }
-    audio_sfxcount = slot + 1;
-    sfx_load_slot(asset_id, slot);
-}
-
 struct audio_voice {
     ALSndId id;
+    int slot; // Pinned sound effect slot.
 };
 
 static int audio_voice_count = 0;
 static struct audio_voice audio_voices[AUDIO_MAX_VOICES - 1];
 
 void audio_init(void) {
-    for (int i = ID_SFX_FIRST; i <= ID_SFX_LAST; i++) {
-        sfx_load((pak_track){i});
-    }
+    // Sound effects stop being used as soon as their voice is deallocated.
+    residency_init(&audio_sfx_residency, "sfx", AUDIO_SFX_SLOTS,
+                   PAK_TRACK_COUNT, 0, sfx_load_slot);
 
     pak_track asset = TRACK_RISING_TIDE;
 
-    // Mark all DMA buffers as "old" so they get used.
-    for (int i = 0; i < AUDIO_DMA_COUNT; i++) {
-        audio_dma[i].age = 1;
-    }
-
-    osCreateMesgQueue(&audio_dmaqueue, audio_dmaqueue_buffer,
-                      ARRAY_COUNT(audio_dmaqueue_buffer));
+    audio_dma_init();
 
     int audio_rate = osAiSetFrequency(AUDIO_SAMPLERATE);
     if (osTvType == OS_TV_PAL) {
@@ -272,7 +199,7 @@ void audio_init(void) {
 
     pak_load_asset_sync(&audio_trackbuf, sizeof(audio_trackbuf),
                         pak_track_object(asset));
-    audio_track_fixup(&audio_trackbuf, asset);
+    audio_track_bind(&audio_trackbuf, asset);
     audio_trackstart = current_sample;
     audio_trackinfo = audio_trackbuf.header.info;
     static ALSound snd = {
@@ -319,12 +246,7 @@ static void audio_startsfx(struct sfx_src *restrict sp) {
     if (sp->track_id.id < 1 || PAK_TRACK_COUNT < sp->track_id.id) {
         fatal_error("invalid sfx: %d", sp->track_id.id);
     }
-    int slot = audio_track_to_slot[sp->track_id.id];
-    if (audio_track_from_slot[slot] != sp->track_id.id) {
-        fatal_error("NOT LOADED %d %d", audio_track_from_slot[slot],
-                    sp->track_id.id);
-        return;
-    }
+    int slot = residency_use(&audio_sfx_residency, sp->track_id.id);
     ALSndId sndid = alSndpAllocate(&audio_sndp, &audio_sfxbuf[slot].sound);
     if (sndid < 0) {
         return;
@@ -337,32 +259,18 @@ static void audio_startsfx(struct sfx_src *restrict sp) {
     alSndpPlay(&audio_sndp);
     audio_voices[voice] = (struct audio_voice){
         .id = sndid,
+        .slot = slot,
     };
+    residency_pin(&audio_sfx_residency, slot);
 }
 
 void audio_frame(struct game_state *restrict gs,
                  struct audio_state *restrict st, struct scheduler *sc,
                  OSMesgQueue *queue) {
-    // Return finished DMA messages.
-    {
-        int nactive = audio_dmanactive;
-        for (;;) {
-            OSMesg mesg;
-            int r = osRecvMesg(&audio_dmaqueue, &mesg, OS_MESG_NOBLOCK);
-            if (r == -1) {
-                break;
-            }
-            nactive--;
-        }
-        audio_dmanactive = nactive;
-    }
-
-    // Increase the age of all sample buffers.
-    for (int i = 0; i < AUDIO_DMA_COUNT; i++) {
-        audio_dma[i].age++;
-    }
+    audio_dma_update();
 
     // Play game sound effects.
+    residency_set_frame(&audio_sfx_residency, ++audio_frame_count);
     for (struct sfx_src *restrict srcp = gs->sfx.src,
                                   *srce = srcp + gs->sfx.count;
          srcp != srce; srcp++) {
@@ -386,6 +294,7 @@ void audio_frame(struct game_state *restrict gs,
         int state = alSndpGetState(&audio_sndp);
         if (state == AL_STOPPED) {
             alSndpDeallocate(&audio_sndp, audio_voices[i].id);
+            residency_unpin(&audio_sfx_residency, audio_voices[i].slot);
             audio_voice_count--;
             audio_voices[i] = audio_voices[audio_voice_count];
         } else {
@@ -0,0 +1,97 @@
+#include "game/n64/audio_dma.h"
+
+#include "base/base.h"
+#include "base/pak/pak.h"
+
+#include <ultra64.h>
+
+struct audio_dmainfo {
+    uint32_t age;
+    uint32_t offset;
+};
+
+static struct audio_dmainfo audio_dma[AUDIO_DMA_COUNT];
+
+static u8 audio_dmabuf[AUDIO_DMA_COUNT][AUDIO_DMA_BUFSZ]
+    __attribute__((aligned(16), section("uninit")));
+
+static OSIoMesg audio_dmamsg[AUDIO_DMA_COUNT];
+
+static OSMesgQueue audio_dmaqueue;
+static OSMesg audio_dmaqueue_buffer[AUDIO_DMA_COUNT];
+static unsigned audio_dmanext, audio_dmanactive;
+
+void audio_dma_init(void) {
+    // Mark all DMA buffers as "old" so they get used.
+    for (int i = 0; i < AUDIO_DMA_COUNT; i++) {
+        audio_dma[i].age = 1;
+    }
+
+    osCreateMesgQueue(&audio_dmaqueue, audio_dmaqueue_buffer,
+                      ARRAY_COUNT(audio_dmaqueue_buffer));
+}
+
+void *audio_dma_load(uint32_t addr, uint32_t len) {
+    struct audio_dmainfo *restrict dma = audio_dma;
+    uint32_t astart = addr, aend = astart + len;
+
+    // If these samples are already buffered, return the buffer.
+    int oldest = 0;
+    uint32_t oldest_age = 0;
+    for (int i = 0; i < AUDIO_DMA_COUNT; i++) {
+        if (dma[i].age > oldest_age) {
+            oldest = i;
+            oldest_age = dma[i].age;
+        }
+        uint32_t dstart = dma[i].offset, dend = dstart + AUDIO_DMA_BUFSZ;
+        if (dstart <= astart && aend <= dend) {
+            dma[i].age = 0;
+            uint32_t offset = astart - dstart;
+            return audio_dmabuf[i] + offset;
+        }
+    }
+
+    // Otherwise, use the oldest buffer to start a new DMA.
+    if (oldest_age == 0 || audio_dmanactive >= AUDIO_DMA_COUNT) {
+        // If the buffer is in use, don't bother.
+        fatal_error("DMA buffer in use"); // FIXME: not in release builds
+        return audio_dmabuf[oldest];
+    }
+    uint32_t dma_addr = astart & ~1u;
+    OSIoMesg *restrict mesg = &audio_dmamsg[audio_dmanext];
+    audio_dmanext = (audio_dmanext + 1) % AUDIO_DMA_COUNT;
+    audio_dmanactive++;
+    *mesg = (OSIoMesg){
+        .hdr = {.pri = OS_MESG_PRI_NORMAL, .retQueue = &audio_dmaqueue},
+        .dramAddr = audio_dmabuf[oldest],
+        .devAddr = dma_addr,
+        .size = AUDIO_DMA_BUFSZ,
+    };
+    osEPiStartDma(rom_handle, mesg, OS_READ);
+    dma[oldest] = (struct audio_dmainfo){
+        .age = 0,
+        .offset = dma_addr,
+    };
+    return audio_dmabuf[oldest] + (astart & 1u);
+}
+
+void audio_dma_update(void) {
+    // Return finished DMA messages.
+    {
+        int nactive = audio_dmanactive;
+        for (;;) {
+            OSMesg mesg;
+            int r = osRecvMesg(&audio_dmaqueue, &mesg, OS_MESG_NOBLOCK);
+            if (r == -1) {
+                break;
+            }
+            nactive--;
+        }
+        audio_dmanactive = nactive;
+    }
+
+    // Increase the age of all sample buffers.
+    for (int i = 0; i < AUDIO_DMA_COUNT; i++) {
+        audio_dma[i].age++;
+    }
+}
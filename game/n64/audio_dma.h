@@ -0,0 +1,24 @@
+// Audio sample DMA.
+#pragma once
+
+#include <stdint.h>
+
+// Audio samples are streamed from the cartridge into a small set of buffers.
+// This does not depend on the audio library, so it can be tested on the host.
+
+enum {
+    AUDIO_DMA_COUNT = 8,
+    AUDIO_DMA_BUFSZ = 2 * 1024,
+};
+
+// Initialize the sample buffers.
+void audio_dma_init(void);
+
+// Get a pointer to the given range of cartridge data. If the range is not
+// already in a buffer, start a DMA to load it into the least recently used
+// buffer. The data is ready by the time the audio task runs, but not
+// necessarily before then.
+void *audio_dma_load(uint32_t addr, uint32_t len);
+
+// Retire finished DMAs and age the buffers. Called once per audio frame.
+void audio_dma_update(void);
@@ -0,0 +1,104 @@
+// Test for audio sample DMA, running against the host libultra stand-in.
+#include "game/n64/audio_dma.h"
+
+#include "base/base.h"
+#include "base/pak/pak.h"
+#include "base/testlib/testlib.h"
+#include "sdk/host/host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Linked with the pak loader, which needs an object table.
+struct pak_object pak_objects[1];
+
+enum {
+    ROM_SIZE = 64 * 1024,
+};
+
+static uint8_t rom[ROM_SIZE];
+
+static const char *make_rom(void) {
+    for (int i = 0; i < ROM_SIZE; i++) {
+        rom[i] = i * 7 + (i >> 8);
+    }
+    static char path[256];
+    const char *dir = getenv("TEST_TMPDIR");
+    if (dir == NULL) {
+        dir = "/tmp";
+    }
+    snprintf(path, sizeof(path), "%s/audio_dma_test.rom", dir);
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL || fwrite(rom, 1, sizeof(rom), fp) != sizeof(rom) ||
+        fclose(fp) != 0) {
+        test_logf("could not write %s", quote_str(path));
+        test_fail();
+    }
+    return path;
+}
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+// Number of DMAs at the start of the current check.
+static unsigned dma_base;
+
+// Load samples, and check the data and the number of DMAs started.
+static const uint8_t *check_load(uint32_t addr, uint32_t len, int dma_count) {
+    const uint8_t *ptr = audio_dma_load(addr, len);
+    host_pi_flush();
+    if (memcmp(ptr, rom + addr, len) != 0) {
+        test_logf("data at 0x%x does not match", (unsigned)addr);
+        test_fail();
+    }
+    check_int("DMA count", host_pi_stats().dma_count - dma_base, dma_count);
+    return ptr;
+}
+
+static void start(const char *name) {
+    test_start(name);
+    dma_base = host_pi_stats().dma_count;
+}
+
+void test_main(void) {
+    host_init(&(struct host_config){
+        .rom = make_rom(),
+        .pi_latency = 10000,
+    });
+    pak_init(0);
+    audio_dma_init();
+
+    // Buffers start out covering the beginning of the ROM, so tests use data
+    // after that.
+    start("hit");
+    const uint8_t *p = check_load(4100, 50, 1);
+    const uint8_t *q = check_load(4120, 100, 1);
+    check_int("offset", q - p, 20);
+    check_load(4100 + AUDIO_DMA_BUFSZ - 10, 20, 2);
+
+    start("odd");
+    // DMAs start on an even address.
+    check_load(9001, 10, 1);
+    check_load(9000, 11, 1);
+    audio_dma_update();
+
+    start("lru");
+    // Fill every buffer, one per frame.
+    for (int i = 0; i < AUDIO_DMA_COUNT; i++) {
+        check_load(16384 + i * AUDIO_DMA_BUFSZ, 16, i + 1);
+        audio_dma_update();
+    }
+    // Using the oldest buffer again makes the second oldest buffer get
+    // replaced by the next load.
+    check_load(16384, 16, AUDIO_DMA_COUNT);
+    audio_dma_update();
+    check_load(12000, 16, AUDIO_DMA_COUNT + 1);
+    audio_dma_update();
+    check_load(16384, 16, AUDIO_DMA_COUNT + 1);
+    check_load(16384 + AUDIO_DMA_BUFSZ, 16, AUDIO_DMA_COUNT + 2);
+}
@@ -1,6 +1,7 @@
 #include "game/n64/graphics.h"
 
 #include "base/base.h"
+#include "base/memory.h"
 #include "base/n64/os.h"
 #include "base/n64/scheduler.h"
 #include "game/n64/system.h"
@@ -26,12 +27,44 @@ static Mtx matrixes[2][64] __attribute__((section("uninit")));
 static struct scheduler_task tasks[2];
 static Vp viewports[2];
 
+enum {
+    // Size of the per-frame memory for each graphics task. The most used at
+    // once is 8 KB: 2 KB of particle vertexes, which last the whole frame, and
+    // 6 KB of text glyph buffers, which are released after use. The model
+    // transforms, 448 bytes, are released before the particles are drawn.
+    FRAME_MEMORY_SIZE = 8 * 1024,
+};
+
+// Per-frame memory for each graphics task.
+static struct mem_frame frame_memory;
+
 enum {
     SP_STACK_SIZE = 1024,
 };
 
 static u64 sp_dram_stack[SP_STACK_SIZE / 8] __attribute__((section("uninit")));
 
+// The graphics microcode. This must match the -ucode flag passed to
+// modelconvert, which is set with --define=ucode=<name>.
+#if defined UCODE_F3DEX
+#define UCODE_TEXT gspF3DEX_fifoTextStart
+#define UCODE_DATA gspF3DEX_fifoDataStart
+#define UCODE_FIFO 1
+#else
+#define UCODE_TEXT gspF3DEX2_xbusTextStart
+#define UCODE_DATA gspF3DEX2_xbusDataStart
+#define UCODE_FIFO 0
+#endif
+
+#if UCODE_FIFO
+enum {
+    // Size of the RDP command FIFO buffer, used by FIFO microcode.
+    FIFO_SIZE = 0x10000,
+};
+
+static u64 fifo_buffer[FIFO_SIZE / 8] __attribute__((section("uninit")));
+#endif
+
 // Get the resource mask for the given task.
 static unsigned graphics_taskmask(int i) {
     return 1u << i;
@@ -42,6 +75,10 @@ static unsigned graphics_buffermask(int i) {
     return 4u << i;
 }
 
+void graphics_init(void) {
+    mem_frame_init(&frame_memory, FRAME_MEMORY_SIZE, "frame");
+}
+
 // Render the next graphics frame.
 void graphics_frame(struct game_state *restrict gs,
                     struct graphics_state *restrict st, struct scheduler *sc,
@@ -72,6 +109,8 @@ void graphics_frame(struct game_state *restrict gs,
             .zbuffer = zbuffer,
             .is_pal = is_pal,
             .viewport = &viewports[st->current_task],
+            // The previous task using these resources has finished.
+            .frame_zone = mem_frame_begin(&frame_memory, st->current_task),
         };
         game_system_render(gs, &gr);
         data_ptr = (u64 *)dl_start;
@@ -90,13 +129,18 @@ void graphics_frame(struct game_state *restrict gs,
         .ucode_boot = (u64 *)rspbootTextStart,
         .ucode_boot_size =
             (uintptr_t)rspbootTextEnd - (uintptr_t)rspbootTextStart,
-        .ucode_data = (u64 *)gspF3DEX2_xbusDataStart,
+        .ucode_data = (u64 *)UCODE_DATA,
         .ucode_data_size = SP_UCODE_DATA_SIZE,
-        .ucode = (u64 *)gspF3DEX2_xbusTextStart,
+        .ucode = (u64 *)UCODE_TEXT,
         .ucode_size = SP_UCODE_SIZE,
         .dram_stack = sp_dram_stack,
         .dram_stack_size = sizeof(sp_dram_stack),
+#if UCODE_FIFO
+        .output_buff = fifo_buffer,
+        .output_buff_size = fifo_buffer + ARRAY_COUNT(fifo_buffer),
+#else
         // No output_buff.
+#endif
         .data_ptr = data_ptr,
         .data_size = data_size,
     }};
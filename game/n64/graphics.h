@@ -7,6 +7,7 @@
 #include <stdbool.h>
 
 struct game_state;
+struct mem_zone;
 struct scheduler;
 
 enum {
@@ -17,6 +18,10 @@ enum {
     SCREEN_HEIGHT_PAL = 288,
     SCREEN_HEIGHT_NONPAL = 240,
     SCREEN_HEIGHT_BUFFER = SCREEN_HEIGHT_PAL,
+
+    // Number of frames after a frame is built that the RCP may still be
+    // reading the data it references. Two graphics tasks can be in flight.
+    GRAPHICS_LATENCY = 2,
 };
 
 // How long a "meter" is in game units.
@@ -38,6 +43,10 @@ struct graphics {
     Mtx *mtx_start;
     Mtx *mtx_end;
 
+    // Memory for data used by this frame only. It is released when the
+    // graphics task for the frame finishes.
+    struct mem_zone *frame_zone;
+
     uint16_t *framebuffer;
     uint16_t *zbuffer;
 
@@ -59,6 +68,9 @@ struct graphics_state {
 // The frame index being rendered, or rendered next.
 extern unsigned graphics_current_frame;
 
+// Initialize graphics.
+void graphics_init(void);
+
 // Render the next graphics frame.
 void graphics_frame(struct game_state *restrict gs,
                     struct graphics_state *restrict st, struct scheduler *sc,
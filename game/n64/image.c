@@ -1,89 +1,257 @@
 #include "game/n64/image.h"
 
-#include "assets/image.h"
 #include "assets/pak.h"
 #include "base/base.h"
-#include "base/fixup.h"
 #include "base/memory.h"
 #include "base/pak/pak.h"
+#include "base/residency.h"
 #include "game/core/menu.h"
 #include "game/n64/graphics.h"
+#include "game/n64/image_strip.h"
 
 enum {
-    // Maximum number of images which can be loaded at once.
-    IMAGE_SLOTS = 4,
+    // Maximum number of compressed images, and maximum number of streamed
+    // images, which can be loaded at once.
+    IMAGE_SLOTS = 3,
 
-    // Amount of memory which can be used for images.
-    IMAGE_HEAPSIZE = 192 * 1024,
+    // Amount of memory for each compressed image. Larger images should be
+    // stored without compression, so they are streamed.
+    IMAGE_SLOTSIZE = 16 * 1024,
+
+    // Amount of memory for each streamed image. Only the header is loaded,
+    // and this must be a multiple of 8.
+    IMAGE_HEADERSIZE = 2 * 1024,
+
+    // Number of strips of streamed images which can be loaded at once.
+    IMAGE_STRIP_COUNT = 16,
+
+    // Amount of memory for each strip. Strips fit in TMEM.
+    IMAGE_STRIP_SIZE = 4 * 1024,
+
+    // Number of rows above and below the screen to load strips ahead of time,
+    // for images which are moving on-screen.
+    IMAGE_PREFETCH = 32,
 };
 
 // A single rectangle of image data in a larger image.
 struct image_rect {
     short x, y, xsz, ysz;
-    void *pixels;
+    uint32_t pixels; // Offset of pixel data from start of image.
 };
 
-// Header for a strip-based image.
+// Header for a strip-based image. Image data is position-independent, and is
+// used in place after loading.
 struct image_header {
     int rect_count;
     struct image_rect rect[];
 };
 
+// Get the pixel data for a rectangle in an image.
+static void *image_pixels(const struct image_header *restrict img,
+                          const struct image_rect *restrict r) {
+    return (void *)((uintptr_t)img + r->pixels);
+}
+
+// A set of image slots.
+struct image_slots {
+    struct residency residency;
+    struct image_header *image[IMAGE_SLOTS];
+    uint32_t request[IMAGE_SLOTS]; // Pak request loading each slot.
+    bool checked[IMAGE_SLOTS];     // Whether each image has been checked.
+};
+
 // Image system state.
 struct image_state {
-    struct mem_zone heap;
-    struct image_header *image[IMAGE_SLOTS];
-    int image_from_slot[IMAGE_SLOTS];
-    int image_to_slot[PAK_IMAGE_COUNT + 1];
+    // Compressed images are loaded whole. Images stored without compression
+    // are streamed: only the header is loaded into a slot, and the strips are
+    // loaded into strip buffers as they are drawn.
+    struct image_slots whole;
+    struct image_slots stream;
+
+    // Strips of streamed images. Completed loads send the strip index to the
+    // queue.
+    struct image_strip strip[IMAGE_STRIP_COUNT];
+    uint8_t *strip_data;
+    OSMesgQueue strip_queue;
+    OSMesg strip_queue_buffer[IMAGE_STRIP_COUNT];
 };
 
-// Fix the internal pointers in an image after loading.
-static void image_fixup(struct image_header *restrict img, size_t size) {
-    uintptr_t base = (uintptr_t)img;
-    for (int i = 0; i < img->rect_count; i++) {
-        img->rect[i].pixels = pointer_fixup(img->rect[i].pixels, base, size);
-    }
+// Get the size of the pixel data for a rectangle.
+static uint32_t image_rect_size(const struct image_rect *restrict r) {
+    unsigned xsz = (r->xsz + 3) & ~3u;
+    return xsz * r->ysz * sizeof(uint16_t);
 }
 
-// Load an image into the given slot.
-static void image_load_slot(struct image_state *restrict ist, pak_image asset,
-                            int slot) {
-    int obj = pak_image_object(asset);
-    size_t obj_size = pak_objects[obj].size;
-    struct image_header *restrict img = mem_zone_alloc(&ist->heap, obj_size);
-    pak_load_asset_sync(img, obj_size, obj);
-    image_fixup(img, obj_size);
-    ist->image[slot] = img;
-    ist->image_to_slot[asset.id] = slot;
-    ist->image_from_slot[slot] = asset.id;
+// Check that the rectangles in an image are in range. Does not modify the
+// image or read the pixel data. For streamed images, only the first
+// header_size bytes are loaded, and each rectangle must fit in a strip buffer.
+static void image_check(const struct image_header *restrict img, size_t size,
+                        size_t header_size, bool stream) {
+    bool ok = img->rect_count >= 0 &&
+              (size_t)img->rect_count <=
+                  (header_size - sizeof(*img)) / sizeof(*img->rect);
+    for (int i = 0; ok && i < img->rect_count; i++) {
+        const struct image_rect *restrict r = &img->rect[i];
+        ok = r->xsz >= 0 && r->ysz >= 0 && r->pixels < size &&
+             image_rect_size(r) <= size - r->pixels &&
+             (!stream || image_rect_size(r) <= IMAGE_STRIP_SIZE);
+    }
+    if (!ok) {
+        fatal_error("Bad image header");
+    }
 }
 
 // State of the image system.
 static struct image_state image_state;
 
-// Load an image into an available slot.
-static void image_load(pak_image asset) {
-    struct image_state *restrict ist = &image_state;
-    if (asset.id < 1 || PAK_IMAGE_COUNT < asset.id) {
-        fatal_error("image_load: invalid image\nImage: %d", asset.id);
+// Get the size of the part of an image loaded into its slot.
+static size_t image_loaded_size(const struct pak_object *restrict obj,
+                                bool stream) {
+    return stream && obj->size > IMAGE_HEADERSIZE ? IMAGE_HEADERSIZE
+                                                  : obj->size;
+}
+
+// Return true if an image is streamed.
+static bool image_is_streamed(int asset) {
+    int obj = pak_image_object((pak_image){asset});
+    return (pak_objects[obj].flags & PAK_COMPRESSED) == 0;
+}
+
+// Get the slots which hold an image.
+static struct image_slots *image_slots_for(struct image_state *restrict ist,
+                                           bool stream) {
+    return stream ? &ist->stream : &ist->whole;
+}
+
+// Start loading an image into the given slot.
+static void image_load_slot(int asset, int slot, bool stream) {
+    struct image_slots *restrict sl = image_slots_for(&image_state, stream);
+    int obj = pak_image_object((pak_image){asset});
+    const struct pak_object *restrict op = &pak_objects[obj];
+    size_t obj_size = op->size;
+    if (!stream && obj_size > IMAGE_SLOTSIZE) {
+        fatal_error("image_load: image too large\nImage: %d\nSize: %zu",
+                    asset, obj_size);
+    }
+    // The previous image in this slot may still be loading.
+    if (sl->request[slot] != 0) {
+        pak_wait(sl->request[slot]);
     }
-    int slot = ist->image_to_slot[asset.id];
-    if (ist->image_from_slot[slot] == asset.id) {
-        return;
+    sl->checked[slot] = false;
+    if (stream) {
+        sl->request[slot] =
+            pak_load_async(sl->image[slot], op->offset,
+                           image_loaded_size(op, true), PAK_PRI_NORMAL, NULL,
+                           NULL);
+    } else {
+        sl->request[slot] = pak_load_asset_async(
+            sl->image[slot], IMAGE_SLOTSIZE, obj, PAK_PRI_NORMAL);
+    }
+}
+
+static void image_load_whole(int asset, int slot) {
+    image_load_slot(asset, slot, false);
+}
+
+static void image_load_stream(int asset, int slot) {
+    image_load_slot(asset, slot, true);
+}
+
+// Get a loaded image, waiting for it to finish loading if necessary. The image
+// is checked the first time it is used after loading. Synchronous and staged
+// loads complete with no request, so this does not depend on the request.
+static const struct image_header *image_get(struct image_slots *restrict sl,
+                                            int slot, bool stream) {
+    if (sl->request[slot] != 0) {
+        pak_wait(sl->request[slot]);
+        sl->request[slot] = 0;
     }
-    for (slot = 0; slot < IMAGE_SLOTS; slot++) {
-        if (ist->image_from_slot[slot] == 0) {
-            image_load_slot(ist, asset, slot);
-            return;
+    if (!sl->checked[slot]) {
+        sl->checked[slot] = true;
+        pak_image asset = {sl->residency.slot[slot].asset};
+        const struct pak_object *restrict op =
+            &pak_objects[pak_image_object(asset)];
+        image_check(sl->image[slot], op->size, image_loaded_size(op, stream),
+                    stream);
+    }
+    return sl->image[slot];
+}
+
+// Record strip loads which have completed.
+static void image_strip_poll(struct image_state *restrict ist) {
+    OSMesg mesg;
+    while (osRecvMesg(&ist->strip_queue, &mesg, OS_MESG_NOBLOCK) == 0) {
+        ist->strip[(uintptr_t)mesg].request = 0;
+    }
+}
+
+// Get the strip buffer containing a strip, or return -1 if the strip is not
+// loaded or loading.
+static int image_strip_find(const struct image_state *restrict ist, int asset,
+                            int rect) {
+    for (int i = 0; i < IMAGE_STRIP_COUNT; i++) {
+        const struct image_strip *restrict sp = &ist->strip[i];
+        if (sp->image == asset && sp->rect == rect) {
+            return i;
         }
     }
-    fatal_error("image_load: no slots available");
+    return -1;
+}
+
+// Start loading a strip into the least recently used strip buffer which the
+// RCP is not reading. Returns false if there is no such buffer.
+static bool image_strip_load(struct image_state *restrict ist, int asset,
+                             const struct image_header *restrict img, int rect,
+                             pak_priority priority) {
+    const unsigned frame = graphics_current_frame;
+    int best = image_strip_victim(ist->strip, IMAGE_STRIP_COUNT, frame,
+                                  GRAPHICS_LATENCY);
+    if (best < 0) {
+        return false;
+    }
+    struct image_strip *restrict sp = &ist->strip[best];
+    // Finish the previous load, and remove its message from the queue, so it
+    // is not mistaken for the completion of the new load.
+    if (sp->request != 0) {
+        pak_wait(sp->request);
+        image_strip_poll(ist);
+    }
+    const struct pak_object *restrict op =
+        &pak_objects[pak_image_object((pak_image){asset})];
+    const struct image_rect *restrict r = &img->rect[rect];
+    *sp = (struct image_strip){
+        .image = asset,
+        .rect = rect,
+        // Strips loaded ahead of time can be replaced immediately.
+        .last_use =
+            priority == PAK_PRI_HIGH ? frame : frame - GRAPHICS_LATENCY,
+    };
+    sp->request = pak_load_async(ist->strip_data + best * IMAGE_STRIP_SIZE,
+                                 op->offset + r->pixels, image_rect_size(r),
+                                 priority, &ist->strip_queue,
+                                 (OSMesg)(uintptr_t)best);
+    return true;
 }
 
 void image_init(void) {
-    mem_zone_init(&image_state.heap, IMAGE_HEAPSIZE, "image");
-    image_load(IMG_LOGO);
-    image_load(IMG_POINT);
+    struct image_state *restrict ist = &image_state;
+    for (int i = 0; i < IMAGE_SLOTS; i++) {
+        ist->whole.image[i] = mem_alloc(IMAGE_SLOTSIZE);
+        ist->stream.image[i] = mem_alloc(IMAGE_HEADERSIZE);
+    }
+    ist->strip_data = mem_alloc(IMAGE_STRIP_COUNT * IMAGE_STRIP_SIZE);
+    osCreateMesgQueue(&ist->strip_queue, ist->strip_queue_buffer,
+                      IMAGE_STRIP_COUNT);
+    residency_init(&ist->whole.residency, "image", IMAGE_SLOTS,
+                   PAK_IMAGE_COUNT, GRAPHICS_LATENCY, image_load_whole);
+    residency_init(&ist->stream.residency, "image stream", IMAGE_SLOTS,
+                   PAK_IMAGE_COUNT, GRAPHICS_LATENCY, image_load_stream);
+}
+
+void image_preload(pak_image image_id) {
+    bool stream = image_is_streamed(image_id.id);
+    residency_use(&image_slots_for(&image_state, stream)->residency,
+                  image_id.id);
 }
 
 static const Gfx image_dl[] = {
@@ -99,20 +267,78 @@ static const Gfx image_dl[] = {
     gsSPEndDisplayList(),
 };
 
-static Gfx *image_draw(Gfx *dl, Gfx *dl_end, pak_image asset, int x, int y) {
-    (void)dl_end;
-    struct image_state *restrict ist = &image_state;
-    int slot = ist->image_to_slot[asset.id];
-    if (ist->image_from_slot[slot] != asset.id) {
-        fatal_error("image_draw: not loaded\nImage: %d", asset.id);
+// Return true if a rectangle drawn at the given position overlaps the screen,
+// extended by the given margin above and below.
+static bool image_rect_visible(struct graphics *restrict gr,
+                               const struct image_rect *restrict r, int x,
+                               int y, int margin) {
+    return x + r->x < gr->width && x + r->x + r->xsz > 0 &&
+           y + r->y < gr->height + margin && y + r->y + r->ysz > -margin;
+}
+
+// Get the pixel data to draw for a rectangle, or NULL if it should not be
+// drawn. For streamed images, strips are drawn once they are loaded, and strips
+// which are not loaded are loaded ahead of time.
+static void *image_draw_pixels(struct image_state *restrict ist,
+                               struct graphics *restrict gr, bool stream,
+                               int asset,
+                               const struct image_header *restrict img,
+                               int rect, int x, int y) {
+    if (!stream) {
+        return image_pixels(img, &img->rect[rect]);
+    }
+    if (!image_rect_visible(gr, &img->rect[rect], x, y, 0)) {
+        return NULL;
+    }
+    int strip = image_strip_find(ist, asset, rect);
+    if (strip < 0) {
+        return NULL;
+    }
+    struct image_strip *restrict sp = &ist->strip[strip];
+    sp->last_use = graphics_current_frame;
+    if (sp->request != 0) {
+        return NULL;
+    }
+    return ist->strip_data + strip * IMAGE_STRIP_SIZE;
+}
+
+// Start loading strips of a streamed image which are not loaded. Strips on
+// screen are loaded first, and strips near the screen are loaded if there are
+// buffers to spare.
+static void image_stream(struct image_state *restrict ist,
+                         struct graphics *restrict gr, int asset,
+                         const struct image_header *restrict img, int x,
+                         int y) {
+    static const int margin[2] = {0, IMAGE_PREFETCH};
+    static const pak_priority priority[2] = {PAK_PRI_HIGH, PAK_PRI_NORMAL};
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < img->rect_count; i++) {
+            if (image_rect_visible(gr, &img->rect[i], x, y, margin[pass]) &&
+                image_strip_find(ist, asset, i) < 0 &&
+                !image_strip_load(ist, asset, img, i, priority[pass])) {
+                return;
+            }
+        }
     }
-    const struct image_header *restrict img = ist->image[slot];
+}
+
+static Gfx *image_draw(Gfx *dl, struct graphics *restrict gr, pak_image asset,
+                       int x, int y) {
+    struct image_state *restrict ist = &image_state;
+    const bool stream = image_is_streamed(asset.id);
+    struct image_slots *restrict sl = image_slots_for(ist, stream);
+    int slot = residency_use(&sl->residency, asset.id);
+    const struct image_header *restrict img = image_get(sl, slot, stream);
     gSPDisplayList(dl++, image_dl);
     for (int i = 0; i < img->rect_count; i++) {
+        void *pixels =
+            image_draw_pixels(ist, gr, stream, asset.id, img, i, x, y);
+        if (pixels == NULL) {
+            continue;
+        }
         struct image_rect r = img->rect[i];
         unsigned xsz = (r.xsz + 3) & ~3u;
-        gDPSetTextureImage(dl++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1,
-                           img->rect[i].pixels);
+        gDPSetTextureImage(dl++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, pixels);
         gDPSetTile(dl++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 0, 0, G_TX_LOADTILE, 0,
                    G_TX_NOMIRROR, 0, G_TX_NOLOD, G_TX_NOMIRROR, 0, G_TX_NOLOD);
         gDPLoadSync(dl++);
@@ -126,6 +352,9 @@ static Gfx *image_draw(Gfx *dl, Gfx *dl_end, pak_image asset, int x, int y) {
                             (x + r.x + xsz) << 2, (y + r.y + r.ysz) << 2, 0, 0,
                             0, 1 << 10, 1 << 10);
     }
+    if (stream) {
+        image_stream(ist, gr, asset.id, img, x, y);
+    }
     return dl;
 }
 
@@ -133,10 +362,12 @@ Gfx *image_render(Gfx *dl, struct graphics *restrict gr,
                   struct sys_menu *restrict msys) {
     // Coordinates of screen center.
     const int x0 = gr->width >> 1, y0 = gr->height >> 1;
+    residency_set_frame(&image_state.whole.residency, graphics_current_frame);
+    residency_set_frame(&image_state.stream.residency, graphics_current_frame);
+    image_strip_poll(&image_state);
     for (int i = 0; i < msys->image_count; i++) {
         const struct menu_image *restrict imp = &msys->image[i];
-        dl = image_draw(dl, gr->dl_end, imp->image, x0 + imp->pos.x,
-                        y0 - imp->pos.y);
+        dl = image_draw(dl, gr, imp->image, x0 + imp->pos.x, y0 - imp->pos.y);
     }
     return dl;
 }
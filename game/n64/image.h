@@ -1,6 +1,8 @@
 // Large image handling.
 #pragma once
 
+#include "base/pak/types.h"
+
 #include <ultra64.h>
 
 struct graphics;
@@ -9,6 +11,9 @@ struct sys_menu;
 // Initialize large image handling.
 void image_init(void);
 
+// Load an image before it is used.
+void image_preload(pak_image image_id);
+
 // Render large images.
 Gfx *image_render(Gfx *dl, struct graphics *restrict gr,
                   struct sys_menu *restrict msys);
@@ -0,0 +1,19 @@
+#include "game/n64/image_strip.h"
+
+int image_strip_victim(const struct image_strip *restrict strip, int count,
+                       unsigned frame, unsigned latency) {
+    int best = -1;
+    unsigned best_age = 0;
+    for (int i = 0; i < count; i++) {
+        const struct image_strip *restrict sp = &strip[i];
+        if (sp->image == 0) {
+            return i;
+        }
+        unsigned age = frame - sp->last_use;
+        if (age >= latency && (best < 0 || age > best_age)) {
+            best = i;
+            best_age = age;
+        }
+    }
+    return best;
+}
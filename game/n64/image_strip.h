@@ -0,0 +1,21 @@
+// Strip buffers for streamed images.
+#pragma once
+
+#include <stdint.h>
+
+// This does not depend on libultra, so it can be tested on the host.
+
+// A strip of a streamed image, loaded into a strip buffer.
+struct image_strip {
+    int image;         // Image asset ID, or zero if the buffer is unused.
+    int rect;          // Index of the rectangle in the image.
+    unsigned last_use; // Frame when the strip was last drawn.
+    uint32_t request;  // Pak request loading the strip, or zero if loaded.
+};
+
+// Choose a strip buffer to load a new strip into. This is an unused buffer, if
+// there is one, or else the least recently used buffer which was last used at
+// least latency frames before the given frame, so the RCP is no longer reading
+// it. Returns -1 if there is no such buffer.
+int image_strip_victim(const struct image_strip *restrict strip, int count,
+                       unsigned frame, unsigned latency);
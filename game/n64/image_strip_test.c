@@ -0,0 +1,88 @@
+#include "game/n64/image_strip.h"
+
+#include "base/base.h"
+#include "base/testlib/testlib.h"
+
+enum {
+    STRIPS = 4,
+    LATENCY = 2,
+};
+
+static struct image_strip strip[STRIPS];
+
+static void check_int(const char *what, int got, int expect) {
+    if (got != expect) {
+        test_logf("%s: got %d, expect %d", what, got, expect);
+        test_fail();
+    }
+}
+
+// Fill every buffer with a strip last used in the given frames.
+static void fill(const unsigned last_use[STRIPS]) {
+    for (int i = 0; i < STRIPS; i++) {
+        strip[i] = (struct image_strip){
+            .image = 1,
+            .rect = i,
+            .last_use = last_use[i],
+        };
+    }
+}
+
+static int victim(unsigned frame) {
+    return image_strip_victim(strip, STRIPS, frame, LATENCY);
+}
+
+static void test_empty(void) {
+    test_start("empty");
+    static const unsigned last_use[STRIPS] = {1, 2, 3, 4};
+    fill(last_use);
+    // Unused buffers are chosen first, even over old strips.
+    strip[2].image = 0;
+    check_int("victim", victim(100), 2);
+}
+
+static void test_lru(void) {
+    test_start("lru");
+    static const unsigned last_use[STRIPS] = {7, 3, 9, 5};
+    fill(last_use);
+    check_int("victim", victim(20), 1);
+    strip[1].last_use = 20;
+    check_int("victim", victim(20), 3);
+}
+
+static void test_latency(void) {
+    test_start("latency");
+    static const unsigned last_use[STRIPS] = {10, 10, 9, 10};
+    fill(last_use);
+    // Strips used in the last LATENCY frames may still be read by the RCP.
+    check_int("victim", victim(10), -1);
+    check_int("victim", victim(9 + LATENCY - 1), -1);
+    check_int("victim", victim(9 + LATENCY), 2);
+    check_int("victim", victim(10 + LATENCY), 2);
+}
+
+static void test_prefetch(void) {
+    test_start("prefetch");
+    static const unsigned last_use[STRIPS] = {10, 10, 10, 10};
+    fill(last_use);
+    // Strips loaded ahead of time are marked as used LATENCY frames ago, so
+    // they can be replaced in the same frame.
+    strip[3].last_use = 10 - LATENCY;
+    check_int("victim", victim(10), 3);
+}
+
+static void test_wrap(void) {
+    test_start("wrap");
+    // The frame counter wraps around.
+    static const unsigned last_use[STRIPS] = {0xfffffffeu, 1, 0xffffffffu, 2};
+    fill(last_use);
+    check_int("victim", victim(3), 0);
+}
+
+void test_main(void) {
+    test_empty();
+    test_lru();
+    test_latency();
+    test_prefetch();
+    test_wrap();
+}
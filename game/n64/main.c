@@ -4,6 +4,8 @@
 #include "base/n64/os.h"
 #include "base/n64/scheduler.h"
 #include "base/pak/pak.h"
+#include "base/pak/trace.h"
+#include "base/prof.h"
 #include "game/n64/audio.h"
 #include "game/n64/graphics.h"
 #include "game/n64/system.h"
@@ -16,8 +18,9 @@
 #include <stdint.h>
 
 enum {
-    // Maximum number of simultaneous PI requests.
-    PI_MSG_COUNT = 8,
+    // Maximum number of simultaneous PI requests. Pak loads and audio DMA each
+    // have up to eight requests in flight.
+    PI_MSG_COUNT = PAK_REQUEST_COUNT + 8,
 };
 
 extern u8 _main_thread_stack[];
@@ -86,6 +89,7 @@ static void main(void *arg) {
                       PI_MSG_COUNT);
 
     pak_init(PAK_SIZE);
+    pak_trace_start();
 
     // Set up message queues.
     osCreateMesgQueue(&st->evt_queue, st->evt_buffer,
@@ -100,17 +104,23 @@ static void main(void *arg) {
 
         if (video_ready || audio_ready) {
             while (process_event(st, OS_MESG_NOBLOCK) == 0) {}
+            prof_next_frame();
+            pak_poll();
             console_init(&console, CONSOLE_TRUNCATE);
             game_system_update(&game_state, &scheduler);
 
             if (audio_ready) {
+                PROF_BEGIN("audio");
                 audio_frame(&game_state, &st->audio, &scheduler,
                             &st->evt_queue);
+                PROF_END();
             }
 
             if (video_ready) {
+                PROF_BEGIN("graphics");
                 graphics_frame(&game_state, &st->graphics, &scheduler,
                                &st->evt_queue);
+                PROF_END();
             }
         } else {
             process_event(st, OS_MESG_BLOCK);
@@ -1,14 +1,14 @@
 #include "game/n64/model.h"
 
-#include "assets/model.h"
 #include "assets/pak.h"
 #include "assets/texture.h"
 #include "base/base.h"
-#include "base/fixup.h"
 #include "base/hash.h"
-#include "base/mat4.h"
+#include "base/heap.h"
+#include "base/memory.h"
 #include "base/n64/mat4.h"
 #include "base/pak/pak.h"
+#include "base/residency.h"
 #include "base/vec2.h"
 #include "base/vec3.h"
 #include "game/core/physics.h"
@@ -17,8 +17,14 @@
 #include "game/n64/material.h"
 
 enum {
-    // Number of model assets which can be loaded at once.
-    MODEL_SLOTS = 3,
+    // Maximum number of model assets which can be loaded at once.
+    MODEL_SLOTS = 8,
+
+    // Size of the heap for model data.
+    MODEL_HEAP_SIZE = 32 * 1024,
+
+    // Maximum number of bytes of model data moved by compaction each frame.
+    MODEL_COMPACT_BUDGET = 4 * 1024,
 
     // Number of animation frames which can be loaded at once.
     FRAME_SLOTS = 8,
@@ -37,99 +43,118 @@ static_assert((int)MAT_SLOT_COUNT == (int)MATERIAL_SLOTS);
 // Models
 // =============================================================================
 
+// Model data is position-independent: it is used in place after loading, and
+// all references are offsets, which the accessors below resolve.
+
 // A frame in a model animation.
 struct model_frame {
     float time;
     float inv_dt;    // Inverse of time delta to next frame.
-    unsigned vertex; // Cartridge address of vertex data.
+    unsigned vertex; // Offset of vertex data in the frame data object.
 };
 
 // An animation in a model.
 struct model_animation {
     float duration;
     int frame_count;
-    struct model_frame *frame;
+    uint32_t frame_offset; // Offset of frame array from start of model.
 };
 
-// Header for the model data.
+// Header for the model data. Offsets are relative to the start of the header.
 struct model_header {
-    Vtx *vertex_data;
-    Gfx *display_list[MATERIAL_SLOTS];
+    uint32_t vertex_offset;
+    uint32_t display_list_offset[MATERIAL_SLOTS]; // Zero if unused.
     int animation_count;
     unsigned frame_size;
     struct model_animation animation[];
 };
 
-// Model data, including buffer.
-union model_data {
-    struct model_header header;
-    uint8_t data[10 * 1024];
-};
+// Get the static vertex data for a model.
+static Vtx *model_vertex(const struct model_header *restrict mdl) {
+    return (Vtx *)((uintptr_t)mdl + mdl->vertex_offset);
+}
 
-// Loaded models.
-static union model_data model_data[MODEL_SLOTS] ASSET;
-
-// Map from model asset ID to slot number. If the slot maps back to the same
-// model asset, then this texture is loaded, otherwise it is not loaded.
-static int model_to_slot[PAK_MODEL_COUNT + 1];
-
-// Map from model slot number to model asset ID.
-static int model_from_slot[MODEL_SLOTS];
-
-// Fix the internal pointers in a model after loading.
-static void model_fixup(union model_data *p, pak_model asset) {
-    const struct pak_object vtx_obj = pak_objects[pak_model_object(asset) + 1];
-    const uintptr_t base = (uintptr_t)p;
-    const size_t size = sizeof(union model_data);
-    struct model_header *restrict hdr = &p->header;
-    const unsigned max_vtx_offset =
-        vtx_obj.size < hdr->frame_size ? 0 : vtx_obj.size - hdr->frame_size;
-    hdr->vertex_data = pointer_fixup(hdr->vertex_data, base, size);
-    for (int i = 0; i < MATERIAL_SLOTS; i++) {
-        hdr->display_list[i] = pointer_fixup(hdr->display_list[i], base, size);
-    }
-    for (int i = 0; i < hdr->animation_count; i++) {
-        struct model_animation *restrict anim = &hdr->animation[i];
-        if (anim->frame_count > 0) {
-            struct model_frame *restrict frame =
-                pointer_fixup(hdr->animation[i].frame, base, size);
-            anim->frame = frame;
-            for (int j = 0; j < anim->frame_count; j++) {
-                unsigned vtx_offset = frame[j].vertex;
-                if (vtx_offset > max_vtx_offset) {
-                    fatal_error("Bad vertex offset\nOffset: $%x", vtx_offset);
-                }
-                frame[j].vertex = vtx_obj.offset + vtx_offset;
-            }
-        }
-    }
+// Get the display list for a material slot, or NULL if there is none.
+static Gfx *model_display_list(const struct model_header *restrict mdl,
+                               int slot) {
+    uint32_t offset = mdl->display_list_offset[slot];
+    return offset == 0 ? NULL : (Gfx *)((uintptr_t)mdl + offset);
 }
 
-// Load a model into the given slot.
-static void model_load_slot(pak_model asset, int slot) {
-    pak_load_asset_sync(&model_data[slot], sizeof(model_data[slot]),
-                        pak_model_object(asset));
-    model_fixup(&model_data[slot], asset);
-    model_to_slot[asset.id] = slot;
-    model_from_slot[slot] = asset.id;
+// Get the frames in an animation.
+static const struct model_frame *model_frames(
+    const struct model_header *restrict mdl,
+    const struct model_animation *restrict anim) {
+    return (const struct model_frame *)((uintptr_t)mdl + anim->frame_offset);
 }
 
-// Load a model and return the slot.
-static int model_load(pak_model asset) {
-    if (asset.id < 1 || PAK_MODEL_COUNT < asset.id) {
-        fatal_error("model_load: invalid model\nModel: %d", asset.id);
+// Loaded models. Models are variable-size, and the heap is compacted a little
+// each frame, so models must be accessed through their handles.
+static uint8_t model_heap_data[MODEL_HEAP_SIZE] ASSET;
+static struct heap model_heap;
+
+// Heap handle for each loaded model, or zero.
+static int model_handle[MODEL_SLOTS];
+
+// Value of model_heap.stats.moved_size when the heap was last written back.
+static uint32_t model_moved_size;
+
+// Frame data object for each loaded model.
+static struct pak_object model_frame_object[MODEL_SLOTS];
+
+// Tracks which models are loaded into which slots.
+static struct residency model_residency;
+
+// Check that the offsets in a model header are in range. Does not modify the
+// model or read the frame arrays.
+static void model_check(const struct model_header *restrict mdl,
+                        uint32_t size) {
+    bool ok = size >= sizeof(*mdl) && mdl->vertex_offset < size &&
+              (unsigned)mdl->animation_count <
+                  (size - sizeof(*mdl)) / sizeof(*mdl->animation);
+    for (int i = 0; ok && i < MATERIAL_SLOTS; i++) {
+        ok = mdl->display_list_offset[i] < size;
     }
-    int slot = model_to_slot[asset.id];
-    if (model_from_slot[slot] == asset.id) {
-        return slot;
+    for (int i = 0; ok && i < mdl->animation_count; i++) {
+        const struct model_animation *restrict anim = &mdl->animation[i];
+        ok = anim->frame_offset <= size &&
+             (unsigned)anim->frame_count <=
+                 (size - anim->frame_offset) / sizeof(struct model_frame);
+    }
+    if (!ok) {
+        fatal_error("Bad model header");
     }
-    for (slot = 0; slot < MODEL_SLOTS; slot++) {
-        if (model_from_slot[slot] == 0) {
-            model_load_slot(asset, slot);
-            return slot;
+}
+
+// Free the model data in a slot.
+static void model_free_slot(int slot) {
+    heap_free(&model_heap, model_handle[slot]);
+    model_handle[slot] = 0;
+}
+
+// Load a model into the given slot.
+static void model_load_slot(int asset, int slot) {
+    model_free_slot(slot);
+    int obj = pak_model_object((pak_model){asset});
+    uint32_t size = pak_objects[obj].size;
+    int handle;
+    // Evict other models until this one fits.
+    while ((handle = heap_alloc(&model_heap, size)) == 0) {
+        int victim = residency_evict(&model_residency);
+        if (victim < 0) {
+            fatal_error(
+                "Model heap full\nAsset: %d\nSize: %lu\nFree: %zu\n"
+                "Largest: %zu",
+                asset, (unsigned long)size, heap_free_size(&model_heap),
+                heap_largest_free(&model_heap));
         }
+        model_free_slot(victim);
     }
-    fatal_error("model_load: no slots available");
+    model_handle[slot] = handle;
+    void *ptr = heap_get(&model_heap, handle);
+    pak_load_asset_sync(ptr, size, obj);
+    model_check(ptr, size);
+    model_frame_object[slot] = pak_objects[obj + 1];
 }
 
 // =============================================================================
@@ -225,20 +250,48 @@ static uint8_t frame_data[FRAME_SLOTS][5 * 1024] ASSET;
 // Map from slots to animation frame cartridge addresses.
 static unsigned frame_from_slot[FRAME_SLOTS];
 
-// Next slot to load into.
-static int frame_next_slot;
+// Graphics frame when each slot was last used.
+static unsigned frame_last_use[FRAME_SLOTS];
+
+// Pak request loading each slot, or zero.
+static uint32_t frame_request[FRAME_SLOTS];
+
+// Find a slot to load a new animation frame into. This is an empty slot, if
+// there is one, or else the least recently used slot which the RCP is no
+// longer reading. Returns -1 if there is no such slot.
+static int frame_victim(void) {
+    int best = -1;
+    unsigned best_age = 0;
+    for (int i = 0; i < FRAME_SLOTS; i++) {
+        if (frame_from_slot[i] == 0) {
+            return i;
+        }
+        unsigned age = graphics_current_frame - frame_last_use[i];
+        if (age >= GRAPHICS_LATENCY && (best < 0 || age > best_age)) {
+            best = i;
+            best_age = age;
+        }
+    }
+    return best;
+}
 
-// Load an animation frame. Return the slot index.
+// Start loading an animation frame, if it is not already loaded. Return the
+// slot index, or -1 if every slot is in use. The data is not available until
+// frame_wait is called.
 static int frame_load(unsigned frame_addr, unsigned size) {
     unsigned hash = hash32(frame_addr);
 
     // Find the frame if it is loaded.
     int slot = frame_slot_get(frame_to_slot, hash, frame_addr);
+    if (slot >= 0) {
+        frame_last_use[slot] = graphics_current_frame;
+        return slot;
+    }
 
-    // Find an empty slot, and load it there.
-    slot = frame_next_slot++;
-    if (frame_next_slot >= FRAME_SLOTS) {
-        frame_next_slot = 0;
+    // Evict a slot which is not in use, and load it there.
+    slot = frame_victim();
+    if (slot < 0) {
+        return -1;
     }
     if (size > sizeof(frame_data[slot])) {
         fatal_error(
@@ -246,24 +299,41 @@ static int frame_load(unsigned frame_addr, unsigned size) {
             "Frame size: %u\nSlot size: %zu\n",
             size, sizeof(frame_data[slot]));
     }
-    pak_load_data_sync(&frame_data[slot], frame_addr, size);
+    frame_request[slot] = pak_load_async(&frame_data[slot], frame_addr, size,
+                                         PAK_PRI_HIGH, NULL, NULL);
     unsigned old_addr = frame_from_slot[slot];
     if (old_addr != 0) {
         frame_slot_erase(frame_to_slot, hash32(old_addr), old_addr);
     }
     frame_slot_set(frame_to_slot, hash, frame_addr, slot);
     frame_from_slot[slot] = frame_addr;
+    frame_last_use[slot] = graphics_current_frame;
     return slot;
 }
 
+// Wait for all animation frames to finish loading.
+static void frame_wait(void) {
+    for (int i = 0; i < FRAME_SLOTS; i++) {
+        if (frame_request[i] != 0) {
+            pak_wait(frame_request[i]);
+            frame_request[i] = 0;
+        }
+    }
+}
+
 // =============================================================================
 // Public
 // =============================================================================
 
 void model_render_init(void) {
-    model_load(MODEL_FAIRY);
-    model_load(MODEL_BLUEENEMY);
-    model_load(MODEL_GREENENEMY);
+    heap_init(&model_heap, "model", model_heap_data, sizeof(model_heap_data),
+              MODEL_SLOTS, GRAPHICS_LATENCY);
+    residency_init(&model_residency, "model", MODEL_SLOTS, PAK_MODEL_COUNT,
+                   GRAPHICS_LATENCY, model_load_slot);
+}
+
+void model_preload(pak_model model_id) {
+    residency_use(&model_residency, model_id.id);
 }
 
 static const struct model_frame *model_getframe(
@@ -275,62 +345,108 @@ static const struct model_frame *model_getframe(
     if (anim->frame_count == 0) {
         return NULL;
     }
+    const struct model_frame *restrict frame = model_frames(mdl, anim);
     for (int i = 0; i < anim->frame_count; i++) {
-        if (anim->frame[i].time > time) {
-            return i > 0 ? &anim->frame[i - 1] : &anim->frame[0];
+        if (frame[i].time > time) {
+            return i > 0 ? &frame[i - 1] : &frame[0];
         }
     }
-    return &anim->frame[anim->frame_count - 1];
+    return &frame[anim->frame_count - 1];
 }
 
 Gfx *model_render(Gfx *dl, struct graphics *restrict gr,
                   struct sys_model *restrict msys,
                   struct sys_phys *restrict psys) {
+    residency_set_frame(&model_residency, graphics_current_frame);
+    heap_set_frame(&model_heap, graphics_current_frame);
+    // Compact before taking any pointers to model data.
+    heap_compact(&model_heap, MODEL_COMPACT_BUDGET);
+    // Create all of the model matrixes in one batch. The transforms are only
+    // used until the matrixes are created.
+    Mtx *restrict mtx = gr->mtx_ptr;
+    {
+        int capacity = msys->pool.count;
+        struct mem_mark mark = mem_zone_mark(gr->frame_zone);
+        vec3 *restrict pos =
+            mem_zone_alloc(gr->frame_zone, sizeof(*pos) * capacity);
+        quat *restrict rot =
+            mem_zone_alloc(gr->frame_zone, sizeof(*rot) * capacity);
+        int count = 0;
+        struct pool_join j = pool_join_start(&msys->pool, &psys->pool);
+        while (pool_join_next(&j)) {
+            const struct cp_model *restrict mp = j.a;
+            const struct cp_phys *restrict cp = j.b;
+            if (mp->model_id.id != 0) {
+                pos[count] =
+                    vec3_vec2(vec2_scale(cp->pos, meter), meter * cp->height);
+                rot[count] = cp->orientation;
+                count++;
+            }
+        }
+        if (count > gr->mtx_end - gr->mtx_ptr) {
+            fatal_error("Matrix overflow");
+        }
+        mat4_tofixed_translate_rotate_scale(mtx, count, pos, rot, NULL);
+        gr->mtx_ptr += count;
+        mem_zone_release(gr->frame_zone, mark);
+    }
     void *current_segment = 0;
     unsigned mat_flags = G_MTX_MODELVIEW | G_MTX_LOAD | G_MTX_PUSH;
-    for (int i = 0; i < msys->count; i++) {
-        struct cp_model *restrict mp = &msys->models[i];
-        struct cp_phys *restrict cp = physics_get(psys, mp->ent);
+    // Visit the entities in the same order as above, so each uses the next
+    // matrix.
+    struct pool_join j = pool_join_start(&msys->pool, &psys->pool);
+    while (pool_join_next(&j)) {
+        struct cp_model *restrict mp = j.a;
         int model = mp->model_id.id;
-        if (model == 0 || cp == NULL) {
+        if (model == 0) {
             continue;
         }
-        int slot = model_to_slot[model];
-        if (model_from_slot[slot] != model) {
-            fatal_error("Model not loaded");
-        }
-        const struct model_header *restrict mdl = &model_data[slot].header;
-        void *segment = mdl->vertex_data;
+        int slot = residency_use(&model_residency, model);
+        const struct model_header *restrict mdl =
+            heap_use(&model_heap, model_handle[slot]);
+        void *segment = model_vertex(mdl);
         const struct model_frame *frame =
             model_getframe(mdl, mp->animation_id, mp->animation_time);
         if (frame != NULL) {
-            int frame_slot = frame_load(frame->vertex, mdl->frame_size);
-            segment = frame_data[frame_slot];
+            const struct pak_object fobj = model_frame_object[slot];
+            if (fobj.size < mdl->frame_size ||
+                frame->vertex > fobj.size - mdl->frame_size) {
+                fatal_error("Bad vertex offset\nOffset: $%x", frame->vertex);
+            }
+            int frame_slot =
+                frame_load(fobj.offset + frame->vertex, mdl->frame_size);
+            // If every slot is in use, draw the model's base pose.
+            if (frame_slot >= 0) {
+                segment = frame_data[frame_slot];
+            }
         }
         if (segment != current_segment) {
             gSPSegment(dl++, 1, K0_TO_PHYS(segment));
         }
-        Mtx *mtx = gr->mtx_ptr++;
-        {
-            mat4 mat;
-            mat4_translate_rotate_scale(
-                &mat, vec3_vec2(vec2_scale(cp->pos, meter), meter * cp->height),
-                cp->orientation, 1.0f);
-            mat4_tofixed(mtx, &mat);
-        }
         gSPMatrix(dl++, K0_TO_PHYS(mtx), mat_flags);
+        mtx++;
         mat_flags &= ~G_MTX_PUSH;
+        // Materials merged into a texture atlas have no display list, so
+        // their textures are not loaded.
         for (int j = 0; j < MATERIAL_SLOTS; j++) {
-            if ((mp->material[j].flags & MAT_ENABLED) != 0) {
+            Gfx *mdl_dl = model_display_list(mdl, j);
+            if ((mp->material[j].flags & MAT_ENABLED) != 0 && mdl_dl != NULL) {
                 dl = material_use(&gr->material, dl, mp->material[j]);
-                if (mdl->display_list[0] != NULL) {
-                    gSPDisplayList(dl++, K0_TO_PHYS(mdl->display_list[j]));
-                }
+                gSPDisplayList(dl++, K0_TO_PHYS(mdl_dl));
             }
         }
     }
     if ((mat_flags & G_MTX_PUSH) == 0) {
         gSPPopMatrix(dl++, G_MTX_MODELVIEW);
     }
+    // Compaction copies model data through the data cache, and the RSP reads
+    // the new locations.
+    if (model_heap.stats.moved_size != model_moved_size) {
+        model_moved_size = model_heap.stats.moved_size;
+        osWritebackDCache(model_heap_data, model_heap.stats.high_water);
+    }
+    // The frame loads overlap with building the display list, but must finish
+    // before the RSP reads them.
+    frame_wait();
     return dl;
 }
@@ -11,6 +11,9 @@ struct sys_phys;
 // Initialize model rendering.
 void model_render_init(void);
 
+// Load a model before it is used.
+void model_preload(pak_model model_id);
+
 // Render all models.
 Gfx *model_render(Gfx *dl, struct graphics *restrict gr,
                   struct sys_model *restrict msys,
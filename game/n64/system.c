@@ -1,9 +1,16 @@
 #include "game/n64/system.h"
 
+#include "assets/group.h"
+#include "assets/pak.h"
 #include "base/base.h"
 #include "base/console.h"
+#include "base/log.h"
+#include "base/memory.h"
 #include "base/n64/console.h"
 #include "base/n64/scheduler.h"
+#include "base/pak/pak.h"
+#include "base/pak/trace.h"
+#include "base/prof.h"
 #include "game/n64/audio.h"
 #include "game/n64/camera.h"
 #include "game/n64/defs.h"
@@ -16,24 +23,124 @@
 #include "game/n64/text.h"
 #include "game/n64/texture.h"
 
+// Buffer for loading preload groups, large enough for any group. This is only
+// allocated while the groups are loaded.
+static void *game_group_buffer;
+static size_t game_group_bufsize;
+
+// Pages which can be shown on the console.
+typedef enum {
+    PAGE_GAME,    // Output from the game.
+    PAGE_MEMORY,  // Memory usage.
+    PAGE_PROFILE, // Profiler zones.
+
+    PAGE_COUNT,
+} console_page;
+
+// The page shown on the console.
+static console_page game_page;
+
+// Load an asset from a preload group.
+static void game_preload_member(int object_id) {
+    pak_texture texture = pak_texture_asset(object_id);
+    pak_model model = pak_model_asset(object_id);
+    pak_image image = pak_image_asset(object_id);
+    if (texture.id != 0) {
+        texture_preload(texture);
+    } else if (model.id != 0) {
+        model_preload(model);
+    } else if (image.id != 0) {
+        image_preload(image);
+    } else {
+        fatal_error("Cannot preload object\nObject: %d", object_id);
+    }
+}
+
+// Load all assets in a preload group, with one DMA.
+static void game_preload(pak_group group) {
+    pak_load_group(pak_group_object(group), game_group_buffer,
+                   game_group_bufsize, game_preload_member);
+}
+
 void game_system_init(struct game_state *restrict gs) {
+    mem_set_tag(MEM_TAG_GRAPHICS);
+    graphics_init();
+    mem_set_tag(MEM_TAG_AUDIO);
     audio_init();
+    mem_set_tag(MEM_TAG_GAME);
     input_init(&gs->input);
     time_init();
+    mem_set_tag(MEM_TAG_ASSET);
     model_render_init();
-    particle_render_init();
     texture_init();
     image_init();
+    mem_set_tag(MEM_TAG_TEXT);
     text_init();
+    mem_set_tag(MEM_TAG_ASSET);
     terrain_init();
+    for (int i = 1; i <= PAK_GROUP_COUNT; i++) {
+        size_t size = pak_objects[pak_group_object((pak_group){i})].size;
+        if (size > game_group_bufsize) {
+            game_group_bufsize = size;
+        }
+    }
+    game_group_buffer = mem_alloc_temp(game_group_bufsize);
+    game_preload(GROUP_BOOT);
+    game_preload(GROUP_STAGE);
+    mem_free_temp(game_group_buffer, game_group_bufsize);
+    game_group_buffer = NULL;
+    mem_set_tag(MEM_TAG_GAME);
     game_init(gs);
+    mem_set_tag(MEM_TAG_OTHER);
     // gs->show_console = true;
 }
 
 void game_system_update(struct game_state *restrict gs, struct scheduler *sc) {
+    PROF_BEGIN("update");
     input_update(&gs->input);
     float dt = time_update(&gs->time, sc);
+    unsigned log_start = log_position();
     game_update(gs, dt);
+    // Messages from this frame are only formatted when the console is visible.
+    if (gs->show_console) {
+        log_print(&console, log_start);
+    }
+    // With the console open, Z cycles between the game output, the memory
+    // page, and the profiler page. R prints the pak load trace, except on the
+    // profiler page, where holding R shows the last frame's zones in the
+    // format read by tools/proftrace.
+    bool dump = false;
+    if (gs->show_console && gs->input.count >= 1) {
+        unsigned press = gs->input.input[0].button_press;
+        dump = (gs->input.input[0].button_state & BUTTON_R) != 0;
+        if ((press & BUTTON_R) != 0 && game_page != PAGE_PROFILE) {
+            pak_trace_print();
+        }
+        if ((press & BUTTON_Z) != 0) {
+            game_page = (game_page + 1) % PAGE_COUNT;
+        }
+    }
+    if (gs->show_console) {
+        switch (game_page) {
+        case PAGE_GAME:
+            break;
+        case PAGE_MEMORY:
+            console_init(&console, CONSOLE_TRUNCATE);
+            mem_report();
+            break;
+        case PAGE_PROFILE:
+            console_init(&console, CONSOLE_TRUNCATE);
+            if (dump) {
+                prof_dump(&console);
+            } else {
+                prof_print(&console);
+            }
+            break;
+        case PAGE_COUNT:
+            break;
+        }
+    }
+    PROF_END();
 }
 
 enum {
@@ -144,19 +251,33 @@ void game_system_render(struct game_state *restrict gs,
     // Render game.
     gDPSetDepthImage(dl++, gr->zbuffer);
     gDPSetPrimColor(dl++, 0, 0, 255, 255, 255, 255);
+    PROF_BEGIN("camera_render");
     dl = camera_render(&gs->camera, gr, dl);
+    PROF_END();
+    PROF_BEGIN("model_render");
     dl = model_render(dl, gr, &gs->model, &gs->physics);
+    PROF_END();
+    PROF_BEGIN("terrain_render");
     dl = terrain_render(dl, gr);
+    PROF_END();
+    PROF_BEGIN("particle_render");
     dl = particle_render(dl, gr, &gs->particle, &gs->camera);
+    PROF_END();
     gDPSetTextureLOD(dl++, G_TL_TILE);
 
     // Render menu images and text.
+    PROF_BEGIN("image_render");
     dl = image_render(dl, gr, &gs->menu);
+    PROF_END();
+    PROF_BEGIN("text_render");
     dl = text_render(dl, gr, &gs->menu);
+    PROF_END();
 
     // Render debugging text overlay.
     if (gs->show_console) {
+        PROF_BEGIN("console_render");
         dl = console_draw_displaylist(&console, dl, gr->dl_end);
+        PROF_END();
     }
 
     if (2 > gr->dl_end - dl) {
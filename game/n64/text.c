@@ -6,9 +6,9 @@
 #include "assets/font.h"
 #include "assets/pak.h"
 #include "base/base.h"
-#include "base/fixup.h"
 #include "base/memory.h"
 #include "base/pak/pak.h"
+#include "base/residency.h"
 #include "game/core/menu.h"
 #include "game/n64/defs.h"
 #include "game/n64/graphics.h"
@@ -21,10 +21,21 @@
 
 enum {
     // Maximum total number of font textures.
-    MAX_FONT_TEXTURES = 12,
+    MAX_FONT_TEXTURES = 64,
 
-    // Memory available for fonts.
-    FONT_HEAP_SIZE = 48 * 1024,
+    // Memory available for font headers.
+    FONT_HEAP_SIZE = 16 * 1024,
+
+    // Number of font textures which can be loaded at once.
+    FONT_PAGES = 10,
+
+    // Amount of memory for each loaded font texture. Font textures fit in
+    // TMEM.
+    FONT_PAGE_SIZE = 4 * 1024,
+
+    // Maximum number of glyphs drawn in one frame. The glyph buffers for this
+    // many glyphs take 6 KB of the graphics frame memory.
+    TEXT_MAX_GLYPHS = 256,
 };
 
 // =============================================================================
@@ -94,28 +105,42 @@ static struct font_sprite font_get_sprite(const char *name, size_t namelen) {
 // Font Loading
 // =============================================================================
 
+// Font data is position-independent, and is used in place after loading. Only
+// the header is loaded, up to the end of the texture array. The textures are
+// loaded separately, as pages, when text uses them.
+
 struct font_glyph {
     uint8_t size[2];
     int8_t offset[2];
     uint8_t pos[2];
-    uint8_t texindex;
+    uint8_t texindex; // One plus texture index in font, or zero if invisible.
     uint8_t advance;
 };
 
 struct font_header {
     uint16_t glyph_count;
     uint16_t texture_count;
-    struct font_texture *textures; // Not used at runtime, use font_textures.
+    uint32_t texture_offset; // Offset of font_texture_data array.
     uint8_t charmap[256];
     struct font_glyph glyphs[];
 };
 
+// A font texture, as stored in the font asset.
+struct font_texture_data {
+    uint16_t width;
+    uint16_t height;
+    uint16_t pix_fmt;
+    uint16_t pix_size;
+    uint32_t pixels; // Offset of pixel data from start of font.
+};
+
 struct font_texture {
     uint16_t width;
     uint16_t height;
     uint16_t pix_fmt;
     uint16_t pix_size;
-    void *pixels;
+    uint32_t offset; // Offset of pixel data in the cartridge.
+    uint32_t size;   // Size of pixel data.
 };
 
 struct font_texture_slot {
@@ -123,56 +148,177 @@ struct font_texture_slot {
     struct font_glyph *glyphs;
 };
 
-// All textures loaded. Slot 0 is invalid, used for invisible glyphs.
+// All textures in loaded fonts. Slot 0 is invalid, used for invisible glyphs.
 static struct font_texture_slot font_textures[MAX_FONT_TEXTURES];
 
-// Fix internal pointers in font after loading.
-static void font_fixup(struct font_header *restrict fn, size_t size,
-                       int first_texture) {
+// Get the size of a font header, given the start of the header.
+static uint32_t font_header_size(const struct font_header *restrict fn) {
+    return fn->texture_offset +
+           fn->texture_count * sizeof(struct font_texture_data);
+}
+
+// Get the size of the pixel data in a texture, or zero if the pixel size is
+// not supported.
+static uint32_t font_texture_size(
+    const struct font_texture_data *restrict tex) {
+    unsigned bits;
+    switch (tex->pix_size) {
+    case G_IM_SIZ_4b:
+        bits = 4;
+        break;
+    case G_IM_SIZ_8b:
+        bits = 8;
+        break;
+    case G_IM_SIZ_16b:
+        bits = 16;
+        break;
+    default:
+        return 0;
+    }
+    // DMA sizes must be even.
+    return ((tex->width * tex->height * bits + 15) >> 4) << 1;
+}
+
+// Add the textures in a font to the texture slots, starting with the given
+// slot. Reads the texture array, but does not modify the font. The font object
+// is at the given offset in the cartridge, and has the given size.
+static void font_add_textures(struct font_header *restrict fn, uint32_t offset,
+                              uint32_t size, int first_texture) {
     const uintptr_t base = (uintptr_t)fn;
-    const struct font_texture *restrict texarr =
-        pointer_fixup(fn->textures, base, size);
+    const struct font_texture_data *restrict texarr =
+        (const struct font_texture_data *)(base + fn->texture_offset);
     for (int i = 0; i < fn->texture_count; i++) {
-        struct font_texture tex = texarr[i];
-        tex.pixels = pointer_fixup(tex.pixels, base, size);
+        const struct font_texture_data *restrict tex = &texarr[i];
+        uint32_t tsize = font_texture_size(tex);
+        if (tex->pixels >= size || tsize == 0 || tsize > FONT_PAGE_SIZE ||
+            tsize > size - tex->pixels) {
+            fatal_error("Bad font texture\nOffset: $%x", tex->pixels);
+        }
         font_textures[first_texture + i] = (struct font_texture_slot){
-            .texture = tex,
+            .texture =
+                {
+                    .width = tex->width,
+                    .height = tex->height,
+                    .pix_fmt = tex->pix_fmt,
+                    .pix_size = tex->pix_size,
+                    .offset = offset + tex->pixels,
+                    .size = tsize,
+                },
             .glyphs = fn->glyphs,
         };
     }
-    for (int i = 0; i < fn->glyph_count; i++) {
-        struct font_glyph *gi = &fn->glyphs[i];
-        if (gi->size[0] == 0 || gi->size[1] == 0) {
-            gi->texindex = 0;
-        } else {
-            gi->texindex += first_texture;
-        }
-    }
 }
 
-// Memory for loading fonts.
+// Memory for loading font headers.
 static struct mem_zone font_heap;
 
 // Pointer to font data for each font asset.
 static struct font_header *font_slots[PAK_FONT_COUNT + 1];
 
+// Texture slot of the first texture in each font asset.
+static int font_first_texture[PAK_FONT_COUNT + 1];
+
 // Number of textures loaded. Includes the empty slot, 0.
 static int font_texture_count = 1;
 
-static void font_load(pak_font asset_id) {
-    // Load from cartridge memory.
-    int obj = pak_font_object(asset_id);
-    size_t size = pak_objects[obj].size;
-    struct font_header *fn = mem_zone_alloc(&font_heap, size);
-    pak_load_asset_sync(fn, size, obj);
-    int first = font_texture_count;
-    if (fn->texture_count > MAX_FONT_TEXTURES - first) {
-        fatal_error("Too many font textures\nLoaded: %d\nNew: %d", first,
-                    fn->texture_count);
+// Load font headers from cartridge memory. The fixed part of each header is
+// read first to get the header size, and then the headers are loaded
+// together.
+static void font_load(const pak_font *assets, int count) {
+    struct font_header *fonts[PAK_FONT_COUNT];
+    uint32_t request[PAK_FONT_COUNT];
+    if (count > PAK_FONT_COUNT) {
+        fatal_error("font_load: too many fonts\nCount: %d", count);
+    }
+    for (int i = 0; i < count; i++) {
+        const struct pak_object *restrict obj =
+            &pak_objects[pak_font_object(assets[i])];
+        if ((obj->flags & PAK_COMPRESSED) != 0) {
+            fatal_error("Font is compressed\nFont: %d", assets[i].id);
+        }
+        alignas(16) struct font_header probe;
+        if (obj->size < sizeof(probe)) {
+            fatal_error("Bad font header");
+        }
+        pak_load_data_sync(&probe, obj->offset, 16);
+        uint32_t size = font_header_size(&probe);
+        if (probe.texture_offset < sizeof(probe) ||
+            probe.glyph_count > (probe.texture_offset - sizeof(probe)) /
+                                    sizeof(struct font_glyph) ||
+            probe.texture_offset > obj->size || size > obj->size) {
+            fatal_error("Bad font header");
+        }
+        size = (size + 7) & ~7u;
+        fonts[i] = mem_zone_alloc(&font_heap, size);
+        request[i] = pak_load_async(fonts[i], obj->offset, size,
+                                    PAK_PRI_NORMAL, NULL, NULL);
+    }
+    for (int i = 0; i < count; i++) {
+        pak_wait(request[i]);
+    }
+    for (int i = 0; i < count; i++) {
+        const struct pak_object *restrict obj =
+            &pak_objects[pak_font_object(assets[i])];
+        struct font_header *fn = fonts[i];
+        int first = font_texture_count;
+        if (fn->texture_count > MAX_FONT_TEXTURES - first) {
+            fatal_error("Too many font textures\nLoaded: %d\nNew: %d", first,
+                        fn->texture_count);
+        }
+        font_add_textures(fn, obj->offset, obj->size, first);
+        font_slots[assets[i].id] = fn;
+        font_first_texture[assets[i].id] = first;
+        font_texture_count = first + fn->texture_count;
+    }
+}
+
+// Loaded font textures.
+struct font_pages {
+    struct residency residency;
+    uint8_t *data;
+    uint32_t request[FONT_PAGES]; // Pak request loading each page, or zero.
+    // Completed loads send the page index to the queue.
+    OSMesgQueue queue;
+    OSMesg queue_buffer[FONT_PAGES];
+};
+
+static struct font_pages font_pages;
+
+// Record page loads which have completed.
+static void font_page_poll(void) {
+    struct font_pages *restrict fp = &font_pages;
+    OSMesg mesg;
+    while (osRecvMesg(&fp->queue, &mesg, OS_MESG_NOBLOCK) == 0) {
+        fp->request[(uintptr_t)mesg] = 0;
+    }
+}
+
+// Start loading a font texture into a page.
+static void font_page_load(int texture, int page) {
+    struct font_pages *restrict fp = &font_pages;
+    // Finish the previous load, and remove its message from the queue, so it
+    // is not mistaken for the completion of the new load.
+    if (fp->request[page] != 0) {
+        pak_wait(fp->request[page]);
+        font_page_poll();
     }
-    font_fixup(fn, size, first);
-    font_slots[asset_id.id] = fn;
-    font_texture_count = first + fn->texture_count;
+    const struct font_texture *restrict tex = &font_textures[texture].texture;
+    fp->request[page] = pak_load_async(
+        fp->data + page * FONT_PAGE_SIZE, tex->offset, tex->size,
+        PAK_PRI_HIGH, &fp->queue, (OSMesg)(uintptr_t)page);
+}
+
+// Mark a font texture as used in this frame. Returns a pointer to its pixel
+// data if it is loaded, or NULL if it is still loading or there is no page
+// free to load it into. Pages used in recent frames cannot be reused, so text
+// with more textures than that is drawn over several frames.
+static void *font_page_use(int texture) {
+    struct font_pages *restrict fp = &font_pages;
+    int page = residency_try_use(&fp->residency, texture);
+    if (page < 0 || fp->request[page] != 0) {
+        return NULL;
+    }
+    return fp->data + page * FONT_PAGE_SIZE;
 }
 
 static const struct font_header *font_get(pak_font asset_id) {
@@ -277,12 +423,12 @@ static void text_place(struct text_glyph *restrict glyphs, int count, int x,
             xpos = x;
             line_start = i;
         }
-        int glyph = glyphs[i].glyph;
-        const struct font_glyph *restrict gi =
-            &font_slots[glyphs[i].src]->glyphs[glyph];
+        int font = glyphs[i].src, glyph = glyphs[i].glyph;
+        const struct font_glyph *restrict gi = &font_slots[font]->glyphs[glyph];
         glyphs[i].x = xpos + gi->offset[0];
         glyphs[i].y = ypos + gi->offset[1];
-        glyphs[i].src = gi->texindex;
+        glyphs[i].src =
+            gi->texindex == 0 ? 0 : font_first_texture[font] + gi->texindex - 1;
         xpos += gi->advance;
     }
     text_align(glyphs + line_start, count - line_start, xpos - x);
@@ -314,29 +460,30 @@ static int text_sort(struct text_glyph *restrict out_glyphs,
     return pos;
 }
 
-// Two buffers -- first buffer is for the raw glyphs, second buffer is for
-// glyphs converted to sprites + textures + coordinates.
-static struct text_glyph glyph_buffer[2][256];
-
 void text_init(void) {
     mem_zone_init(&font_heap, FONT_HEAP_SIZE, "font");
-    font_load(FONT_BUTTONS);
-    font_load(FONT_TITLE);
-    font_load(FONT_BODY);
+    struct font_pages *restrict fp = &font_pages;
+    fp->data = mem_alloc(FONT_PAGES * FONT_PAGE_SIZE);
+    osCreateMesgQueue(&fp->queue, fp->queue_buffer, FONT_PAGES);
+    residency_init(&fp->residency, "font", FONT_PAGES, MAX_FONT_TEXTURES - 1,
+                   GRAPHICS_LATENCY, font_page_load);
+    static const pak_font fonts[] = {FONT_BUTTONS, FONT_TITLE, FONT_BODY};
+    font_load(fonts, ARRAY_COUNT(fonts));
 }
 
-static Gfx *text_use_texture(Gfx *dl, const struct font_texture *restrict tex) {
+static Gfx *text_use_texture(Gfx *dl, const struct font_texture *restrict tex,
+                             void *pixels) {
     switch (tex->pix_size) {
     case G_IM_SIZ_4b:
-        gDPLoadTextureBlock_4b(dl++, tex->pixels, tex->pix_fmt, tex->width,
+        gDPLoadTextureBlock_4b(dl++, pixels, tex->pix_fmt, tex->width,
                                tex->height, 0, 0, 0, 0, 0, 0, 0);
         break;
     case G_IM_SIZ_8b:
-        gDPLoadTextureBlock(dl++, tex->pixels, tex->pix_fmt, G_IM_SIZ_8b,
+        gDPLoadTextureBlock(dl++, pixels, tex->pix_fmt, G_IM_SIZ_8b,
                             tex->width, tex->height, 0, 0, 0, 0, 0, 0, 0);
         break;
     case G_IM_SIZ_16b:
-        gDPLoadTextureBlock(dl++, tex->pixels, tex->pix_fmt, G_IM_SIZ_16b,
+        gDPLoadTextureBlock(dl++, pixels, tex->pix_fmt, G_IM_SIZ_16b,
                             tex->width, tex->height, 0, 0, 0, 0, 0, 0, 0);
         break;
     default:
@@ -345,16 +492,15 @@ static Gfx *text_use_texture(Gfx *dl, const struct font_texture *restrict tex) {
     return dl;
 }
 
-Gfx *text_render(Gfx *dl, struct graphics *restrict gr,
-                 struct sys_menu *restrict msys) {
-    if (msys->text_count == 0) {
-        return dl;
-    }
-
+// Draw the menu text. Uses two glyph buffers with the given capacity -- first
+// buffer is for the raw glyphs, second buffer is for glyphs converted to
+// sprites + textures + coordinates.
+static Gfx *text_draw(Gfx *dl, struct graphics *restrict gr,
+                      struct sys_menu *restrict msys,
+                      struct text_glyph *const glyph_buffer[2], int capacity) {
     const int x0 = gr->width >> 1, y0 = gr->height >> 1;
 
-    struct text_glyph *gstart = glyph_buffer[0],
-                      *gend = gstart + ARRAY_COUNT(glyph_buffer[0]),
+    struct text_glyph *gstart = glyph_buffer[0], *gend = gstart + capacity,
                       *gptr = gstart;
     for (int i = 0; i < msys->text_count; i++) {
         struct menu_text *restrict txp = &msys->text[i];
@@ -377,7 +523,14 @@ Gfx *text_render(Gfx *dl, struct graphics *restrict gr,
         return dl;
     }
 
-    int ncommands = 7 + 7 * MAX_FONT_TEXTURES + 4 * scount;
+    // Count the textures used. Glyphs are sorted by texture.
+    int tcount = 0;
+    for (int i = 0; i < scount; i++) {
+        if (i == 0 || glyph_buffer[1][i].src != glyph_buffer[1][i - 1].src) {
+            tcount++;
+        }
+    }
+    int ncommands = 7 + 7 * tcount + 4 * scount;
     if (ncommands > gr->dl_end - dl) {
         fatal_dloverflow();
     }
@@ -398,10 +551,20 @@ Gfx *text_render(Gfx *dl, struct graphics *restrict gr,
     for (int i = 0; i < scount; i++) {
         struct text_glyph *restrict g = &glyph_buffer[1][i];
         if (g->src != current_texture) {
+            // Textures which are still loading or which cannot be loaded in
+            // this frame are not drawn.
+            void *pixels = font_page_use(g->src);
+            if (pixels == NULL) {
+                int src = g->src;
+                while (i + 1 < scount && glyph_buffer[1][i + 1].src == src) {
+                    i++;
+                }
+                continue;
+            }
             // 7 commands.
             const struct font_texture_slot *tex = &font_textures[g->src];
             current_texture = g->src;
-            dl = text_use_texture(dl, &tex->texture);
+            dl = text_use_texture(dl, &tex->texture, pixels);
             tglyphs = tex->glyphs;
         }
         const struct font_glyph *gi = &tglyphs[g->glyph];
@@ -418,3 +581,32 @@ Gfx *text_render(Gfx *dl, struct graphics *restrict gr,
     }
     return dl;
 }
+
+Gfx *text_render(Gfx *dl, struct graphics *restrict gr,
+                 struct sys_menu *restrict msys) {
+    residency_set_frame(&font_pages.residency, graphics_current_frame);
+    font_page_poll();
+    // Each character makes at most one glyph.
+    size_t capacity = 0;
+    for (int i = 0; i < msys->text_count; i++) {
+        const struct menu_text *restrict txp = &msys->text[i];
+        if (txp->font.id != 0) {
+            capacity += strlen(txp->text);
+        }
+    }
+    if (capacity == 0) {
+        return dl;
+    }
+    if (capacity > TEXT_MAX_GLYPHS) {
+        capacity = TEXT_MAX_GLYPHS;
+    }
+    // The glyph buffers are only used while building the display list.
+    struct mem_mark mark = mem_zone_mark(gr->frame_zone);
+    struct text_glyph *const glyph_buffer[2] = {
+        mem_zone_alloc(gr->frame_zone, sizeof(struct text_glyph) * capacity),
+        mem_zone_alloc(gr->frame_zone, sizeof(struct text_glyph) * capacity),
+    };
+    dl = text_draw(dl, gr, msys, glyph_buffer, capacity);
+    mem_zone_release(gr->frame_zone, mark);
+    return dl;
+}
@@ -1,10 +1,11 @@
 #include "game/n64/texture.h"
 
 #include "assets/pak.h"
-#include "assets/texture.h"
 #include "base/base.h"
 #include "base/pak/pak.h"
+#include "base/residency.h"
 #include "game/n64/defs.h"
+#include "game/n64/graphics.h"
 #include "game/n64/texture_dl/dl.h"
 
 enum {
@@ -21,58 +22,27 @@ struct texture_slot {
 // Loaded texture data.
 static struct texture_slot texture_data[TEXTURE_SLOTS] ASSET;
 
-// Map from texture asset ID to slot number. If the slot maps back to the same
-// texture asset, then this texture is loaded, otherwise it is not loaded.
-static int texture_to_slot[PAK_TEXTURE_COUNT + 1];
+// Tracks which textures are loaded into which slots.
+static struct residency texture_residency;
 
-// Map from texture slot number to texture asset ID.
-static int texture_from_slot[TEXTURE_SLOTS];
-
-// Load a texture into the given slot. Ignores any texture in the slot, and does
-// not check if the texture is already loaded into another slot.
-static void texture_load_slot(pak_texture asset, int slot) {
+// Load a texture into the given slot.
+static void texture_load_slot(int asset, int slot) {
     pak_load_asset_sync(&texture_data[slot], sizeof(texture_data[slot]),
-                        pak_texture_object(asset));
-    texture_to_slot[asset.id] = slot;
-    texture_from_slot[slot] = asset.id;
+                        pak_texture_object((pak_texture){asset}));
 }
 
-// Load a texture, and return the slot.
-static int texture_load(pak_texture asset) {
-    if (asset.id < 1 || PAK_TEXTURE_COUNT < asset.id) {
-        fatal_error("texture_load: invalid texture\nTexture: %d", asset.id);
-    }
-    int slot = texture_to_slot[asset.id];
-    if (texture_from_slot[slot] == asset.id) {
-        return slot;
-    }
-    for (slot = 0; slot < TEXTURE_SLOTS; slot++) {
-        if (texture_from_slot[slot] == 0) {
-            texture_load_slot(asset, slot);
-            return slot;
-        }
-    }
-    fatal_error("texture_load: no slots available");
+void texture_init(void) {
+    residency_init(&texture_residency, "texture", TEXTURE_SLOTS,
+                   PAK_TEXTURE_COUNT, GRAPHICS_LATENCY, texture_load_slot);
 }
 
-void texture_init(void) {
-    texture_load(IMG_GROUND1);
-    texture_load(IMG_GROUND2);
-    texture_load(IMG_FAIRY1);
-    texture_load(IMG_FAIRY2);
-    texture_load(IMG_BLUEENEMY);
-    texture_load(IMG_GREENENEMY);
-    texture_load(IMG_STAR1);
+void texture_preload(pak_texture texture_id) {
+    residency_use(&texture_residency, texture_id.id);
 }
 
 Gfx *texture_use(Gfx *dl, pak_texture texture_id) {
-    if (texture_id.id < 1 || PAK_TEXTURE_COUNT < texture_id.id) {
-        fatal_error("Invalid texture");
-    }
-    int slot = texture_to_slot[texture_id.id];
-    if (texture_from_slot[slot] != texture_id.id) {
-        fatal_error("Texture not loaded");
-    }
+    residency_set_frame(&texture_residency, graphics_current_frame);
+    int slot = residency_use(&texture_residency, texture_id.id);
     const struct texture_slot *tex = &texture_data[slot];
     gDPSetTextureImage(dl++, G_IM_FMT_RGBA, G_IM_SIZ_16b, 1, tex->data);
     const Gfx *tex_dl = NULL;
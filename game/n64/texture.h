@@ -7,5 +7,8 @@
 // Initialize the texture system.
 void texture_init(void);
 
+// Load a texture before it is used.
+void texture_preload(pak_texture texture_id);
+
 // Load and use the given texture.
 Gfx *texture_use(Gfx *dl, pak_texture texture_id);
@@ -0,0 +1,43 @@
+// Control of the simulated hardware behind the host libultra stand-in.
+#pragma once
+
+#include <ultra64.h>
+
+// Parameters for the simulated hardware.
+struct host_config {
+    // Path to the ROM image loaded by PI DMA, or NULL for no ROM.
+    const char *rom;
+
+    // Time from the start of a PI DMA to the first byte, in nanoseconds.
+    unsigned pi_latency;
+
+    // PI transfer rate, in bytes per microsecond. Zero for no limit.
+    unsigned pi_rate;
+};
+
+// Statistics for the simulated PI.
+struct host_pi_stats {
+    // Number of DMAs completed, and the number of bytes they transferred.
+    unsigned dma_count;
+    unsigned long long dma_bytes;
+};
+
+// Initialize the simulated hardware. Must be called before any libultra
+// function, and only once.
+void host_init(const struct host_config *restrict cfg);
+
+// Wait until all queued PI DMAs have completed and their messages have been
+// sent.
+void host_pi_flush(void);
+
+// Get statistics for the simulated PI.
+struct host_pi_stats host_pi_stats(void);
+
+// Simulate a vertical retrace. The framebuffer passed to osViSwapBuffer
+// becomes the current framebuffer, and the VI event message is sent once for
+// every retraceCount calls.
+void host_vi_retrace(void);
+
+// Play the given number of bytes of audio from the buffers passed to
+// osAiSetNextBuffer. The AI event is sent for each buffer which finishes.
+void host_ai_play(unsigned size);
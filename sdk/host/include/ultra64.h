@@ -0,0 +1,214 @@
+// Host stand-in for the subset of libultra used by the pak loader, the RCP
+// scheduler, and audio sample DMA. This is not the real SDK header: it only
+// declares what those modules use, and the types have different layouts. See
+// sdk/host/host.h for controlling the simulated hardware.
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef int8_t s8;
+typedef uint16_t u16;
+typedef int16_t s16;
+typedef uint32_t u32;
+typedef int32_t s32;
+typedef uint64_t u64;
+typedef int64_t s64;
+typedef float f32;
+typedef double f64;
+
+// =============================================================================
+// Messages and Events
+// =============================================================================
+
+typedef void *OSMesg;
+typedef u32 OSEvent;
+
+enum {
+    OS_MESG_NOBLOCK = 0,
+    OS_MESG_BLOCK = 1,
+};
+
+enum {
+    OS_MESG_PRI_NORMAL = 0,
+    OS_MESG_PRI_HIGH = 1,
+};
+
+enum {
+    OS_EVENT_SW1 = 0,
+    OS_EVENT_SW2 = 1,
+    OS_EVENT_CART = 2,
+    OS_EVENT_COUNTER = 3,
+    OS_EVENT_SP = 4,
+    OS_EVENT_SI = 5,
+    OS_EVENT_AI = 6,
+    OS_EVENT_VI = 7,
+    OS_EVENT_PI = 8,
+    OS_EVENT_DP = 9,
+    OS_NUM_EVENTS = 15,
+};
+
+// Message queue. All queues share one lock, so a zeroed queue is valid once
+// osCreateMesgQueue has been called.
+typedef struct OSMesgQueue_s {
+    s32 validCount;
+    s32 first;
+    s32 msgCount;
+    OSMesg *msg;
+} OSMesgQueue;
+
+void osCreateMesgQueue(OSMesgQueue *mq, OSMesg *msg, s32 count);
+s32 osSendMesg(OSMesgQueue *mq, OSMesg msg, s32 flag);
+s32 osJamMesg(OSMesgQueue *mq, OSMesg msg, s32 flag);
+s32 osRecvMesg(OSMesgQueue *mq, OSMesg *msg, s32 flag);
+void osSetEventMesg(OSEvent e, OSMesgQueue *mq, OSMesg msg);
+
+// =============================================================================
+// Threads
+// =============================================================================
+
+typedef s32 OSPri;
+typedef s32 OSId;
+
+enum {
+    OS_PRIORITY_IDLE = 0,
+    OS_PRIORITY_APPMAX = 127,
+    OS_PRIORITY_PIMGR = 150,
+    OS_PRIORITY_VIMGR = 254,
+};
+
+// Threads run on pthreads. Priorities are recorded but not enforced, so
+// threads run concurrently instead of preempting each other.
+typedef struct OSThread_s {
+    OSId id;
+    OSPri priority;
+    void (*entry)(void *arg);
+    void *arg;
+    pthread_t thread;
+} OSThread;
+
+void osCreateThread(OSThread *t, OSId id, void (*entry)(void *), void *arg,
+                    void *sp, OSPri pri);
+void osStartThread(OSThread *t);
+void osSetThreadPri(OSThread *t, OSPri pri);
+
+// =============================================================================
+// Time and Cache
+// =============================================================================
+
+typedef u64 OSTime;
+
+#define OS_CLOCK_RATE 62500000LL
+#define OS_CPU_COUNTER (OS_CLOCK_RATE * 3 / 4)
+#define OS_NSEC_TO_CYCLES(n) ((u64)(n) * 3 / 64)
+#define OS_USEC_TO_CYCLES(n) ((u64)(n) * 375 / 8)
+#define OS_CYCLES_TO_NSEC(c) ((u64)(c) * 64 / 3)
+#define OS_CYCLES_TO_USEC(c) ((u64)(c) * 8 / 375)
+
+// Time since host_init, from the host monotonic clock, in CPU counter cycles.
+OSTime osGetTime(void);
+u32 osGetCount(void);
+
+// There are no caches to manage on the host. These do nothing.
+void osWritebackDCache(void *addr, s32 size);
+void osWritebackDCacheAll(void);
+void osInvalDCache(void *addr, s32 size);
+void osInvalICache(void *addr, s32 size);
+
+// =============================================================================
+// Peripheral Interface
+// =============================================================================
+
+enum {
+    OS_READ = 0,
+    OS_WRITE = 1,
+};
+
+typedef struct OSPiHandle_s {
+    struct OSPiHandle_s *next;
+    u8 type;
+    u32 baseAddress;
+} OSPiHandle;
+
+typedef struct {
+    u16 type;
+    u8 pri;
+    u8 status;
+    OSMesgQueue *retQueue;
+} OSMesgHdr;
+
+typedef struct {
+    OSMesgHdr hdr;
+    void *dramAddr;
+    u32 devAddr;
+    u32 size;
+    OSPiHandle *piHandle;
+} OSIoMesg;
+
+// Get the handle for the ROM image passed to host_init.
+OSPiHandle *osCartRomInit(void);
+
+// Queue a DMA from the ROM image. The device address is an offset in the ROM
+// image. When the DMA completes, the OSIoMesg is sent to its return queue.
+// High priority messages are moved to the front of the queue. Only OS_READ is
+// supported.
+s32 osEPiStartDma(OSPiHandle *handle, OSIoMesg *mb, s32 direction);
+
+// =============================================================================
+// RCP
+// =============================================================================
+
+enum {
+    OS_TV_PAL = 0,
+    OS_TV_NTSC = 1,
+    OS_TV_MPAL = 2,
+};
+
+extern s32 osTvType;
+
+enum {
+    M_GFXTASK = 1,
+    M_AUDTASK = 2,
+};
+
+typedef struct {
+    u32 type;
+    u32 flags;
+    u64 *ucode_boot;
+    u32 ucode_boot_size;
+    u64 *ucode;
+    u32 ucode_size;
+    u64 *ucode_data;
+    u32 ucode_data_size;
+    u64 *dram_stack;
+    u32 dram_stack_size;
+    u64 *output_buff;
+    u64 *output_buff_size;
+    u64 *data_ptr;
+    u32 data_size;
+    u64 *yield_data_ptr;
+    u32 yield_data_size;
+} OSTask_t;
+
+typedef union {
+    OSTask_t t;
+    long long int force_structure_alignment;
+} OSTask;
+
+// Tasks finish as soon as they start. The SP event is sent, followed by the
+// DP event for graphics tasks.
+void osSpTaskLoad(OSTask *task);
+void osSpTaskStartGo(OSTask *task);
+
+// The video interface swaps buffers when host_vi_retrace is called.
+void osViSwapBuffer(void *frameBufPtr);
+void osViBlack(u8 active);
+void *osViGetCurrentFramebuffer(void);
+void *osViGetNextFramebuffer(void);
+void osViSetEvent(OSMesgQueue *mq, OSMesg m, u32 retraceCount);
+
+// The audio interface plays samples when host_ai_play is called.
+s32 osAiSetFrequency(u32 frequency);
+s32 osAiSetNextBuffer(void *bufPtr, u32 size);
+u32 osAiGetLength(void);
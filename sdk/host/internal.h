@@ -0,0 +1,10 @@
+// Internal functions for the host libultra stand-in.
+#pragma once
+
+#include "sdk/host/host.h"
+
+// Send the message registered for an event with osSetEventMesg, if any.
+void host_event(OSEvent e);
+
+// Initialize the simulated PI.
+void host_pi_init(const struct host_config *restrict cfg);
@@ -0,0 +1,182 @@
+#include "sdk/host/internal.h"
+
+#include "base/base.h"
+
+#include <stdbool.h>
+#include <time.h>
+
+// Lock for all message queues and the event table. Threads waiting on any
+// queue wait on the same condition, which is broadcast whenever a queue
+// changes.
+static pthread_mutex_t os_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t os_cond = PTHREAD_COND_INITIALIZER;
+
+static struct {
+    OSMesgQueue *queue;
+    OSMesg mesg;
+} os_events[OS_NUM_EVENTS];
+
+// Time of host_init, in nanoseconds.
+static uint64_t os_start;
+
+static uint64_t os_nsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void host_init(const struct host_config *restrict cfg) {
+    os_start = os_nsec();
+    host_pi_init(cfg);
+}
+
+// =============================================================================
+// Messages and Events
+// =============================================================================
+
+void osCreateMesgQueue(OSMesgQueue *mq, OSMesg *msg, s32 count) {
+    pthread_mutex_lock(&os_lock);
+    *mq = (OSMesgQueue){
+        .msg = msg,
+        .msgCount = count,
+    };
+    pthread_mutex_unlock(&os_lock);
+}
+
+// Add a message to a queue, at the front or back. The lock must be held.
+static s32 os_push(OSMesgQueue *mq, OSMesg msg, s32 flag, bool front) {
+    while (mq->validCount >= mq->msgCount) {
+        if (flag == OS_MESG_NOBLOCK) {
+            return -1;
+        }
+        pthread_cond_wait(&os_cond, &os_lock);
+    }
+    int index;
+    if (front) {
+        mq->first = (mq->first + mq->msgCount - 1) % mq->msgCount;
+        index = mq->first;
+    } else {
+        index = (mq->first + mq->validCount) % mq->msgCount;
+    }
+    mq->msg[index] = msg;
+    mq->validCount++;
+    pthread_cond_broadcast(&os_cond);
+    return 0;
+}
+
+s32 osSendMesg(OSMesgQueue *mq, OSMesg msg, s32 flag) {
+    pthread_mutex_lock(&os_lock);
+    s32 r = os_push(mq, msg, flag, false);
+    pthread_mutex_unlock(&os_lock);
+    return r;
+}
+
+s32 osJamMesg(OSMesgQueue *mq, OSMesg msg, s32 flag) {
+    pthread_mutex_lock(&os_lock);
+    s32 r = os_push(mq, msg, flag, true);
+    pthread_mutex_unlock(&os_lock);
+    return r;
+}
+
+s32 osRecvMesg(OSMesgQueue *mq, OSMesg *msg, s32 flag) {
+    pthread_mutex_lock(&os_lock);
+    while (mq->validCount == 0) {
+        if (flag == OS_MESG_NOBLOCK) {
+            pthread_mutex_unlock(&os_lock);
+            return -1;
+        }
+        pthread_cond_wait(&os_cond, &os_lock);
+    }
+    if (msg != NULL) {
+        *msg = mq->msg[mq->first];
+    }
+    mq->first = (mq->first + 1) % mq->msgCount;
+    mq->validCount--;
+    pthread_cond_broadcast(&os_cond);
+    pthread_mutex_unlock(&os_lock);
+    return 0;
+}
+
+void osSetEventMesg(OSEvent e, OSMesgQueue *mq, OSMesg msg) {
+    if (e >= OS_NUM_EVENTS) {
+        fatal_error("osSetEventMesg: invalid event: %u", (unsigned)e);
+    }
+    pthread_mutex_lock(&os_lock);
+    os_events[e].queue = mq;
+    os_events[e].mesg = msg;
+    pthread_mutex_unlock(&os_lock);
+}
+
+void host_event(OSEvent e) {
+    pthread_mutex_lock(&os_lock);
+    if (os_events[e].queue != NULL) {
+        // Like interrupt handlers, drop the event if the queue is full.
+        os_push(os_events[e].queue, os_events[e].mesg, OS_MESG_NOBLOCK,
+                false);
+    }
+    pthread_mutex_unlock(&os_lock);
+}
+
+// =============================================================================
+// Threads
+// =============================================================================
+
+static void *os_thread_main(void *arg) {
+    OSThread *t = arg;
+    t->entry(t->arg);
+    return NULL;
+}
+
+void osCreateThread(OSThread *t, OSId id, void (*entry)(void *), void *arg,
+                    void *sp, OSPri pri) {
+    (void)sp;
+    *t = (OSThread){
+        .id = id,
+        .priority = pri,
+        .entry = entry,
+        .arg = arg,
+    };
+}
+
+void osStartThread(OSThread *t) {
+    int r = pthread_create(&t->thread, NULL, os_thread_main, t);
+    if (r != 0) {
+        fatal_error("osStartThread: could not create thread: %d", r);
+    }
+    pthread_detach(t->thread);
+}
+
+void osSetThreadPri(OSThread *t, OSPri pri) {
+    if (t != NULL) {
+        t->priority = pri;
+    }
+}
+
+// =============================================================================
+// Time and Cache
+// =============================================================================
+
+OSTime osGetTime(void) {
+    return OS_NSEC_TO_CYCLES(os_nsec() - os_start);
+}
+
+u32 osGetCount(void) {
+    return osGetTime();
+}
+
+void osWritebackDCache(void *addr, s32 size) {
+    (void)addr;
+    (void)size;
+}
+
+void osWritebackDCacheAll(void) {}
+
+void osInvalDCache(void *addr, s32 size) {
+    (void)addr;
+    (void)size;
+}
+
+void osInvalICache(void *addr, s32 size) {
+    (void)addr;
+    (void)size;
+}
@@ -0,0 +1,164 @@
+#include "sdk/host/internal.h"
+
+#include "base/base.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+    // Maximum number of DMAs queued at once.
+    PI_QUEUE_SIZE = 64,
+};
+
+static OSPiHandle pi_handle;
+
+// ROM image, loaded into memory.
+static uint8_t *pi_rom;
+static size_t pi_rom_size;
+
+static unsigned pi_latency;
+static unsigned pi_rate;
+
+// Queued DMAs. The PI thread removes a DMA from the queue when it finishes, so
+// pi_count is nonzero while a DMA is in progress.
+static pthread_mutex_t pi_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pi_cond = PTHREAD_COND_INITIALIZER;
+static OSIoMesg *pi_queue[PI_QUEUE_SIZE];
+static int pi_count;
+static struct host_pi_stats pi_stats;
+
+static void pi_load_rom(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fatal_error("Could not open ROM\nPath: %s\nError: %s", path,
+                    strerror(errno));
+    }
+    size_t cap = 64 * 1024, len = 0;
+    uint8_t *data = malloc(cap);
+    for (;;) {
+        if (data == NULL) {
+            fatal_error("Out of memory loading ROM");
+        }
+        len += fread(data + len, 1, cap - len, fp);
+        if (len < cap) {
+            break;
+        }
+        cap *= 2;
+        data = realloc(data, cap);
+    }
+    if (ferror(fp)) {
+        fatal_error("Could not read ROM\nPath: %s", path);
+    }
+    fclose(fp);
+    pi_rom = data;
+    pi_rom_size = len;
+}
+
+// Sleep for the simulated duration of a DMA.
+static void pi_delay(uint32_t size) {
+    uint64_t ns = pi_latency;
+    if (pi_rate != 0) {
+        ns += (uint64_t)size * 1000 / pi_rate;
+    }
+    if (ns == 0) {
+        return;
+    }
+    struct timespec ts = {
+        .tv_sec = ns / 1000000000,
+        .tv_nsec = ns % 1000000000,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+static void *pi_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&pi_lock);
+    for (;;) {
+        while (pi_count == 0) {
+            pthread_cond_wait(&pi_cond, &pi_lock);
+        }
+        OSIoMesg *mb = pi_queue[0];
+        pthread_mutex_unlock(&pi_lock);
+
+        pi_delay(mb->size);
+        memcpy(mb->dramAddr, pi_rom + mb->devAddr, mb->size);
+        // Count the DMA before the message is sent, so the receiver sees it.
+        pthread_mutex_lock(&pi_lock);
+        pi_stats.dma_count++;
+        pi_stats.dma_bytes += mb->size;
+        pthread_mutex_unlock(&pi_lock);
+        osSendMesg(mb->hdr.retQueue, mb, OS_MESG_NOBLOCK);
+
+        pthread_mutex_lock(&pi_lock);
+        pi_count--;
+        memmove(pi_queue, pi_queue + 1, pi_count * sizeof(*pi_queue));
+        pthread_cond_broadcast(&pi_cond);
+    }
+    return NULL;
+}
+
+void host_pi_init(const struct host_config *restrict cfg) {
+    if (cfg->rom != NULL) {
+        pi_load_rom(cfg->rom);
+    }
+    pi_latency = cfg->pi_latency;
+    pi_rate = cfg->pi_rate;
+    pthread_t thread;
+    int r = pthread_create(&thread, NULL, pi_main, NULL);
+    if (r != 0) {
+        fatal_error("Could not create PI thread: %d", r);
+    }
+    pthread_detach(thread);
+}
+
+OSPiHandle *osCartRomInit(void) {
+    return &pi_handle;
+}
+
+s32 osEPiStartDma(OSPiHandle *handle, OSIoMesg *mb, s32 direction) {
+    (void)handle;
+    if (direction != OS_READ) {
+        fatal_error("osEPiStartDma: only OS_READ is supported");
+    }
+    if (mb->devAddr > pi_rom_size || mb->size > pi_rom_size - mb->devAddr) {
+        fatal_error(
+            "osEPiStartDma: read past end of ROM\n"
+            "Address: 0x%lx\nSize: %lu\nROM size: %zu",
+            (unsigned long)mb->devAddr, (unsigned long)mb->size, pi_rom_size);
+    }
+    pthread_mutex_lock(&pi_lock);
+    if (pi_count >= PI_QUEUE_SIZE) {
+        fatal_error("osEPiStartDma: too many DMAs queued");
+    }
+    // The DMA in progress stays at the front of the queue.
+    int pos = pi_count;
+    if (mb->hdr.pri == OS_MESG_PRI_HIGH && pi_count > 0) {
+        pos = 1;
+    }
+    memmove(pi_queue + pos + 1, pi_queue + pos,
+            (pi_count - pos) * sizeof(*pi_queue));
+    pi_queue[pos] = mb;
+    pi_count++;
+    pthread_cond_broadcast(&pi_cond);
+    pthread_mutex_unlock(&pi_lock);
+    return 0;
+}
+
+void host_pi_flush(void) {
+    pthread_mutex_lock(&pi_lock);
+    while (pi_count > 0) {
+        pthread_cond_wait(&pi_cond, &pi_lock);
+    }
+    pthread_mutex_unlock(&pi_lock);
+}
+
+struct host_pi_stats host_pi_stats(void) {
+    pthread_mutex_lock(&pi_lock);
+    struct host_pi_stats stats = pi_stats;
+    pthread_mutex_unlock(&pi_lock);
+    return stats;
+}
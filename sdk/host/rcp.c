@@ -0,0 +1,152 @@
+#include "sdk/host/internal.h"
+
+#include "base/base.h"
+
+#include <stddef.h>
+
+s32 osTvType = OS_TV_NTSC;
+
+// Lock for the video and audio interface state.
+static pthread_mutex_t rcp_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// =============================================================================
+// Signal Processor
+// =============================================================================
+
+static OSTask *sp_task;
+
+void osSpTaskLoad(OSTask *task) {
+    sp_task = task;
+}
+
+void osSpTaskStartGo(OSTask *task) {
+    if (task != sp_task) {
+        fatal_error("osSpTaskStartGo: task not loaded");
+    }
+    sp_task = NULL;
+    host_event(OS_EVENT_SP);
+    if (task->t.type == M_GFXTASK) {
+        host_event(OS_EVENT_DP);
+    }
+}
+
+// =============================================================================
+// Video Interface
+// =============================================================================
+
+static struct {
+    void *current;
+    void *next;
+    OSMesgQueue *queue;
+    OSMesg mesg;
+    unsigned divisor;
+    unsigned count;
+} vi;
+
+void osViSwapBuffer(void *frameBufPtr) {
+    pthread_mutex_lock(&rcp_lock);
+    vi.next = frameBufPtr;
+    pthread_mutex_unlock(&rcp_lock);
+}
+
+void osViBlack(u8 active) {
+    (void)active;
+}
+
+void *osViGetCurrentFramebuffer(void) {
+    pthread_mutex_lock(&rcp_lock);
+    void *ptr = vi.current;
+    pthread_mutex_unlock(&rcp_lock);
+    return ptr;
+}
+
+void *osViGetNextFramebuffer(void) {
+    pthread_mutex_lock(&rcp_lock);
+    void *ptr = vi.next;
+    pthread_mutex_unlock(&rcp_lock);
+    return ptr;
+}
+
+void osViSetEvent(OSMesgQueue *mq, OSMesg m, u32 retraceCount) {
+    pthread_mutex_lock(&rcp_lock);
+    vi.queue = mq;
+    vi.mesg = m;
+    vi.divisor = retraceCount;
+    vi.count = 0;
+    pthread_mutex_unlock(&rcp_lock);
+}
+
+void host_vi_retrace(void) {
+    pthread_mutex_lock(&rcp_lock);
+    vi.current = vi.next;
+    OSMesgQueue *queue = NULL;
+    if (vi.queue != NULL && ++vi.count >= vi.divisor) {
+        vi.count = 0;
+        queue = vi.queue;
+    }
+    OSMesg mesg = vi.mesg;
+    pthread_mutex_unlock(&rcp_lock);
+    if (queue != NULL) {
+        osSendMesg(queue, mesg, OS_MESG_NOBLOCK);
+    }
+}
+
+// =============================================================================
+// Audio Interface
+// =============================================================================
+
+// Audio buffers in the DMA FIFO. The first buffer is playing, and remaining
+// is the number of bytes in it which have not been played.
+static struct {
+    unsigned count;
+    u32 size[2];
+    u32 remaining;
+} ai;
+
+s32 osAiSetFrequency(u32 frequency) {
+    return frequency;
+}
+
+s32 osAiSetNextBuffer(void *bufPtr, u32 size) {
+    (void)bufPtr;
+    s32 r = -1;
+    pthread_mutex_lock(&rcp_lock);
+    if (ai.count < 2) {
+        ai.size[ai.count] = size;
+        if (ai.count == 0) {
+            ai.remaining = size;
+        }
+        ai.count++;
+        r = 0;
+    }
+    pthread_mutex_unlock(&rcp_lock);
+    return r;
+}
+
+u32 osAiGetLength(void) {
+    pthread_mutex_lock(&rcp_lock);
+    u32 len = ai.count > 0 ? ai.remaining : 0;
+    pthread_mutex_unlock(&rcp_lock);
+    return len;
+}
+
+void host_ai_play(unsigned size) {
+    // Play all the samples before sending any events, so the event handler
+    // sees the final length.
+    int finished = 0;
+    pthread_mutex_lock(&rcp_lock);
+    while (ai.count > 0 && size >= ai.remaining) {
+        size -= ai.remaining;
+        ai.count--;
+        ai.size[0] = ai.size[1];
+        ai.remaining = ai.count > 0 ? ai.size[0] : 0;
+        finished++;
+    }
+    if (ai.count > 0) {
+        ai.remaining -= size;
+    }
+    pthread_mutex_unlock(&rcp_lock);
+    for (int i = 0; i < finished; i++) {
+        host_event(OS_EVENT_AI);
+    }
+}
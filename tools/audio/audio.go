@@ -34,12 +34,22 @@ type waveType byte
 
 const (
 	adpcmType waveType = 0
-	rawType
+	rawType   waveType = 1
+)
+
+// Layout of the audio header. The header has a fixed layout with no internal
+// pointers, so the game can use it directly after loading.
+const (
+	infoSize      = 8                                // Size of struct audio_trackinfo.
+	waveTableSize = 20                               // Size of ALWaveTable.
+	typeOffset    = infoSize + 8                     // Offset of ALWaveTable.type.
+	loopOffset    = infoSize + waveTableSize         // Offset of ALADPCMloop.
+	bookOffset    = loopOffset + aiff.VADPCMLoopSize // Offset of ALADPCMBook.
 )
 
 func baseHeader(t waveType) []byte {
-	d := make([]byte, 28)
-	d[8] = byte(t)
+	d := make([]byte, infoSize+waveTableSize)
+	d[typeOffset] = byte(t)
 	return d
 }
 
@@ -54,6 +64,9 @@ func rawHeader(a *aiff.AIFF) ([]byte, error) {
 	return out, nil
 }
 
+// adpcmHeader creates the header for an ADPCM track. The loop is always at
+// loopOffset, and is only used if the loop length is nonzero. The codebook is
+// always at bookOffset.
 func adpcmHeader(a *aiff.AIFF) ([]byte, error) {
 	out := baseHeader(adpcmType)
 	var loop, codebook []byte
@@ -79,17 +92,12 @@ func adpcmHeader(a *aiff.AIFF) ([]byte, error) {
 	if len(codebook) == 0 {
 		return nil, errors.New("ADPCM track has no codebook")
 	}
-	if loop != nil {
-		out = pad4(out)
-		binary.BigEndian.PutUint32(out[20:], uint32(len(out)))
-		out = append(out, loop...)
+	if loop == nil {
+		loop = make([]byte, aiff.VADPCMLoopSize)
 	}
-	if codebook != nil {
-		out = pad4(out)
-		binary.BigEndian.PutUint32(out[24:], uint32(len(out)))
-		out = append(out, codebook...)
-	}
-	return out, nil
+	out = append(out, loop...)
+	out = append(out, codebook...)
+	return pad4(out), nil
 }
 
 // ReadTrack reads a music track from disk.
@@ -0,0 +1,109 @@
+package audio
+
+import (
+	"bytes"
+	"encoding/binary"
+	"testing"
+
+	"thornmarked/tools/audio/aiff"
+)
+
+func testCodebook() *aiff.VADPCMCodes {
+	const order, entries = 2, 4
+	table := make([]int16, order*entries*8)
+	for i := range table {
+		table[i] = int16(i*37 - 500)
+	}
+	return &aiff.VADPCMCodes{
+		Version:    1,
+		Order:      order,
+		NumEntries: entries,
+		Table:      table,
+	}
+}
+
+// checkBook checks that the codebook is at its fixed location in the header.
+func checkBook(t *testing.T, hdr []byte, ck *aiff.VADPCMCodes) {
+	t.Helper()
+	if want := bookOffset + 8 + 2*len(ck.Table); len(hdr) < want {
+		t.Fatalf("header size is %d, expected at least %d", len(hdr), want)
+	}
+	book := hdr[bookOffset:]
+	if n := binary.BigEndian.Uint32(book); n != uint32(ck.Order) {
+		t.Errorf("order = %d, expected %d", n, ck.Order)
+	}
+	if n := binary.BigEndian.Uint32(book[4:]); n != uint32(ck.NumEntries) {
+		t.Errorf("predictors = %d, expected %d", n, ck.NumEntries)
+	}
+	for i, x := range ck.Table {
+		if y := int16(binary.BigEndian.Uint16(book[8+2*i:])); y != x {
+			t.Fatalf("book[%d] = %d, expected %d", i, y, x)
+		}
+	}
+}
+
+// checkNoPointers checks that the pointer fields in the wave table are zero,
+// since the header must not depend on where it is loaded.
+func checkNoPointers(t *testing.T, hdr []byte) {
+	t.Helper()
+	for _, off := range []int{infoSize, infoSize + 12, infoSize + 16} {
+		if p := binary.BigEndian.Uint32(hdr[off:]); p != 0 {
+			t.Errorf("header has nonzero pointer at offset %d: 0x%x", off, p)
+		}
+	}
+}
+
+func TestADPCMHeader(t *testing.T) {
+	ck := testCodebook()
+	a := &aiff.AIFF{Chunks: []aiff.Chunk{ck}}
+	hdr, err := adpcmHeader(a)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if hdr[typeOffset] != byte(adpcmType) {
+		t.Errorf("type = %d, expected %d", hdr[typeOffset], adpcmType)
+	}
+	if n := binary.BigEndian.Uint32(hdr[4:]); n != 0 {
+		t.Errorf("loop length = %d, expected 0", n)
+	}
+	checkNoPointers(t, hdr)
+	checkBook(t, hdr, ck)
+}
+
+func TestADPCMHeaderLoop(t *testing.T) {
+	ck := testCodebook()
+	loop := aiff.VADPCMLoop{Start: 1000, End: 5000, Count: -1}
+	for i := range loop.State {
+		loop.State[i] = int16(i + 1)
+	}
+	a := &aiff.AIFF{Chunks: []aiff.Chunk{
+		&aiff.VADPCMLoops{Loops: []aiff.VADPCMLoop{loop}},
+		ck,
+	}}
+	hdr, err := adpcmHeader(a)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if n := binary.BigEndian.Uint32(hdr[4:]); n != 4000 {
+		t.Errorf("loop length = %d, expected 4000", n)
+	}
+	checkNoPointers(t, hdr)
+	want := make([]byte, aiff.VADPCMLoopSize)
+	loop.Marshal(want)
+	if got := hdr[loopOffset : loopOffset+aiff.VADPCMLoopSize]; !bytes.Equal(got, want) {
+		t.Errorf("loop = %x, expected %x", got, want)
+	}
+	checkBook(t, hdr, ck)
+}
+
+func TestRawHeader(t *testing.T) {
+	a := &aiff.AIFF{Common: aiff.Common{NumChannels: 1, SampleSize: 16}}
+	hdr, err := rawHeader(a)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if hdr[typeOffset] != byte(rawType) {
+		t.Errorf("type = %d, expected %d", hdr[typeOffset], rawType)
+	}
+	checkNoPointers(t, hdr)
+}
@@ -23,7 +23,9 @@ func makeAssetCharmap(fn *font) ([]byte, error) {
 	return out, nil
 }
 
-// makeAssetGlyphs makes the glyph array for the asset.
+// makeAssetGlyphs makes the glyph array for the asset. The texture index is
+// stored plus one, so zero marks an invisible glyph, and the game can use the
+// array without modifying it.
 func makeAssetGlyphs(fn *font) ([]byte, error) {
 	const recSize = 8
 	out := make([]byte, len(fn.glyphs)*recSize)
@@ -31,6 +33,9 @@ func makeAssetGlyphs(fn *font) ([]byte, error) {
 		off := i * recSize
 		rec := out[off : off+recSize : off+recSize]
 		if g.size[0] > 0 && g.size[1] > 0 {
+			if g.texindex >= 255 {
+				return nil, fmt.Errorf("texture index too high, index = %d", g.texindex)
+			}
 			copy(rec, []byte{
 				byte(g.size[0]),
 				byte(g.size[1]),
@@ -38,7 +43,7 @@ func makeAssetGlyphs(fn *font) ([]byte, error) {
 				byte(-g.center[1]),
 				byte(g.pos[0]),
 				byte(g.pos[1]),
-				byte(g.texindex),
+				byte(g.texindex + 1),
 				byte(g.advance),
 			})
 		} else {
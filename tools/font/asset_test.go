@@ -0,0 +1,169 @@
+package main
+
+import (
+	"bytes"
+	"encoding/binary"
+	"image"
+	"image/color"
+	"testing"
+
+	"thornmarked/tools/texture"
+)
+
+// Sizes of the structures in game/n64/text.c.
+const (
+	fontMagicSize   = 16
+	fontHeaderSize  = 264 // struct font_header, including the charmap.
+	fontGlyphSize   = 8   // struct font_glyph.
+	fontTextureSize = 12  // struct font_texture_data.
+	fontPageSize    = 4 * 1024
+)
+
+func testFont() *font {
+	tex := image.NewRGBA(image.Rect(0, 0, 16, 8))
+	for y := 0; y < 8; y++ {
+		for x := 0; x < 16; x++ {
+			v := uint8(x * 17)
+			tex.SetRGBA(x, y, color.RGBA{v, v, v, 255})
+		}
+	}
+	tex2 := image.NewRGBA(image.Rect(0, 0, 8, 4))
+	for i := range tex2.Pix {
+		tex2.Pix[i] = 255
+	}
+	return &font{
+		charmap: map[uint32]uint32{' ': 0, 'A': 1, 'B': 2, 'C': 3},
+		glyphs: []*glyph{
+			{advance: 4},
+			{size: [2]int32{6, 8}, center: [2]int32{0, -7}, advance: 7, pos: [2]int32{0, 0}, texindex: 0},
+			{size: [2]int32{6, 8}, center: [2]int32{0, -7}, advance: 7, pos: [2]int32{8, 0}, texindex: 0},
+			{size: [2]int32{8, 4}, center: [2]int32{1, -3}, advance: 9, pos: [2]int32{0, 0}, texindex: 1},
+		},
+		textures: []*image.RGBA{tex, tex2},
+	}
+}
+
+// TestMakeAsset checks that the font asset passes the checks in font_load and
+// font_add_textures, and that every reference in the font is in range.
+func TestMakeAsset(t *testing.T) {
+	fn := testFont()
+	tf := texture.SizedFormat{Format: texture.I, Size: texture.Size4}
+	data, err := makeAsset(fn, tf)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(data) < fontMagicSize || !bytes.HasPrefix(data, []byte("Font")) {
+		t.Fatal("missing magic")
+	}
+	// The magic is removed when the font is packed.
+	data = data[fontMagicSize:]
+	size := uint32(len(data))
+	if size < fontHeaderSize {
+		t.Fatalf("size %d is smaller than the header", size)
+	}
+	e := binary.BigEndian
+	glyphCount := uint32(e.Uint16(data[0:]))
+	textureCount := uint32(e.Uint16(data[2:]))
+	textureOffset := e.Uint32(data[4:])
+	headerSize := textureOffset + textureCount*fontTextureSize
+	if textureOffset < fontHeaderSize ||
+		glyphCount > (textureOffset-fontHeaderSize)/fontGlyphSize ||
+		textureOffset > size || headerSize > size {
+		t.Fatalf("bad header: glyphs=%d, textures=%d, offset=%d, size=%d",
+			glyphCount, textureCount, textureOffset, size)
+	}
+	if glyphCount != uint32(len(fn.glyphs)) || textureCount != uint32(len(fn.textures)) {
+		t.Errorf("counts: got %d glyphs, %d textures; want %d, %d",
+			glyphCount, textureCount, len(fn.glyphs), len(fn.textures))
+	}
+
+	cmap := data[8:fontHeaderSize]
+	for c, g := range fn.charmap {
+		if got := uint32(cmap[c]); got != g {
+			t.Errorf("charmap[%d] = %d, want %d", c, got, g)
+		}
+	}
+	for c, g := range cmap {
+		if uint32(g) >= glyphCount {
+			t.Errorf("charmap[%d] = %d, out of range", c, g)
+		}
+	}
+
+	for i, g := range fn.glyphs {
+		rec := data[fontHeaderSize+i*fontGlyphSize:]
+		texindex := uint32(rec[6])
+		if texindex > textureCount {
+			t.Errorf("glyph %d: texture index %d out of range", i, texindex)
+		}
+		if rec[7] != byte(g.advance) {
+			t.Errorf("glyph %d: advance = %d, want %d", i, rec[7], g.advance)
+		}
+		if g.size[0] == 0 {
+			if texindex != 0 {
+				t.Errorf("glyph %d: invisible glyph has texture %d", i, texindex)
+			}
+			continue
+		}
+		if texindex != uint32(g.texindex)+1 {
+			t.Errorf("glyph %d: texture index = %d, want %d", i, texindex, g.texindex+1)
+			continue
+		}
+		tex := fn.textures[g.texindex]
+		if int(rec[0])+int(rec[4]) > tex.Rect.Dx() ||
+			int(rec[1])+int(rec[5]) > tex.Rect.Dy() {
+			t.Errorf("glyph %d: outside texture", i)
+		}
+	}
+
+	for i, img := range fn.textures {
+		rec := data[textureOffset+uint32(i)*fontTextureSize:]
+		w, h := e.Uint16(rec[0:]), e.Uint16(rec[2:])
+		pixSize := e.Uint16(rec[6:])
+		pixels := e.Uint32(rec[8:])
+		var bits uint32
+		switch pixSize {
+		case 0:
+			bits = 4
+		case 1:
+			bits = 8
+		case 2:
+			bits = 16
+		default:
+			t.Errorf("texture %d: unsupported pixel size %d", i, pixSize)
+			continue
+		}
+		tsize := ((uint32(w)*uint32(h)*bits + 15) >> 4) << 1
+		if pixels >= size || tsize == 0 || tsize > fontPageSize ||
+			tsize > size-pixels {
+			t.Errorf("texture %d: bad texture, offset=%d, size=%d", i, pixels, tsize)
+			continue
+		}
+		if pixels&7 != 0 {
+			t.Errorf("texture %d: offset %d is not aligned", i, pixels)
+		}
+		if pixels < headerSize {
+			t.Errorf("texture %d: offset %d overlaps header", i, pixels)
+		}
+		want, err := texture.Pack(img, tf, texture.Linear)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if !bytes.Equal(data[pixels:pixels+tsize], want) {
+			t.Errorf("texture %d: pixel data does not match", i)
+		}
+	}
+}
+
+func TestMakeAssetErrors(t *testing.T) {
+	tf := texture.SizedFormat{Format: texture.I, Size: texture.Size4}
+	fn := testFont()
+	fn.charmap[256] = 1
+	if _, err := makeAsset(fn, tf); err == nil {
+		t.Error("character 256: no error")
+	}
+	fn = testFont()
+	fn.textures[0] = image.NewRGBA(image.Rect(0, 0, 128, 128))
+	if _, err := makeAsset(fn, tf); err == nil {
+		t.Error("large texture: no error")
+	}
+}
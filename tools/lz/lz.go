@@ -0,0 +1,342 @@
+// Package lz implements the LZ compression used for pak objects.
+//
+// A compressed stream is a sequence of blocks. Each block decompresses to
+// BlockSize bytes, except the last block, which may be shorter. Blocks can be
+// decompressed independently of how the stream is split into DMA chunks, but
+// matches may refer to data in earlier blocks.
+//
+// Each block starts with a 16-bit big-endian header. If bit 15 is set, the
+// block is stored raw. The low 15 bits are the size of the block payload,
+// which follows the header.
+//
+// A compressed payload is a sequence of sequences, like LZ4. Each sequence
+// starts with a token byte. The high nibble is the number of literals, and the
+// low nibble is the match length minus MinMatch. A nibble value of 15 is
+// followed by extension bytes, which are added to the length, and which
+// continue as long as the extension byte is 255. After the token come the
+// literal length extension, the literals, a 16-bit big-endian match offset,
+// and the match length extension. When the literals reach the end of the
+// block, the sequence ends without a match.
+package lz
+
+import (
+	"encoding/binary"
+	"errors"
+	"fmt"
+)
+
+const (
+	// BlockSize is the decompressed size of each block.
+	BlockSize = 4096
+
+	// MinMatch is the length of the shortest match.
+	MinMatch = 4
+
+	// MaxOffset is the largest match offset.
+	MaxOffset = 65535
+
+	rawFlag    = 0x8000
+	headerSize = 2
+
+	hashBits  = 14
+	maxChain  = 64
+	hashEmpty = -1
+)
+
+// Result is the output of Compress.
+type Result struct {
+	// Compressed data.
+	Data []byte
+
+	// Number of bytes of extra space needed to decompress in place, beyond
+	// the difference between the decompressed and compressed sizes. To
+	// decompress in place, the compressed data is placed at the end of a
+	// buffer, and decompressed to the start of the buffer. The buffer must be
+	// at least len(src) + Margin bytes long.
+	Margin int
+}
+
+func hash4(b []byte) uint32 {
+	return (binary.LittleEndian.Uint32(b) * 2654435761) >> (32 - hashBits)
+}
+
+// encoder compresses a stream.
+type encoder struct {
+	src   []byte
+	out   []byte
+	head  []int32 // First position with each hash.
+	chain []int32 // Previous position with the same hash.
+
+	// Largest distance, over all sequences, that the decompressed output is
+	// ahead of the compressed input, after each sequence.
+	ahead int
+}
+
+func newEncoder(src []byte) *encoder {
+	e := &encoder{
+		src:   src,
+		head:  make([]int32, 1<<hashBits),
+		chain: make([]int32, len(src)),
+		ahead: -len(src),
+	}
+	for i := range e.head {
+		e.head[i] = hashEmpty
+	}
+	return e
+}
+
+// insert adds the position to the hash chains.
+func (e *encoder) insert(pos int) {
+	if pos+MinMatch > len(e.src) {
+		return
+	}
+	h := hash4(e.src[pos:])
+	e.chain[pos] = e.head[h]
+	e.head[h] = int32(pos)
+}
+
+// find returns the longest match for the data at pos, ending at or before end.
+func (e *encoder) find(pos, end int) (offset, length int) {
+	if pos+MinMatch > end {
+		return 0, 0
+	}
+	src := e.src
+	cand := e.head[hash4(src[pos:])]
+	for n := 0; n < maxChain && cand != hashEmpty; n++ {
+		c := int(cand)
+		if pos-c > MaxOffset {
+			break
+		}
+		if length < end-pos && src[c+length] == src[pos+length] {
+			k := 0
+			for pos+k < end && src[c+k] == src[pos+k] {
+				k++
+			}
+			if k > length {
+				offset, length = pos-c, k
+				if k == end-pos {
+					break
+				}
+			}
+		}
+		cand = e.chain[c]
+	}
+	if length < MinMatch {
+		return 0, 0
+	}
+	return offset, length
+}
+
+func appendLength(out []byte, n int) []byte {
+	for ; n >= 255; n -= 255 {
+		out = append(out, 255)
+	}
+	return append(out, byte(n))
+}
+
+// appendSequence appends a sequence with the given literals, followed by a
+// match if length is nonzero.
+func appendSequence(out, literals []byte, offset, length int) []byte {
+	var token byte
+	if n := len(literals); n >= 15 {
+		token = 15 << 4
+	} else {
+		token = byte(n) << 4
+	}
+	if length != 0 {
+		if n := length - MinMatch; n >= 15 {
+			token |= 15
+		} else {
+			token |= byte(n)
+		}
+	}
+	out = append(out, token)
+	if len(literals) >= 15 {
+		out = appendLength(out, len(literals)-15)
+	}
+	out = append(out, literals...)
+	if length != 0 {
+		out = append(out, byte(offset>>8), byte(offset))
+		if length-MinMatch >= 15 {
+			out = appendLength(out, length-MinMatch-15)
+		}
+	}
+	return out
+}
+
+// block compresses the block starting at the given position.
+func (e *encoder) block(start int) {
+	end := start + BlockSize
+	if end > len(e.src) {
+		end = len(e.src)
+	}
+	hpos := len(e.out)
+	e.out = append(e.out, 0, 0)
+	// Decompressed and compressed positions after each sequence.
+	type mark struct{ out, in int }
+	var marks []mark
+	lit := start
+	pos := start
+	for pos < end {
+		offset, length := e.find(pos, end)
+		if length == 0 {
+			e.insert(pos)
+			pos++
+			continue
+		}
+		e.out = appendSequence(e.out, e.src[lit:pos], offset, length)
+		for i := 0; i < length; i++ {
+			e.insert(pos + i)
+		}
+		pos += length
+		lit = pos
+		marks = append(marks, mark{pos, len(e.out)})
+	}
+	if lit < end {
+		e.out = appendSequence(e.out, e.src[lit:end], 0, 0)
+		marks = append(marks, mark{end, len(e.out)})
+	}
+	payload := len(e.out) - hpos - headerSize
+	if payload >= end-start {
+		// Store the block raw.
+		e.out = append(e.out[:hpos+headerSize], e.src[start:end]...)
+		binary.BigEndian.PutUint16(e.out[hpos:], uint16(rawFlag|(end-start)))
+		e.mark(end, len(e.out))
+		return
+	}
+	binary.BigEndian.PutUint16(e.out[hpos:], uint16(payload))
+	for _, m := range marks {
+		e.mark(m.out, m.in)
+	}
+}
+
+// mark records that the decompressor has written the output up to out after
+// reading the input up to in.
+func (e *encoder) mark(out, in int) {
+	if d := out - in; d > e.ahead {
+		e.ahead = d
+	}
+}
+
+// Compress compresses data.
+func Compress(src []byte) *Result {
+	e := newEncoder(src)
+	for pos := 0; pos < len(src); pos += BlockSize {
+		e.block(pos)
+	}
+	ahead := e.ahead
+	if ahead < 0 {
+		ahead = 0
+	}
+	return &Result{Data: e.out, Margin: ahead + len(e.out) - len(src)}
+}
+
+var errTruncated = errors.New("truncated data")
+
+func readLength(src []byte, pos int) (n, newpos int, err error) {
+	for {
+		if pos >= len(src) {
+			return 0, 0, errTruncated
+		}
+		b := src[pos]
+		pos++
+		n += int(b)
+		if b != 255 {
+			return n, pos, nil
+		}
+	}
+}
+
+// Decompress decompresses data. The size is the decompressed size.
+func Decompress(src []byte, size int) ([]byte, error) {
+	out := make([]byte, 0, size)
+	pos := 0
+	for len(out) < size {
+		if len(src)-pos < headerSize {
+			return nil, errTruncated
+		}
+		header := int(binary.BigEndian.Uint16(src[pos:]))
+		pos += headerSize
+		n := header &^ rawFlag
+		if n > len(src)-pos {
+			return nil, errTruncated
+		}
+		payload := src[pos : pos+n]
+		pos += n
+		end := len(out) + BlockSize
+		if end > size {
+			end = size
+		}
+		if header&rawFlag != 0 {
+			if n != end-len(out) {
+				return nil, fmt.Errorf("raw block has size %d, expected %d", n, end-len(out))
+			}
+			out = append(out, payload...)
+			continue
+		}
+		var err error
+		out, err = decompressBlock(out, payload, end)
+		if err != nil {
+			return nil, err
+		}
+	}
+	if pos != len(src) {
+		return nil, fmt.Errorf("%d bytes of extra data", len(src)-pos)
+	}
+	return out, nil
+}
+
+func decompressBlock(out, src []byte, end int) ([]byte, error) {
+	pos := 0
+	for len(out) < end {
+		if pos >= len(src) {
+			return nil, errTruncated
+		}
+		token := src[pos]
+		pos++
+		nlit := int(token >> 4)
+		if nlit == 15 {
+			n, p, err := readLength(src, pos)
+			if err != nil {
+				return nil, err
+			}
+			nlit += n
+			pos = p
+		}
+		if nlit > len(src)-pos || nlit > end-len(out) {
+			return nil, errors.New("literals out of range")
+		}
+		out = append(out, src[pos:pos+nlit]...)
+		pos += nlit
+		if len(out) == end {
+			break
+		}
+		if len(src)-pos < 2 {
+			return nil, errTruncated
+		}
+		offset := int(binary.BigEndian.Uint16(src[pos:]))
+		pos += 2
+		length := int(token&15) + MinMatch
+		if length == 15+MinMatch {
+			n, p, err := readLength(src, pos)
+			if err != nil {
+				return nil, err
+			}
+			length += n
+			pos = p
+		}
+		if offset == 0 || offset > len(out) {
+			return nil, fmt.Errorf("bad match offset: %d", offset)
+		}
+		if length > end-len(out) {
+			return nil, errors.New("match out of range")
+		}
+		for i := 0; i < length; i++ {
+			out = append(out, out[len(out)-offset])
+		}
+	}
+	if pos != len(src) {
+		return nil, fmt.Errorf("%d bytes of extra data in block", len(src)-pos)
+	}
+	return out, nil
+}
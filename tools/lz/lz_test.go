@@ -0,0 +1,259 @@
+package lz
+
+import (
+	"bytes"
+	"encoding/binary"
+	"flag"
+	"io/ioutil"
+	"math/rand"
+	"path/filepath"
+	"strings"
+	"testing"
+)
+
+// The test corpus is shared with the decoder in base/pak. Each file has a
+// compressed counterpart with the .lz extension, which starts with an 8-byte
+// header containing the decompressed size and margin, as 32-bit big-endian
+// integers, followed by the compressed data.
+const corpusDir = "../../base/pak/testdata"
+
+var update = flag.Bool("update", false, "rewrite compressed files in corpus")
+
+type corpusFile struct {
+	name string
+	data []byte
+}
+
+func readCorpus(t testing.TB) []corpusFile {
+	names, err := filepath.Glob(filepath.Join(corpusDir, "*.bin"))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(names) == 0 {
+		t.Fatal("empty corpus")
+	}
+	var files []corpusFile
+	for _, name := range names {
+		data, err := ioutil.ReadFile(name)
+		if err != nil {
+			t.Fatal(err)
+		}
+		files = append(files, corpusFile{name, data})
+	}
+	return files
+}
+
+func lzName(name string) string {
+	return strings.TrimSuffix(name, ".bin") + ".lz"
+}
+
+func checkRoundTrip(t *testing.T, name string, data []byte) *Result {
+	t.Helper()
+	r := Compress(data)
+	out, err := Decompress(r.Data, len(data))
+	if err != nil {
+		t.Errorf("%s: decompress: %v", name, err)
+		return nil
+	}
+	if !bytes.Equal(out, data) {
+		t.Errorf("%s: data does not match", name)
+		return nil
+	}
+	if len(r.Data) > len(data)+(len(data)+BlockSize-1)/BlockSize*headerSize {
+		t.Errorf("%s: compressed size %d is too large for size %d",
+			name, len(r.Data), len(data))
+	}
+	checkInPlace(t, name, data, r)
+	return r
+}
+
+// checkInPlace simulates decompressing in place, and checks that the output
+// never overwrites input which has not been read yet.
+func checkInPlace(t *testing.T, name string, data []byte, r *Result) {
+	t.Helper()
+	bufsize := len(data) + r.Margin
+	base := bufsize - len(r.Data)
+	if base < 0 {
+		t.Errorf("%s: margin %d too small for compressed size %d",
+			name, r.Margin, len(r.Data))
+		return
+	}
+	// Decompress each block separately, using positions in the buffer.
+	in, out := 0, 0
+	for out < len(data) {
+		header := int(binary.BigEndian.Uint16(r.Data[in:]))
+		n := header &^ rawFlag
+		in += headerSize
+		end := out + BlockSize
+		if end > len(data) {
+			end = len(data)
+		}
+		if header&rawFlag != 0 {
+			if out > base+in {
+				t.Errorf("%s: raw block at %d overwrites input", name, in)
+				return
+			}
+			in += n
+			out = end
+			continue
+		}
+		pend := in + n
+		for out < end {
+			token := r.Data[in]
+			in++
+			nlit := int(token >> 4)
+			if nlit == 15 {
+				k, p, _ := readLength(r.Data[:pend], in)
+				nlit += k
+				in = p
+			}
+			if out > base+in {
+				t.Errorf("%s: literals at %d overwrite input", name, in)
+				return
+			}
+			in += nlit
+			out += nlit
+			if out == end {
+				break
+			}
+			in += 2
+			length := int(token&15) + MinMatch
+			if length == 15+MinMatch {
+				k, p, _ := readLength(r.Data[:pend], in)
+				length += k
+				in = p
+			}
+			out += length
+			if out > base+in {
+				t.Errorf("%s: match at %d overwrites input", name, in)
+				return
+			}
+		}
+	}
+}
+
+func TestCorpus(t *testing.T) {
+	for _, f := range readCorpus(t) {
+		r := checkRoundTrip(t, f.name, f.data)
+		if r == nil {
+			continue
+		}
+		t.Logf("%s: %d -> %d, margin %d", filepath.Base(f.name), len(f.data),
+			len(r.Data), r.Margin)
+		lzname := lzName(f.name)
+		if *update {
+			hdr := make([]byte, 8, 8+len(r.Data))
+			binary.BigEndian.PutUint32(hdr, uint32(len(f.data)))
+			binary.BigEndian.PutUint32(hdr[4:], uint32(r.Margin))
+			if err := ioutil.WriteFile(lzname, append(hdr, r.Data...), 0666); err != nil {
+				t.Fatal(err)
+			}
+			continue
+		}
+		// The compressed files are read by the decoder test in base/pak. Check
+		// that they are valid, but do not require them to be identical to
+		// the output of the current compressor.
+		cdata, err := ioutil.ReadFile(lzname)
+		if err != nil {
+			t.Error(err)
+			continue
+		}
+		if len(cdata) < 8 {
+			t.Errorf("%s: too short", lzname)
+			continue
+		}
+		if size := binary.BigEndian.Uint32(cdata); size != uint32(len(f.data)) {
+			t.Errorf("%s: size is %d, expected %d", lzname, size, len(f.data))
+			continue
+		}
+		margin := int(binary.BigEndian.Uint32(cdata[4:]))
+		out, err := Decompress(cdata[8:], len(f.data))
+		if err != nil {
+			t.Errorf("%s: %v", lzname, err)
+		} else if !bytes.Equal(out, f.data) {
+			t.Errorf("%s: data does not match", lzname)
+		}
+		checkInPlace(t, lzname, f.data, &Result{Data: cdata[8:], Margin: margin})
+	}
+}
+
+func TestGenerated(t *testing.T) {
+	rng := rand.New(rand.NewSource(1))
+	sizes := []int{0, 1, 3, 4, 15, 16, 270, BlockSize - 1, BlockSize,
+		BlockSize + 1, 3*BlockSize + 17}
+	for _, size := range sizes {
+		// Runs of random length, with random bytes between them, which
+		// produces long literals, long matches, and overlapping matches.
+		data := make([]byte, size)
+		for i := 0; i < size; {
+			n := rng.Intn(600) + 1
+			if rng.Intn(2) == 0 {
+				c := byte(rng.Intn(4))
+				for j := 0; j < n && i < size; j++ {
+					data[i] = c
+					i++
+				}
+			} else {
+				for j := 0; j < n && i < size; j++ {
+					data[i] = byte(rng.Intn(256))
+					i++
+				}
+			}
+		}
+		checkRoundTrip(t, "generated", data)
+		// Random data, stored raw.
+		rng.Read(data)
+		checkRoundTrip(t, "random", data)
+	}
+}
+
+func TestCorrupt(t *testing.T) {
+	data := bytes.Repeat([]byte("corrupt data "), 1000)
+	r := Compress(data)
+	if _, err := Decompress(r.Data[:len(r.Data)-1], len(data)); err == nil {
+		t.Error("truncated data: no error")
+	}
+	if _, err := Decompress(append(r.Data, 0), len(data)); err == nil {
+		t.Error("extra data: no error")
+	}
+	bad := append([]byte(nil), r.Data...)
+	// First sequence is literals then a match, with offset after literals.
+	bad[headerSize+1+13] = 0xff
+	bad[headerSize+1+14] = 0xff
+	if _, err := Decompress(bad, len(data)); err == nil {
+		t.Error("bad offset: no error")
+	}
+}
+
+func BenchmarkCompress(b *testing.B) {
+	files := readCorpus(b)
+	var total int64
+	for _, f := range files {
+		total += int64(len(f.data))
+	}
+	b.SetBytes(total)
+	for i := 0; i < b.N; i++ {
+		for _, f := range files {
+			Compress(f.data)
+		}
+	}
+}
+
+func BenchmarkDecompress(b *testing.B) {
+	files := readCorpus(b)
+	var total int64
+	var compressed [][]byte
+	for _, f := range files {
+		total += int64(len(f.data))
+		compressed = append(compressed, Compress(f.data).Data)
+	}
+	b.SetBytes(total)
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		for j, f := range files {
+			if _, err := Decompress(compressed[j], len(f.data)); err != nil {
+				b.Fatal(err)
+			}
+		}
+	}
+}
@@ -36,6 +36,11 @@ enum {
 static inline int pak_{{.LowerName}}_object(pak_{{.LowerName}} asset) {
 	return PAK_{{.UpperName}}_START + (asset.id - 1) * {{.ObjectsPerAsset}};
 }
+// Return the asset which contains the given object ID, or the zero asset.
+static inline pak_{{.LowerName}} pak_{{.LowerName}}_asset(int object) {
+	int n = object - PAK_{{.UpperName}}_START;
+	return (pak_{{.LowerName}}){n >= 0 && n < PAK_{{.UpperName}}_COUNT * {{.ObjectsPerAsset}} ? n / {{.ObjectsPerAsset}} + 1 : 0};
+}
 {{- end}}
 `
 
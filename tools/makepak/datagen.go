@@ -7,9 +7,12 @@ import (
 	"errors"
 	"fmt"
 	"io/ioutil"
+	"math"
 	"os"
 
 	"thornmarked/tools/audio"
+	"thornmarked/tools/lz"
+	"thornmarked/tools/paktrace/trace"
 )
 
 // Check that the first n bytes of the data equal the magic, followed by nul
@@ -96,23 +99,74 @@ func parseData(objects [][]byte, dtype datatype, data []byte) error {
 	}
 }
 
+// Flags for pak objects, from base/pak/object.h.
+const (
+	flagCompressed = 1 << 0
+)
+
+// An object stored in the pak.
+type object struct {
+	raw    []byte // Object data, before compression.
+	data   []byte // Stored data.
+	flags  uint16
+	margin uint16 // Extra space for decompressing in place.
+
+	// For groups, the size of the group descriptor and its members, which
+	// are stored after the descriptor. Zero for other objects.
+	span int
+}
+
+// groupDescriptor returns the descriptor for a preload group, which is stored
+// at the start of the group. The format is described in base/pak/object.h.
+func (mn *manifest) groupDescriptor(g *entry) []byte {
+	d := make([]byte, 2+2*len(g.members))
+	binary.BigEndian.PutUint16(d, uint16(len(g.members)))
+	for i, m := range g.members {
+		binary.BigEndian.PutUint16(d[2+2*i:], uint16(mn.object(m)))
+	}
+	return d
+}
+
+// compress compresses the object, if that makes it smaller. Only the first
+// object of each asset may be compressed. Later objects, like model frames and
+// audio samples, are loaded piecewise by offset at runtime.
+func (obj *object) compress() {
+	r := lz.Compress(obj.data)
+	if len(r.Data) >= len(obj.data) || r.Margin > math.MaxUint16 {
+		return
+	}
+	obj.data = r.Data
+	obj.flags |= flagCompressed
+	obj.margin = uint16(r.Margin)
+}
+
 // readData reads the entry data for this section and uses it to fill in the
 // given array of objects.
-func (sec *section) readData(objects [][]byte) error {
+func (sec *section) readData(objects []object) error {
+	if sec.dtype == typeGroup {
+		return nil
+	}
 	n := sec.dtype.slotCount()
+	odata := make([][]byte, n)
 	for i, e := range sec.Entries {
 		data, err := ioutil.ReadFile(e.fullpath)
 		if err != nil {
 			return err
 		}
-		if err := parseData(objects[i*n:i*n+n:i*n+n], sec.dtype, data); err != nil {
+		if err := parseData(odata, sec.dtype, data); err != nil {
 			return fmt.Errorf("could not parse %s %q: %v", sec.dtype.name(), e.filename, err)
 		}
+		for j, d := range odata {
+			objects[i*n+j] = object{raw: d, data: d}
+		}
+		if e.compress {
+			objects[i*n].compress()
+		}
 	}
 	return nil
 }
 
-func (mn *manifest) writeStats(filename string, odata [][]byte, offsets []uint32, size int) error {
+func (mn *manifest) writeStats(filename string, objects []object, size, before, after int) error {
 	fp, err := os.Create(filename)
 	if err != nil {
 		return err
@@ -129,16 +183,21 @@ func (mn *manifest) writeStats(filename string, odata [][]byte, offsets []uint32
 		n := sec.dtype.slotCount()
 		sizes := make([]int, n)
 		tsizes := make([]int, n)
-		var tsize int
+		var tsize, ccount, craw, cstored int
 		for i := range sec.Entries {
 			off := sec.Start - 1 + i*n
-			edata := odata[off : off+n : off+n]
-			for j, d := range edata {
-				if len(d) > sizes[j] {
-					sizes[j] = len(d)
+			eobjs := objects[off : off+n : off+n]
+			for j, obj := range eobjs {
+				if len(obj.raw) > sizes[j] {
+					sizes[j] = len(obj.raw)
+				}
+				tsizes[j] += len(obj.data)
+				tsize += len(obj.data)
+				if obj.flags&flagCompressed != 0 {
+					ccount++
+					craw += len(obj.raw)
+					cstored += len(obj.data)
 				}
-				tsizes[j] += len(d)
-				tsize += len(d)
 			}
 		}
 		if _, err := fmt.Fprintf(w, "    Max size: %d\n", sizes); err != nil {
@@ -147,11 +206,23 @@ func (mn *manifest) writeStats(filename string, odata [][]byte, offsets []uint32
 		if _, err := fmt.Fprintf(w, "    Total sizes: %d %d\n", tsizes, tsize); err != nil {
 			return err
 		}
+		if ccount > 0 {
+			if _, err := fmt.Fprintf(w, "    Compressed: %d objects, %d -> %d bytes\n", ccount, craw, cstored); err != nil {
+				return err
+			}
+		}
 		switch sec.dtype {
+		case typeGroup:
+			for i, e := range sec.Entries {
+				obj := objects[sec.Start-1+i]
+				if _, err := fmt.Fprintf(w, "    %s: %d members, %d bytes\n", e.Ident, len(e.members), obj.span); err != nil {
+					return err
+				}
+			}
 		case typeModel:
 			var maxfsize uint32
 			for i := range sec.Entries {
-				fsize := binary.BigEndian.Uint32(odata[sec.Start-1+i*n][12:16])
+				fsize := binary.BigEndian.Uint32(objects[sec.Start-1+i*n].raw[24:28])
 				if fsize > maxfsize {
 					maxfsize = fsize
 				}
@@ -161,54 +232,151 @@ func (mn *manifest) writeStats(filename string, odata [][]byte, offsets []uint32
 			}
 		}
 	}
+	if _, err := fmt.Fprintf(w, "Total size: %d\n", size); err != nil {
+		return err
+	}
+	if len(mn.traces) != 0 {
+		var loads int
+		for _, t := range mn.traces {
+			loads += len(t.Objects)
+		}
+		if _, err := fmt.Fprintf(w, "Traces: %d loads\n  DMA requests if adjacent loads are coalesced, before reordering: %d\n  DMA requests if adjacent loads are coalesced, after reordering: %d\n", loads, before, after); err != nil {
+			return err
+		}
+	}
 	if err := w.Flush(); err != nil {
 		return err
 	}
 	return fp.Close()
 }
 
+// layoutUnits returns the units of objects which are stored together, in
+// their default order. Each group is one unit, containing the group descriptor
+// followed by the group's members. Every other object is its own unit, in
+// order. Units are identified by their first object, which is the object
+// recorded in traces when the unit is loaded.
+func (mn *manifest) layoutUnits() (order []int, units map[int][]int) {
+	units = make(map[int][]int)
+	placed := make([]bool, mn.Size)
+	if gsec := mn.groups(); gsec != nil {
+		for _, g := range gsec.Entries {
+			id := mn.object(g)
+			unit := []int{id}
+			placed[id] = true
+			for _, m := range g.members {
+				mid := mn.object(m)
+				unit = append(unit, mid)
+				placed[mid] = true
+			}
+			order = append(order, id)
+			units[id] = unit
+		}
+	}
+	for id := 1; id < mn.Size; id++ {
+		if !placed[id] {
+			order = append(order, id)
+			units[id] = []int{id}
+		}
+	}
+	return order, units
+}
+
+// layout returns the order of objects in the pak data, and the number of DMA
+// requests for the traces before and after reordering, if adjacent loads are
+// coalesced; see trace.Requests. Units which are loaded one after another in
+// the traces are placed next to each other.
+func (mn *manifest) layout() (order []int, before, after int) {
+	uorder, units := mn.layoutUnits()
+	if len(mn.traces) != 0 {
+		before = trace.Requests(uorder, mn.traces)
+		uorder = trace.Optimize(uorder, mn.traces)
+		after = trace.Requests(uorder, mn.traces)
+	}
+	order = make([]int, 0, mn.Size-1)
+	for _, id := range uorder {
+		order = append(order, units[id]...)
+	}
+	return order, before, after
+}
+
 func (mn *manifest) writeData(filename, statsfile string) error {
 	// Get object data for all assets.
-	odata := make([][]byte, mn.Size)
+	objects := make([]object, mn.Size)
 	for _, sec := range mn.Sections {
 		n := len(sec.Entries) * sec.dtype.slotCount()
-		if err := sec.readData(odata[sec.Start : sec.Start+n : sec.Start+n]); err != nil {
+		if err := sec.readData(objects[sec.Start : sec.Start+n : sec.Start+n]); err != nil {
 			return err
 		}
 	}
-	odata = odata[1:]
+	if gsec := mn.groups(); gsec != nil {
+		for _, g := range gsec.Entries {
+			// Uncompressed images are streamed from the cartridge, so staging
+			// them with the group would only waste the DMA.
+			for _, m := range g.members {
+				if m.dtype == typeImage &&
+					objects[mn.object(m)].flags&flagCompressed == 0 {
+					return fmt.Errorf("group %s: image %s is not compressed, so it is streamed and cannot be preloaded",
+						g.Ident, m.Ident)
+				}
+			}
+			d := mn.groupDescriptor(g)
+			objects[mn.object(g)] = object{raw: d, data: d}
+		}
+	}
 
 	// Calculate offset of each object.
-	offsets := make([]uint32, len(odata))
+	offsets := make([]uint32, mn.Size)
 	const (
-		hsz     = 8 // Header entry size.
+		hsz     = 16 // Header entry size, sizeof(struct pak_object).
 		maxSize = 64 * 1024 * 1024
 	)
 	pos := mn.Size * hsz // Position in pak file
-	for i, data := range odata {
+	order, before, after := mn.layout()
+	for _, id := range order {
+		obj := &objects[id]
 		pos = (pos + 1) &^ 1
-		if len(data) > maxSize-pos {
+		if len(obj.data) > maxSize-pos {
 			return errors.New("too much data in pak")
 		}
-		offsets[i] = uint32(pos)
-		pos += len(data)
+		offsets[id] = uint32(pos)
+		pos += len(obj.data)
 	}
+	if gsec := mn.groups(); gsec != nil {
+		for _, g := range gsec.Entries {
+			id := mn.object(g)
+			end := offsets[id] + uint32(len(objects[id].data))
+			for _, m := range g.members {
+				mid := mn.object(m)
+				end = offsets[mid] + uint32(len(objects[mid].data))
+			}
+			objects[id].span = int(end - offsets[id])
+		}
+	}
+	objects = objects[1:]
+	offsets = offsets[1:]
 
 	// Write stats.
 	if statsfile != "" {
-		if err := mn.writeStats(statsfile, odata, offsets, pos); err != nil {
+		if err := mn.writeStats(statsfile, objects, pos, before, after); err != nil {
 			return fmt.Errorf("could not write stats: %v", err)
 		}
 	}
 
 	// Write objects to buffer.
 	pdata := make([]byte, pos)
-	for i, data := range odata {
+	for i, obj := range objects {
 		offset := offsets[i]
+		size, stored := len(obj.raw), len(obj.data)
+		if obj.span != 0 {
+			size, stored = obj.span, obj.span
+		}
 		h := pdata[i*hsz : (i+1)*hsz : (i+1)*hsz]
 		binary.BigEndian.PutUint32(h[0:4], offset)
-		binary.BigEndian.PutUint32(h[4:8], uint32(len(data)))
-		copy(pdata[offset:], data)
+		binary.BigEndian.PutUint32(h[4:8], uint32(size))
+		binary.BigEndian.PutUint32(h[8:12], uint32(stored))
+		binary.BigEndian.PutUint16(h[12:14], obj.flags)
+		binary.BigEndian.PutUint16(h[14:16], obj.margin)
+		copy(pdata[offset:], obj.data)
 	}
 	return ioutil.WriteFile(filename, pdata, 0666)
 }
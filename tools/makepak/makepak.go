@@ -14,6 +14,7 @@ import (
 	"unicode/utf8"
 
 	"thornmarked/tools/getpath"
+	"thornmarked/tools/paktrace/trace"
 )
 
 type stringArrayValue struct {
@@ -52,6 +53,12 @@ type entry struct {
 	Index    int
 	filename string
 	fullpath string
+	compress bool // Compress the asset's first object.
+
+	// For groups, the identifiers of the member assets, and the members
+	// after they are resolved.
+	memberNames []string
+	members     []*entry
 }
 
 type section struct {
@@ -67,6 +74,30 @@ type section struct {
 type manifest struct {
 	Size     int
 	Sections []*section
+
+	// Traces of pak loads, used to choose the order of objects.
+	traces []*trace.Trace
+}
+
+// object returns the index of an asset's first object in the pak.
+func (mn *manifest) object(e *entry) int {
+	for _, sec := range mn.Sections {
+		if sec.dtype == e.dtype {
+			return sec.Start + (e.Index-1)*sec.ObjectsPerAsset
+		}
+	}
+	panic("no section for entry")
+}
+
+// groups returns the section containing preload groups, or nil if there are no
+// groups.
+func (mn *manifest) groups() *section {
+	for _, sec := range mn.Sections {
+		if sec.dtype == typeGroup {
+			return sec
+		}
+	}
+	return nil
 }
 
 func parseManifestLine(line []byte) (*entry, error) {
@@ -80,13 +111,16 @@ func parseManifestLine(line []byte) (*entry, error) {
 	if len(fields) == 0 {
 		return nil, nil
 	}
-	if len(fields) != 3 {
-		return nil, fmt.Errorf("got %d fields, expected exactly 3", len(fields))
-	}
 	dt, err := parseType(string(fields[0]))
 	if err != nil {
 		return nil, err
 	}
+	if dt == typeGroup {
+		return parseGroupLine(fields)
+	}
+	if len(fields) != 3 && len(fields) != 4 {
+		return nil, fmt.Errorf("got %d fields, expected 3 or 4", len(fields))
+	}
 	ident := string(fields[1])
 	if !validIdent.MatchString(ident) {
 		return nil, fmt.Errorf("invalid identifier: %q", ident)
@@ -95,13 +129,79 @@ func parseManifestLine(line []byte) (*entry, error) {
 	if path.IsAbs(filename) {
 		return nil, errors.New("path is absolute")
 	}
+	var compress bool
+	if len(fields) == 4 {
+		if opt := string(fields[3]); opt != "compress" {
+			return nil, fmt.Errorf("unknown option: %q", opt)
+		}
+		compress = true
+	}
 	return &entry{
 		dtype:    dt,
 		Ident:    ident,
 		filename: filename,
+		compress: compress,
+	}, nil
+}
+
+// parseGroupLine parses a preload group, which is the group identifier
+// followed by the identifiers of its members.
+func parseGroupLine(fields [][]byte) (*entry, error) {
+	if len(fields) < 3 {
+		return nil, errors.New("group has no members")
+	}
+	var idents []string
+	for _, f := range fields[1:] {
+		ident := string(f)
+		if !validIdent.MatchString(ident) {
+			return nil, fmt.Errorf("invalid identifier: %q", ident)
+		}
+		idents = append(idents, ident)
+	}
+	return &entry{
+		dtype:       typeGroup,
+		Ident:       idents[0],
+		memberNames: idents[1:],
 	}, nil
 }
 
+// resolveGroups resolves the members of each group. Each asset may be a member
+// of at most one group, since the members of a group are stored contiguously.
+func (mn *manifest) resolveGroups() error {
+	gsec := mn.groups()
+	if gsec == nil {
+		return nil
+	}
+	assets := make(map[string]*entry)
+	for _, sec := range mn.Sections {
+		if sec.dtype == typeGroup {
+			continue
+		}
+		for _, e := range sec.Entries {
+			if _, ok := assets[e.Ident]; ok {
+				return fmt.Errorf("duplicate identifier: %q", e.Ident)
+			}
+			assets[e.Ident] = e
+		}
+	}
+	groupOf := make(map[*entry]*entry)
+	for _, g := range gsec.Entries {
+		for _, name := range g.memberNames {
+			e, ok := assets[name]
+			if !ok {
+				return fmt.Errorf("group %s: unknown asset: %q", g.Ident, name)
+			}
+			if other, ok := groupOf[e]; ok {
+				return fmt.Errorf("group %s: asset %s is already in group %s",
+					g.Ident, name, other.Ident)
+			}
+			groupOf[e] = g
+			g.members = append(g.members, e)
+		}
+	}
+	return nil
+}
+
 func readManifest(filename string) (*manifest, error) {
 	fp, err := os.Open(filename)
 	if err != nil {
@@ -146,10 +246,14 @@ func readManifest(filename string) (*manifest, error) {
 		}
 	}
 	sections = sections[:spos]
-	return &manifest{
+	mn := &manifest{
 		Size:     pos,
 		Sections: sections,
-	}, nil
+	}
+	if err := mn.resolveGroups(); err != nil {
+		return nil, fmt.Errorf("%s: %w", filename, err)
+	}
+	return mn, nil
 }
 
 func (e *entry) resolveInputs(dirs []string) error {
@@ -169,6 +273,9 @@ func (e *entry) resolveInputs(dirs []string) error {
 }
 
 func (sec *section) resolveInputs(dirs []string) error {
+	if sec.dtype == typeGroup {
+		return nil
+	}
 	for _, e := range sec.Entries {
 		if err := e.resolveInputs(dirs); err != nil {
 			return err
@@ -187,8 +294,9 @@ func (mn *manifest) resolveInputs(dirs []string) error {
 }
 
 func mainE() error {
-	var dirs []string
+	var dirs, traces []string
 	flag.Var(&stringArrayValue{value: &dirs}, "dir", "search for files in")
+	flag.Var(&stringArrayValue{value: &traces}, "trace", "order objects using load trace")
 	manifestFlag := flag.String("manifest", "", "input manifest file")
 	dataFlag := flag.String("out-data", "", "output data file")
 	dataStatsFlag := flag.String("out-data-stats", "", "output data stats")
@@ -198,7 +306,7 @@ func mainE() error {
 	if *manifestFlag == "" {
 		fmt.Fprint(os.Stderr,
 			"Usage:\n"+
-				"  makepak [-dir <dir> ...] -manifest=<manifest>\n"+
+				"  makepak [-dir <dir> ...] [-trace <trace> ...] -manifest=<manifest>\n"+
 				"          [-out-data=<file>] [-out-code-dir=<file>] [-out-code-prefix=<prefix>]\n")
 		os.Exit(1)
 	}
@@ -226,6 +334,13 @@ func mainE() error {
 		if err := mn.resolveInputs(dirs); err != nil {
 			return err
 		}
+		for _, name := range traces {
+			t, err := trace.ReadFile(getpath.GetPath(name))
+			if err != nil {
+				return err
+			}
+			mn.traces = append(mn.traces, t)
+		}
 		if err := mn.writeData(outData, outDataStats); err != nil {
 			return err
 		}
@@ -16,6 +16,7 @@ const (
 	typeTrack
 	typeModel
 	typeTexture
+	typeGroup
 )
 
 type typeinfo struct {
@@ -30,6 +31,7 @@ var types = [...]typeinfo{
 	typeModel:   {"model", 2},
 	typeTexture: {"texture", 1},
 	typeTrack:   {"track", 2},
+	typeGroup:   {"group", 1},
 }
 
 func parseType(s string) (t datatype, err error) {
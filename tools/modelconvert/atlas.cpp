@@ -0,0 +1,38 @@
+#include "tools/modelconvert/atlas.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace modelconvert {
+
+int AtlasGridSize(int cell_count) {
+    if (cell_count < 1) {
+        throw std::range_error("AtlasGridSize: bad cell count");
+    }
+    int size = 1;
+    while (size * size < cell_count) {
+        size *= 2;
+    }
+    return size;
+}
+
+std::array<float, 2> AtlasTexcoord(int cell_count, int cell, int cell_size,
+                                   std::array<float, 2> texcoord) {
+    if (cell < 0 || cell >= cell_count) {
+        throw std::range_error("AtlasTexcoord: bad cell");
+    }
+    if (cell_size < 2) {
+        throw std::range_error("AtlasTexcoord: bad cell size");
+    }
+    const int grid = AtlasGridSize(cell_count);
+    const float inset = 0.5f / cell_size;
+    const std::array<int, 2> pos{{cell % grid, cell / grid}};
+    std::array<float, 2> result;
+    for (int i = 0; i < 2; i++) {
+        const float t = std::clamp(texcoord[i], 0.0f, 1.0f);
+        result[i] = (pos[i] + inset + t * (1.0f - 2.0f * inset)) / grid;
+    }
+    return result;
+}
+
+} // namespace modelconvert
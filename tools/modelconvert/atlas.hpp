@@ -0,0 +1,20 @@
+#pragma once
+
+#include <array>
+
+namespace modelconvert {
+
+// Get the number of rows and columns in a texture atlas with the given number
+// of cells. This is the smallest power of two whose square is at least the
+// number of cells, so the atlas has power-of-two dimensions. This must match
+// textureconvert.
+int AtlasGridSize(int cell_count);
+
+// Map texture coordinates within an atlas cell, in the range 0-1, to texture
+// coordinates within the atlas. Each cell is cell_size texels on a side. The
+// coordinates are inset to the centers of the texels on the edge of the cell,
+// so bilinear filtering does not read from neighboring cells.
+std::array<float, 2> AtlasTexcoord(int cell_count, int cell, int cell_size,
+                                   std::array<float, 2> texcoord);
+
+} // namespace modelconvert
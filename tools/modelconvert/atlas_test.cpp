@@ -0,0 +1,80 @@
+// Test for the texture atlas layout and texture coordinate remapping.
+#include "tools/modelconvert/atlas.hpp"
+
+#include <array>
+#include <cmath>
+#include <string_view>
+
+#include <fmt/core.h>
+
+namespace modelconvert {
+namespace {
+
+int failures;
+
+void TestGridSize() {
+    const std::array<std::array<int, 2>, 7> cases{{
+        {{1, 1}},
+        {{2, 2}},
+        {{3, 2}},
+        {{4, 2}},
+        {{5, 4}},
+        {{16, 4}},
+        {{17, 8}},
+    }};
+    for (const auto &[count, size] : cases) {
+        int got = AtlasGridSize(count);
+        if (got != size) {
+            fmt::print(stderr, "FAIL: AtlasGridSize({}) = {}, expect {}\n",
+                       count, got, size);
+            failures++;
+        }
+    }
+}
+
+void CheckTexcoord(std::string_view name, int count, int cell, int cell_size,
+                   std::array<float, 2> in, std::array<float, 2> expect) {
+    std::array<float, 2> got = AtlasTexcoord(count, cell, cell_size, in);
+    for (int i = 0; i < 2; i++) {
+        if (std::abs(got[i] - expect[i]) > 1.0e-6f) {
+            fmt::print(stderr, "FAIL: {}: got ({}, {}), expect ({}, {})\n",
+                       name, got[0], got[1], expect[0], expect[1]);
+            failures++;
+            return;
+        }
+    }
+}
+
+void TestTexcoord() {
+    // Three cells in a 2x2 grid of 16x16 cells, so the atlas is 32x32. Cell
+    // edges map to the centers of the edge texels: texel 0.5 and 15.5 of the
+    // cell.
+    CheckTexcoord("cell 0 min", 3, 0, 16, {{0.0f, 0.0f}},
+                  {{0.5f / 32, 0.5f / 32}});
+    CheckTexcoord("cell 0 max", 3, 0, 16, {{1.0f, 1.0f}},
+                  {{15.5f / 32, 15.5f / 32}});
+    CheckTexcoord("cell 1", 3, 1, 16, {{0.0f, 1.0f}},
+                  {{16.5f / 32, 15.5f / 32}});
+    CheckTexcoord("cell 2", 3, 2, 16, {{0.5f, 0.5f}}, {{0.25f, 0.75f}});
+    // Slightly out of range coordinates are clamped to the cell.
+    CheckTexcoord("clamp", 3, 0, 16, {{-0.001f, 1.001f}},
+                  {{0.5f / 32, 15.5f / 32}});
+}
+
+int Main() {
+    TestGridSize();
+    TestTexcoord();
+    if (failures > 0) {
+        fmt::print(stderr, "{} checks failed\n", failures);
+        return 1;
+    }
+    fmt::print("OK\n");
+    return 0;
+}
+
+} // namespace
+} // namespace modelconvert
+
+int main() {
+    return modelconvert::Main();
+}
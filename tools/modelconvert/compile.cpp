@@ -9,6 +9,7 @@
 #include <cassert>
 #include <limits>
 #include <stdexcept>
+#include <unordered_map>
 
 #include <fmt/core.h>
 
@@ -42,7 +43,6 @@ bool operator<(const VOrder &x, const VOrder &y) {
 // Vertex state.
 struct VState {
     Vtx vertex;
-    int tri_count;
     int group_id;
 };
 
@@ -95,7 +95,6 @@ struct VertexSet {
             } else {
                 v.vertex.color = std::array<uint8_t, 4>{{0, 0, 0, 0}};
             }
-            v.tri_count = 0;
             v.group_id = -1;
         }
 
@@ -155,29 +154,59 @@ struct VertexSet {
     int group_count;
 };
 
+// Buffers used by the compiler. These are reused for each material and each
+// batch, so the compiler does not allocate memory once the buffers have grown
+// to the size of the mesh.
+struct CompileArena {
+    std::vector<int> tri_count; // Remaining triangles for each vertex.
+    std::vector<GState> group;
+    std::vector<Triangle> triangle;
+    std::vector<int> batch_vertex;
+    std::vector<int> prev_vertex;
+    std::vector<Triangle> batch_triangle;
+    std::vector<Triangle> prev_triangle;
+    std::vector<uint8_t> reuse_slot;
+    std::vector<int> transform_verts;
+    std::vector<Vtx> vdata;
+};
+
 class Compiler {
 public:
-    Compiler(const VertexSet &vert, const Mesh &mesh, int material)
-        : m_vertex{vert.vertex} {
-        for (VState &v : m_vertex) {
-            v.tri_count = 0;
-        }
+    Compiler(const VertexSet &vert, const Mesh &mesh, int material,
+             CompileArena *arena)
+        : m_vertex{vert.vertex},
+          m_tri_count{arena->tri_count},
+          m_group{arena->group},
+          m_triangle{arena->triangle},
+          m_batch_vertex{arena->batch_vertex},
+          m_prev_vertex{arena->prev_vertex},
+          m_batch_triangle{arena->batch_triangle},
+          m_prev_triangle{arena->prev_triangle},
+          m_reuse_slot{arena->reuse_slot},
+          m_transform_verts{arena->transform_verts},
+          m_vdata{arena->vdata} {
+        m_tri_count.assign(m_vertex.size(), 0);
+        m_triangle.clear();
         for (const Triangle &tri : mesh.triangle) {
             if (tri.material == material) {
                 m_triangle.push_back(tri);
                 for (const int idx : tri.vertex) {
-                    m_vertex.at(idx).tri_count++;
+                    m_tri_count.at(idx)++;
                 }
             }
         }
         {
             GState g{};
             g.current_attr = -1;
-            m_group.resize(vert.group_count, g);
+            m_group.assign(vert.group_count, g);
         }
-        for (const VState &v : m_vertex) {
-            m_group.at(v.group_id).tri_count += v.tri_count;
+        for (size_t i = 0; i < m_vertex.size(); i++) {
+            m_group.at(m_vertex[i].group_id).tri_count += m_tri_count[i];
         }
+        m_batch_vertex.clear();
+        m_prev_vertex.clear();
+        m_batch_triangle.clear();
+        m_prev_triangle.clear();
     }
 
     void Emit(DisplayList *dl, std::vector<int> *dl_vertex_id,
@@ -246,19 +275,20 @@ private:
         Triangle tri = m_triangle.at(triangle_id);
         m_triangle.erase(m_triangle.begin() + triangle_id);
         for (const int vertex_id : tri.vertex) {
-            VState &v = m_vertex.at(vertex_id);
+            const VState &v = m_vertex.at(vertex_id);
             GState &g = m_group.at(v.group_id);
             if (!g.in_current_batch) {
                 assert(m_vert_space > 0);
                 m_vert_space--;
                 m_batch_vertex.push_back(vertex_id);
             }
-            assert(v.tri_count >= 1);
-            v.tri_count--;
+            int &tri_count = m_tri_count.at(vertex_id);
+            assert(tri_count >= 1);
+            tri_count--;
             assert(g.tri_count >= 1);
             g.tri_count--;
             g.in_current_batch = true;
-            g.current_attr = v.tri_count == 0 ? -1 : vertex_id;
+            g.current_attr = tri_count == 0 ? -1 : vertex_id;
         }
         m_batch_triangle.push_back(tri);
     }
@@ -291,7 +321,8 @@ private:
 
         // Figure out which slots have vertexes in this batch.
         int cache_size = dl->vertex_cache_size();
-        std::vector<uint8_t> reuse_slot(cache_size, 0);
+        std::vector<uint8_t> &reuse_slot = m_reuse_slot;
+        reuse_slot.assign(cache_size, 0);
         for (const int vertex_id : vertex) {
             const VState &v = m_vertex.at(vertex_id);
             int slot = dl->cache().CachePos(v.vertex.pos);
@@ -332,8 +363,8 @@ private:
         }
 
         // Figure out which vertexes this batch will transform.
-        std::vector<int> transform_verts;
-        transform_verts.reserve(count);
+        std::vector<int> &transform_verts = m_transform_verts;
+        transform_verts.clear();
         for (const int vertex_id : vertex) {
             const VState &v = m_vertex.at(vertex_id);
             int slot = dl->cache().CachePos(v.vertex.pos);
@@ -345,7 +376,8 @@ private:
         // Transform vertexes.
         {
             const int vcount = transform_verts.size();
-            std::vector<Vtx> vdata(vcount);
+            std::vector<Vtx> &vdata = m_vdata;
+            vdata.resize(vcount);
             int vstart = 0, vend = vcount;
             int dl_off = m_dl_vertex.size();
             m_dl_vertex.resize(dl_off + vcount, -1);
@@ -392,21 +424,28 @@ private:
         }
     }
 
-    // The mesh data to emit.
-    std::vector<VState> m_vertex;
-    std::vector<GState> m_group;
-    std::vector<Triangle> m_triangle;
+    // The mesh data to emit. Everything except the vertex data is stored in
+    // the arena.
+    const std::vector<VState> &m_vertex;
+    std::vector<int> &m_tri_count;
+    std::vector<GState> &m_group;
+    std::vector<Triangle> &m_triangle;
 
     // Space remaining in vetrex cache in current batch.
     int m_vert_space;
 
     // Vertexes to be transformed in current batch, previous batch.
-    std::vector<int> m_batch_vertex;
-    std::vector<int> m_prev_vertex;
+    std::vector<int> &m_batch_vertex;
+    std::vector<int> &m_prev_vertex;
 
     // Triangles in current batch, previous batch.
-    std::vector<Triangle> m_batch_triangle;
-    std::vector<Triangle> m_prev_triangle;
+    std::vector<Triangle> &m_batch_triangle;
+    std::vector<Triangle> &m_prev_triangle;
+
+    // Scratch buffers for EmitPrevBatch.
+    std::vector<uint8_t> &m_reuse_slot;
+    std::vector<int> &m_transform_verts;
+    std::vector<Vtx> &m_vdata;
 
     // Which batch this is.
     int m_batch_index = 0;
@@ -470,9 +509,10 @@ Model CompileMesh(const Mesh &mesh, const Config &cfg, std::FILE *stats) {
     VertexSet vert{mesh, cfg, stats};
     Model model;
     std::vector<int> dl_vertex_id;
+    CompileArena arena;
     for (int mat = 0; mat < mat_count; mat++) {
-        Compiler compiler{vert, mesh, mat};
-        DisplayList dl(VertexCacheSize, dl_vertex_id.size() * Vtx::Size);
+        Compiler compiler{vert, mesh, mat, &arena};
+        DisplayList dl(cfg.ucode, dl_vertex_id.size() * Vtx::Size);
         compiler.Emit(&dl, &dl_vertex_id, stats);
         dl.End();
         model.command.emplace_back(dl.command());
@@ -0,0 +1,293 @@
+// Fuzz test for the display list compiler. Compiles random synthetic meshes and
+// checks that the display lists only draw with vertexes loaded into the cache,
+// and that they draw exactly the triangles in the mesh.
+#include "tools/modelconvert/compile.hpp"
+#include "tools/modelconvert/config.hpp"
+#include "tools/modelconvert/mesh.hpp"
+#include "tools/modelconvert/model.hpp"
+#include "tools/modelconvert/synthetic.hpp"
+#include "tools/util/flag.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <assimp/scene.h>
+#include <fmt/core.h>
+
+namespace modelconvert {
+namespace {
+
+using gbi::Gfx;
+using gbi::Ucode;
+using gbi::UcodeInfo;
+
+// A triangle, identified by its vertex positions. Rotated so the smallest
+// position is first, which preserves winding.
+using PosTriangle = std::array<std::array<int16_t, 3>, 3>;
+
+PosTriangle MakePosTriangle(std::array<int16_t, 3> a, std::array<int16_t, 3> b,
+                            std::array<int16_t, 3> c) {
+    if (b < a && b < c) {
+        return {{b, c, a}};
+    }
+    if (c < a && c < b) {
+        return {{c, a, b}};
+    }
+    return {{a, b, c}};
+}
+
+class CheckError : public std::runtime_error {
+public:
+    CheckError(const std::string &msg) : runtime_error{msg} {}
+};
+
+// Simulates the vertex cache while walking through a display list.
+class CacheChecker {
+public:
+    CacheChecker(Ucode ucode, const std::vector<gbi::Vtx> &vertex)
+        : m_ucode{ucode},
+          m_slot(UcodeInfo::Get(ucode).vertex_cache_size, -1),
+          m_vertex{vertex} {}
+
+    // Check a display list. Returns the triangles drawn.
+    std::vector<PosTriangle> Check(const std::vector<Gfx> &dl) {
+        const bool gbi1 = m_ucode == Ucode::F3DEX;
+        m_triangles.clear();
+        for (size_t i = 0; i < dl.size(); i++) {
+            const Gfx &g = dl[i];
+            const unsigned op = g.hi >> 24;
+            if (op == (gbi1 ? 0xb8u : 0xdfu)) {
+                if (i + 1 != dl.size()) {
+                    throw CheckError("commands after end of display list");
+                }
+                return m_triangles;
+            }
+            if (op == (gbi1 ? 0x04u : 0x01u)) {
+                unsigned n, v0;
+                if (gbi1) {
+                    n = (g.hi >> 10) & 0x3f;
+                    v0 = ((g.hi >> 16) & 0xff) / 2;
+                } else {
+                    n = (g.hi >> 12) & 0xff;
+                    v0 = ((g.hi >> 1) & 0x7f) - n;
+                }
+                LoadVertex(g.lo, n, v0);
+            } else if (op == (gbi1 ? 0xbfu : 0x05u)) {
+                Triangle(gbi1 ? g.lo : g.hi);
+            } else if (op == (gbi1 ? 0xb1u : 0x06u)) {
+                Triangle(g.hi);
+                Triangle(g.lo);
+            } else if (op == 0x08u && UcodeInfo::Get(m_ucode).has_tristrip) {
+                Strip(g);
+            } else if (op == (gbi1 ? 0xb2u : 0x02u)) {
+                Slot(g.hi & 0xffff);
+            } else if (op == 0xfau) {
+                // SetPrimColor.
+            } else {
+                throw CheckError(fmt::format("unknown opcode: 0x{:02x}", op));
+            }
+        }
+        throw CheckError("missing end of display list");
+    }
+
+private:
+    void LoadVertex(uint32_t addr, unsigned n, unsigned v0) {
+        if ((addr >> 24) != 1) {
+            throw CheckError("vertex address not in segment 1");
+        }
+        addr &= 0xffffff;
+        if (addr % gbi::Vtx::Size != 0) {
+            throw CheckError("unaligned vertex address");
+        }
+        const unsigned index = addr / gbi::Vtx::Size;
+        if (index + n > m_vertex.size()) {
+            throw CheckError("vertex load past end of vertex data");
+        }
+        if (n == 0 || v0 + n > m_slot.size()) {
+            throw CheckError(
+                fmt::format("bad vertex load: v0={}, n={}", v0, n));
+        }
+        for (unsigned i = 0; i < n; i++) {
+            m_slot[v0 + i] = index + i;
+        }
+    }
+
+    // Check a cache index, times two. Returns the position of the vertex in
+    // that slot.
+    std::array<int16_t, 3> Slot(unsigned idx2) {
+        if ((idx2 & 1) != 0) {
+            throw CheckError(fmt::format("odd vertex index: {}", idx2));
+        }
+        const unsigned slot = idx2 / 2;
+        if (slot >= m_slot.size()) {
+            throw CheckError(fmt::format("vertex {} out of range", slot));
+        }
+        if (m_slot[slot] == -1) {
+            throw CheckError(fmt::format("vertex {} not loaded", slot));
+        }
+        return m_vertex[m_slot[slot]].pos;
+    }
+
+    void Triangle(uint32_t w) {
+        m_triangles.push_back(MakePosTriangle(
+            Slot((w >> 16) & 0xff), Slot((w >> 8) & 0xff), Slot(w & 0xff)));
+    }
+
+    void Strip(const Gfx &g) {
+        const std::array<unsigned, 7> idx{{
+            (g.hi >> 16) & 0xff,
+            (g.hi >> 8) & 0xff,
+            g.hi & 0xff,
+            g.lo >> 24,
+            (g.lo >> 16) & 0xff,
+            (g.lo >> 8) & 0xff,
+            g.lo & 0xff,
+        }};
+        std::array<std::array<int16_t, 3>, 7> pos;
+        size_t n = 0;
+        while (n < idx.size() && idx[n] != 0xfe) {
+            pos[n] = Slot(idx[n]);
+            n++;
+        }
+        if (n < 3) {
+            throw CheckError("triangle strip too short");
+        }
+        for (size_t i = 0; i + 2 < n; i++) {
+            m_triangles.push_back(
+                (i & 1) == 0 ? MakePosTriangle(pos[i], pos[i + 1], pos[i + 2])
+                             : MakePosTriangle(pos[i + 1], pos[i], pos[i + 2]));
+        }
+    }
+
+    Ucode m_ucode;
+    std::vector<int> m_slot; // Index of vertex in each slot, or -1.
+    const std::vector<gbi::Vtx> &m_vertex;
+    std::vector<PosTriangle> m_triangles;
+};
+
+// Get the triangles in each material which have three distinct positions,
+// which are the triangles the compiler should draw.
+std::vector<std::vector<PosTriangle>> MeshTriangles(const Mesh &mesh) {
+    std::vector<std::vector<PosTriangle>> result;
+    const std::vector<std::array<int16_t, 3>> &pos = mesh.animation_frame.at(0);
+    for (const Triangle &tri : mesh.triangle) {
+        if (static_cast<size_t>(tri.material) >= result.size()) {
+            result.resize(tri.material + 1);
+        }
+        const std::array<int16_t, 3> &a = pos.at(tri.vertex[0]),
+                                     &b = pos.at(tri.vertex[1]),
+                                     &c = pos.at(tri.vertex[2]);
+        if (a != b && b != c && a != c) {
+            result[tri.material].push_back(MakePosTriangle(a, b, c));
+        }
+    }
+    return result;
+}
+
+void CheckModel(const Mesh &mesh, const gbi::Model &model, Ucode ucode) {
+    std::vector<std::vector<PosTriangle>> expect = MeshTriangles(mesh);
+    if (model.command.size() != expect.size()) {
+        throw CheckError(fmt::format("got {} display lists, expected {}",
+                                     model.command.size(), expect.size()));
+    }
+    for (size_t i = 0; i < expect.size(); i++) {
+        CacheChecker checker{ucode, model.vertex};
+        std::vector<PosTriangle> drawn;
+        try {
+            drawn = checker.Check(model.command[i]);
+        } catch (CheckError &ex) {
+            throw CheckError(fmt::format("material {}: {}", i, ex.what()));
+        }
+        std::sort(drawn.begin(), drawn.end());
+        std::sort(expect[i].begin(), expect[i].end());
+        if (drawn != expect[i]) {
+            throw CheckError(fmt::format(
+                "material {}: drew {} triangles, which do not match the {} "
+                "triangles in the mesh",
+                i, drawn.size(), expect[i].size()));
+        }
+    }
+}
+
+const SyntheticShape Shapes[] = {
+    SyntheticShape::Grid,  SyntheticShape::Sphere,   SyntheticShape::Soup,
+    SyntheticShape::Strip, SyntheticShape::Cylinder,
+};
+
+const Ucode Ucodes[] = {Ucode::F3DEX, Ucode::F3DEX2, Ucode::F3DEX3};
+
+// Run one iteration of the test. Returns false on failure.
+bool RunIteration(uint32_t seed) {
+    std::mt19937 rand{seed};
+    SyntheticParams params{};
+    params.shape = Shapes[rand() % std::size(Shapes)];
+    params.triangles = 1 + rand() % 2000;
+    params.materials = 1 + rand() % 4;
+    params.seed = seed;
+    Config cfg{};
+    cfg.use_texcoords = (rand() & 1) != 0;
+    cfg.use_vertex_colors = (rand() & 1) != 0;
+    cfg.use_normals = !cfg.use_vertex_colors && (rand() & 1) != 0;
+    cfg.texcoord_bits = 11;
+    cfg.scale = 1.0f;
+    std::unique_ptr<aiScene> scene = GenerateScene(params);
+    cfg.animate = scene->mNumAnimations > 0;
+    for (const Ucode ucode : Ucodes) {
+        cfg.ucode = ucode;
+        try {
+            Mesh mesh = Mesh::Import(cfg, nullptr, scene.get());
+            gbi::Model model = gbi::CompileMesh(mesh, cfg, nullptr);
+            CheckModel(mesh, model, ucode);
+            model.Emit(cfg);
+        } catch (std::exception &ex) {
+            fmt::print(stderr,
+                       "FAIL: seed={} shape={} triangles={} materials={} "
+                       "ucode={}: {}\n",
+                       seed, SyntheticShapeName(params.shape),
+                       params.triangles, params.materials,
+                       UcodeInfo::Get(ucode).name, ex.what());
+            return false;
+        }
+    }
+    return true;
+}
+
+int Main(int argc, char **argv) {
+    int iterations = 50;
+    int seed = 1;
+    flag::Parser fl;
+    fl.AddFlag(flag::Int(&iterations), "iterations",
+               "number of random meshes to test", "N");
+    fl.AddFlag(flag::Int(&seed), "seed", "seed for the first iteration", "N");
+    flag::ProgramArguments prog_args{argc - 1, argv + 1};
+    try {
+        fl.ParseAll(prog_args);
+    } catch (flag::UsageError &ex) {
+        fmt::print(stderr, "Error: {}\n", ex.what());
+        return 64;
+    }
+    int failures = 0;
+    for (int i = 0; i < iterations; i++) {
+        if (!RunIteration(seed + i)) {
+            failures++;
+        }
+    }
+    if (failures > 0) {
+        fmt::print(stderr, "{} of {} iterations failed\n", failures,
+                   iterations);
+        return 1;
+    }
+    fmt::print("{} iterations passed\n", iterations);
+    return 0;
+}
+
+} // namespace
+} // namespace modelconvert
+
+int main(int argc, char **argv) {
+    return modelconvert::Main(argc, argv);
+}
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "tools/modelconvert/axes.hpp"
+#include "tools/modelconvert/gbi.hpp"
+
+#include <vector>
 
 namespace modelconvert {
 
@@ -23,6 +26,14 @@ struct Config {
     Axes axes;
     // If true, create animations.
     bool animate;
+    // Microcode to generate display lists for.
+    gbi::Ucode ucode;
+    // Materials whose textures are packed into a texture atlas, in atlas cell
+    // order. These are merged into the first material in the list. Empty if
+    // no atlas is used.
+    std::vector<int> atlas;
+    // Size of each atlas cell, in texels, in the converted atlas texture.
+    int atlas_cell_size;
 };
 
 } // namespace modelconvert
@@ -9,8 +9,56 @@
 namespace modelconvert {
 namespace gbi {
 
-DisplayList::DisplayList(unsigned cache_size, unsigned vertex_offset)
-    : m_cache{cache_size}, m_vertex_offset{vertex_offset}, m_has_tri1{false} {}
+namespace {
+
+// Find the vertex which completes a triangle containing the directed edge
+// (a, b), or return -1 if the triangle does not contain that edge.
+int CompleteEdge(const std::array<int, 3> &tri, int a, int b) {
+    for (int i = 0; i < 3; i++) {
+        if (tri[i] == a && tri[(i + 1) % 3] == b) {
+            return tri[(i + 2) % 3];
+        }
+    }
+    return -1;
+}
+
+// Extend a triangle strip with triangles from the list. Sets the used flag for
+// triangles which are added to the strip.
+void ExtendStrip(std::vector<int> *strip,
+                 const std::vector<std::array<int, 3>> &tris,
+                 std::vector<bool> *used) {
+    while (strip->size() < MaxStripVertexes) {
+        size_t n = strip->size();
+        // The new triangle has index n-2, and is (s[n-2], s[n-1], x) if n is
+        // even, or (s[n-1], s[n-2], x) if n is odd.
+        int a = (*strip)[n - 2], b = (*strip)[n - 1];
+        if ((n & 1) != 0) {
+            std::swap(a, b);
+        }
+        int next = -1;
+        for (size_t i = 0; i < tris.size(); i++) {
+            if (!(*used)[i]) {
+                int x = CompleteEdge(tris[i], a, b);
+                if (x != -1) {
+                    (*used)[i] = true;
+                    next = x;
+                    break;
+                }
+            }
+        }
+        if (next == -1) {
+            break;
+        }
+        strip->push_back(next);
+    }
+}
+
+} // namespace
+
+DisplayList::DisplayList(Ucode ucode, unsigned vertex_offset)
+    : m_ucode{ucode},
+      m_cache{UcodeInfo::Get(ucode).vertex_cache_size},
+      m_vertex_offset{vertex_offset} {}
 
 void DisplayList::Triangle(std::array<int, 3> tri) {
     for (int i = 0; i < 3; i++) {
@@ -28,15 +76,7 @@ void DisplayList::Triangle(std::array<int, 3> tri) {
             }
         }
     }
-    if (m_has_tri1) {
-        assert(!m_cmds.empty());
-        m_cmds.back() = Gfx::SP2Triangle(m_tri1, tri);
-        m_has_tri1 = false;
-    } else {
-        m_cmds.push_back(Gfx::SP1Triangle(tri));
-        m_has_tri1 = true;
-        m_tri1 = tri;
-    }
+    m_tris.push_back(tri);
 }
 
 void DisplayList::Vertex(int offset, const std::vector<Vtx> &vertexes) {
@@ -47,30 +87,26 @@ void DisplayList::Vertex(int offset, const std::vector<Vtx> &vertexes) {
     if (start == end) {
         return;
     }
-    m_cmds.push_back(
-        Gfx::SPVertex(RSPAddress(m_vertex_offset + m_vtx.size() * Vtx::Size),
-                      end - start, start));
+    // Pending triangles which do not use the overwritten slots can be drawn
+    // after the load, and combined with triangles from the next batch.
+    for (const std::array<int, 3> &tri : m_tris) {
+        for (const int idx : tri) {
+            if (start <= idx && idx < end) {
+                FlushTriangles();
+                goto flushed;
+            }
+        }
+    }
+flushed:
+    m_cmds.push_back(Gfx::SPVertex(
+        m_ucode, RSPAddress(m_vertex_offset + m_vtx.size() * Vtx::Size),
+        end - start, start));
     int pos = start;
     for (const Vtx &v : vertexes) {
         m_cache.Set(pos, v);
         m_vtx.push_back(v);
         pos++;
     }
-    if (m_has_tri1) {
-        bool ok = true;
-        for (const int idx : m_tri1) {
-            if (start <= idx && idx < end) {
-                ok = false;
-                break;
-            }
-        }
-        if (ok) {
-            size_t idx = m_cmds.size() - 2;
-            std::swap(m_cmds.at(idx), m_cmds.at(idx + 1));
-        } else {
-            m_has_tri1 = false;
-        }
-    }
 }
 
 void DisplayList::SetVertexColor(int vertex, std::array<uint8_t, 4> value) {
@@ -81,8 +117,8 @@ void DisplayList::SetVertexColor(int vertex, std::array<uint8_t, 4> value) {
     if (vtx->color != value) {
         vtx->color = value;
         FlushVertex(vertex);
-        m_cmds.push_back(Gfx::SPModifyVertex(vertex, VertexField::RGBA,
-                                             util::Pack8x4(value)));
+        m_cmds.push_back(Gfx::SPModifyVertex(
+            m_ucode, vertex, VertexField::RGBA, util::Pack8x4(value)));
     }
 }
 
@@ -96,25 +132,76 @@ void DisplayList::SetVertexTexcoord(int vertex, std::array<int16_t, 2> value) {
         FlushVertex(vertex);
         // HACK: We are just hard-coding the RSP scaling factor here.
         m_cmds.push_back(
-            Gfx::SPModifyVertex(vertex, VertexField::ST,
+            Gfx::SPModifyVertex(m_ucode, vertex, VertexField::ST,
                                 util::Pack16x2(value[0] >> 1, value[1] >> 1)));
     }
 }
 
 void DisplayList::FlushVertex(int vertex) {
-    if (m_has_tri1) {
-        for (const int vertex_id : m_tri1) {
-            if (vertex_id == vertex) {
-                m_has_tri1 = false;
-                break;
+    for (const std::array<int, 3> &tri : m_tris) {
+        for (const int idx : tri) {
+            if (idx == vertex) {
+                FlushTriangles();
+                return;
+            }
+        }
+    }
+}
+
+bool DisplayList::TakeStrip() {
+    const size_t n = m_tris.size();
+    m_strip.clear();
+    for (size_t i = 0; i < n; i++) {
+        for (int rot = 0; rot < 3; rot++) {
+            const std::array<int, 3> &tri = m_tris[i];
+            m_candidate.assign(
+                {tri[rot], tri[(rot + 1) % 3], tri[(rot + 2) % 3]});
+            m_candidate_used.assign(n, false);
+            m_candidate_used[i] = true;
+            ExtendStrip(&m_candidate, m_tris, &m_candidate_used);
+            if (m_candidate.size() > m_strip.size()) {
+                m_strip.swap(m_candidate);
+                m_used.swap(m_candidate_used);
+                if (m_strip.size() == MaxStripVertexes) {
+                    goto done;
+                }
             }
         }
     }
+done:
+    // A strip of one or two triangles is no better than SP2Triangle.
+    if (m_strip.size() < 5) {
+        return false;
+    }
+    size_t pos = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!m_used[i]) {
+            m_tris[pos++] = m_tris[i];
+        }
+    }
+    m_tris.resize(pos);
+    return true;
+}
+
+void DisplayList::FlushTriangles() {
+    if (UcodeInfo::Get(m_ucode).has_tristrip) {
+        while (m_tris.size() >= 3 && TakeStrip()) {
+            m_cmds.push_back(Gfx::SPTriStrip(m_ucode, m_strip));
+        }
+    }
+    size_t n = m_tris.size(), i = 0;
+    for (; i + 1 < n; i += 2) {
+        m_cmds.push_back(Gfx::SP2Triangle(m_ucode, m_tris[i], m_tris[i + 1]));
+    }
+    if (i < n) {
+        m_cmds.push_back(Gfx::SP1Triangle(m_ucode, m_tris[i]));
+    }
+    m_tris.clear();
 }
 
 void DisplayList::End() {
-    m_cmds.push_back(Gfx::SPEndDisplayList());
-    m_has_tri1 = false;
+    FlushTriangles();
+    m_cmds.push_back(Gfx::SPEndDisplayList(m_ucode));
     m_cache.Clear();
 }
 
@@ -9,14 +9,15 @@
 namespace modelconvert {
 namespace gbi {
 
-// Number of entries in the vertex cache.
-constexpr unsigned VertexCacheSize = 32;
-
 // Display list builder. Performs minor optimizations, such as combining
-// multiple triangles into SP1Triangle and SP2Triangle.
+// multiple triangles into SP2Triangle or triangle strip commands, depending on
+// what the microcode supports.
 class DisplayList {
 public:
-    DisplayList(unsigned cache_size, unsigned vertex_offset);
+    DisplayList(Ucode ucode, unsigned vertex_offset);
+
+    // The microcode this display list targets.
+    Ucode ucode() const { return m_ucode; }
 
     // Read-only access to the vertex cache.
     const VertexCache &cache() const { return m_cache; }
@@ -46,18 +47,33 @@ public:
     void End();
 
 private:
-    // Flush pending triangles with the given vertex.
+    // Flush pending triangles if any of them use the given vertex.
     void FlushVertex(int vertex);
 
+    // Emit commands for all pending triangles.
+    void FlushTriangles();
+
+    // Remove a triangle strip from the pending triangles and store its
+    // vertexes in m_strip. Returns false if no strip longer than two triangles
+    // can be made.
+    bool TakeStrip();
+
+    Ucode m_ucode;
     VertexCache m_cache;
     unsigned m_vertex_offset;
 
     std::vector<Gfx> m_cmds;
     std::vector<Vtx> m_vtx;
 
-    // If the top command is SP1Triangle, then this is the triangle.
-    bool m_has_tri1;
-    std::array<int, 3> m_tri1;
+    // Triangles which have not been emitted yet. They only refer to vertexes
+    // which are currently in the cache.
+    std::vector<std::array<int, 3>> m_tris;
+
+    // Scratch buffers for building triangle strips.
+    std::vector<int> m_strip;
+    std::vector<int> m_candidate;
+    std::vector<bool> m_used;
+    std::vector<bool> m_candidate_used;
 };
 
 } // namespace gbi
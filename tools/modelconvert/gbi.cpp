@@ -2,7 +2,10 @@
 
 #include "tools/util/bswap.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <iterator>
+#include <stdexcept>
 
 namespace modelconvert {
 namespace gbi {
@@ -34,6 +37,12 @@ void Gfx::Write(uint8_t *ptr) const {
 
 namespace {
 
+const UcodeInfo UcodeTable[] = {
+    {"f3dex", 32, 2, false},
+    {"f3dex2", 32, 2, false},
+    {"f3dex3", 56, 5, true},
+};
+
 uint32_t ShiftL(unsigned v, unsigned s, unsigned w) {
     return (v & ((1u << w) - 1)) << s;
 }
@@ -43,49 +52,111 @@ uint32_t Triangle(std::array<int, 3> v) {
            ShiftL(v[2] * 2, 0, 8);
 }
 
+// Command opcodes. These differ between the GBI for F3DEX and the GBI for
+// F3DEX2. F3DEX3 uses the F3DEX2 opcodes, plus its own extensions.
+struct Opcodes {
+    uint8_t vtx;
+    uint8_t modifyvtx;
+    uint8_t tri1;
+    uint8_t tri2;
+    uint8_t tristrip;
+    uint8_t enddl;
+};
+
+const Opcodes &GetOpcodes(Ucode ucode) {
+    static const Opcodes gbi1{0x04, 0xb2, 0xbf, 0xb1, 0x00, 0xb8};
+    static const Opcodes gbi2{0x01, 0x02, 0x05, 0x06, 0x08, 0xdf};
+    return ucode == Ucode::F3DEX ? gbi1 : gbi2;
+}
+
 enum {
-    G_VTX = 0x01,
-    G_MODIFYVTX = 0x02,
-    G_TRI1 = 0x05,
-    G_TRI2 = 0x06,
-    G_ENDDL = 0xdf,
     G_SETPRIMCOLOR = 0xfa,
 };
 
 } // namespace
 
-Gfx Gfx::SPVertex(unsigned v, unsigned n, unsigned v0) {
+const UcodeInfo &UcodeInfo::Get(Ucode ucode) {
+    size_t index = static_cast<size_t>(ucode);
+    if (index >= std::size(UcodeTable)) {
+        throw std::invalid_argument("UcodeInfo::Get: unknown microcode");
+    }
+    return UcodeTable[index];
+}
+
+Ucode UcodeInfo::Parse(std::string_view s) {
+    for (size_t i = 0; i < std::size(UcodeTable); i++) {
+        if (s == UcodeTable[i].name) {
+            return static_cast<Ucode>(i);
+        }
+    }
+    throw std::invalid_argument("unknown microcode");
+}
+
+Gfx Gfx::SPVertex(Ucode ucode, unsigned v, unsigned n, unsigned v0) {
+    const Opcodes &op = GetOpcodes(ucode);
+    if (ucode == Ucode::F3DEX) {
+        return Gfx{
+            ShiftL(op.vtx, 24, 8) | ShiftL(v0 * 2, 16, 8) |
+                ShiftL((n << 10) | (Vtx::Size * n - 1), 0, 16),
+            v,
+        };
+    }
     return Gfx{
-        ShiftL(G_VTX, 24, 8) | ShiftL(n, 12, 8) | ShiftL(v0 + n, 1, 7),
+        ShiftL(op.vtx, 24, 8) | ShiftL(n, 12, 8) | ShiftL(v0 + n, 1, 7),
         v,
     };
 }
 
-Gfx Gfx::SPModifyVertex(int vertex, VertexField field, uint32_t value) {
+Gfx Gfx::SPModifyVertex(Ucode ucode, int vertex, VertexField field,
+                        uint32_t value) {
     return Gfx{
-        ShiftL(G_MODIFYVTX, 24, 8) |
+        ShiftL(GetOpcodes(ucode).modifyvtx, 24, 8) |
             ShiftL(static_cast<uint32_t>(field), 16, 8) |
             ShiftL(vertex * 2, 0, 16),
         value,
     };
 }
 
-Gfx Gfx::SP1Triangle(std::array<int, 3> v1) {
+Gfx Gfx::SP1Triangle(Ucode ucode, std::array<int, 3> v1) {
+    const Opcodes &op = GetOpcodes(ucode);
+    if (ucode == Ucode::F3DEX) {
+        return Gfx{ShiftL(op.tri1, 24, 8), Triangle(v1)};
+    }
     return Gfx{
-        ShiftL(G_TRI1, 24, 8) | Triangle(v1),
+        ShiftL(op.tri1, 24, 8) | Triangle(v1),
         0,
     };
 }
 
-Gfx Gfx::SP2Triangle(std::array<int, 3> v1, std::array<int, 3> v2) {
+Gfx Gfx::SP2Triangle(Ucode ucode, std::array<int, 3> v1,
+                     std::array<int, 3> v2) {
     return Gfx{
-        ShiftL(G_TRI2, 24, 8) | Triangle(v1),
+        ShiftL(GetOpcodes(ucode).tri2, 24, 8) | Triangle(v1),
         Triangle(v2),
     };
 }
 
-Gfx Gfx::SPEndDisplayList() {
-    return Gfx{ShiftL(G_ENDDL, 24, 8), 0};
+Gfx Gfx::SPTriStrip(Ucode ucode, const std::vector<int> &v) {
+    if (!UcodeInfo::Get(ucode).has_tristrip) {
+        throw std::invalid_argument(
+            "Gfx::SPTriStrip: microcode does not support strips");
+    }
+    if (v.size() < 3 || v.size() > MaxStripVertexes) {
+        throw std::range_error("Gfx::SPTriStrip: bad vertex count");
+    }
+    // Unused entries are -1, which ends the strip.
+    std::array<int, MaxStripVertexes> idx;
+    std::fill(std::begin(idx), std::end(idx), -1);
+    std::copy(std::begin(v), std::end(v), std::begin(idx));
+    return Gfx{
+        ShiftL(GetOpcodes(ucode).tristrip, 24, 8) |
+            Triangle({{idx[0], idx[1], idx[2]}}),
+        ShiftL(idx[3] * 2, 24, 8) | Triangle({{idx[4], idx[5], idx[6]}}),
+    };
+}
+
+Gfx Gfx::SPEndDisplayList(Ucode ucode) {
+    return Gfx{ShiftL(GetOpcodes(ucode).enddl, 24, 8), 0};
 }
 
 Gfx Gfx::DPSetPrimColor(unsigned m, unsigned l, std::array<uint8_t, 4> rgba) {
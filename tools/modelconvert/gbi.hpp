@@ -3,10 +3,40 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <string_view>
+#include <vector>
 
 namespace modelconvert {
 namespace gbi {
 
+// Graphics microcode which the display lists are generated for.
+enum class Ucode {
+    F3DEX,
+    F3DEX2,
+    F3DEX3,
+};
+
+// Information about a microcode target.
+struct UcodeInfo {
+    // Name of the microcode, as passed to the -ucode flag.
+    const char *name;
+
+    // Number of entries in the vertex cache.
+    unsigned vertex_cache_size;
+
+    // Maximum number of triangles which can be drawn by a single command.
+    unsigned max_triangles;
+
+    // Whether the microcode supports triangle strip commands.
+    bool has_tristrip;
+
+    // Get the information for a microcode target.
+    static const UcodeInfo &Get(Ucode ucode);
+
+    // Parse a microcode name. Throws std::invalid_argument on failure.
+    static Ucode Parse(std::string_view s);
+};
+
 // Calculate the address of an object relative to the display list start.
 inline uint32_t RSPAddress(uint32_t x) {
     return (1u << 24) | x;
@@ -34,6 +64,9 @@ enum class VertexField {
     Z = 28,
 };
 
+// Maximum number of vertexes in a triangle strip command.
+constexpr int MaxStripVertexes = 7;
+
 // Microcode command.
 struct alignas(8) Gfx {
     // Size of microcode command.
@@ -45,11 +78,17 @@ struct alignas(8) Gfx {
     // Write to buffer.
     void Write(uint8_t *ptr) const;
 
-    static Gfx SPVertex(unsigned v, unsigned n, unsigned v0);
-    static Gfx SPModifyVertex(int vertex, VertexField field, uint32_t value);
-    static Gfx SP1Triangle(std::array<int, 3> v1);
-    static Gfx SP2Triangle(std::array<int, 3> v1, std::array<int, 3> v2);
-    static Gfx SPEndDisplayList();
+    static Gfx SPVertex(Ucode ucode, unsigned v, unsigned n, unsigned v0);
+    static Gfx SPModifyVertex(Ucode ucode, int vertex, VertexField field,
+                              uint32_t value);
+    static Gfx SP1Triangle(Ucode ucode, std::array<int, 3> v1);
+    static Gfx SP2Triangle(Ucode ucode, std::array<int, 3> v1,
+                           std::array<int, 3> v2);
+    // Draw a triangle strip with 3 to MaxStripVertexes vertexes. Triangle i is
+    // (v[i], v[i+1], v[i+2]) for even i, and (v[i+1], v[i], v[i+2]) for odd i,
+    // so all triangles have the same winding.
+    static Gfx SPTriStrip(Ucode ucode, const std::vector<int> &v);
+    static Gfx SPEndDisplayList(Ucode ucode);
     static Gfx DPSetPrimColor(unsigned m, unsigned l,
                               std::array<uint8_t, 4> rgba);
 };
@@ -0,0 +1,133 @@
+// Test for the display list command encodings. The expected values are the
+// words produced by the GBI macros for each microcode: F3DEX_GBI for F3DEX,
+// F3DEX_GBI_2 for F3DEX2, and the F3DEX3 gbi.h, which extends F3DEX_GBI_2.
+#include "tools/modelconvert/gbi.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+
+namespace modelconvert {
+namespace gbi {
+namespace {
+
+int failures;
+
+void Check(std::string_view name, Gfx got, uint32_t hi, uint32_t lo) {
+    if (got.hi != hi || got.lo != lo) {
+        fmt::print(stderr,
+                   "FAIL: {}: got {:08x} {:08x}, expect {:08x} {:08x}\n", name,
+                   got.hi, got.lo, hi, lo);
+        failures++;
+    }
+}
+
+void TestF3DEX() {
+    const Ucode u = Ucode::F3DEX;
+    // gSPVertex(v, 3, 0): gDma1p(G_VTX, v, (3 << 10) | (16 * 3 - 1), 0).
+    Check("f3dex vertex", Gfx::SPVertex(u, RSPAddress(0x10), 3, 0), 0x04000c2f,
+          0x01000010);
+    Check("f3dex vertex v0", Gfx::SPVertex(u, RSPAddress(0), 2, 5), 0x040a081f,
+          0x01000000);
+    Check("f3dex modify",
+          Gfx::SPModifyVertex(u, 5, VertexField::ST, 0x12345678), 0xb214000a,
+          0x12345678);
+    Check("f3dex tri1", Gfx::SP1Triangle(u, {{0, 1, 2}}), 0xbf000000,
+          0x00000204);
+    Check("f3dex tri2", Gfx::SP2Triangle(u, {{0, 1, 2}}, {{2, 1, 3}}),
+          0xb1000204, 0x00040206);
+    Check("f3dex enddl", Gfx::SPEndDisplayList(u), 0xb8000000, 0);
+}
+
+void TestF3DEX2() {
+    const Ucode u = Ucode::F3DEX2;
+    // gSPVertex(v, 3, 0): n << 12, and (v0 + n) << 1.
+    Check("f3dex2 vertex", Gfx::SPVertex(u, RSPAddress(0x10), 3, 0),
+          0x01003006, 0x01000010);
+    Check("f3dex2 vertex v0", Gfx::SPVertex(u, RSPAddress(0), 2, 5),
+          0x0100200e, 0x01000000);
+    Check("f3dex2 modify",
+          Gfx::SPModifyVertex(u, 5, VertexField::ST, 0x12345678), 0x0214000a,
+          0x12345678);
+    Check("f3dex2 tri1", Gfx::SP1Triangle(u, {{0, 1, 2}}), 0x05000204, 0);
+    Check("f3dex2 tri2", Gfx::SP2Triangle(u, {{0, 1, 2}}, {{2, 1, 3}}),
+          0x06000204, 0x00040206);
+    Check("f3dex2 enddl", Gfx::SPEndDisplayList(u), 0xdf000000, 0);
+    Check("primcolor", Gfx::DPSetPrimColor(0, 128, {{1, 2, 3, 4}}), 0xfa000080,
+          0x01020304);
+}
+
+void TestF3DEX3() {
+    const Ucode u = Ucode::F3DEX3;
+    // Vertex indexes above 31 are only valid in F3DEX3.
+    Check("f3dex3 vertex", Gfx::SPVertex(u, RSPAddress(0x10), 8, 48),
+          0x01008070, 0x01000010);
+    Check("f3dex3 tri2", Gfx::SP2Triangle(u, {{40, 41, 42}}, {{42, 41, 55}}),
+          0x06505254, 0x0054526e);
+    // gSPTriStrip(v1, ..., v7). Unused vertexes are -1.
+    Check("f3dex3 strip", Gfx::SPTriStrip(u, {0, 1, 2, 3, 4, 5, 6}), 0x08000204,
+          0x06080a0c);
+    Check("f3dex3 strip short", Gfx::SPTriStrip(u, {3, 4, 5}), 0x0806080a,
+          0xfefefefe);
+}
+
+void TestErrors() {
+    auto expect_throw = [](std::string_view name, auto f) {
+        try {
+            f();
+        } catch (std::exception &) {
+            return;
+        }
+        fmt::print(stderr, "FAIL: {}: no exception\n", name);
+        failures++;
+    };
+    expect_throw("strip on f3dex2", [] {
+        Gfx::SPTriStrip(Ucode::F3DEX2, {0, 1, 2});
+    });
+    expect_throw("short strip", [] {
+        Gfx::SPTriStrip(Ucode::F3DEX3, {0, 1});
+    });
+    expect_throw("long strip", [] {
+        Gfx::SPTriStrip(Ucode::F3DEX3, {0, 1, 2, 3, 4, 5, 6, 7});
+    });
+    expect_throw("parse", [] { UcodeInfo::Parse("f3dex4"); });
+}
+
+void TestInfo() {
+    const std::vector<std::pair<Ucode, unsigned>> cache{
+        {Ucode::F3DEX, 32}, {Ucode::F3DEX2, 32}, {Ucode::F3DEX3, 56}};
+    for (const auto &[u, size] : cache) {
+        const UcodeInfo &info = UcodeInfo::Get(u);
+        if (info.vertex_cache_size != size ||
+            UcodeInfo::Parse(info.name) != u) {
+            fmt::print(stderr, "FAIL: info for {}\n", info.name);
+            failures++;
+        }
+    }
+}
+
+int Main() {
+    TestF3DEX();
+    TestF3DEX2();
+    TestF3DEX3();
+    TestErrors();
+    TestInfo();
+    if (failures > 0) {
+        fmt::print(stderr, "{} checks failed\n", failures);
+        return 1;
+    }
+    fmt::print("OK\n");
+    return 0;
+}
+
+} // namespace
+} // namespace gbi
+} // namespace modelconvert
+
+int main() {
+    return modelconvert::gbi::Main();
+}
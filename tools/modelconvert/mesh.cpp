@@ -1,5 +1,6 @@
 #include "tools/modelconvert/mesh.hpp"
 
+#include "tools/modelconvert/atlas.hpp"
 #include "tools/modelconvert/config.hpp"
 #include "tools/util/hash.hpp"
 #include "tools/util/pack.hpp"
@@ -242,6 +243,10 @@ void Importer::Import(const aiScene *scene) {
         fmt::print(m_stats, "Triangles: {}\n", m_triangle.size());
         fmt::print(m_stats, "Nodes: {}\n", m_node.size());
         fmt::print(m_stats, "Bones: {}\n", m_bone.size());
+        if (!m_cfg.atlas.empty()) {
+            const int size = AtlasGridSize(m_cfg.atlas.size());
+            fmt::print(m_stats, "Atlas: {}x{} cells\n", size, size);
+        }
         fmt::print(m_stats, "\n");
     }
 }
@@ -336,6 +341,16 @@ void Importer::AddMesh(const aiMesh *mesh, const aiMatrix4x4 &transform) {
         QuantizeVectors(&m_vertexpos, posarr, nvert, m_transform * transform);
     }
 
+    // Get the atlas cell for this mesh's material, or -1 if the material is not
+    // in the atlas.
+    int atlas_cell = -1;
+    for (size_t i = 0; i < m_cfg.atlas.size(); i++) {
+        if (m_cfg.atlas[i] == static_cast<int>(mesh->mMaterialIndex)) {
+            atlas_cell = i;
+            break;
+        }
+    }
+
     // Get texture coordinates.
     if (m_cfg.use_texcoords) {
         const aiVector3D *texcoordarr = mesh->mTextureCoords[0];
@@ -352,6 +367,24 @@ void Importer::AddMesh(const aiMesh *mesh, const aiMatrix4x4 &transform) {
         for (int i = 0; i < nvert; i++) {
             std::array<float, 3> ftexcoord = ImportVector(texcoordarr[i]);
             ftexcoord[1] = 1.0f - ftexcoord[1];
+            if (atlas_cell != -1) {
+                // Texture coordinates cannot wrap within the atlas.
+                constexpr float epsilon = 1.0e-3f;
+                for (int j = 0; j < 2; j++) {
+                    if (!(ftexcoord[j] >= -epsilon &&
+                          ftexcoord[j] <= 1.0f + epsilon)) {
+                        throw MeshError(fmt::format(
+                            "texture coordinates outside atlas cell, "
+                            "material={}",
+                            mesh->mMaterialIndex));
+                    }
+                }
+                std::array<float, 2> t = AtlasTexcoord(
+                    m_cfg.atlas.size(), atlas_cell, m_cfg.atlas_cell_size,
+                    {{ftexcoord[0], ftexcoord[1]}});
+                ftexcoord[0] = t[0];
+                ftexcoord[1] = t[1];
+            }
             std::array<int16_t, 2> itexcoord;
             for (int j = 0; j < 2; j++) {
                 const float v = ftexcoord[j] * scale;
@@ -422,7 +455,8 @@ done_colors:
 done_normals:;
 
     {
-        int material = mesh->mMaterialIndex;
+        int material = atlas_cell == -1 ? static_cast<int>(mesh->mMaterialIndex)
+                                        : m_cfg.atlas[0];
         int nfaces = mesh->mNumFaces;
         const aiFace *faces = mesh->mFaces;
         for (int i = 0; i < nfaces; i++) {
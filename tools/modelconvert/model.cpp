@@ -31,6 +31,10 @@ struct DataRef {
     }
 };
 
+// The model asset is position-independent, so the game can use it directly
+// after loading it. Offsets in the header and animations are relative to the
+// start of the asset, and frame vertex offsets are relative to the start of
+// the frame data object.
 struct FHeader {
     static constexpr size_t Size = 44;
 
@@ -0,0 +1,200 @@
+// Test for the model file format. Emits synthetic models, splits them into pak
+// objects the way the asset packer does, and reads them back the way the game
+// does: using offsets in place, without modifying the data.
+#include "tools/modelconvert/compile.hpp"
+#include "tools/modelconvert/config.hpp"
+#include "tools/modelconvert/mesh.hpp"
+#include "tools/modelconvert/model.hpp"
+#include "tools/modelconvert/synthetic.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <assimp/scene.h>
+#include <fmt/core.h>
+
+namespace modelconvert {
+namespace {
+
+using gbi::Vtx;
+
+constexpr size_t MaterialSlotCount = 4;
+
+class CheckError : public std::runtime_error {
+public:
+    CheckError(const std::string &msg) : runtime_error{msg} {}
+};
+
+// A region of loaded data.
+class Object {
+public:
+    Object(const std::vector<uint8_t> &data, uint32_t offset, uint32_t size) {
+        if (offset > data.size() || size > data.size() - offset) {
+            throw CheckError("object outside file");
+        }
+        m_data.assign(data.begin() + offset, data.begin() + offset + size);
+    }
+
+    size_t size() const { return m_data.size(); }
+
+    // Get the data at the given offset, checking that it is in range.
+    const uint8_t *At(uint32_t offset, size_t size) const {
+        if (offset > m_data.size() || size > m_data.size() - offset) {
+            throw CheckError(fmt::format(
+                "offset {} size {} outside object of size {}", offset, size,
+                m_data.size()));
+        }
+        return m_data.data() + offset;
+    }
+
+    uint32_t U32(uint32_t offset) const {
+        const uint8_t *p = At(offset, 4);
+        return (static_cast<uint32_t>(p[0]) << 24) |
+               (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+private:
+    std::vector<uint8_t> m_data;
+};
+
+uint32_t U32(const std::vector<uint8_t> &data, size_t offset) {
+    return (static_cast<uint32_t>(data.at(offset)) << 24) |
+           (static_cast<uint32_t>(data.at(offset + 1)) << 16) |
+           (static_cast<uint32_t>(data.at(offset + 2)) << 8) |
+           data.at(offset + 3);
+}
+
+// Check that the data at the given offset matches the serialized items.
+template <typename T>
+void CheckData(const Object &obj, uint32_t offset, const std::vector<T> &items,
+               const char *what) {
+    if (offset % 8 != 0) {
+        throw CheckError(
+            fmt::format("{} not aligned: offset {}", what, offset));
+    }
+    const uint8_t *ptr = obj.At(offset, items.size() * T::Size);
+    uint8_t buf[T::Size];
+    for (size_t i = 0; i < items.size(); i++) {
+        items[i].Write(buf);
+        if (std::memcmp(buf, ptr + i * T::Size, T::Size) != 0) {
+            throw CheckError(fmt::format("{} {} does not match", what, i));
+        }
+    }
+}
+
+void CheckModel(const gbi::Model &model, const std::vector<uint8_t> &data) {
+    if (data.size() < 32 || std::memcmp(data.data(), "Model", 5) != 0) {
+        throw CheckError("bad magic");
+    }
+    // Split into pak objects, like the asset packer.
+    const Object mdl{data, U32(data, 16), U32(data, 20)};
+    const Object fdata{data, U32(data, 24), U32(data, 28)};
+
+    // Static vertex data.
+    CheckData(mdl, mdl.U32(0), model.vertex, "vertex");
+
+    // Display lists.
+    for (size_t i = 0; i < MaterialSlotCount; i++) {
+        const uint32_t offset = mdl.U32(4 + 4 * i);
+        const bool used =
+            i < model.command.size() && model.command[i].size() > 1;
+        if (offset == 0) {
+            if (used) {
+                throw CheckError(fmt::format("missing display list {}", i));
+            }
+            continue;
+        }
+        if (!used) {
+            throw CheckError(fmt::format("unexpected display list {}", i));
+        }
+        CheckData(mdl, offset, model.command[i], "command");
+    }
+
+    // Animations and frame data.
+    const uint32_t anim_count = mdl.U32(20);
+    const uint32_t frame_size = mdl.U32(24);
+    if (anim_count != model.animation.size()) {
+        throw CheckError(fmt::format("animation count is {}, expected {}",
+                                     anim_count, model.animation.size()));
+    }
+    if (frame_size != model.vertex.size() * Vtx::Size) {
+        throw CheckError(fmt::format("bad frame size: {}", frame_size));
+    }
+    for (uint32_t i = 0; i < anim_count; i++) {
+        const gbi::Animation &anim = model.animation[i];
+        const uint32_t apos = 28 + 12 * i;
+        const uint32_t frame_count = mdl.U32(apos + 4);
+        const uint32_t frame_offset = mdl.U32(apos + 8);
+        if (frame_count != anim.frame.size()) {
+            throw CheckError(fmt::format("animation {}: bad frame count", i));
+        }
+        for (uint32_t j = 0; j < frame_count; j++) {
+            const uint32_t vtx_offset = mdl.U32(frame_offset + 12 * j + 8);
+            const gbi::FrameData &frame = model.frame.at(anim.frame[j].index);
+            const uint8_t *ptr = fdata.At(vtx_offset, frame_size);
+            for (size_t k = 0; k < frame.pos.size(); k++) {
+                Vtx v = model.vertex[k];
+                v.pos = frame.pos[k].pos;
+                uint8_t buf[Vtx::Size];
+                v.Write(buf);
+                if (std::memcmp(buf, ptr + k * Vtx::Size, Vtx::Size) != 0) {
+                    throw CheckError(fmt::format(
+                        "animation {} frame {}: vertex {} does not match", i,
+                        j, k));
+                }
+            }
+        }
+    }
+}
+
+const SyntheticShape Shapes[] = {
+    SyntheticShape::Grid,
+    SyntheticShape::Sphere,
+    SyntheticShape::Cylinder,
+};
+
+int Main() {
+    int failures = 0, count = 0;
+    for (const SyntheticShape shape : Shapes) {
+        for (int materials = 1; materials <= 5; materials += 2) {
+            count++;
+            SyntheticParams params{};
+            params.shape = shape;
+            params.triangles = 300;
+            params.materials = materials;
+            params.seed = 1;
+            std::unique_ptr<aiScene> scene = GenerateScene(params);
+            Config cfg{};
+            cfg.use_texcoords = true;
+            cfg.use_vertex_colors = true;
+            cfg.texcoord_bits = 11;
+            cfg.scale = 1.0f;
+            cfg.ucode = gbi::Ucode::F3DEX2;
+            cfg.animate = scene->mNumAnimations > 0;
+            try {
+                Mesh mesh = Mesh::Import(cfg, nullptr, scene.get());
+                gbi::Model model = gbi::CompileMesh(mesh, cfg, nullptr);
+                CheckModel(model, model.Emit(cfg));
+            } catch (std::exception &ex) {
+                fmt::print(stderr, "FAIL: shape={} materials={}: {}\n",
+                           SyntheticShapeName(shape), materials, ex.what());
+                failures++;
+            }
+        }
+    }
+    if (failures > 0) {
+        fmt::print(stderr, "{} of {} models failed\n", failures, count);
+        return 1;
+    }
+    fmt::print("{} models passed\n", count);
+    return 0;
+}
+
+} // namespace
+} // namespace modelconvert
+
+int main() {
+    return modelconvert::Main();
+}
@@ -7,7 +7,9 @@
 #include "tools/util/flag.hpp"
 #include "tools/util/quote.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <charconv>
 #include <cmath>
 #include <cstdlib>
 #include <err.h>
@@ -17,6 +19,7 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <fmt/core.h>
+#include <fmt/format.h>
 
 namespace modelconvert {
 namespace {
@@ -42,6 +45,72 @@ public:
     }
 };
 
+class UcodeFlag : public flag::FlagBase {
+    gbi::Ucode *m_ptr;
+
+public:
+    explicit UcodeFlag(gbi::Ucode *ptr) : m_ptr{ptr} {}
+
+    flag::FlagArgument Argument() const override {
+        return flag::FlagArgument::Required;
+    }
+
+    void Parse(std::optional<std::string_view> arg) override {
+        assert(arg.has_value());
+        try {
+            *m_ptr = gbi::UcodeInfo::Parse(*arg);
+        } catch (std::invalid_argument &ex) {
+            std::string msg = fmt::format("invalid microcode: {}", ex.what());
+            throw flag::UsageError(msg);
+        }
+    }
+};
+
+// Flag for a list of materials to pack into a texture atlas.
+class AtlasFlag : public flag::FlagBase {
+    std::vector<int> *m_ptr;
+
+public:
+    explicit AtlasFlag(std::vector<int> *ptr) : m_ptr{ptr} {}
+
+    flag::FlagArgument Argument() const override {
+        return flag::FlagArgument::Required;
+    }
+
+    void Parse(std::optional<std::string_view> arg) override {
+        assert(arg.has_value());
+        std::vector<int> materials;
+        std::string_view s = *arg;
+        while (true) {
+            size_t pos = s.find(',');
+            std::string_view item = s.substr(0, pos);
+            int value;
+            const char *end = item.data() + item.size();
+            std::from_chars_result r = std::from_chars(item.data(), end, value);
+            if (item.empty() || r.ec != std::errc{} || r.ptr != end ||
+                value < 0) {
+                throw flag::UsageError(fmt::format(
+                    "invalid atlas: bad material {}", util::Quote(item)));
+            }
+            if (std::find(materials.begin(), materials.end(), value) !=
+                materials.end()) {
+                throw flag::UsageError(fmt::format(
+                    "invalid atlas: duplicate material {}", value));
+            }
+            materials.push_back(value);
+            if (pos == std::string_view::npos) {
+                break;
+            }
+            s = s.substr(pos + 1);
+        }
+        if (materials.size() < 2) {
+            throw flag::UsageError(
+                "invalid atlas: need at least two materials");
+        }
+        *m_ptr = std::move(materials);
+    }
+};
+
 // Wrapper for std::FILE.
 class File {
     std::FILE *m_file;
@@ -102,6 +171,7 @@ Args ParseArgs(int argc, char **argv) {
     }
     Args args{};
     args.config.texcoord_bits = 11;
+    args.config.ucode = gbi::Ucode::F3DEX2;
     flag::Parser fl;
     fl.AddFlag(flag::String(&args.model), "model", "input model file", "FILE");
     fl.AddFlag(flag::String(&args.output), "output", "output data file",
@@ -125,6 +195,16 @@ Args ParseArgs(int argc, char **argv) {
     fl.AddFlag(AxesFlag(&args.config.axes), "axes",
                "remap axes, default 'x,y,z'", "AXES");
     fl.AddBoolFlag(&args.config.animate, "animate", "convert animations");
+    fl.AddFlag(UcodeFlag(&args.config.ucode), "ucode",
+               "target microcode: f3dex, f3dex2, or f3dex3 (default f3dex2); "
+               "the game can only run f3dex and f3dex2",
+               "UCODE");
+    fl.AddFlag(AtlasFlag(&args.config.atlas), "atlas",
+               "pack the textures for the comma-separated list of materials "
+               "into an atlas",
+               "MATERIALS");
+    fl.AddFlag(flag::Int(&args.config.atlas_cell_size), "atlas-cell-size",
+               "size of each atlas cell in the atlas texture, in texels", "N");
     flag::ProgramArguments prog_args{argc - 1, argv + 1};
     try {
         fl.ParseAll(prog_args);
@@ -138,6 +218,12 @@ Args ParseArgs(int argc, char **argv) {
     if (!args.scale) {
         FailUsage("missing required flag -scale");
     }
+    if (!args.config.atlas.empty() && !args.config.use_texcoords) {
+        FailUsage("-atlas requires -use-texcoords");
+    }
+    if (!args.config.atlas.empty() && args.config.atlas_cell_size < 2) {
+        FailUsage("-atlas requires -atlas-cell-size of at least 2");
+    }
     return args;
 }
 
@@ -190,6 +276,15 @@ void Main(int argc, char **argv) {
         fmt::print(stats, "    Scale: {}\n", cfg.scale);
         fmt::print(stats, "    Axes: {}\n", cfg.axes.ToString());
         fmt::print(stats, "    Animate: {}\n", cfg.animate);
+        {
+            const gbi::UcodeInfo &info = gbi::UcodeInfo::Get(cfg.ucode);
+            fmt::print(stats, "    Microcode: {} (vertex cache: {})\n",
+                       info.name, info.vertex_cache_size);
+        }
+        if (!cfg.atlas.empty()) {
+            fmt::print(stats, "    Atlas: {} (cell size: {})\n",
+                       fmt::join(cfg.atlas, ","), cfg.atlas_cell_size);
+        }
         fmt::print(stats, "\n");
     }
 
@@ -0,0 +1,201 @@
+// Benchmark for the model conversion pipeline, using synthetic meshes.
+#include "tools/modelconvert/compile.hpp"
+#include "tools/modelconvert/config.hpp"
+#include "tools/modelconvert/mesh.hpp"
+#include "tools/modelconvert/model.hpp"
+#include "tools/modelconvert/synthetic.hpp"
+#include "tools/util/flag.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <assimp/scene.h>
+#include <fmt/core.h>
+
+// Number of calls to operator new.
+size_t AllocCount;
+
+void *operator new(size_t size) {
+    AllocCount++;
+    void *ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace modelconvert {
+namespace {
+
+// Triangle counts to benchmark.
+const int TriangleCounts[] = {1000, 5000, 20000, 100000, 500000};
+
+const SyntheticShape Shapes[] = {
+    SyntheticShape::Grid,  SyntheticShape::Sphere,   SyntheticShape::Soup,
+    SyntheticShape::Strip, SyntheticShape::Cylinder,
+};
+
+class ShapeFlag : public flag::FlagBase {
+    std::vector<SyntheticShape> *m_ptr;
+
+public:
+    explicit ShapeFlag(std::vector<SyntheticShape> *ptr) : m_ptr{ptr} {}
+
+    flag::FlagArgument Argument() const override {
+        return flag::FlagArgument::Required;
+    }
+
+    void Parse(std::optional<std::string_view> arg) override {
+        assert(arg.has_value());
+        try {
+            m_ptr->push_back(ParseSyntheticShape(*arg));
+        } catch (std::invalid_argument &ex) {
+            throw flag::UsageError(fmt::format("invalid shape: {}", ex.what()));
+        }
+    }
+};
+
+class UcodeFlag : public flag::FlagBase {
+    gbi::Ucode *m_ptr;
+
+public:
+    explicit UcodeFlag(gbi::Ucode *ptr) : m_ptr{ptr} {}
+
+    flag::FlagArgument Argument() const override {
+        return flag::FlagArgument::Required;
+    }
+
+    void Parse(std::optional<std::string_view> arg) override {
+        assert(arg.has_value());
+        try {
+            *m_ptr = gbi::UcodeInfo::Parse(*arg);
+        } catch (std::invalid_argument &ex) {
+            throw flag::UsageError(
+                fmt::format("invalid microcode: {}", ex.what()));
+        }
+    }
+};
+
+struct Args {
+    std::vector<SyntheticShape> shapes;
+    int min_triangles;
+    int max_triangles;
+    gbi::Ucode ucode;
+};
+
+Args ParseArgs(int argc, char **argv) {
+    Args args{};
+    args.min_triangles = 0;
+    // The compiler is quadratic in the number of triangles, so the largest
+    // sizes take a long time and must be requested explicitly.
+    args.max_triangles = 100000;
+    args.ucode = gbi::Ucode::F3DEX2;
+    flag::Parser fl;
+    fl.AddFlag(ShapeFlag(&args.shapes), "shape",
+               "benchmark this shape, may be repeated (default all)", "SHAPE");
+    fl.AddFlag(flag::Int(&args.min_triangles), "min-triangles",
+               "skip sizes smaller than N triangles", "N");
+    fl.AddFlag(flag::Int(&args.max_triangles), "max-triangles",
+               "skip sizes larger than N triangles (default 100000)", "N");
+    fl.AddFlag(UcodeFlag(&args.ucode), "ucode", "target microcode", "UCODE");
+    flag::ProgramArguments prog_args{argc - 1, argv + 1};
+    try {
+        fl.ParseAll(prog_args);
+    } catch (flag::UsageError &ex) {
+        fmt::print(stderr, "Error: {}\n", ex.what());
+        std::exit(64);
+    }
+    if (args.shapes.empty()) {
+        args.shapes.assign(std::begin(Shapes), std::end(Shapes));
+    }
+    return args;
+}
+
+using Clock = std::chrono::steady_clock;
+
+double Millis(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void Main(int argc, char **argv) {
+    const Args args = ParseArgs(argc, argv);
+    Config cfg{};
+    cfg.use_texcoords = true;
+    cfg.use_vertex_colors = true;
+    cfg.texcoord_bits = 11;
+    cfg.scale = 1.0f;
+    cfg.ucode = args.ucode;
+
+    fmt::print(
+        "{:<8} {:>8} {:>8} {:>8} {:>6} {:>8} {:>10} {:>10} {:>10} {:>10}\n",
+        "shape", "tris", "verts", "dlverts", "reuse", "cmds", "import_ms",
+        "compile_ms", "allocs", "emit_ms");
+    for (const SyntheticShape shape : args.shapes) {
+        for (const int count : TriangleCounts) {
+            if (count < args.min_triangles || count > args.max_triangles) {
+                continue;
+            }
+            SyntheticParams params{};
+            params.shape = shape;
+            params.triangles = count;
+            params.materials = 1;
+            params.seed = 1;
+            std::unique_ptr<aiScene> scene = GenerateScene(params);
+            cfg.animate = scene->mNumAnimations > 0;
+
+            const Clock::time_point t0 = Clock::now();
+            Mesh mesh = Mesh::Import(cfg, nullptr, scene.get());
+            const Clock::time_point t1 = Clock::now();
+            const size_t alloc_start = AllocCount;
+            gbi::Model model = gbi::CompileMesh(mesh, cfg, nullptr);
+            const size_t allocs = AllocCount - alloc_start;
+            const Clock::time_point t2 = Clock::now();
+            std::vector<uint8_t> data = model.Emit(cfg);
+            const Clock::time_point t3 = Clock::now();
+
+            // Vertex reuse ratio: number of triangle corners per vertex loaded
+            // into the cache. Higher is better, and 6 is the ideal for a large
+            // regular grid.
+            size_t cmd_count = 0;
+            for (const std::vector<gbi::Gfx> &dl : model.command) {
+                cmd_count += dl.size();
+            }
+            const size_t tri_count = mesh.triangle.size();
+            const double reuse =
+                model.vertex.empty()
+                    ? 0.0
+                    : 3.0 * tri_count / static_cast<double>(model.vertex.size());
+            fmt::print(
+                "{:<8} {:>8} {:>8} {:>8} {:>6.2f} {:>8} {:>10.2f} {:>10.2f} "
+                "{:>10} {:>10.2f}\n",
+                SyntheticShapeName(shape), tri_count, mesh.vertex.size(),
+                model.vertex.size(), reuse, cmd_count, Millis(t0, t1),
+                Millis(t1, t2), allocs, Millis(t2, t3));
+            std::fflush(stdout);
+        }
+    }
+}
+
+} // namespace
+} // namespace modelconvert
+
+int main(int argc, char **argv) {
+    modelconvert::Main(argc, argv);
+    return 0;
+}
@@ -0,0 +1,458 @@
+#include "tools/modelconvert/synthetic.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <assimp/scene.h>
+
+namespace modelconvert {
+
+namespace {
+
+constexpr float Pi = 3.14159265358979323846f;
+
+const std::string_view ShapeNames[] = {
+    "grid", "sphere", "soup", "strip", "cylinder",
+};
+
+// A vertex which is influenced by up to two bones.
+struct SVertex {
+    aiVector3D pos;
+    aiVector3D normal;
+    aiVector3D texcoord;
+    aiColor4D color;
+    std::array<int, 2> bone;
+    std::array<float, 2> weight;
+};
+
+// A bone in a chain of bones. Each bone is a child of the previous bone.
+struct SBone {
+    std::string name;
+    aiVector3D offset; // Position relative to parent.
+    aiVector3D pos;    // Position in mesh space.
+};
+
+// Builds an AssImp scene from a list of vertexes and triangles.
+class SceneBuilder {
+public:
+    explicit SceneBuilder(uint32_t seed) : m_rand{seed} {}
+
+    // Add a vertex and return its index. The vertex is given a random color.
+    int AddVertex(aiVector3D pos, aiVector3D normal, aiVector3D texcoord) {
+        std::uniform_real_distribution<float> dist{0.0f, 1.0f};
+        SVertex v{};
+        v.pos = pos;
+        v.normal = normal;
+        v.texcoord = texcoord;
+        v.color = aiColor4D(dist(m_rand), dist(m_rand), dist(m_rand), 1.0f);
+        v.bone = {{-1, -1}};
+        int index = m_vertex.size();
+        m_vertex.push_back(v);
+        return index;
+    }
+
+    // Add a triangle.
+    void AddTriangle(int v0, int v1, int v2) {
+        m_triangle.push_back({{v0, v1, v2}});
+    }
+
+    // Add a quad, as two triangles.
+    void AddQuad(int v0, int v1, int v2, int v3) {
+        AddTriangle(v0, v1, v2);
+        AddTriangle(v0, v2, v3);
+    }
+
+    // Add a bone to the end of the bone chain.
+    void AddBone(aiVector3D offset) {
+        SBone b{};
+        b.name = "bone" + std::to_string(m_bone.size());
+        b.offset = offset;
+        b.pos = m_bone.empty() ? offset : m_bone.back().pos + offset;
+        m_bone.push_back(std::move(b));
+    }
+
+    // Bind a vertex to one or two bones.
+    void BindVertex(int vertex, int bone0, int bone1, float weight1) {
+        SVertex &v = m_vertex.at(vertex);
+        if (bone0 == bone1 || weight1 <= 0.0f) {
+            v.bone = {{bone0, -1}};
+            v.weight = {{1.0f, 0.0f}};
+        } else {
+            v.bone = {{bone0, bone1}};
+            v.weight = {{1.0f - weight1, weight1}};
+        }
+    }
+
+    std::mt19937 &rand() { return m_rand; }
+    const std::vector<SBone> &bone() const { return m_bone; }
+
+    // Create the scene, with the triangles split round-robin into the given
+    // number of materials.
+    std::unique_ptr<aiScene> Build(int materials) const;
+
+private:
+    aiMesh *BuildMesh(int material, int material_count) const;
+
+    std::mt19937 m_rand;
+    std::vector<SVertex> m_vertex;
+    std::vector<std::array<int, 3>> m_triangle;
+    std::vector<SBone> m_bone;
+};
+
+// Allocate an array which AssImp will free with delete[].
+template <typename T>
+T *NewArray(size_t n) {
+    return n == 0 ? nullptr : new T[n];
+}
+
+std::unique_ptr<aiScene> SceneBuilder::Build(int materials) const {
+    if (materials < 1) {
+        throw std::invalid_argument("GenerateScene: need at least 1 material");
+    }
+    std::unique_ptr<aiScene> scene = std::make_unique<aiScene>();
+
+    scene->mNumMaterials = materials;
+    scene->mMaterials = NewArray<aiMaterial *>(materials);
+    for (int i = 0; i < materials; i++) {
+        scene->mMaterials[i] = new aiMaterial();
+    }
+
+    scene->mNumMeshes = materials;
+    scene->mMeshes = NewArray<aiMesh *>(materials);
+    for (int i = 0; i < materials; i++) {
+        scene->mMeshes[i] = BuildMesh(i, materials);
+    }
+
+    // The root node holds the meshes, and its child is the first bone.
+    aiNode *root = new aiNode("root");
+    root->mNumMeshes = materials;
+    root->mMeshes = NewArray<unsigned>(materials);
+    for (int i = 0; i < materials; i++) {
+        root->mMeshes[i] = i;
+    }
+    aiNode *parent = root;
+    for (const SBone &b : m_bone) {
+        aiNode *node = new aiNode(b.name);
+        aiMatrix4x4::Translation(b.offset, node->mTransformation);
+        node->mParent = parent;
+        parent->mNumChildren = 1;
+        parent->mChildren = NewArray<aiNode *>(1);
+        parent->mChildren[0] = node;
+        parent = node;
+    }
+    scene->mRootNode = root;
+    return scene;
+}
+
+aiMesh *SceneBuilder::BuildMesh(int material, int material_count) const {
+    // Find the vertexes used by this material.
+    std::vector<int> vertex_map(m_vertex.size(), -1);
+    std::vector<int> vertexes;
+    size_t tri_count = 0;
+    for (size_t i = material; i < m_triangle.size(); i += material_count) {
+        for (const int v : m_triangle[i]) {
+            if (vertex_map[v] == -1) {
+                vertex_map[v] = vertexes.size();
+                vertexes.push_back(v);
+            }
+        }
+        tri_count++;
+    }
+
+    aiMesh *mesh = new aiMesh();
+    mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+    mesh->mMaterialIndex = material;
+    const unsigned nvert = vertexes.size();
+    mesh->mNumVertices = nvert;
+    mesh->mVertices = NewArray<aiVector3D>(nvert);
+    mesh->mNormals = NewArray<aiVector3D>(nvert);
+    mesh->mTextureCoords[0] = NewArray<aiVector3D>(nvert);
+    mesh->mNumUVComponents[0] = 2;
+    mesh->mColors[0] = NewArray<aiColor4D>(nvert);
+    for (unsigned i = 0; i < nvert; i++) {
+        const SVertex &v = m_vertex[vertexes[i]];
+        mesh->mVertices[i] = v.pos;
+        mesh->mNormals[i] = v.normal;
+        mesh->mTextureCoords[0][i] = v.texcoord;
+        mesh->mColors[0][i] = v.color;
+    }
+
+    mesh->mNumFaces = tri_count;
+    mesh->mFaces = NewArray<aiFace>(tri_count);
+    aiFace *face = mesh->mFaces;
+    for (size_t i = material; i < m_triangle.size(); i += material_count) {
+        face->mNumIndices = 3;
+        face->mIndices = NewArray<unsigned>(3);
+        for (int j = 0; j < 3; j++) {
+            face->mIndices[j] = vertex_map[m_triangle[i][j]];
+        }
+        face++;
+    }
+
+    if (!m_bone.empty()) {
+        const unsigned nbone = m_bone.size();
+        mesh->mNumBones = nbone;
+        mesh->mBones = NewArray<aiBone *>(nbone);
+        for (unsigned b = 0; b < nbone; b++) {
+            std::vector<aiVertexWeight> weights;
+            for (unsigned i = 0; i < nvert; i++) {
+                const SVertex &v = m_vertex[vertexes[i]];
+                for (int j = 0; j < 2; j++) {
+                    if (v.bone[j] == static_cast<int>(b)) {
+                        weights.emplace_back(i, v.weight[j]);
+                    }
+                }
+            }
+            aiBone *bone = new aiBone();
+            bone->mName = aiString(m_bone[b].name);
+            aiMatrix4x4::Translation(-m_bone[b].pos, bone->mOffsetMatrix);
+            bone->mNumWeights = weights.size();
+            bone->mWeights = NewArray<aiVertexWeight>(weights.size());
+            std::copy(weights.begin(), weights.end(), bone->mWeights);
+            mesh->mBones[b] = bone;
+        }
+    }
+
+    return mesh;
+}
+
+// =============================================================================
+
+void MakeGrid(SceneBuilder *sb, int triangles) {
+    const int n = std::max(1, static_cast<int>(std::lrint(
+                                  std::sqrt(triangles * 0.5))));
+    constexpr float spacing = 16.0f;
+    const aiVector3D normal{0.0f, 0.0f, 1.0f};
+    std::vector<int> idx;
+    for (int y = 0; y <= n; y++) {
+        for (int x = 0; x <= n; x++) {
+            idx.push_back(sb->AddVertex(
+                aiVector3D((x - n / 2) * spacing, (y - n / 2) * spacing, 0.0f),
+                normal,
+                aiVector3D(static_cast<float>(x) / n,
+                           static_cast<float>(y) / n, 0.0f)));
+        }
+    }
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            const int i = y * (n + 1) + x;
+            sb->AddQuad(idx[i], idx[i + 1], idx[i + n + 2], idx[i + n + 1]);
+        }
+    }
+}
+
+void MakeSphere(SceneBuilder *sb, int triangles) {
+    // Each of the 8 faces of the octahedron is divided into n*n triangles.
+    const int n = std::max(1, static_cast<int>(std::lrint(
+                                  std::sqrt(triangles / 8.0))));
+    constexpr float radius = 8000.0f;
+    const aiVector3D axes[3] = {
+        {1.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f},
+    };
+    for (int face = 0; face < 8; face++) {
+        const aiVector3D a = axes[0] * ((face & 1) ? -1.0f : 1.0f),
+                         b = axes[1] * ((face & 2) ? -1.0f : 1.0f),
+                         c = axes[2] * ((face & 4) ? -1.0f : 1.0f);
+        // Flip winding for faces with an odd number of negative axes.
+        const bool flip = ((face ^ (face >> 1) ^ (face >> 2)) & 1) != 0;
+        // Vertex (i, j) is at a + (b - a) * i / n + (c - a) * j / n.
+        std::vector<int> idx;
+        for (int j = 0; j <= n; j++) {
+            for (int i = 0; i + j <= n; i++) {
+                aiVector3D p = a + (b - a) * (static_cast<float>(i) / n) +
+                               (c - a) * (static_cast<float>(j) / n);
+                p.Normalize();
+                float u = 0.5f + std::atan2(p.y, p.x) / (2.0f * Pi);
+                float v = 0.5f - std::asin(p.z) / Pi;
+                idx.push_back(
+                    sb->AddVertex(p * radius, p, aiVector3D(u, v, 0.0f)));
+            }
+        }
+        // Index of vertex (i, j) in idx.
+        auto at = [n, &idx](int i, int j) {
+            return idx[j * (n + 1) - j * (j - 1) / 2 + i];
+        };
+        auto add = [sb, flip](int v0, int v1, int v2) {
+            if (flip) {
+                sb->AddTriangle(v0, v2, v1);
+            } else {
+                sb->AddTriangle(v0, v1, v2);
+            }
+        };
+        for (int j = 0; j < n; j++) {
+            for (int i = 0; i + j < n; i++) {
+                add(at(i, j), at(i + 1, j), at(i, j + 1));
+                if (i + j + 1 < n) {
+                    add(at(i + 1, j), at(i + 1, j + 1), at(i, j + 1));
+                }
+            }
+        }
+    }
+}
+
+void MakeSoup(SceneBuilder *sb, int triangles) {
+    std::uniform_real_distribution<float> center{-16000.0f, 16000.0f};
+    std::uniform_real_distribution<float> offset{-100.0f, 100.0f};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+    for (int i = 0; i < std::max(1, triangles); i++) {
+        const aiVector3D c{center(sb->rand()), center(sb->rand()),
+                           center(sb->rand())};
+        int v[3];
+        for (int j = 0; j < 3; j++) {
+            aiVector3D p = c + aiVector3D(offset(sb->rand()),
+                                          offset(sb->rand()),
+                                          offset(sb->rand()));
+            aiVector3D normal = p - c;
+            normal.Normalize();
+            v[j] = sb->AddVertex(
+                p, normal, aiVector3D(unit(sb->rand()), unit(sb->rand()), 0));
+        }
+        sb->AddTriangle(v[0], v[1], v[2]);
+    }
+}
+
+void MakeStrip(SceneBuilder *sb, int triangles) {
+    // The strip follows a helix, so very long strips still fit in the range of
+    // a 16-bit vertex position.
+    const int n = std::max(1, triangles / 2);
+    constexpr float radius = 8000.0f, step = 4.0f, pitch = 200.0f,
+                    width = 3.0f;
+    std::vector<int> idx;
+    for (int i = 0; i <= n; i++) {
+        const float angle = i * step / radius;
+        const float z = pitch * angle / (2.0f * Pi);
+        const aiVector3D normal{std::cos(angle), std::sin(angle), 0.0f};
+        const aiVector3D center = normal * radius;
+        const float u = static_cast<float>(i) / n;
+        for (int j = 0; j < 2; j++) {
+            idx.push_back(sb->AddVertex(center + aiVector3D(0, 0, z + j * width),
+                                        normal, aiVector3D(u, j, 0)));
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        sb->AddQuad(idx[i * 2], idx[i * 2 + 2], idx[i * 2 + 3],
+                    idx[i * 2 + 1]);
+    }
+}
+
+void MakeCylinder(SceneBuilder *sb, int triangles) {
+    constexpr int segments = 32, bones = 4;
+    constexpr float radius = 1000.0f, height = 16000.0f;
+    const int rings = std::max(1, triangles / (2 * segments));
+    const float bone_length = height / bones;
+    for (int i = 0; i < bones; i++) {
+        sb->AddBone(aiVector3D(0.0f, 0.0f, i == 0 ? 0.0f : bone_length));
+    }
+    std::vector<int> idx;
+    for (int r = 0; r <= rings; r++) {
+        const float z = height * r / rings;
+        // Blend between the two nearest bones.
+        const float bpos = std::min(z / bone_length, bones - 1.0f);
+        const int bone0 = static_cast<int>(bpos);
+        const int bone1 = std::min(bone0 + 1, bones - 1);
+        for (int s = 0; s <= segments; s++) {
+            const float angle = 2.0f * Pi * s / segments;
+            const aiVector3D normal{std::cos(angle), std::sin(angle), 0.0f};
+            int v = sb->AddVertex(
+                normal * radius + aiVector3D(0.0f, 0.0f, z), normal,
+                aiVector3D(static_cast<float>(s) / segments,
+                           static_cast<float>(r) / rings, 0.0f));
+            sb->BindVertex(v, bone0, bone1, bpos - bone0);
+            idx.push_back(v);
+        }
+    }
+    for (int r = 0; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            const int i = r * (segments + 1) + s;
+            sb->AddQuad(idx[i], idx[i + 1], idx[i + segments + 2],
+                        idx[i + segments + 1]);
+        }
+    }
+}
+
+// Add a bending animation to a scene with a chain of bones.
+void AddBendAnimation(aiScene *scene, const std::vector<SBone> &bones) {
+    constexpr int frames = 9;
+    aiAnimation *anim = new aiAnimation();
+    anim->mName = aiString("bend");
+    anim->mDuration = frames - 1;
+    anim->mTicksPerSecond = frames - 1;
+    anim->mNumChannels = bones.size();
+    anim->mChannels = NewArray<aiNodeAnim *>(bones.size());
+    for (size_t b = 0; b < bones.size(); b++) {
+        aiNodeAnim *chan = new aiNodeAnim();
+        chan->mNodeName = aiString(bones[b].name);
+        chan->mNumPositionKeys = 1;
+        chan->mPositionKeys = NewArray<aiVectorKey>(1);
+        chan->mPositionKeys[0].mTime = 0.0;
+        chan->mPositionKeys[0].mValue = bones[b].offset;
+        chan->mNumRotationKeys = frames;
+        chan->mRotationKeys = NewArray<aiQuatKey>(frames);
+        for (int i = 0; i < frames; i++) {
+            const float angle = 0.3f * std::sin(2.0f * Pi * i / (frames - 1));
+            chan->mRotationKeys[i].mTime = i;
+            chan->mRotationKeys[i].mValue =
+                aiQuaternion(aiVector3D(1.0f, 0.0f, 0.0f), angle);
+        }
+        anim->mChannels[b] = chan;
+    }
+    scene->mNumAnimations = 1;
+    scene->mAnimations = NewArray<aiAnimation *>(1);
+    scene->mAnimations[0] = anim;
+}
+
+} // namespace
+
+std::string_view SyntheticShapeName(SyntheticShape shape) {
+    size_t index = static_cast<size_t>(shape);
+    if (index >= std::size(ShapeNames)) {
+        throw std::invalid_argument("SyntheticShapeName: unknown shape");
+    }
+    return ShapeNames[index];
+}
+
+SyntheticShape ParseSyntheticShape(std::string_view name) {
+    for (size_t i = 0; i < std::size(ShapeNames); i++) {
+        if (name == ShapeNames[i]) {
+            return static_cast<SyntheticShape>(i);
+        }
+    }
+    throw std::invalid_argument("unknown shape");
+}
+
+std::unique_ptr<aiScene> GenerateScene(const SyntheticParams &params) {
+    SceneBuilder sb{params.seed};
+    switch (params.shape) {
+    case SyntheticShape::Grid:
+        MakeGrid(&sb, params.triangles);
+        break;
+    case SyntheticShape::Sphere:
+        MakeSphere(&sb, params.triangles);
+        break;
+    case SyntheticShape::Soup:
+        MakeSoup(&sb, params.triangles);
+        break;
+    case SyntheticShape::Strip:
+        MakeStrip(&sb, params.triangles);
+        break;
+    case SyntheticShape::Cylinder:
+        MakeCylinder(&sb, params.triangles);
+        break;
+    default:
+        throw std::invalid_argument("GenerateScene: unknown shape");
+    }
+    std::unique_ptr<aiScene> scene = sb.Build(params.materials);
+    if (!sb.bone().empty()) {
+        AddBendAnimation(scene.get(), sb.bone());
+    }
+    return scene;
+}
+
+} // namespace modelconvert
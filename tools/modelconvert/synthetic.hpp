@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+struct aiScene;
+
+namespace modelconvert {
+
+// Shapes which can be generated procedurally, for testing and benchmarking.
+enum class SyntheticShape {
+    // Flat grid of quads, each split into two triangles.
+    Grid,
+    // Sphere made by subdividing the faces of an octahedron.
+    Sphere,
+    // Triangles with random vertexes and no shared vertexes.
+    Soup,
+    // Long strip of quads, one quad wide.
+    Strip,
+    // Cylinder skinned to a chain of bones, with a bending animation.
+    Cylinder,
+};
+
+// Parameters for generating a synthetic mesh.
+struct SyntheticParams {
+    SyntheticShape shape;
+
+    // Approximate number of triangles to generate.
+    int triangles;
+
+    // Number of materials. Triangles are assigned to materials round-robin,
+    // with one AssImp mesh per material.
+    int materials;
+
+    // Seed for the random number generator. Only used by shapes with random
+    // data, and for the vertex colors.
+    uint32_t seed;
+};
+
+// Get the name of a shape.
+std::string_view SyntheticShapeName(SyntheticShape shape);
+
+// Parse the name of a shape. Throws std::invalid_argument on failure.
+SyntheticShape ParseSyntheticShape(std::string_view name);
+
+// Generate a scene containing a synthetic mesh, without reading any files.
+// The mesh has positions, normals, texture coordinates, and vertex colors.
+// Only the Cylinder shape has bones and animations.
+std::unique_ptr<aiScene> GenerateScene(const SyntheticParams &params);
+
+} // namespace modelconvert
@@ -7,8 +7,9 @@
 namespace modelconvert {
 namespace gbi {
 
-uint32_t VertexCache::HashPos::operator()(
-    const std::array<int16_t, 3> &p) const {
+namespace {
+
+uint32_t HashPos(const std::array<int16_t, 3> &p) {
     util::Murmur3 h = util::Murmur3::Initial(0);
     h.Update(p[0]);
     h.Update(p[1]);
@@ -16,7 +17,22 @@ uint32_t VertexCache::HashPos::operator()(
     return h.Hash();
 }
 
-VertexCache::VertexCache(unsigned size) : m_entries(size, Entry{}) {}
+unsigned PosTableSize(unsigned cache_size) {
+    unsigned size = 1;
+    while (size < cache_size * 2) {
+        size <<= 1;
+    }
+    return size;
+}
+
+const int16_t EmptySlot = -1;
+
+} // namespace
+
+VertexCache::VertexCache(unsigned size)
+    : m_entries(size, Entry{}),
+      m_pos(PosTableSize(size), PosEntry{{{0, 0, 0}}, EmptySlot}),
+      m_pos_mask{PosTableSize(size) - 1} {}
 
 const Vtx *VertexCache::Get(int cache_slot) const {
     if (cache_slot < 0 || cache_slot >= size()) {
@@ -35,11 +51,7 @@ Vtx *VertexCache::Get(int cache_slot) {
 }
 
 int VertexCache::CachePos(std::array<int16_t, 3> pos) const {
-    auto it = m_pos.find(pos);
-    if (it == m_pos.end()) {
-        return -1;
-    }
-    return it->second;
+    return m_pos[FindPos(pos)].slot;
 }
 
 void VertexCache::Erase(int cache_slot) {
@@ -53,7 +65,9 @@ void VertexCache::Clear() {
     for (Entry &e : m_entries) {
         e.valid = false;
     }
-    m_pos.clear();
+    for (PosEntry &p : m_pos) {
+        p.slot = EmptySlot;
+    }
 }
 
 void VertexCache::Set(int cache_slot, const Vtx &v) {
@@ -62,20 +76,47 @@ void VertexCache::Set(int cache_slot, const Vtx &v) {
     }
     Entry &e = m_entries.at(cache_slot);
     EraseEntry(cache_slot, e);
-    m_pos[v.pos] = cache_slot;
+    PosEntry &p = m_pos[FindPos(v.pos)];
+    p.pos = v.pos;
+    p.slot = cache_slot;
     e.valid = true;
     e.vertex = v;
 }
 
 void VertexCache::EraseEntry(int cache_slot, Entry &e) {
     if (e.valid) {
-        auto it = m_pos.find(e.vertex.pos);
-        if (it != m_pos.end() && it->second == cache_slot) {
-            m_pos.erase(it);
+        unsigned index = FindPos(e.vertex.pos);
+        if (m_pos[index].slot == cache_slot) {
+            ErasePos(index);
         }
         e.valid = false;
     }
 }
 
+unsigned VertexCache::FindPos(const std::array<int16_t, 3> &pos) const {
+    unsigned index = HashPos(pos) & m_pos_mask;
+    while (m_pos[index].slot != EmptySlot && m_pos[index].pos != pos) {
+        index = (index + 1) & m_pos_mask;
+    }
+    return index;
+}
+
+void VertexCache::ErasePos(unsigned index) {
+    // Backward shift deletion: move later entries in the probe sequence into
+    // the hole, so lookups never need tombstones.
+    unsigned hole = index;
+    unsigned next = (hole + 1) & m_pos_mask;
+    while (m_pos[next].slot != EmptySlot) {
+        unsigned home = HashPos(m_pos[next].pos) & m_pos_mask;
+        // Move the entry if its home is not cyclically in (hole, next].
+        if (((next - home) & m_pos_mask) >= ((next - hole) & m_pos_mask)) {
+            m_pos[hole] = m_pos[next];
+            hole = next;
+        }
+        next = (next + 1) & m_pos_mask;
+    }
+    m_pos[hole].slot = EmptySlot;
+}
+
 } // namespace gbi
 } // namespace modelconvert
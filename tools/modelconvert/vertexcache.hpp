@@ -4,7 +4,6 @@
 
 #include <array>
 #include <cstdint>
-#include <unordered_map>
 #include <vector>
 
 namespace modelconvert {
@@ -38,17 +37,30 @@ public:
 private:
     void EraseEntry(int cache_slot, Entry &e);
 
+    // Find the index of a position in the position table, or the index of the
+    // empty entry where it would be inserted.
+    unsigned FindPos(const std::array<int16_t, 3> &pos) const;
+
+    // Remove an entry from the position table.
+    void ErasePos(unsigned index);
+
     struct Entry {
         bool valid;
         Vtx vertex;
     };
 
-    struct HashPos {
-        uint32_t operator()(const std::array<int16_t, 3> &p) const;
+    struct PosEntry {
+        std::array<int16_t, 3> pos;
+        int16_t slot; // -1 if empty.
     };
 
     std::vector<Entry> m_entries;
-    std::unordered_map<std::array<int16_t, 3>, int, HashPos> m_pos;
+
+    // Open-addressing hash table with linear probing, mapping positions to
+    // cache slots. The capacity is a power of two, at least twice the cache
+    // size, so it never fills up and never needs to grow.
+    std::vector<PosEntry> m_pos;
+    unsigned m_pos_mask;
 };
 
 } // namespace gbi
@@ -0,0 +1,60 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"os"
+
+	"thornmarked/tools/getpath"
+	"thornmarked/tools/paktrace/trace"
+)
+
+func mainE() error {
+	pairsFlag := flag.Int("pairs", 10, "number of co-loaded pairs to show")
+	flag.Parse()
+	args := flag.Args()
+	if len(args) == 0 {
+		fmt.Fprint(os.Stderr,
+			"Usage:\n"+
+				"  paktrace [-pairs=<n>] <trace> ...\n")
+		os.Exit(1)
+	}
+	var traces []*trace.Trace
+	var loads, dropped int
+	objects := make(map[int]int)
+	for _, arg := range args {
+		t, err := trace.ReadFile(getpath.GetPath(arg))
+		if err != nil {
+			return err
+		}
+		fmt.Printf("%s: %d loads, %d dropped\n", arg, len(t.Objects), t.Dropped)
+		traces = append(traces, t)
+		loads += len(t.Objects)
+		dropped += t.Dropped
+		for _, obj := range t.Objects {
+			objects[obj]++
+		}
+	}
+	if dropped != 0 {
+		fmt.Fprintf(os.Stderr, "Warning: %d loads were dropped\n", dropped)
+	}
+	fmt.Printf("Total: %d loads of %d objects\n", loads, len(objects))
+	pairs := trace.Pairs(traces)
+	if len(pairs) > *pairsFlag {
+		pairs = pairs[:*pairsFlag]
+	}
+	if len(pairs) > 0 {
+		fmt.Println("Most frequently co-loaded:")
+		for _, p := range pairs {
+			fmt.Printf("  %5d -> %5d  %d\n", p.First, p.Second, p.Count)
+		}
+	}
+	return nil
+}
+
+func main() {
+	if err := mainE(); err != nil {
+		fmt.Fprintln(os.Stderr, "Error:", err)
+		os.Exit(1)
+	}
+}
@@ -0,0 +1,243 @@
+// Package trace reads pak load traces, and uses them to choose the order of
+// objects in a pak file.
+//
+// A trace is recorded by base/pak/trace.c. It can be read from a memory dump,
+// which contains the trace buffer, or from text with lines like
+// "paktrace: 12 13 40", which is easier to write by hand.
+package trace
+
+import (
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io/ioutil"
+	"sort"
+	"strconv"
+	"strings"
+)
+
+// Magic at the start of the trace buffer, struct pak_trace.
+const magic = "PAKTRACE"
+
+// Capacity of the trace buffer, PAK_TRACE_SIZE.
+const capacity = 2048
+
+// A Trace is a sequence of loads from a pak.
+type Trace struct {
+	Objects []int // Object ID for each load.
+	Dropped int   // Number of loads which were not recorded.
+}
+
+// Parse parses a trace from a memory dump or console text.
+func Parse(data []byte) (*Trace, error) {
+	if i := bytes.Index(data, []byte(magic)); i != -1 {
+		return parseBinary(data[i+len(magic):])
+	}
+	return parseText(data)
+}
+
+// ReadFile reads a trace from a file.
+func ReadFile(name string) (*Trace, error) {
+	data, err := ioutil.ReadFile(name)
+	if err != nil {
+		return nil, err
+	}
+	t, err := Parse(data)
+	if err != nil {
+		return nil, fmt.Errorf("%s: %v", name, err)
+	}
+	return t, nil
+}
+
+// parseBinary parses the trace buffer, after the magic. The Nintendo 64 is
+// big-endian.
+func parseBinary(data []byte) (*Trace, error) {
+	if len(data) < 8 {
+		return nil, errors.New("trace buffer is truncated")
+	}
+	count := binary.BigEndian.Uint32(data)
+	dropped := binary.BigEndian.Uint32(data[4:])
+	if count > capacity {
+		return nil, fmt.Errorf("bad trace count: %d", count)
+	}
+	data = data[8:]
+	if len(data) < int(count)*2 {
+		return nil, errors.New("trace buffer is truncated")
+	}
+	t := &Trace{
+		Objects: make([]int, count),
+		Dropped: int(dropped),
+	}
+	for i := range t.Objects {
+		t.Objects[i] = int(binary.BigEndian.Uint16(data[i*2:]))
+	}
+	return t, nil
+}
+
+// parseText parses the trace from console text. Lines without the trace
+// prefix are ignored.
+func parseText(data []byte) (*Trace, error) {
+	const prefix = "paktrace:"
+	t := new(Trace)
+	var found bool
+	for lineno, line := range strings.Split(string(data), "\n") {
+		i := strings.Index(line, prefix)
+		if i == -1 {
+			continue
+		}
+		found = true
+		fields := strings.Fields(line[i+len(prefix):])
+		if len(fields) == 2 && fields[0] == "dropped" {
+			n, err := strconv.Atoi(fields[1])
+			if err != nil {
+				return nil, fmt.Errorf("line %d: %v", lineno+1, err)
+			}
+			t.Dropped += n
+			continue
+		}
+		for _, f := range fields {
+			n, err := strconv.Atoi(f)
+			if err != nil || n < 1 || n > 0xffff {
+				return nil, fmt.Errorf("line %d: invalid object: %q", lineno+1, f)
+			}
+			t.Objects = append(t.Objects, n)
+		}
+	}
+	if !found {
+		return nil, errors.New("no trace found")
+	}
+	return t, nil
+}
+
+// A Pair is two different objects which were loaded one after the other.
+type Pair struct {
+	First, Second int
+	Count         int // Number of times loaded together.
+}
+
+// Pairs returns the pairs of objects loaded one after the other, sorted by
+// decreasing count. Ties are ordered by first occurrence.
+func Pairs(traces []*Trace) []Pair {
+	index := make(map[[2]int]int)
+	var pairs []Pair
+	for _, t := range traces {
+		for i := 1; i < len(t.Objects); i++ {
+			a, b := t.Objects[i-1], t.Objects[i]
+			if a == b {
+				continue
+			}
+			k := [2]int{a, b}
+			j, ok := index[k]
+			if !ok {
+				j = len(pairs)
+				index[k] = j
+				pairs = append(pairs, Pair{First: a, Second: b})
+			}
+			pairs[j].Count++
+		}
+	}
+	sort.SliceStable(pairs, func(i, j int) bool {
+		return pairs[i].Count > pairs[j].Count
+	})
+	return pairs
+}
+
+// Requests returns the number of DMA requests needed to perform the loads in
+// the traces, if loads of objects which are next to each other in the given
+// order are coalesced when they are loaded one after the other. Objects which
+// are not in the order are loaded with their own request.
+//
+// This is a bound, not a prediction. The runtime only coalesces loads made
+// together with pak_load_batch, and loads made one at a time each take a
+// request however the objects are ordered.
+func Requests(order []int, traces []*Trace) int {
+	pos := make(map[int]int, len(order))
+	for i, obj := range order {
+		pos[obj] = i
+	}
+	var n int
+	for _, t := range traces {
+		for i, obj := range t.Objects {
+			if i > 0 {
+				p, ok1 := pos[t.Objects[i-1]]
+				q, ok2 := pos[obj]
+				if ok1 && ok2 && q == p+1 {
+					continue
+				}
+			}
+			n++
+		}
+	}
+	return n
+}
+
+// Optimize reorders objects so that objects which are frequently loaded one
+// after the other are next to each other. The pairs with the highest count
+// are joined into chains first, as long as each object has at most one
+// neighbor on each side, and no cycle is formed. Chains are placed at the
+// position of the earliest object in the original order, which keeps objects
+// missing from the traces in their original order.
+func Optimize(order []int, traces []*Trace) []int {
+	inOrder := make(map[int]bool, len(order))
+	for _, obj := range order {
+		inOrder[obj] = true
+	}
+	next := make(map[int]int)
+	prev := make(map[int]int)
+	// Chain head for each object, for detecting cycles.
+	chain := make(map[int]int)
+	head := func(obj int) int {
+		for {
+			h, ok := chain[obj]
+			if !ok || h == obj {
+				return obj
+			}
+			obj = h
+		}
+	}
+	for _, p := range Pairs(traces) {
+		a, b := p.First, p.Second
+		if !inOrder[a] || !inOrder[b] {
+			continue
+		}
+		if _, ok := next[a]; ok {
+			continue
+		}
+		if _, ok := prev[b]; ok {
+			continue
+		}
+		ha, hb := head(a), head(b)
+		if ha == hb {
+			continue
+		}
+		next[a] = b
+		prev[b] = a
+		chain[hb] = ha
+	}
+	result := make([]int, 0, len(order))
+	done := make(map[int]bool, len(order))
+	for _, obj := range order {
+		if done[obj] {
+			continue
+		}
+		// Emit the whole chain containing this object, from its start.
+		for {
+			p, ok := prev[obj]
+			if !ok {
+				break
+			}
+			obj = p
+		}
+		for {
+			result = append(result, obj)
+			done[obj] = true
+			n, ok := next[obj]
+			if !ok {
+				break
+			}
+			obj = n
+		}
+	}
+	return result
+}
@@ -0,0 +1,82 @@
+package trace
+
+import (
+	"encoding/binary"
+	"reflect"
+	"testing"
+)
+
+func TestParseText(t *testing.T) {
+	const text = "Some other output\n" +
+		"paktrace: 3 4 5\n" +
+		"paktrace: 9\n" +
+		"paktrace: dropped 2\n"
+	tr, err := Parse([]byte(text))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if want := []int{3, 4, 5, 9}; !reflect.DeepEqual(tr.Objects, want) {
+		t.Errorf("objects: got %v, want %v", tr.Objects, want)
+	}
+	if tr.Dropped != 2 {
+		t.Errorf("dropped: got %d, want 2", tr.Dropped)
+	}
+	if _, err := Parse([]byte("paktrace: 3 x\n")); err == nil {
+		t.Error("bad object: no error")
+	}
+	if _, err := Parse([]byte("nothing here\n")); err == nil {
+		t.Error("no trace: no error")
+	}
+}
+
+func TestParseBinary(t *testing.T) {
+	// Trace buffer in the middle of a memory dump.
+	data := make([]byte, 100)
+	data = append(data, magic...)
+	var hdr [8]byte
+	binary.BigEndian.PutUint32(hdr[:], 3)
+	binary.BigEndian.PutUint32(hdr[4:], 7)
+	data = append(data, hdr[:]...)
+	for _, obj := range []uint16{10, 2, 300, 0} {
+		var b [2]byte
+		binary.BigEndian.PutUint16(b[:], obj)
+		data = append(data, b[:]...)
+	}
+	tr, err := Parse(data)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if want := []int{10, 2, 300}; !reflect.DeepEqual(tr.Objects, want) {
+		t.Errorf("objects: got %v, want %v", tr.Objects, want)
+	}
+	if tr.Dropped != 7 {
+		t.Errorf("dropped: got %d, want 7", tr.Dropped)
+	}
+	if _, err := Parse(data[:len(data)-6]); err == nil {
+		t.Error("truncated: no error")
+	}
+}
+
+func TestOptimize(t *testing.T) {
+	order := []int{1, 2, 3, 4, 5, 6, 7}
+	traces := []*Trace{
+		{Objects: []int{6, 2, 4}},
+		{Objects: []int{6, 2, 4, 7}},
+		// Would form a cycle.
+		{Objects: []int{4, 6}},
+		// Not in the order.
+		{Objects: []int{20, 1}},
+	}
+	before := Requests(order, traces)
+	if before != 11 {
+		t.Errorf("requests before: got %d, want 11", before)
+	}
+	got := Optimize(order, traces)
+	if want := []int{1, 6, 2, 4, 7, 3, 5}; !reflect.DeepEqual(got, want) {
+		t.Errorf("order: got %v, want %v", got, want)
+	}
+	after := Requests(got, traces)
+	if after != 6 {
+		t.Errorf("requests after: got %d, want 6", after)
+	}
+}
@@ -0,0 +1,267 @@
+// Package prof reads CPU profiles of frames, and converts them to folded
+// stacks for flame graphs.
+//
+// A profile is recorded by base/prof.c. It can be read from a memory dump,
+// which contains the profiler ring buffer, or from the text printed to the
+// console by prof_dump, which has lines like "prof: 12 1 250 1500 physics".
+package prof
+
+import (
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"io/ioutil"
+	"sort"
+	"strconv"
+	"strings"
+)
+
+// Magic at the start of the ring buffer, struct prof_ring.
+const magic = "PROFRING"
+
+// Sizes of the ring buffer, from base/prof.h.
+const (
+	numFrames = 16 // PROF_FRAMES
+	numZones  = 32 // PROF_ZONES
+	numNames  = 32 // PROF_NAMES
+	nameSize  = 16 // PROF_NAME_SIZE
+)
+
+// Sizes of the structures in the ring buffer, in bytes.
+const (
+	zoneSize   = 12                     // struct prof_zone
+	frameSize  = 12 + numZones*zoneSize // struct prof_frame
+	headerSize = 12 + numNames*nameSize // rate, frame, name_count, and name
+	ringSize   = headerSize + numFrames*frameSize
+)
+
+// Root is the name of the stack frame containing all zones in a frame.
+const Root = "frame"
+
+// A Zone is a span of time in a frame.
+type Zone struct {
+	Name     string
+	Depth    int     // Nesting depth, 0 for top-level zones.
+	Start    float64 // Start time, in microseconds, relative to frame start.
+	Duration float64 // Duration, in microseconds.
+}
+
+// A Frame is the profile of one frame. Zones are in the order they started.
+type Frame struct {
+	Seq      uint32  // Frame sequence number.
+	Duration float64 // Duration, in microseconds.
+	Zones    []Zone
+	Dropped  int // Number of zones which were not recorded.
+}
+
+// Parse parses the frames in a memory dump or console text.
+func Parse(data []byte) ([]*Frame, error) {
+	if i := bytes.Index(data, []byte(magic)); i != -1 {
+		return parseBinary(data[i+len(magic):])
+	}
+	return parseText(data)
+}
+
+// ReadFile reads the frames in a file.
+func ReadFile(name string) ([]*Frame, error) {
+	data, err := ioutil.ReadFile(name)
+	if err != nil {
+		return nil, err
+	}
+	fs, err := Parse(data)
+	if err != nil {
+		return nil, fmt.Errorf("%s: %v", name, err)
+	}
+	return fs, nil
+}
+
+// parseBinary parses the ring buffer, after the magic. The Nintendo 64 is
+// big-endian. Only complete frames are returned, oldest first.
+func parseBinary(data []byte) ([]*Frame, error) {
+	if len(data) < ringSize {
+		return nil, errors.New("profiler ring buffer is truncated")
+	}
+	be := binary.BigEndian
+	rate := be.Uint32(data)
+	seq := be.Uint32(data[4:])
+	nameCount := be.Uint32(data[8:])
+	if rate == 0 {
+		return nil, errors.New("profiler clock rate is zero")
+	}
+	if nameCount > numNames {
+		return nil, fmt.Errorf("bad name count: %d", nameCount)
+	}
+	names := make([]string, nameCount)
+	for i := range names {
+		b := data[12+i*nameSize : 12+(i+1)*nameSize]
+		if j := bytes.IndexByte(b, 0); j != -1 {
+			b = b[:j]
+		}
+		names[i] = string(b)
+	}
+	micros := func(ticks uint32) float64 {
+		return float64(ticks) * 1e6 / float64(rate)
+	}
+	// The current frame is incomplete.
+	count := uint32(numFrames - 1)
+	if seq < count {
+		count = seq
+	}
+	var frames []*Frame
+	for s := seq - count; s != seq; s++ {
+		fd := data[headerSize+int(s%numFrames)*frameSize:]
+		n := int(be.Uint16(fd[8:]))
+		if n > numZones {
+			return nil, fmt.Errorf("frame %d: bad zone count: %d", s, n)
+		}
+		f := &Frame{
+			Seq:      s,
+			Duration: micros(be.Uint32(fd[4:])),
+			Zones:    make([]Zone, n),
+			Dropped:  int(be.Uint16(fd[10:])),
+		}
+		for i := range f.Zones {
+			zd := fd[12+i*zoneSize:]
+			name := int(zd[8])
+			if name == 0 || name >= len(names) {
+				return nil, fmt.Errorf("frame %d: bad zone name: %d", s, name)
+			}
+			f.Zones[i] = Zone{
+				Name:     names[name],
+				Depth:    int(zd[9]),
+				Start:    micros(be.Uint32(zd)),
+				Duration: micros(be.Uint32(zd[4:])),
+			}
+		}
+		frames = append(frames, f)
+	}
+	return frames, nil
+}
+
+// parseText parses frames from console text. Lines without the profile prefix
+// are ignored. If the same frame was printed more than once, only the first
+// copy is used.
+func parseText(data []byte) ([]*Frame, error) {
+	const prefix = "prof:"
+	var frames []*Frame
+	// The frame being parsed, which is nil if it is a copy of an earlier frame.
+	var cur *Frame
+	var curSeq uint32
+	hasHeader := false
+	seen := make(map[uint32]bool)
+	for lineno, line := range strings.Split(string(data), "\n") {
+		i := strings.Index(line, prefix)
+		if i == -1 {
+			continue
+		}
+		fields := strings.Fields(line[i+len(prefix):])
+		bad := func(err error) error {
+			return fmt.Errorf("line %d: %v", lineno+1, err)
+		}
+		if len(fields) < 3 {
+			return nil, bad(errors.New("too few fields"))
+		}
+		seq64, err := strconv.ParseUint(fields[0], 10, 32)
+		if err != nil {
+			return nil, bad(err)
+		}
+		seq := uint32(seq64)
+		if fields[1] == "frame" {
+			d, err := strconv.ParseFloat(fields[2], 64)
+			if err != nil {
+				return nil, bad(err)
+			}
+			hasHeader = true
+			curSeq = seq
+			cur = nil
+			if !seen[seq] {
+				seen[seq] = true
+				cur = &Frame{Seq: seq, Duration: d}
+				frames = append(frames, cur)
+			}
+			continue
+		}
+		if !hasHeader || seq != curSeq {
+			return nil, bad(fmt.Errorf("frame %d has no header", seq))
+		}
+		if cur == nil {
+			continue
+		}
+		if fields[1] == "dropped" {
+			n, err := strconv.Atoi(fields[2])
+			if err != nil {
+				return nil, bad(err)
+			}
+			cur.Dropped += n
+			continue
+		}
+		if len(fields) != 5 {
+			return nil, bad(errors.New("wrong number of fields"))
+		}
+		var z Zone
+		if z.Depth, err = strconv.Atoi(fields[1]); err != nil {
+			return nil, bad(err)
+		}
+		if z.Start, err = strconv.ParseFloat(fields[2], 64); err != nil {
+			return nil, bad(err)
+		}
+		if z.Duration, err = strconv.ParseFloat(fields[3], 64); err != nil {
+			return nil, bad(err)
+		}
+		z.Name = fields[4]
+		cur.Zones = append(cur.Zones, z)
+	}
+	if len(frames) == 0 {
+		return nil, errors.New("no profile found")
+	}
+	return frames, nil
+}
+
+// A Stack is a stack of nested zones, and the time spent in the innermost zone
+// and not in any zone nested inside it.
+type Stack struct {
+	Stack string  // Zone names, separated by semicolons, starting with Root.
+	Time  float64 // Self time, in microseconds.
+}
+
+// Fold converts frames to folded stacks, summing the self time of each stack
+// over all frames. Stacks are sorted by name. Stacks with no self time are
+// omitted.
+func Fold(frames []*Frame) ([]Stack, error) {
+	times := make(map[string]float64)
+	for _, f := range frames {
+		// Stack names and indexes into self for each open zone, starting with
+		// the root.
+		names := []string{Root}
+		open := []int{0}
+		self := []float64{f.Duration}
+		paths := []string{Root}
+		for i, z := range f.Zones {
+			if z.Depth < 0 || z.Depth >= len(open) {
+				return nil, fmt.Errorf("frame %d: zone %d: bad depth: %d",
+					f.Seq, i, z.Depth)
+			}
+			names = names[:z.Depth+1]
+			open = open[:z.Depth+1]
+			self[open[z.Depth]] -= z.Duration
+			names = append(names, z.Name)
+			open = append(open, len(self))
+			self = append(self, z.Duration)
+			paths = append(paths, strings.Join(names, ";"))
+		}
+		for i, path := range paths {
+			if self[i] > 0 {
+				times[path] += self[i]
+			}
+		}
+	}
+	stacks := make([]Stack, 0, len(times))
+	for path, t := range times {
+		stacks = append(stacks, Stack{Stack: path, Time: t})
+	}
+	sort.Slice(stacks, func(i, j int) bool {
+		return stacks[i].Stack < stacks[j].Stack
+	})
+	return stacks, nil
+}
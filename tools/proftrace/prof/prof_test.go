@@ -0,0 +1,152 @@
+package prof
+
+import (
+	"encoding/binary"
+	"reflect"
+	"testing"
+)
+
+func TestParseText(t *testing.T) {
+	const text = "Some other output\n" +
+		"prof: 7 frame 16000\n" +
+		"prof: 7 0 0 5000 update\n" +
+		"prof: 7 1 1000 1500 physics\n" +
+		"prof: 7 dropped 2\n" +
+		// The same frame, printed again.
+		"prof: 7 frame 16000\n" +
+		"prof: 7 0 0 5000 update\n" +
+		"prof: 8 frame 17000\n"
+	fs, err := Parse([]byte(text))
+	if err != nil {
+		t.Fatal(err)
+	}
+	want := []*Frame{
+		{
+			Seq:      7,
+			Duration: 16000,
+			Zones: []Zone{
+				{Name: "update", Depth: 0, Start: 0, Duration: 5000},
+				{Name: "physics", Depth: 1, Start: 1000, Duration: 1500},
+			},
+			Dropped: 2,
+		},
+		{Seq: 8, Duration: 17000},
+	}
+	if !reflect.DeepEqual(fs, want) {
+		t.Errorf("got %+v, want %+v", fs, want)
+	}
+	if _, err := Parse([]byte("prof: 3 frame 10\nprof: 3 0 0 x update\n")); err == nil {
+		t.Error("bad zone: no error")
+	}
+	if _, err := Parse([]byte("prof: 3 0 0 10 update\n")); err == nil {
+		t.Error("no header: no error")
+	}
+	if _, err := Parse([]byte("nothing here\n")); err == nil {
+		t.Error("no profile: no error")
+	}
+}
+
+func TestParseBinary(t *testing.T) {
+	be := binary.BigEndian
+	// Ring buffer in the middle of a memory dump, with two complete frames and
+	// a clock with 2 ticks per microsecond.
+	ring := make([]byte, ringSize)
+	be.PutUint32(ring, 2000000)
+	be.PutUint32(ring[4:], 2)
+	be.PutUint32(ring[8:], 3)
+	copy(ring[12+1*nameSize:], "update")
+	copy(ring[12+2*nameSize:], "physics")
+	type zone struct {
+		start, duration uint32
+		name, depth     byte
+	}
+	putFrame := func(i int, duration uint32, dropped uint16, zones []zone) {
+		fd := ring[headerSize+i*frameSize:]
+		be.PutUint32(fd[4:], duration)
+		be.PutUint16(fd[8:], uint16(len(zones)))
+		be.PutUint16(fd[10:], dropped)
+		for j, z := range zones {
+			zd := fd[12+j*zoneSize:]
+			be.PutUint32(zd, z.start)
+			be.PutUint32(zd[4:], z.duration)
+			zd[8] = z.name
+			zd[9] = z.depth
+		}
+	}
+	putFrame(0, 32000, 0, []zone{{0, 10000, 1, 0}, {2000, 3000, 2, 1}})
+	putFrame(1, 34000, 1, []zone{{0, 6000, 1, 0}})
+	// The current frame is not returned.
+	putFrame(2, 0, 0, []zone{{0, 0, 1, 0}})
+	data := make([]byte, 100)
+	data = append(data, magic...)
+	data = append(data, ring...)
+	fs, err := Parse(data)
+	if err != nil {
+		t.Fatal(err)
+	}
+	want := []*Frame{
+		{
+			Seq:      0,
+			Duration: 16000,
+			Zones: []Zone{
+				{Name: "update", Depth: 0, Start: 0, Duration: 5000},
+				{Name: "physics", Depth: 1, Start: 1000, Duration: 1500},
+			},
+		},
+		{
+			Seq:      1,
+			Duration: 17000,
+			Zones: []Zone{
+				{Name: "update", Depth: 0, Start: 0, Duration: 3000},
+			},
+			Dropped: 1,
+		},
+	}
+	if !reflect.DeepEqual(fs, want) {
+		t.Errorf("got %+v, want %+v", fs, want)
+	}
+	if _, err := Parse(data[:len(data)-1]); err == nil {
+		t.Error("truncated: no error")
+	}
+}
+
+func TestFold(t *testing.T) {
+	frames := []*Frame{
+		{
+			Duration: 16000,
+			Zones: []Zone{
+				{Name: "update", Depth: 0, Duration: 5000},
+				{Name: "physics", Depth: 1, Duration: 1000},
+				{Name: "camera", Depth: 1, Duration: 500},
+				{Name: "physics", Depth: 1, Duration: 1000},
+				{Name: "graphics", Depth: 0, Duration: 8000},
+				{Name: "model", Depth: 1, Duration: 8000},
+			},
+		},
+		{
+			Duration: 17000,
+			Zones: []Zone{
+				{Name: "update", Depth: 0, Duration: 3000},
+				{Name: "physics", Depth: 1, Duration: 1500},
+			},
+		},
+	}
+	stacks, err := Fold(frames)
+	if err != nil {
+		t.Fatal(err)
+	}
+	want := []Stack{
+		{Stack: "frame", Time: 3000 + 14000},
+		{Stack: "frame;graphics;model", Time: 8000},
+		{Stack: "frame;update", Time: 2500 + 1500},
+		{Stack: "frame;update;camera", Time: 500},
+		{Stack: "frame;update;physics", Time: 2000 + 1500},
+	}
+	if !reflect.DeepEqual(stacks, want) {
+		t.Errorf("got %v, want %v", stacks, want)
+	}
+	bad := []*Frame{{Zones: []Zone{{Name: "update", Depth: 1}}}}
+	if _, err := Fold(bad); err == nil {
+		t.Error("bad depth: no error")
+	}
+}
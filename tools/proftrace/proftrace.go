@@ -0,0 +1,57 @@
+package main
+
+import (
+	"flag"
+	"fmt"
+	"os"
+
+	"thornmarked/tools/getpath"
+	"thornmarked/tools/proftrace/prof"
+)
+
+func mainE() error {
+	averageFlag := flag.Bool("average", false, "show average time per frame")
+	flag.Parse()
+	args := flag.Args()
+	if len(args) == 0 {
+		fmt.Fprint(os.Stderr,
+			"Usage:\n"+
+				"  proftrace [-average] <profile> ...\n")
+		os.Exit(1)
+	}
+	var frames []*prof.Frame
+	var dropped int
+	for _, arg := range args {
+		fs, err := prof.ReadFile(getpath.GetPath(arg))
+		if err != nil {
+			return err
+		}
+		fmt.Fprintf(os.Stderr, "%s: %d frames\n", arg, len(fs))
+		frames = append(frames, fs...)
+		for _, f := range fs {
+			dropped += f.Dropped
+		}
+	}
+	if dropped != 0 {
+		fmt.Fprintf(os.Stderr, "Warning: %d zones were dropped\n", dropped)
+	}
+	stacks, err := prof.Fold(frames)
+	if err != nil {
+		return err
+	}
+	for _, s := range stacks {
+		t := s.Time
+		if *averageFlag {
+			t /= float64(len(frames))
+		}
+		fmt.Printf("%s %.0f\n", s.Stack, t)
+	}
+	return nil
+}
+
+func main() {
+	if err := mainE(); err != nil {
+		fmt.Fprintln(os.Stderr, "Error:", err)
+		os.Exit(1)
+	}
+}
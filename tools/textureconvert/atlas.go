@@ -0,0 +1,93 @@
+package main
+
+import (
+	"errors"
+	"fmt"
+	"image"
+	"image/draw"
+	"strings"
+
+	"thornmarked/tools/getpath"
+	"thornmarked/tools/texture"
+)
+
+// atlasGridSize returns the number of rows and columns in an atlas with the
+// given number of cells. This is the smallest power of two whose square is at
+// least the number of cells, so an atlas of power-of-two cells has
+// power-of-two dimensions. This must match modelconvert.
+func atlasGridSize(n int) int {
+	size := 1
+	for size*size < n {
+		size *= 2
+	}
+	return size
+}
+
+func isPowerOfTwo(n int) bool {
+	return n > 0 && n&(n-1) == 0
+}
+
+// packAtlas packs images into a single atlas image. Image i is placed in row
+// i/size, column i%size. All images must have the same power-of-two
+// dimensions. Unused cells are transparent.
+//
+// Cells have no gutter. Instead, modelconvert insets texture coordinates to
+// the centers of the texels on the edges of each cell, so bilinear filtering
+// stays within the cell. This only works if the atlas is not scaled and has no
+// mipmaps.
+func packAtlas(imgs []*image.RGBA) (*image.RGBA, error) {
+	if len(imgs) == 0 {
+		return nil, errors.New("atlas has no inputs")
+	}
+	csize := imgs[0].Rect.Size()
+	if !isPowerOfTwo(csize.X) || !isPowerOfTwo(csize.Y) {
+		return nil, fmt.Errorf("atlas input size is not a power of two: %v", csize)
+	}
+	for _, img := range imgs[1:] {
+		if sz := img.Rect.Size(); sz != csize {
+			return nil, fmt.Errorf("atlas inputs have different sizes: %v and %v", csize, sz)
+		}
+	}
+	size := atlasGridSize(len(imgs))
+	atlas := image.NewRGBA(image.Rect(0, 0, csize.X*size, csize.Y*size))
+	for i, img := range imgs {
+		pos := image.Pt(csize.X*(i%size), csize.Y*(i/size))
+		draw.Draw(atlas, image.Rectangle{pos, pos.Add(csize)}, img, img.Rect.Min, draw.Src)
+	}
+	return atlas, nil
+}
+
+// readAtlas reads a comma-separated list of images and packs them into a single
+// atlas image.
+func readAtlas(inputs string) (*image.RGBA, error) {
+	var imgs []*image.RGBA
+	for _, input := range strings.Split(inputs, ",") {
+		input = getpath.GetPath(input)
+		if input == "" {
+			return nil, errors.New("empty atlas input")
+		}
+		img, err := texture.ReadPNG(input)
+		if err != nil {
+			return nil, err
+		}
+		imgs = append(imgs, texture.ToRGBA(img))
+	}
+	return packAtlas(imgs)
+}
+
+// checkAtlasSize returns an error if an atlas does not fit in TMEM. Textures
+// are normally scaled down to fit, but scaling an atlas would move the cell
+// edges away from the texture coordinates chosen by modelconvert.
+func checkAtlasSize(img *image.RGBA, format texture.SizedFormat) error {
+	limit := tmemSize
+	if format.Format == texture.CI {
+		limit >>= 1
+	}
+	sz := img.Rect.Size()
+	if n := texture.TileSize(sz.X, sz.Y, format.Size.Size()); n > limit {
+		return fmt.Errorf(
+			"atlas too large for TMEM, size=%dx%d, bytes=%d, maxbytes=%d",
+			sz.X, sz.Y, n, limit)
+	}
+	return nil
+}
@@ -0,0 +1,78 @@
+package main
+
+import (
+	"image"
+	"image/color"
+	"strings"
+	"testing"
+
+	"thornmarked/tools/texture"
+)
+
+func TestAtlasGridSize(t *testing.T) {
+	cases := []struct{ n, size int }{
+		{1, 1}, {2, 2}, {3, 2}, {4, 2}, {5, 4}, {16, 4}, {17, 8},
+	}
+	for _, c := range cases {
+		if size := atlasGridSize(c.n); size != c.size {
+			t.Errorf("atlasGridSize(%d) = %d, want %d", c.n, size, c.size)
+		}
+	}
+}
+
+func solidImage(size int, c color.RGBA) *image.RGBA {
+	img := image.NewRGBA(image.Rect(0, 0, size, size))
+	for y := 0; y < size; y++ {
+		for x := 0; x < size; x++ {
+			img.SetRGBA(x, y, c)
+		}
+	}
+	return img
+}
+
+func TestPackAtlas(t *testing.T) {
+	colors := []color.RGBA{
+		{255, 0, 0, 255},
+		{0, 255, 0, 255},
+		{0, 0, 255, 255},
+	}
+	var imgs []*image.RGBA
+	for _, c := range colors {
+		imgs = append(imgs, solidImage(16, c))
+	}
+	atlas, err := packAtlas(imgs)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if sz := atlas.Rect.Size(); sz != image.Pt(32, 32) {
+		t.Fatalf("atlas size: got %v, want (32,32)", sz)
+	}
+	// Check the corners of each cell, and the unused fourth cell.
+	want := append(colors, color.RGBA{})
+	for i, c := range want {
+		x0, y0 := 16*(i%2), 16*(i/2)
+		for _, p := range []image.Point{{x0, y0}, {x0 + 15, y0 + 15}} {
+			if got := atlas.RGBAAt(p.X, p.Y); got != c {
+				t.Errorf("cell %d at %v: got %v, want %v", i, p, got, c)
+			}
+		}
+	}
+
+	if _, err := packAtlas([]*image.RGBA{solidImage(16, colors[0]), solidImage(8, colors[1])}); err == nil {
+		t.Error("different sizes: no error")
+	}
+	if _, err := packAtlas([]*image.RGBA{solidImage(12, colors[0]), solidImage(12, colors[1])}); err == nil {
+		t.Error("size not a power of two: no error")
+	}
+}
+
+func TestCheckAtlasSize(t *testing.T) {
+	rgba16 := texture.SizedFormat{Format: texture.RGBA, Size: texture.Size16}
+	// 2x2 cells of 32x32 RGBA16 is 8 KB, twice the size of TMEM.
+	if err := checkAtlasSize(image.NewRGBA(image.Rect(0, 0, 64, 64)), rgba16); err == nil || !strings.Contains(err.Error(), "TMEM") {
+		t.Errorf("64x64 rgba.16: got %v, want TMEM error", err)
+	}
+	if err := checkAtlasSize(image.NewRGBA(image.Rect(0, 0, 32, 32)), rgba16); err != nil {
+		t.Errorf("32x32 rgba.16: %v", err)
+	}
+}
@@ -0,0 +1,142 @@
+package main
+
+import (
+	"encoding/binary"
+	"image"
+	"image/color"
+	"testing"
+
+	"thornmarked/tools/texture"
+)
+
+// Limits from game/n64/image.c.
+const (
+	imageHeaderSize = 2 * 1024 // Size of the header loaded for streamed images.
+	imageStripSize  = 4 * 1024 // Size of a strip buffer.
+)
+
+// stripImage returns an image with a disc and, below it, a separate full-width
+// bar, so the image has empty rows and strips of different widths.
+func stripImage() *image.RGBA {
+	img := image.NewRGBA(image.Rect(0, 0, 96, 120))
+	red := color.RGBA{255, 0, 0, 255}
+	blue := color.RGBA{0, 0, 255, 255}
+	for y := 10; y < 90; y++ {
+		for x := 0; x < 96; x++ {
+			dx, dy := x-48, y-50
+			if dx*dx+dy*dy < 40*40 {
+				img.SetRGBA(x, y, red)
+			}
+		}
+	}
+	for y := 100; y < 110; y++ {
+		for x := 0; x < 96; x++ {
+			img.SetRGBA(x, y, blue)
+		}
+	}
+	return img
+}
+
+// rgba16 converts a color to RGBA 5551.
+func rgba16(c color.RGBA) uint16 {
+	return uint16(c.R>>3)<<11 | uint16(c.G>>3)<<6 | uint16(c.B>>3)<<1 |
+		uint16(c.A>>7)
+}
+
+// TestMakeStrips checks that the strip image passes image_check, both loaded
+// whole and streamed, and that the strips cover every visible pixel.
+func TestMakeStrips(t *testing.T) {
+	src := stripImage()
+	opts := options{
+		format: texture.SizedFormat{Format: texture.RGBA, Size: texture.Size16},
+		anchor: [2]float64{0.5, 0.5},
+	}
+	img := image.NewRGBA(src.Rect)
+	copy(img.Pix, src.Pix)
+	data, err := makeStrips(&opts, img)
+	if err != nil {
+		t.Fatal(err)
+	}
+	// The magic is removed when the image is packed.
+	data = data[16:]
+	size := uint32(len(data))
+	if size < imageHeaderSize {
+		t.Fatalf("image is %d bytes, test needs a streamed image", size)
+	}
+
+	e := binary.BigEndian
+	count := int32(e.Uint32(data))
+	if count < 0 || count > (imageHeaderSize-4)/12 {
+		t.Fatalf("bad rect count: %d", count)
+	}
+	type rect struct {
+		x, y, xsz, ysz int16
+		pixels         uint32
+	}
+	rects := make([]rect, count)
+	for i := range rects {
+		rd := data[4+12*i:]
+		r := rect{
+			x:      int16(e.Uint16(rd[0:])),
+			y:      int16(e.Uint16(rd[2:])),
+			xsz:    int16(e.Uint16(rd[4:])),
+			ysz:    int16(e.Uint16(rd[6:])),
+			pixels: e.Uint32(rd[8:]),
+		}
+		rsize := uint32((int(r.xsz)+3)&^3) * uint32(r.ysz) * 2
+		if r.xsz < 0 || r.ysz < 0 || r.pixels >= size ||
+			rsize > size-r.pixels || rsize > imageStripSize {
+			t.Fatalf("rect %d: bad rect: %+v, size=%d", i, r, rsize)
+		}
+		if r.pixels&7 != 0 {
+			t.Errorf("rect %d: offset %d is not aligned", i, r.pixels)
+		}
+		rects[i] = r
+	}
+
+	// Every visible pixel is in a strip, with the right value. Odd rows are
+	// in the native TMEM layout, with 32-bit words swapped.
+	const x0, y0 = 48, 60
+	for y := 0; y < src.Rect.Dy(); y++ {
+		for x := 0; x < src.Rect.Dx(); x++ {
+			c := src.RGBAAt(x, y)
+			if c.A == 0 {
+				continue
+			}
+			found := false
+			for _, r := range rects {
+				rx, ry := x-x0-int(r.x), y-y0-int(r.y)
+				if rx < 0 || ry < 0 || rx >= int(r.xsz) || ry >= int(r.ysz) {
+					continue
+				}
+				stride := ((int(r.xsz) + 3) &^ 3) * 2
+				off := rx * 2
+				if ry&1 != 0 {
+					off ^= 4
+				}
+				pos := int(r.pixels) + ry*stride + off
+				if got := e.Uint16(data[pos:]); got != rgba16(c) {
+					t.Errorf("pixel (%d, %d): got %04x, want %04x",
+						x, y, got, rgba16(c))
+				}
+				found = true
+				break
+			}
+			if !found {
+				t.Errorf("pixel (%d, %d) is not in a strip", x, y)
+				return
+			}
+		}
+	}
+}
+
+func TestMakeStripsEmpty(t *testing.T) {
+	opts := options{
+		format: texture.SizedFormat{Format: texture.RGBA, Size: texture.Size16},
+		anchor: [2]float64{0.5, 0.5},
+	}
+	img := image.NewRGBA(image.Rect(0, 0, 32, 32))
+	if _, err := makeStrips(&opts, img); err == nil {
+		t.Error("empty image: no error")
+	}
+}
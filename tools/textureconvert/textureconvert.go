@@ -24,6 +24,7 @@ type options struct {
 	layout    texture.Layout
 	mipmap    bool
 	strips    bool
+	atlas     bool
 	dithering texture.Dithering
 	anchor    [2]float64
 	gamma     float64
@@ -35,6 +36,7 @@ func parseArgs() (opts options, err error) {
 	native := flag.Bool("native", false, "use native TMEM texture layout")
 	flag.BoolVar(&opts.mipmap, "mipmap", false, "generate mipmaps")
 	flag.BoolVar(&opts.strips, "strips", false, "convert to strips that fit in TMEM")
+	flag.BoolVar(&opts.atlas, "atlas", false, "pack the comma-separated -input images into an atlas")
 	flag.Var(&opts.format, "format", "use texture format `fmt.size` (e.g. rgba.16)")
 	dither := flag.String("dither", "", "use dithering algorithm (none, bayer, floyd-steinberg)")
 	anchor := flag.String("anchor", "", "origin of image (strips only), `x:y` range 0-1")
@@ -47,10 +49,20 @@ func parseArgs() (opts options, err error) {
 	if opts.output == "" {
 		return opts, errors.New("missing required flag -output")
 	}
-	opts.input = getpath.GetPath(*input)
-	if opts.input == "" {
+	if *input == "" {
 		return opts, errors.New("missing required flag -input")
 	}
+	if opts.atlas {
+		if opts.strips {
+			return opts, errors.New("cannot use -atlas with -strips")
+		}
+		if opts.mipmap {
+			return opts, errors.New("cannot use -atlas with -mipmap, since mipmaps blend neighboring cells")
+		}
+		opts.input = *input
+	} else {
+		opts.input = getpath.GetPath(*input)
+	}
 	if *native {
 		opts.layout = texture.Native
 	} else {
@@ -155,11 +167,22 @@ func mainE() error {
 	}
 
 	// Load image as RGBA with 8 bits per sample.
-	inimg, err := texture.ReadPNG(opts.input)
-	if err != nil {
-		return err
+	var img *image.RGBA
+	if opts.atlas {
+		img, err = readAtlas(opts.input)
+		if err != nil {
+			return err
+		}
+		if err := checkAtlasSize(img, opts.format); err != nil {
+			return err
+		}
+	} else {
+		inimg, err := texture.ReadPNG(opts.input)
+		if err != nil {
+			return err
+		}
+		img = texture.ToRGBA(inimg)
 	}
-	img := texture.ToRGBA(inimg)
 
 	var data []byte
 	switch {